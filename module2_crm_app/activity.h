@@ -0,0 +1,125 @@
+#ifndef __ACTIVITY_H__
+#define __ACTIVITY_H__
+
+#include <array>
+#include <cstddef>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <utility>
+
+#include "customers.h"
+
+/// @brief Number of most recent interactions kept in every ActivitySummary
+#define ACTIVITY_RECENT_INTERACTIONS 5U
+
+/// @brief Aggregated view of the interactions of a customer, kept up to date
+/// as interactions are added so that it never requires walking the history
+struct ActivitySummary {
+  /// @brief Number of interactions, archived ones included
+  std::size_t interaction_count_;
+  /// @brief Whether any interaction is dated, i.e. whether first_timestamp_
+  /// and last_timestamp_ are set
+  bool dated_;
+  /// @brief Date of the oldest dated interaction as a UNIX Timestamp
+  std::time_t first_timestamp_;
+  /// @brief Date of the latest dated interaction as a UNIX Timestamp
+  std::time_t last_timestamp_;
+  /// @brief Most recent interactions held in memory, latest first
+  std::array<std::shared_ptr<Interaction>, ACTIVITY_RECENT_INTERACTIONS>
+      recent_;
+  /// @brief Dates of the entries of recent_
+  std::array<std::time_t, ACTIVITY_RECENT_INTERACTIONS> recent_timestamps_;
+  /// @brief Number of valid entries in recent_
+  std::size_t recent_count_;
+
+  ActivitySummary()
+      : interaction_count_{},
+        dated_{false},
+        first_timestamp_{},
+        last_timestamp_{},
+        recent_{},
+        recent_timestamps_{},
+        recent_count_{} {}
+
+  /// @brief Checks if the customer has had any interactions yet
+  /// @return True if at least one interaction was recorded
+  bool HasInteractions() const { return interaction_count_ > 0U; }
+
+  /// @brief Checks if the dates of the first and last interactions are known
+  /// @return True if at least one dated interaction was recorded
+  bool IsDated() const { return dated_; }
+
+  /// @brief Accounts for a new interaction. Constant time: only the few most
+  /// recent interactions are kept.
+  /// @param interaction Interaction added
+  void Add(const std::shared_ptr<Interaction>& interaction) {
+    std::time_t timestamp{};
+    if (!interaction->GetTimestamp(timestamp)) {
+      // Counted, but cannot be placed in time
+      interaction_count_++;
+      return;
+    }
+
+    AddRange(1U, timestamp, timestamp);
+
+    // Usually the latest one, inserted at the front
+    std::size_t position = 0U;
+    while (position < recent_count_ &&
+           recent_timestamps_[position] >= timestamp) {
+      position++;
+    }
+    if (position >= ACTIVITY_RECENT_INTERACTIONS) {
+      return;
+    }
+
+    if (recent_count_ < ACTIVITY_RECENT_INTERACTIONS) {
+      recent_count_++;
+    }
+    for (std::size_t i = recent_count_ - 1U; i > position; i--) {
+      recent_[i] = std::move(recent_[i - 1U]);
+      recent_timestamps_[i] = recent_timestamps_[i - 1U];
+    }
+    recent_[position] = interaction;
+    recent_timestamps_[position] = timestamp;
+  }
+
+  /// @brief Accounts for a group of interactions, without keeping any of them
+  /// @param count Number of interactions
+  /// @param first_timestamp Date of the oldest one
+  /// @param last_timestamp Date of the latest one
+  void AddRange(const std::size_t count, const std::time_t first_timestamp,
+                const std::time_t last_timestamp) {
+    if (count == 0U) {
+      return;
+    }
+
+    // Undated interactions may have been counted already
+    if (!dated_ || first_timestamp < first_timestamp_) {
+      first_timestamp_ = first_timestamp;
+    }
+    if (!dated_ || last_timestamp > last_timestamp_) {
+      last_timestamp_ = last_timestamp;
+    }
+    dated_ = true;
+    interaction_count_ += count;
+  }
+
+  /// @brief Forgets the recent interactions older than a date, e.g. because
+  /// they have been archived. They are still counted.
+  /// @param cutoff_timestamp Date as a UNIX Timestamp
+  void DropRecentBefore(const std::time_t cutoff_timestamp) {
+    while (recent_count_ > 0U &&
+           recent_timestamps_[recent_count_ - 1U] < cutoff_timestamp) {
+      recent_[--recent_count_].reset();
+    }
+  }
+};
+
+/// @brief Activity summaries by customer ID, allocated from an Arena
+using ActivityMap =
+    std::map<Customer::ID, ActivitySummary, std::less<Customer::ID>,
+             ArenaAllocator<std::pair<const Customer::ID, ActivitySummary>>>;
+
+#endif  // __ACTIVITY_H__
@@ -1,432 +1,808 @@
-#include "app.h"
-
-#include <ctime>
-#include <iostream>
-#include <string>
-
-#include "utilities.h"
-
-namespace {
-
-// Source: https://stackoverflow.com/questions/17335816/clear-screen-using-c
-// Intended to clear the screen in a way that works both on UNIX and Win32
-void clear_screen() { std::cout << "\033[2J\033[1;1H"; }
-
-/// @brief Helper method to fetch user input from console
-/// @param message A prompt message to display
-/// @return User-input from console
-std::string prompt_user_input(const char* message) {
-  std::cout << message;
-  std::string terminal_input{};
-  std::getline(std::cin, terminal_input);
-
-  return terminal_input;
-}
-
-/// @brief Helper method to convert a string to its corresponding Enum value
-/// @tparam EnumT Enum class to convert to
-/// @tparam min_value Min. value to consider the input valid
-/// @tparam max_value Max. value to consider the input valid
-/// @param str String to convert
-/// @return Enum value on success, INVALID on failure
-template <typename EnumT, EnumT min_value, EnumT max_value>
-EnumT to_enum(const std::string& str) {
-  std::uint32_t value{static_cast<std::uint32_t>(EnumT::INVALID)};
-  utilities::try_convert(str, value);
-
-  if (value >= static_cast<std::uint32_t>(min_value) &&
-      value <= static_cast<std::uint32_t>(max_value)) {
-    return static_cast<EnumT>(value);
-  }
-
-  return EnumT::INVALID;
-}
-
-}  // namespace
-
-App::App() : customer_manager_{DATABASE_PATH}, managed_customer_id_{} {
-  commands_ = {
-      {ECommand::ADD_CUSTOMER,
-       {"Aggiungi un nuovo Cliente", std::bind(&App::AddClient, this)}},
-      {ECommand::SHOW_CUSTOMERS,
-       {"Visualizza tutti i Clienti", std::bind(&App::ShowClients, this)}},
-      {ECommand::EDIT_CUSTOMER,
-       {"Modifica un Cliente", std::bind(&App::EditClient, this)}},
-      {ECommand::REMOVE_CUSTOMER,
-       {"Rimuovi un Cliente", std::bind(&App::RemoveClient, this)}},
-      {ECommand::SEARCH_CUSTOMER,
-       {"Cerca un Cliente", std::bind(&App::SearchClient, this)}},
-      {ECommand::MANAGE_CUSTOMER_INTERACTIONS,
-       {"Gestisci interazioni",
-        std::bind(&App::ManageClientInteractions, this)}},
-      {ECommand::EXIT, {"Chiudi", []() { return false; }}},
-  };
-
-  auto& manage_interactions = commands_[ECommand::MANAGE_CUSTOMER_INTERACTIONS];
-  manage_interactions.AddSubMenu(ESubCommand::CLIENT_INTERACTIONS_ADD,
-                                 "Aggiungi interazione",
-                                 std::bind(&App::AddClientInteraction, this));
-  manage_interactions.AddSubMenu(ESubCommand::CLIENT_INTERACTIONS_SHOW,
-                                 "Visualizza interazioni",
-                                 std::bind(&App::ShowClientInteractions, this));
-  manage_interactions.AddSubMenu(
-      ESubCommand::CLIENT_INTERACTIONS_SEARCH, "Cerca interazioni",
-      std::bind(&App::SearchClientInteractions, this));
-  manage_interactions.AddSubMenu(
-      ESubCommand::CLIENT_INTERACTIONS_RESELECT_CLIENT,
-      "Seleziona nuovo cliente da gestire",
-      std::bind(&App::ReselectClientForInteractions, this));
-  manage_interactions.AddSubMenu(ESubCommand::RETURN,
-                                 "Torna alla pagina principale",
-                                 []() { return false; });
-}
-
-std::int32_t App::Run() {
-  while (true) {
-    managed_customer_id_ = 0;
-
-    std::cout << "CRM per InsuraPro Solutions!" << std::endl;
-    ShowMenu();
-
-    const std::string action = prompt_user_input("Cosa vuoi fare? ");
-    const ECommand selected_action =
-        to_enum<App::ECommand, App::ECommand::ADD_CUSTOMER,
-                App::ECommand::EXIT>(action);
-
-    clear_screen();
-
-    if (selected_action == ECommand::INVALID) {
-      std::cout << "L'azione scelta non è valida." << std::endl << std::endl;
-      continue;
-    }
-
-    if (selected_action == ECommand::EXIT) {
-      break;
-    }
-
-    commands_[selected_action].callback_();
-    std::cout << std::endl;
-  }
-
-  return EXIT_SUCCESS;
-}
-
-void App::ShowMenu() {
-  for (const auto& command : commands_) {
-    std::cout << static_cast<std::uint32_t>(command.first) << ") "
-              << command.second.description_ << std::endl;
-  }
-}
-
-void App::ShowSubMenu(ECommand cmd) {
-  for (const auto& command : commands_[cmd].submenu_) {
-    std::cout << static_cast<std::uint32_t>(command.first) << ") "
-              << command.second.description_ << std::endl;
-  }
-}
-
-void App::AddClient() {
-  std::cout << "Aggiungi nuovo cliente" << std::endl;
-  std::cout << "Compila i campi di seguito oppure lasciali vuoti per tornare "
-               "indietro."
-            << std::endl;
-  const std::string name = prompt_user_input("Nome: ");
-  const std::string surname = prompt_user_input("Cognome: ");
-
-  if (name.empty() && surname.empty()) {
-    return;
-  } else if (name.empty() || surname.empty()) {
-    clear_screen();
-
-    std::cout << "Per aggiungere un cliente devi compilare entrambi i campi!"
-              << std::endl
-              << std::endl;
-    AddClient();
-    return;
-  }
-
-  if (customer_manager_.AddCustomer(name, surname)) {
-    std::cout << "Cliente aggiunto." << std::endl;
-  } else {
-    std::cout << "Il cliente esiste già!" << std::endl;
-  }
-}
-
-void App::ShowClients() const {
-  std::cout << "Visualizza tutti i clienti" << std::endl;
-  if (!customer_manager_.PrintAllCustomers()) {
-    std::cout << "Non ci sono clienti." << std::endl;
-    return;
-  }
-
-  prompt_user_input("Premere invio per tornare alla schermata iniziale.");
-}
-
-void App::EditClient() {
-  std::cout << "Modifica di un cliente" << std::endl;
-  Customer::ID selected_customer_id{};
-
-  if (!FindAndSelectClient(selected_customer_id)) {
-    std::cout << "Operazione annullata." << std::endl;
-    return;
-  }
-
-  std::cout << std::endl;
-
-  const auto& selected_customer =
-      customer_manager_.GetCustomer(selected_customer_id);
-
-  std::cout << "Utente selezionato: " << std::endl;
-  selected_customer.PrintInfo();
-  std::cout << std::endl;
-
-  std::cout << "Compila i campi di seguito, o lasciali vuoti per non apportare "
-               "modifiche:"
-            << std::endl;
-  const std::string new_name = prompt_user_input("Nome: ");
-  const std::string new_surname = prompt_user_input("Cognome: ");
-
-  if (new_name.empty() && new_surname.empty()) {
-    std::cout << "Non sono state apportate modifiche al cliente selezionato."
-              << std::endl;
-    return;
-  }
-
-  if (customer_manager_.UpdateClientInfo(
-          selected_customer_id,
-          new_name.empty() ? selected_customer.name_ : new_name,
-          new_surname.empty() ? selected_customer.surname_ : new_surname)) {
-    std::cout << "Modifiche apportate con successo." << std::endl;
-  } else {
-    std::cout << "Si è verificato un errore durante il salvataggio."
-              << std::endl;
-  }
-}
-
-void App::RemoveClient() {
-  std::cout << "Rimuovi un cliente" << std::endl;
-  Customer::ID selected_customer_id{};
-
-  if (!FindAndSelectClient(selected_customer_id)) {
-    std::cout << "Operazione annullata." << std::endl;
-    return;
-  }
-
-  std::cout << "Sei sicuro di voler rimuovere il cliente selezionato?"
-            << std::endl;
-  std::string confirm =
-      prompt_user_input("L'operazione sarà irreversibile! [Si/No] ");
-
-  if (!confirm.empty() && (confirm[0] == 's' || confirm[0] == 'S')) {
-    if (!customer_manager_.RemoveCustomer(selected_customer_id)) {
-      std::cout << "Impossibile rimuovere il cliente selezionato." << std::endl;
-      return;
-    } else {
-      std::cout << "Cliente rimosso." << std::endl;
-    }
-  } else {
-    std::cout << "Operazione annullata." << std::endl;
-  }
-}
-
-void App::SearchClient() {
-  std::cout << "Cerca un cliente" << std::endl;
-  Customer::ID selected_customer_id{};
-  if (!FindAndSelectClient(selected_customer_id, true)) {
-    return;
-  }
-
-  const auto& customer = customer_manager_.GetCustomer(selected_customer_id);
-  customer.PrintInfo();
-  std::cout << std::endl;
-}
-
-void App::ManageClientInteractions() {
-  while (true) {
-    if (managed_customer_id_ == 0) {
-      std::cout << "Prima di procedere è necessario selezionare un Cliente da "
-                   "gestire."
-                << std::endl;
-
-      if (!FindAndSelectClient(managed_customer_id_)) {
-        std::cout
-            << "Devi selezionare un cliente per poter gestire le interazioni."
-            << std::endl;
-        return;
-      }
-
-      clear_screen();
-    }
-
-    std::cout << "Gestione delle Interazioni" << std::endl;
-
-    const auto& selected_customer =
-        customer_manager_.GetCustomer(managed_customer_id_);
-    std::cout << "Cliente selezionato: " << std::endl;
-    selected_customer.PrintInfo();
-    std::cout << std::endl;
-
-    ShowSubMenu(ECommand::MANAGE_CUSTOMER_INTERACTIONS);
-
-    const std::string action = prompt_user_input("Cosa vuoi fare? ");
-    const ESubCommand selected_action =
-        to_enum<App::ESubCommand, App::ESubCommand::CLIENT_INTERACTIONS_ADD,
-                App::ESubCommand::RETURN>(action);
-
-    clear_screen();
-
-    if (selected_action == ESubCommand::INVALID) {
-      std::cout << "L'azione scelta non è valida." << std::endl << std::endl;
-      continue;
-    }
-
-    if (selected_action == ESubCommand::RETURN) {
-      break;
-    }
-
-    commands_[ECommand::MANAGE_CUSTOMER_INTERACTIONS]
-        .submenu_[selected_action]
-        .callback_();
-    std::cout << std::endl;
-  }
-}
-
-void App::AddClientInteraction() {
-  std::cout << "Aggiungi nuova interazione" << std::endl;
-  std::cout << "Lasciare entrambi i campi vuoti per tornare al menu."
-            << std::endl;
-  std::string when =
-      prompt_user_input("Data dell'interazione (ad es.: 15/12/2024 16:15) ");
-
-  if (!utilities::is_valid_date(when, DATE_FORMAT)) {
-    clear_screen();
-
-    std::cout << "La data inserita non è valida!" << std::endl << std::endl;
-    AddClientInteraction();
-    return;
-  }
-
-  std::string what = prompt_user_input("Breve descrizione: ");
-  std::cout << std::endl;
-
-  utilities::remove_chars_from_str(what, "\t\r\n", ' ');
-
-  if (when.empty() && what.empty()) {
-    return;
-  } else if (when.empty() || what.empty()) {
-    clear_screen();
-
-    std::cout << "Entrambi i campi sono obbligatori!" << std::endl;
-    AddClientInteraction();
-    return;
-  }
-
-  std::string confirm = prompt_user_input("Salvare l'interazione? [Si/No] ");
-  if (!confirm.empty() && (confirm[0] == 's' || confirm[0] == 'S')) {
-    if (customer_manager_.AddInteraction(managed_customer_id_, when, what)) {
-      std::cout << "Interazione aggiunta con successo." << std::endl;
-    } else {
-      std::cout << "Si è verificato un errore e non è stato possibile "
-                   "completare la richiesta."
-                << std::endl;
-    }
-  }
-}
-
-void App::SearchClientInteractions() {
-  std::cout << "Cerca interazione" << std::endl;
-  std::cout << "Inserisci le date nell'intervallo in cui cercare. (Formato: "
-               "Giorno/Mese/Anno)"
-            << std::endl;
-  std::string from_date = prompt_user_input("Dal: ");
-  std::string to_date = prompt_user_input("Al: ");
-
-  std::time_t from_timestamp{};
-  std::time_t to_timestamp{};
-  if (!utilities::to_timestamp(from_date, "%d/%m/%Y", from_timestamp) ||
-      !utilities::to_timestamp(to_date, "%d/%m/%Y", to_timestamp)) {
-    std::cout << "Le date inserite non sono nel formato corretto." << std::endl;
-    return;
-  }
-
-  if (from_timestamp > to_timestamp) {
-    std::swap(from_timestamp, to_timestamp);
-  }
-
-  std::cout << std::endl;
-  if (!customer_manager_.PrintCustomerInteractions(
-          managed_customer_id_, from_timestamp, to_timestamp)) {
-    std::cout << "Non sono state trovate interazioni nel periodo specificato."
-              << std::endl;
-  }
-
-  prompt_user_input("Premere invio per tornare alla schermata iniziale.");
-}
-
-void App::ShowClientInteractions() {
-  std::cout << "Visualizza interazioni" << std::endl;
-  const auto& customer = customer_manager_.GetCustomer(managed_customer_id_);
-  if (!customer.HasInteractions()) {
-    std::cout << "Non ci sono interazioni registrate per l'attuale cliente."
-              << std::endl;
-    return;
-  }
-
-  customer.PrintInteractions();
-
-  prompt_user_input("Premere invio per tornare alla schermata iniziale.");
-}
-
-void App::ReselectClientForInteractions() { managed_customer_id_ = 0; }
-
-bool App::FindAndSelectClient(Customer::ID& output_id,
-                              const bool no_selection) const {
-  std::cout << "Puoi specificare uno o più campi per affinare la ricerca "
-            << std::endl;
-  std::string id = prompt_user_input("ID Cliente (Opzionale): ");
-  std::string name{};
-  std::string surname{};
-
-  if (id.empty()) {
-    name = prompt_user_input("Nome (Opzionale): ");
-    surname = prompt_user_input("Cognome (Opzionale): ");
-  }
-
-  std::vector<Customer::ID> found_customers{};
-
-  if (customer_manager_.FindCustomers(id, name, surname, found_customers)) {
-    if (found_customers.size() > 1) {
-      std::cout << "Trovate " << found_customers.size() << " corrispondenze."
-                << std::endl;
-      customer_manager_.PrintCustomersByID(found_customers);
-
-      if (no_selection) {
-        return false;
-      }
-
-      const std::string client_id = prompt_user_input(
-          "Seleziona un ID Cliente o digita 'annulla' per tornare al "
-          "menu principale: ");
-
-      if (client_id == "annulla") {
-        return false;
-      } else if (!utilities::try_convert(client_id, output_id) ||
-                 !utilities::is_in_vector(found_customers, output_id)) {
-        std::cout << "ID Cliente non valido. Si prega di selezionare un ID "
-                     "presente nelle corrispondenze della ricerca."
-                  << std::endl;
-
-        clear_screen();
-        return FindAndSelectClient(output_id);
-      }
-    } else {
-      output_id = found_customers[0];
-    }
-
-    return true;
-  }
-
-  std::cout << std::endl
-            << "La ricerca non ha prodotto alcun risultato." << std::endl;
-  return false;
+#include "app.h"
+
+#include <ctime>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <string>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Number of customers listed at a time
+constexpr std::size_t CUSTOMERS_PAGE_SIZE{20U};
+
+/// @brief Days after today whose appointments are shown
+constexpr int APPOINTMENT_DAYS{7};
+
+/// @brief Maximum number of appointments shown at a time
+constexpr std::size_t MAX_APPOINTMENTS_SHOWN{200U};
+
+// Source: https://stackoverflow.com/questions/17335816/clear-screen-using-c
+// Intended to clear the screen in a way that works both on UNIX and Win32
+void clear_screen() { std::cout << "\033[2J\033[1;1H"; }
+
+/// @brief Helper method to fetch user input from console
+/// @param input Where to store the user-input
+/// @return False once the console input has been closed
+bool read_terminal_input(const bool, std::string& input) {
+  return static_cast<bool>(std::getline(std::cin, input));
+}
+
+/// @brief Name of a command in the trace
+/// @param command Main command
+/// @param sub_command Subcommand, INVALID if none
+/// @return Name, a string literal
+const char* trace_name(const App::ECommand command,
+                       const App::ESubCommand sub_command) {
+  switch (sub_command) {
+    case App::ESubCommand::CLIENT_INTERACTIONS_ADD:
+      return "App::AddClientInteraction";
+    case App::ESubCommand::CLIENT_INTERACTIONS_SHOW:
+      return "App::ShowClientInteractions";
+    case App::ESubCommand::CLIENT_INTERACTIONS_SEARCH:
+      return "App::SearchClientInteractions";
+    case App::ESubCommand::CLIENT_INTERACTIONS_RESELECT_CLIENT:
+      return "App::ReselectClientForInteractions";
+    default:
+      break;
+  }
+
+  switch (command) {
+    case App::ECommand::ADD_CUSTOMER:
+      return "App::AddClient";
+    case App::ECommand::SHOW_CUSTOMERS:
+      return "App::ShowClients";
+    case App::ECommand::EDIT_CUSTOMER:
+      return "App::EditClient";
+    case App::ECommand::REMOVE_CUSTOMER:
+      return "App::RemoveClient";
+    case App::ECommand::SEARCH_CUSTOMER:
+      return "App::SearchClient";
+    case App::ECommand::MANAGE_CUSTOMER_INTERACTIONS:
+      return "App::ManageClientInteractions";
+    case App::ECommand::SWITCH_TENANT:
+      return "App::SwitchTenant";
+    case App::ECommand::SHOW_APPOINTMENTS:
+      return "App::ShowAppointments";
+    default:
+      return "App::Execute";
+  }
+}
+
+/// @brief Converts an amount in euro, with up to two decimals separated by
+/// a comma or a dot, into cents
+/// @param amount Amount, e.g. "350,50"
+/// @param cents Where to store the amount in cents
+/// @return False if the amount is malformed or too large
+bool to_cents(const std::string& amount, std::uint32_t& cents) {
+  const std::size_t separator = amount.find_first_of(",.");
+  const std::string units = amount.substr(0U, separator);
+  std::string decimals =
+      separator != std::string::npos ? amount.substr(separator + 1U) : "";
+  if (units.empty() || decimals.size() > 2U ||
+      units.find_first_not_of("0123456789") != std::string::npos ||
+      decimals.find_first_not_of("0123456789") != std::string::npos ||
+      units.size() > 7U) {
+    return false;
+  }
+
+  decimals.resize(2U, '0');
+  cents = static_cast<std::uint32_t>(std::stoul(units) * 100U +
+                                     std::stoul(decimals));
+  return true;
+}
+
+/// @brief Helper method to convert a string to its corresponding Enum value
+/// @tparam EnumT Enum class to convert to
+/// @tparam min_value Min. value to consider the input valid
+/// @tparam max_value Max. value to consider the input valid
+/// @param str String to convert
+/// @return Enum value on success, INVALID on failure
+template <typename EnumT, EnumT min_value, EnumT max_value>
+EnumT to_enum(const std::string& str) {
+  std::uint32_t value{static_cast<std::uint32_t>(EnumT::INVALID)};
+  utilities::try_convert(str, value);
+
+  if (value >= static_cast<std::uint32_t>(min_value) &&
+      value <= static_cast<std::uint32_t>(max_value)) {
+    return static_cast<EnumT>(value);
+  }
+
+  return EnumT::INVALID;
+}
+
+}  // namespace
+
+App::App(const Config& config, const InputSource& input_source,
+         const CommandObserver& command_observer)
+    : tenant_manager_{config},
+      tenant_name_{},
+      customer_manager_{},
+      reminder_lead_time_{static_cast<std::time_t>(config.reminder_minutes_) *
+                          60},
+      managed_customer_id_{},
+      input_source_{input_source ? input_source : read_terminal_input},
+      input_closed_{false},
+      command_observer_{command_observer},
+      session_recorder_{},
+      current_command_{ECommand::INVALID},
+      current_sub_command_{ESubCommand::INVALID} {
+  if (!config.record_path_.empty()) {
+    session_recorder_.reset(new SessionRecorder{config.record_path_});
+  }
+
+  if (!tenant_manager_.IsMultiTenant()) {
+    customer_manager_ = tenant_manager_.Acquire({});
+    StartReminders();
+  } else if (!config.tenant_.empty() && !SelectTenant(config.tenant_)) {
+    std::cout << "Il nome dell'agenzia non è valido." << std::endl;
+  }
+
+  commands_ = {
+      {ECommand::SHOW_CUSTOMERS,
+       {"Visualizza tutti i Clienti", std::bind(&App::ShowClients, this)}},
+      {ECommand::SEARCH_CUSTOMER,
+       {"Cerca un Cliente", std::bind(&App::SearchClient, this)}},
+      {ECommand::SHOW_APPOINTMENTS,
+       {"Visualizza gli appuntamenti della settimana",
+        std::bind(&App::ShowAppointments, this)}},
+      {ECommand::MANAGE_CUSTOMER_INTERACTIONS,
+       {"Gestisci interazioni",
+        std::bind(&App::ManageClientInteractions, this)}},
+      {ECommand::EXIT, {"Chiudi", []() { return false; }}},
+  };
+
+  if (tenant_manager_.IsMultiTenant()) {
+    commands_[ECommand::SWITCH_TENANT] = {"Cambia agenzia",
+                                          std::bind(&App::SwitchTenant, this)};
+  }
+
+  // Replicas are read-only: commands that change data are not offered
+  if (!config.replica_) {
+    commands_[ECommand::ADD_CUSTOMER] = {"Aggiungi un nuovo Cliente",
+                                         std::bind(&App::AddClient, this)};
+    commands_[ECommand::EDIT_CUSTOMER] = {"Modifica un Cliente",
+                                          std::bind(&App::EditClient, this)};
+    commands_[ECommand::REMOVE_CUSTOMER] = {
+        "Rimuovi un Cliente", std::bind(&App::RemoveClient, this)};
+  }
+
+  auto& manage_interactions = commands_[ECommand::MANAGE_CUSTOMER_INTERACTIONS];
+  if (!config.replica_) {
+    manage_interactions.AddSubMenu(ESubCommand::CLIENT_INTERACTIONS_ADD,
+                                   "Aggiungi interazione",
+                                   std::bind(&App::AddClientInteraction, this));
+  }
+  manage_interactions.AddSubMenu(ESubCommand::CLIENT_INTERACTIONS_SHOW,
+                                 "Visualizza interazioni",
+                                 std::bind(&App::ShowClientInteractions, this));
+  manage_interactions.AddSubMenu(
+      ESubCommand::CLIENT_INTERACTIONS_SEARCH, "Cerca interazioni",
+      std::bind(&App::SearchClientInteractions, this));
+  manage_interactions.AddSubMenu(
+      ESubCommand::CLIENT_INTERACTIONS_RESELECT_CLIENT,
+      "Seleziona nuovo cliente da gestire",
+      std::bind(&App::ReselectClientForInteractions, this));
+  manage_interactions.AddSubMenu(ESubCommand::RETURN,
+                                 "Torna alla pagina principale",
+                                 []() { return false; });
+}
+
+std::int32_t App::Run() {
+  while (true) {
+    managed_customer_id_ = 0;
+
+    // Every command works on a tenant: one must be chosen first
+    if (!customer_manager_) {
+      Execute(commands_[ECommand::SWITCH_TENANT], ECommand::SWITCH_TENANT,
+              ESubCommand::INVALID);
+      if (input_closed_) {
+        break;
+      }
+      continue;
+    }
+
+    std::cout << "CRM per InsuraPro Solutions!" << std::endl;
+    if (tenant_manager_.IsMultiTenant()) {
+      std::cout << "Agenzia: " << tenant_name_ << std::endl;
+    }
+    if (customer_manager_->IsReplica()) {
+      std::cout << "(Replica in sola lettura)" << std::endl;
+    }
+    ShowMenu();
+
+    const std::string action = PromptUserInput("Cosa vuoi fare? ", true);
+    const ECommand selected_action =
+        to_enum<App::ECommand, App::ECommand::ADD_CUSTOMER,
+                App::ECommand::SHOW_APPOINTMENTS>(action);
+
+    clear_screen();
+
+    if (input_closed_) {
+      break;
+    }
+
+    if (!customer_manager_->Refresh()) {
+      std::cout << "Impossibile aggiornare la replica." << std::endl;
+    }
+
+    if (selected_action == ECommand::INVALID ||
+        commands_.count(selected_action) == 0) {
+      std::cout << "L'azione scelta non è valida." << std::endl << std::endl;
+      continue;
+    }
+
+    if (selected_action == ECommand::EXIT) {
+      break;
+    }
+
+    Execute(commands_[selected_action], selected_action, ESubCommand::INVALID);
+    std::cout << std::endl;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+std::string App::PromptUserInput(const char* message, const bool choice) const {
+  std::cout << message;
+
+  const TraceSpan trace_span{"app", "App::PromptUserInput"};
+  std::string input{};
+  if (input_closed_ || !input_source_(choice, input)) {
+    input_closed_ = true;
+    return {};
+  }
+
+  if (session_recorder_) {
+    session_recorder_->Record(static_cast<std::uint32_t>(current_command_),
+                              static_cast<std::uint32_t>(current_sub_command_),
+                              choice, input);
+  }
+
+  return input;
+}
+
+void App::Execute(const CommandData& command_data, const ECommand command,
+                  const ESubCommand sub_command) {
+  current_command_ = command;
+  current_sub_command_ = sub_command;
+
+  const auto start = std::chrono::steady_clock::now();
+  {
+    // Includes the time spent waiting for input, see App::PromptUserInput
+    const TraceSpan trace_span{"app", trace_name(command, sub_command)};
+    command_data.callback_();
+  }
+  const auto duration = std::chrono::steady_clock::now() - start;
+
+  if (command_observer_) {
+    command_observer_(command, sub_command, duration);
+  }
+
+  current_command_ = sub_command == ESubCommand::INVALID ? ECommand::INVALID
+                                                         : command;
+  current_sub_command_ = ESubCommand::INVALID;
+
+  // Between commands, so that writing the trace never delays one
+  Tracer::Flush();
+}
+
+void App::ShowMenu() {
+  for (const auto& command : commands_) {
+    std::cout << static_cast<std::uint32_t>(command.first) << ") "
+              << command.second.description_ << std::endl;
+  }
+}
+
+void App::ShowSubMenu(ECommand cmd) {
+  for (const auto& command : commands_[cmd].submenu_) {
+    std::cout << static_cast<std::uint32_t>(command.first) << ") "
+              << command.second.description_ << std::endl;
+  }
+}
+
+void App::AddClient() {
+  std::cout << "Aggiungi nuovo cliente" << std::endl;
+  std::cout << "Compila i campi di seguito oppure lasciali vuoti per tornare "
+               "indietro."
+            << std::endl;
+  const std::string name = PromptUserInput("Nome: ");
+  const std::string surname = PromptUserInput("Cognome: ");
+
+  if (name.empty() && surname.empty()) {
+    return;
+  } else if (name.empty() || surname.empty()) {
+    clear_screen();
+
+    std::cout << "Per aggiungere un cliente devi compilare entrambi i campi!"
+              << std::endl
+              << std::endl;
+    AddClient();
+    return;
+  }
+
+  if (customer_manager_->AddCustomer(name, surname)) {
+    std::cout << "Cliente aggiunto." << std::endl;
+  } else {
+    std::cout << "Il cliente esiste già!" << std::endl;
+  }
+}
+
+void App::ShowClients() const {
+  std::cout << "Visualizza tutti i clienti" << std::endl;
+
+  ECustomerOrder order{ECustomerOrder::ID};
+  Customer::ID last_shown_id{INVALID_CUSTOMER_ID};
+  bool show_page = true;
+  while (true) {
+    const bool first_page = last_shown_id == INVALID_CUSTOMER_ID;
+    if (show_page && customer_manager_->PrintCustomerPage(
+                         order, last_shown_id, CUSTOMERS_PAGE_SIZE) == 0U) {
+      if (first_page && order == ECustomerOrder::SCORE) {
+        std::cout << "Nessun cliente ha un punteggio." << std::endl;
+      } else if (first_page) {
+        std::cout << "Non ci sono clienti." << std::endl;
+        return;
+      } else {
+        std::cout << "Non ci sono altri clienti." << std::endl;
+      }
+    }
+    show_page = true;
+
+    std::cout << std::endl
+              << "Ordina per: 1) ID, 2) Cognome e nome, 3) Ultima "
+                 "interazione, 4) Punteggio"
+              << std::endl;
+    const std::string choice = PromptUserInput(
+        "[S] per la pagina successiva, invio per tornare alla schermata "
+        "iniziale. ");
+
+    if (choice.empty()) {
+      return;
+    }
+
+    if (choice[0] == 's' || choice[0] == 'S') {
+      std::cout << std::endl;
+      continue;
+    }
+
+    const ECustomerOrder selected_order =
+        to_enum<ECustomerOrder, ECustomerOrder::ID, ECustomerOrder::SCORE>(
+            choice);
+    if (selected_order == ECustomerOrder::INVALID) {
+      std::cout << "L'azione scelta non è valida." << std::endl;
+      show_page = false;
+      continue;
+    }
+
+    clear_screen();
+    order = selected_order;
+    last_shown_id = INVALID_CUSTOMER_ID;
+  }
+}
+
+void App::EditClient() {
+  std::cout << "Modifica di un cliente" << std::endl;
+  Customer::ID selected_customer_id{};
+
+  if (!FindAndSelectClient(selected_customer_id)) {
+    std::cout << "Operazione annullata." << std::endl;
+    return;
+  }
+
+  std::cout << std::endl;
+
+  const auto& selected_customer =
+      customer_manager_->GetCustomer(selected_customer_id);
+
+  std::cout << "Utente selezionato: " << std::endl;
+  selected_customer.PrintInfo();
+  std::cout << std::endl;
+
+  std::cout << "Compila i campi di seguito, o lasciali vuoti per non apportare "
+               "modifiche:"
+            << std::endl;
+  const std::string new_name = PromptUserInput("Nome: ");
+  const std::string new_surname = PromptUserInput("Cognome: ");
+
+  if (new_name.empty() && new_surname.empty()) {
+    std::cout << "Non sono state apportate modifiche al cliente selezionato."
+              << std::endl;
+    return;
+  }
+
+  if (customer_manager_->UpdateClientInfo(
+          selected_customer_id,
+          new_name.empty() ? selected_customer.name_.GetString() : new_name,
+          new_surname.empty() ? selected_customer.surname_.GetString()
+                              : new_surname)) {
+    std::cout << "Modifiche apportate con successo." << std::endl;
+  } else {
+    std::cout << "Si è verificato un errore durante il salvataggio."
+              << std::endl;
+  }
+}
+
+void App::RemoveClient() {
+  std::cout << "Rimuovi un cliente" << std::endl;
+  Customer::ID selected_customer_id{};
+
+  if (!FindAndSelectClient(selected_customer_id)) {
+    std::cout << "Operazione annullata." << std::endl;
+    return;
+  }
+
+  std::cout << "Sei sicuro di voler rimuovere il cliente selezionato?"
+            << std::endl;
+  std::string confirm =
+      PromptUserInput("L'operazione sarà irreversibile! [Si/No] ");
+
+  if (!confirm.empty() && (confirm[0] == 's' || confirm[0] == 'S')) {
+    if (!customer_manager_->RemoveCustomer(selected_customer_id)) {
+      std::cout << "Impossibile rimuovere il cliente selezionato." << std::endl;
+      return;
+    } else {
+      std::cout << "Cliente rimosso." << std::endl;
+    }
+  } else {
+    std::cout << "Operazione annullata." << std::endl;
+  }
+}
+
+void App::SearchClient() {
+  std::cout << "Cerca un cliente" << std::endl;
+  Customer::ID selected_customer_id{};
+  if (!FindAndSelectClient(selected_customer_id, true)) {
+    return;
+  }
+
+  const auto& customer = customer_manager_->GetCustomer(selected_customer_id);
+  customer.PrintInfo();
+  std::cout << std::endl;
+}
+
+void App::ManageClientInteractions() {
+  while (true) {
+    // The selected client may have been removed by the primary meanwhile
+    if (!customer_manager_->Refresh() ||
+        !customer_manager_->HasCustomer(managed_customer_id_)) {
+      managed_customer_id_ = 0;
+    }
+
+    if (managed_customer_id_ == 0) {
+      std::cout << "Prima di procedere è necessario selezionare un Cliente da "
+                   "gestire."
+                << std::endl;
+
+      if (!FindAndSelectClient(managed_customer_id_)) {
+        std::cout
+            << "Devi selezionare un cliente per poter gestire le interazioni."
+            << std::endl;
+        return;
+      }
+
+      clear_screen();
+    }
+
+    std::cout << "Gestione delle Interazioni" << std::endl;
+
+    const auto& selected_customer =
+        customer_manager_->GetCustomer(managed_customer_id_);
+    std::cout << "Cliente selezionato: " << std::endl;
+    selected_customer.PrintInfo();
+    if (!customer_manager_->PrintCustomerActivity(managed_customer_id_)) {
+      std::cout << "Nessuna interazione registrata." << std::endl;
+    }
+    std::cout << std::endl;
+
+    ShowSubMenu(ECommand::MANAGE_CUSTOMER_INTERACTIONS);
+
+    const std::string action = PromptUserInput("Cosa vuoi fare? ", true);
+    const ESubCommand selected_action =
+        to_enum<App::ESubCommand, App::ESubCommand::CLIENT_INTERACTIONS_ADD,
+                App::ESubCommand::RETURN>(action);
+
+    clear_screen();
+
+    if (input_closed_) {
+      break;
+    }
+
+    auto& submenu = commands_[ECommand::MANAGE_CUSTOMER_INTERACTIONS].submenu_;
+    if (selected_action == ESubCommand::INVALID ||
+        submenu.count(selected_action) == 0) {
+      std::cout << "L'azione scelta non è valida." << std::endl << std::endl;
+      continue;
+    }
+
+    if (selected_action == ESubCommand::RETURN) {
+      break;
+    }
+
+    Execute(submenu[selected_action], ECommand::MANAGE_CUSTOMER_INTERACTIONS,
+            selected_action);
+    std::cout << std::endl;
+  }
+}
+
+void App::AddClientInteraction() {
+  std::cout << "Aggiungi nuova interazione" << std::endl;
+  std::cout << "Lasciare entrambi i campi vuoti per tornare al menu."
+            << std::endl;
+  std::string when =
+      PromptUserInput("Data dell'interazione (ad es.: 15/12/2024 16:15) ");
+
+  if (input_closed_) {
+    return;
+  }
+
+  if (!utilities::is_valid_date(when, DATE_FORMAT) ||
+      when.find(INTERACTION_DETAILS_DELIMITER) != std::string::npos) {
+    clear_screen();
+
+    std::cout << "La data inserita non è valida!" << std::endl << std::endl;
+    AddClientInteraction();
+    return;
+  }
+
+  std::string what = PromptUserInput("Breve descrizione: ");
+  std::cout << std::endl;
+
+  utilities::remove_chars_from_str(what, "\t\r\n", ' ');
+
+  if (when.empty() && what.empty()) {
+    return;
+  } else if (when.empty() || what.empty()) {
+    clear_screen();
+
+    std::cout << "Entrambi i campi sono obbligatori!" << std::endl;
+    AddClientInteraction();
+    return;
+  }
+
+  InteractionDetails details{};
+  if (!PromptInteractionDetails(details)) {
+    clear_screen();
+
+    std::cout << "Il tipo di interazione non è valido!" << std::endl;
+    AddClientInteraction();
+    return;
+  }
+
+  std::string confirm = PromptUserInput("Salvare l'interazione? [Si/No] ");
+  if (!confirm.empty() && (confirm[0] == 's' || confirm[0] == 'S')) {
+    if (customer_manager_->AddInteraction(
+            managed_customer_id_, Interaction::FormatWhen(when, details),
+            what)) {
+      std::cout << "Interazione aggiunta con successo." << std::endl;
+    } else {
+      std::cout << "Si è verificato un errore e non è stato possibile "
+                   "completare la richiesta."
+                << std::endl;
+    }
+  }
+}
+
+bool App::PromptInteractionDetails(InteractionDetails& details) const {
+  details.kind_ = to_enum<EInteractionKind, EInteractionKind::APPOINTMENT,
+                          EInteractionKind::NOTE>(PromptUserInput(
+      "Tipo di interazione: 1) Appuntamento, 2) Contratto, 3) Nota "));
+  if (details.kind_ != EInteractionKind::CONTRACT) {
+    return details.kind_ != EInteractionKind::INVALID;
+  }
+
+  details.policy_ = to_enum<EPolicyType, EPolicyType::CAR, EPolicyType::OTHER>(
+      PromptUserInput(
+          "Polizza: 1) Auto, 2) Casa, 3) Vita, 4) Salute, 5) Altro "));
+  return details.policy_ != EPolicyType::INVALID &&
+         to_cents(PromptUserInput("Premio annuo in euro (ad es.: 350,50): "),
+                  details.premium_cents_) &&
+         utilities::try_convert(PromptUserInput("Durata in mesi: "),
+                                details.duration_months_);
+}
+
+void App::SearchClientInteractions() {
+  std::cout << "Cerca interazione" << std::endl;
+  std::cout << "Inserisci le date nell'intervallo in cui cercare. (Formato: "
+               "Giorno/Mese/Anno)"
+            << std::endl;
+  std::string from_date = PromptUserInput("Dal: ");
+  std::string to_date = PromptUserInput("Al: ");
+
+  std::time_t from_timestamp{};
+  std::time_t to_timestamp{};
+  if (!utilities::to_timestamp(from_date, "%d/%m/%Y", from_timestamp) ||
+      !utilities::to_timestamp(to_date, "%d/%m/%Y", to_timestamp)) {
+    std::cout << "Le date inserite non sono nel formato corretto." << std::endl;
+    return;
+  }
+
+  if (from_timestamp > to_timestamp) {
+    std::swap(from_timestamp, to_timestamp);
+  }
+
+  std::cout << std::endl;
+  if (!customer_manager_->PrintCustomerInteractions(
+          managed_customer_id_, from_timestamp, to_timestamp)) {
+    std::cout << "Non sono state trovate interazioni nel periodo specificato."
+              << std::endl;
+  }
+
+  PromptUserInput("Premere invio per tornare alla schermata iniziale.");
+}
+
+void App::ShowClientInteractions() {
+  std::cout << "Visualizza interazioni" << std::endl;
+  // The whole history, including the archived interactions
+  if (!customer_manager_->PrintCustomerInteractions(
+          managed_customer_id_, std::numeric_limits<std::time_t>::min(),
+          std::numeric_limits<std::time_t>::max())) {
+    std::cout << "Non ci sono interazioni registrate per l'attuale cliente."
+              << std::endl;
+    return;
+  }
+
+  PromptUserInput("Premere invio per tornare alla schermata iniziale.");
+}
+
+void App::ReselectClientForInteractions() { managed_customer_id_ = 0; }
+
+void App::ShowAppointments() const {
+  std::cout << "Appuntamenti di oggi e dei prossimi " << APPOINTMENT_DAYS
+            << " giorni" << std::endl;
+
+  // From midnight, to list the ones already held today too
+  const std::time_t now = std::time(nullptr);
+  std::tm date_time{};
+  localtime_r(&now, &date_time);
+  date_time.tm_hour = 0;
+  date_time.tm_min = 0;
+  date_time.tm_sec = 0;
+  date_time.tm_isdst = -1;
+  const std::time_t from_timestamp = std::mktime(&date_time);
+  date_time.tm_mday += APPOINTMENT_DAYS + 1;
+  date_time.tm_isdst = -1;
+  const std::time_t to_timestamp = std::mktime(&date_time) - 1;
+
+  std::vector<Appointment> appointments{};
+  customer_manager_->GetAppointments(from_timestamp, to_timestamp,
+                                     MAX_APPOINTMENTS_SHOWN, appointments);
+  if (appointments.empty()) {
+    std::cout << "Non ci sono appuntamenti in programma." << std::endl;
+    return;
+  }
+
+  for (const auto& appointment : appointments) {
+    std::cout << appointment.interaction_->GetDate() << "\t";
+    if (customer_manager_->HasCustomer(appointment.customer_id_)) {
+      const Customer& customer =
+          customer_manager_->GetCustomer(appointment.customer_id_);
+      std::cout << customer.id_ << ") " << customer.name_ << " "
+                << customer.surname_;
+    }
+    std::cout << "\t" << appointment.interaction_->what_ << std::endl;
+  }
+  if (appointments.size() == MAX_APPOINTMENTS_SHOWN) {
+    std::cout << "Sono mostrati solo i primi " << MAX_APPOINTMENTS_SHOWN
+              << " appuntamenti." << std::endl;
+  }
+
+  PromptUserInput("Premere invio per tornare alla schermata iniziale.");
+}
+
+void App::SwitchTenant() {
+  std::cout << "Scegli l'agenzia" << std::endl;
+
+  const auto tenants = tenant_manager_.ListTenants();
+  if (tenants.empty()) {
+    std::cout << "Non ci sono ancora agenzie, indica il nome di quella da "
+                 "creare."
+              << std::endl;
+  }
+  for (const auto& tenant : tenants) {
+    std::cout << " - " << tenant
+              << (tenant == tenant_name_ ? " (selezionata)" : "") << std::endl;
+  }
+
+  const std::string name = PromptUserInput("Nome dell'agenzia: ");
+  if (name.empty()) {
+    return;
+  }
+
+  clear_screen();
+  if (!SelectTenant(name)) {
+    std::cout << "Il nome dell'agenzia non è valido." << std::endl
+              << std::endl;
+  }
+}
+
+bool App::SelectTenant(const std::string& name) {
+  if (!TenantManager::IsValidName(name)) {
+    return false;
+  }
+
+  // Released first, so that it can be closed if memory is short
+  if (customer_manager_) {
+    customer_manager_->StopReminders();
+  }
+  customer_manager_.reset();
+  customer_manager_ = tenant_manager_.Acquire(name);
+  tenant_name_ = name;
+  managed_customer_id_ = 0;
+  StartReminders();
+  return true;
+}
+
+void App::StartReminders() {
+  if (reminder_lead_time_ == 0 || !customer_manager_) {
+    return;
+  }
+
+  // Runs on the reminder thread: only the appointment itself is safe to
+  // read, the customers may be changing meanwhile
+  customer_manager_->StartReminders(
+      reminder_lead_time_, [](const Appointment& appointment) {
+        std::ostringstream reminder{};
+        reminder << std::endl
+                 << "Promemoria: appuntamento del "
+                 << appointment.interaction_->GetDate() << " con il cliente "
+                 << appointment.customer_id_ << " - "
+                 << appointment.interaction_->what_ << std::endl;
+        std::cout << reminder.str() << std::flush;
+      });
+}
+
+bool App::FindAndSelectClient(Customer::ID& output_id,
+                              const bool no_selection) const {
+  std::cout << "Puoi specificare uno o più campi per affinare la ricerca "
+            << std::endl;
+  std::string id = PromptUserInput("ID Cliente (Opzionale): ");
+  std::string name{};
+  std::string surname{};
+
+  if (id.empty()) {
+    name = PromptUserInput("Nome (Opzionale): ");
+    surname = PromptUserInput("Cognome (Opzionale): ");
+  }
+
+  std::vector<Customer::ID> found_customers{};
+
+  if (customer_manager_->FindCustomers(id, name, surname, found_customers)) {
+    if (found_customers.size() > 1) {
+      std::cout << "Trovate " << found_customers.size() << " corrispondenze."
+                << std::endl;
+      customer_manager_->PrintCustomersByID(found_customers);
+
+      if (no_selection) {
+        return false;
+      }
+
+      const std::string client_id = PromptUserInput(
+          "Seleziona un ID Cliente o digita 'annulla' per tornare al "
+          "menu principale: ");
+
+      if (client_id == "annulla") {
+        return false;
+      } else if (!utilities::try_convert(client_id, output_id) ||
+                 !utilities::is_in_vector(found_customers, output_id)) {
+        std::cout << "ID Cliente non valido. Si prega di selezionare un ID "
+                     "presente nelle corrispondenze della ricerca."
+                  << std::endl;
+
+        clear_screen();
+        return FindAndSelectClient(output_id);
+      }
+    } else {
+      output_id = found_customers[0];
+    }
+
+    return true;
+  }
+
+  std::cout << std::endl
+            << "La ricerca non ha prodotto alcun risultato." << std::endl;
+  return false;
 }
\ No newline at end of file
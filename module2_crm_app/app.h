@@ -1,129 +1,215 @@
-#ifndef __APP_H__
-#define __APP_H__
-
-#include <cstdint>
-#include <functional>
-#include <map>
-
-#include "crm.h"
-
-/// @brief Handles all the user-input logic through terminal
-class App {
- public:
-  /// @brief Default path where the database is stored
-  const char* const DATABASE_PATH = "./data.tsv";
-
-  /// @brief Defines a list of commands for the Terminal App
-  enum class ECommand : std::uint32_t {
-    ADD_CUSTOMER = 1,
-    SHOW_CUSTOMERS,
-    EDIT_CUSTOMER,
-    REMOVE_CUSTOMER,
-    SEARCH_CUSTOMER,
-    MANAGE_CUSTOMER_INTERACTIONS,
-    EXIT,
-
-    INVALID = UINT32_MAX,
-  };
-
-  /// @brief SubCommands for certain main commands of ECommand
-  enum class ESubCommand : std::uint32_t {
-    CLIENT_INTERACTIONS_ADD = 1,
-    CLIENT_INTERACTIONS_SHOW,
-    CLIENT_INTERACTIONS_SEARCH,
-    CLIENT_INTERACTIONS_RESELECT_CLIENT,
-
-    RETURN,
-
-    INVALID = UINT32_MAX,
-  };
-
-  // No move and copy constructors/operators
-  App(const App&) = delete;
-  App& operator=(const App&) = delete;
-  App(App&&) = delete;
-  App& operator=(App&&) = delete;
-
-  App();
-
-  /// @brief Entrypoint of our App class
-  /// @return Returns a status code
-  std::int32_t Run();
-
- private:
-  /// @brief Displays the main menu
-  void ShowMenu();
-
-  /// @brief Displays the submenu
-  /// @param cmd Main command whose submenu shall be displayed
-  void ShowSubMenu(ECommand cmd);
-
-  /// @brief Starts the guided procedure to add a new client
-  void AddClient();
-
-  /// @brief Shows all currently saved clients
-  void ShowClients() const;
-
-  /// @brief Starts the guided procedure to edit existing clients
-  void EditClient();
-
-  /// @brief Starts the guided procedure to remove existing clients
-  void RemoveClient();
-
-  /// @brief Starts the guided procedure to search for clients
-  void SearchClient();
-
-  /// @brief Starts the guided procedure to manage clients' interactions
-  void ManageClientInteractions();
-
-  /// @brief Starts the guided procedure to add new interactions
-  /// to the selected client
-  void AddClientInteraction();
-
-  /// @brief Starts the guided procedure to search for interactions
-  /// on the selected client in a user-defined time interval
-  void SearchClientInteractions();
-
-  /// @brief Shows all interactions of the currently selected client
-  void ShowClientInteractions();
-
-  /// @brief Resets the currently selected client and returns to the
-  /// interactions management menu
-  void ReselectClientForInteractions();
-
-  /// @brief Starts the guided procedure to find and select clients
-  /// based on ID, Name and/or Surname
-  /// @param output_id Selected client id
-  /// @param no_selection Whether to guide the user through the selection
-  /// of a client when the search yields more than 1 result
-  /// @return True if client successfully selected, false otherwise
-  bool FindAndSelectClient(Customer::ID& output_id,
-                           const bool no_selection = false) const;
-
-  /// @brief Manager class that directly interfaces the database
-  CRM customer_manager_;
-
-  /// @brief Helper structure to store menu options
-  struct CommandData {
-    const char* description_;
-    std::function<void()> callback_;
-    std::map<ESubCommand, CommandData> submenu_;
-
-    CommandData() = default;
-    CommandData(const char* desc, const std::function<void()>& cb)
-        : description_{desc}, callback_{cb}, submenu_{} {}
-
-    void AddSubMenu(ESubCommand cmd, const char* desc,
-                    const std::function<void()>& cb) {
-      submenu_[cmd] = CommandData{desc, cb};
-    }
-  };
-  /// @brief Stores all available commands and corresponding descriptions
-  /// and callbacks for dynamic menu generation
-  std::map<ECommand, CommandData> commands_;
-
-  /// @brief Client ID selected during Interaction management
-  Customer::ID managed_customer_id_;
-};
-
-#endif  // __APP_H__
+#ifndef __APP_H__
+#define __APP_H__
+
+#include <chrono>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "config.h"
+#include "crm.h"
+#include "session.h"
+#include "tenant_manager.h"
+
+/// @brief Handles all the user-input logic through terminal
+class App {
+ public:
+  /// @brief Defines a list of commands for the Terminal App
+  enum class ECommand : std::uint32_t {
+    ADD_CUSTOMER = 1,
+    SHOW_CUSTOMERS,
+    EDIT_CUSTOMER,
+    REMOVE_CUSTOMER,
+    SEARCH_CUSTOMER,
+    MANAGE_CUSTOMER_INTERACTIONS,
+    EXIT,
+    SWITCH_TENANT,
+    SHOW_APPOINTMENTS,
+
+    INVALID = UINT32_MAX,
+  };
+
+  /// @brief SubCommands for certain main commands of ECommand
+  enum class ESubCommand : std::uint32_t {
+    CLIENT_INTERACTIONS_ADD = 1,
+    CLIENT_INTERACTIONS_SHOW,
+    CLIENT_INTERACTIONS_SEARCH,
+    CLIENT_INTERACTIONS_RESELECT_CLIENT,
+
+    RETURN,
+
+    INVALID = UINT32_MAX,
+  };
+
+  /// @brief Provides the answers to the App prompts
+  /// @param choice Whether the answer selects a menu entry
+  /// @param input Where to store the answer
+  /// @return False once no more input is available
+  using InputSource = std::function<bool(const bool choice, std::string& input)>;
+
+  /// @brief Notified every time a command or subcommand completes
+  using CommandObserver =
+      std::function<void(const ECommand command, const ESubCommand sub_command,
+                         const std::chrono::nanoseconds duration)>;
+
+  // No move and copy constructors/operators
+  App(const App&) = delete;
+  App& operator=(const App&) = delete;
+  App(App&&) = delete;
+  App& operator=(App&&) = delete;
+
+  /// @brief Sets up the App
+  /// @param config Runtime options
+  /// @param input_source Where to read answers from, the terminal by default
+  /// @param command_observer Optional callback timing every executed command
+  explicit App(const Config& config, const InputSource& input_source = {},
+               const CommandObserver& command_observer = {});
+
+  /// @brief Entrypoint of our App class
+  /// @return Returns a status code
+  std::int32_t Run();
+
+ private:
+  /// @brief Prompts the user for an answer, recording it if requested
+  /// @param message A prompt message to display
+  /// @param choice Whether the answer selects a menu entry
+  /// @return User input, empty once no more input is available
+  std::string PromptUserInput(const char* message,
+                              const bool choice = false) const;
+
+  /// @brief Displays the main menu
+  void ShowMenu();
+
+  /// @brief Displays the submenu
+  /// @param cmd Main command whose submenu shall be displayed
+  void ShowSubMenu(ECommand cmd);
+
+  /// @brief Starts the guided procedure to add a new client
+  void AddClient();
+
+  /// @brief Shows all currently saved clients
+  void ShowClients() const;
+
+  /// @brief Starts the guided procedure to edit existing clients
+  void EditClient();
+
+  /// @brief Starts the guided procedure to remove existing clients
+  void RemoveClient();
+
+  /// @brief Starts the guided procedure to search for clients
+  void SearchClient();
+
+  /// @brief Starts the guided procedure to manage clients' interactions
+  void ManageClientInteractions();
+
+  /// @brief Starts the guided procedure to add new interactions
+  /// to the selected client
+  void AddClientInteraction();
+
+  /// @brief Asks the kind of a new interaction and, for contracts, the
+  /// details of the policy
+  /// @param details Where to store the answers
+  /// @return False if an answer is not valid
+  bool PromptInteractionDetails(InteractionDetails& details) const;
+
+  /// @brief Starts the guided procedure to search for interactions
+  /// on the selected client in a user-defined time interval
+  void SearchClientInteractions();
+
+  /// @brief Shows all interactions of the currently selected client
+  void ShowClientInteractions();
+
+  /// @brief Resets the currently selected client and returns to the
+  /// interactions management menu
+  void ReselectClientForInteractions();
+
+  /// @brief Shows the appointments of all customers from today to a week
+  /// from now
+  void ShowAppointments() const;
+
+  /// @brief Starts the guided procedure to choose the tenant to work on
+  void SwitchTenant();
+
+  /// @brief Makes a tenant the one the commands work on
+  /// @param name Tenant name
+  /// @return False if the name is not valid
+  bool SelectTenant(const std::string& name);
+
+  /// @brief Starts reminding of the appointments of the selected tenant, if
+  /// reminders are enabled
+  void StartReminders();
+
+  /// @brief Starts the guided procedure to find and select clients
+  /// based on ID, Name and/or Surname
+  /// @param output_id Selected client id
+  /// @param no_selection Whether to guide the user through the selection
+  /// of a client when the search yields more than 1 result
+  /// @return True if client successfully selected, false otherwise
+  bool FindAndSelectClient(Customer::ID& output_id,
+                           const bool no_selection = false) const;
+
+  /// @brief Hosts the databases of the tenants
+  TenantManager tenant_manager_;
+
+  /// @brief Name of the tenant the commands work on
+  std::string tenant_name_;
+
+  /// @brief Manager class that directly interfaces the database of the
+  /// selected tenant, nullptr until one is selected
+  std::shared_ptr<CRM> customer_manager_;
+
+  /// @brief Seconds before an appointment its reminder is printed, 0 to
+  /// print none
+  std::time_t reminder_lead_time_;
+
+  /// @brief Helper structure to store menu options
+  struct CommandData {
+    const char* description_;
+    std::function<void()> callback_;
+    std::map<ESubCommand, CommandData> submenu_;
+
+    CommandData() = default;
+    CommandData(const char* desc, const std::function<void()>& cb)
+        : description_{desc}, callback_{cb}, submenu_{} {}
+
+    void AddSubMenu(ESubCommand cmd, const char* desc,
+                    const std::function<void()>& cb) {
+      submenu_[cmd] = CommandData{desc, cb};
+    }
+  };
+
+  /// @brief Runs the callback of a command, timing it for the observer
+  /// @param command_data Command to run
+  /// @param command Main command
+  /// @param sub_command Subcommand, INVALID for main commands
+  void Execute(const CommandData& command_data, const ECommand command,
+               const ESubCommand sub_command);
+
+  /// @brief Stores all available commands and corresponding descriptions
+  /// and callbacks for dynamic menu generation
+  std::map<ECommand, CommandData> commands_;
+
+  /// @brief Client ID selected during Interaction management
+  Customer::ID managed_customer_id_;
+
+  /// @brief Where answers to prompts come from
+  InputSource input_source_;
+
+  /// @brief Set once the input source has no more answers
+  mutable bool input_closed_;
+
+  /// @brief Notified about every executed command, if set
+  CommandObserver command_observer_;
+
+  /// @brief Records the session to a trace file, if enabled
+  std::unique_ptr<SessionRecorder> session_recorder_;
+
+  /// @brief Command and subcommand currently being executed
+  ECommand current_command_;
+  ESubCommand current_sub_command_;
+};
+
+#endif  // __APP_H__
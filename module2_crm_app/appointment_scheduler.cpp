@@ -0,0 +1,263 @@
+#include "appointment_scheduler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <functional>
+#include <limits>
+
+#include "memory_report.h"
+#include "tracer.h"
+
+namespace {
+
+/// @brief How long past appointments are kept, so that the agenda of the
+/// day still lists the ones already held
+constexpr std::time_t PAST_APPOINTMENTS_KEPT{24 * 60 * 60};
+
+/// @brief Longest sleep of the reminder thread. Bounds the delay of the
+/// reminders when the clock does not follow the system one.
+constexpr std::time_t MAX_REMINDER_WAIT{60};
+
+/// @brief Reads the system clock
+/// @return Current time as a UNIX Timestamp
+std::time_t system_clock() { return std::time(nullptr); }
+
+}  // namespace
+
+bool AppointmentScheduler::EarlierAppointment::operator()(
+    const Appointment& left, const Appointment& right) const {
+  if (left.timestamp_ != right.timestamp_) {
+    return left.timestamp_ < right.timestamp_;
+  }
+  if (left.customer_id_ != right.customer_id_) {
+    return left.customer_id_ < right.customer_id_;
+  }
+  return std::less<const Interaction*>{}(left.interaction_.get(),
+                                         right.interaction_.get());
+}
+
+AppointmentScheduler::AppointmentScheduler(const Clock& clock)
+    : clock_{clock ? clock : system_clock},
+      mutex_{},
+      wake_up_{},
+      appointments_{},
+      reminders_{},
+      lead_time_{},
+      reminded_until_{},
+      callback_{},
+      running_{false},
+      stopping_{false},
+      thread_{} {}
+
+AppointmentScheduler::~AppointmentScheduler() { StopReminders(); }
+
+void AppointmentScheduler::Add(
+    const Customer::ID customer_id,
+    const std::shared_ptr<Interaction>& interaction) {
+  const std::time_t now = clock_();
+  if (!IsScheduled(*interaction, GetCutoff(now))) {
+    return;
+  }
+
+  const Appointment appointment{customer_id, interaction};
+  std::lock_guard<std::mutex> lock{mutex_};
+  DropPast(now);
+  appointments_.insert(appointment);
+
+  // Appointments already held need no reminder
+  if (!running_ || appointment.timestamp_ < now) {
+    return;
+  }
+  reminders_.push_back(appointment);
+  std::push_heap(reminders_.begin(), reminders_.end(), LaterReminder{});
+  if (reminders_.front().interaction_ == appointment.interaction_) {
+    wake_up_.notify_one();
+  }
+}
+
+void AppointmentScheduler::RemoveCustomer(const Customer& customer) {
+  std::lock_guard<std::mutex> lock{mutex_};
+  if (appointments_.empty()) {
+    return;
+  }
+
+  // Their reminders are discarded when they reach the top of the heap
+  for (const auto& interaction : customer.customer_interactions_) {
+    if (interaction->details_.kind_ == EInteractionKind::APPOINTMENT) {
+      appointments_.erase(Appointment{customer.id_, interaction});
+    }
+  }
+}
+
+void AppointmentScheduler::Rebuild(const CustomerMap& customers) {
+  const TraceSpan trace_span{"database", "AppointmentScheduler::Rebuild"};
+  const std::time_t now = clock_();
+  const std::time_t cutoff_timestamp = GetCutoff(now);
+
+  std::vector<Appointment> appointments{};
+  for (const auto& customer : customers) {
+    for (const auto& interaction : customer.second.customer_interactions_) {
+      if (IsScheduled(*interaction, cutoff_timestamp)) {
+        appointments.emplace_back(customer.first, interaction);
+      }
+    }
+  }
+  std::sort(appointments.begin(), appointments.end(), EarlierAppointment{});
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  appointments_.clear();
+  appointments_.insert(appointments.cbegin(), appointments.cend());
+
+  // Only the reminders sent already are skipped: the ones due since the
+  // last check are still queued, and sent as the thread wakes up
+  reminders_.clear();
+  if (running_) {
+    QueueReminders(reminded_until_ + 1);
+    wake_up_.notify_one();
+  }
+}
+
+void AppointmentScheduler::GetAppointments(
+    const std::time_t from_timestamp, const std::time_t to_timestamp,
+    const std::size_t max_count, std::vector<Appointment>& appointments) const {
+  appointments.clear();
+  Appointment first{};
+  first.timestamp_ = from_timestamp;
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  for (auto it = appointments_.lower_bound(first);
+       it != appointments_.cend() && it->timestamp_ <= to_timestamp &&
+       appointments.size() < max_count;
+       ++it) {
+    appointments.push_back(*it);
+  }
+}
+
+void AppointmentScheduler::GetNextAppointments(
+    const std::size_t count, std::vector<Appointment>& appointments) const {
+  GetAppointments(clock_(), std::numeric_limits<std::time_t>::max(), count,
+                  appointments);
+}
+
+void AppointmentScheduler::StartReminders(const std::time_t lead_time,
+                                          const ReminderCallback& callback,
+                                          const bool background) {
+  StopReminders();
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  lead_time_ = lead_time;
+  callback_ = callback;
+  running_ = true;
+  stopping_ = false;
+  const std::time_t now = clock_();
+  reminded_until_ = now - 1;
+  QueueReminders(now);
+  if (background) {
+    thread_ = std::thread{&AppointmentScheduler::Run, this};
+  }
+}
+
+void AppointmentScheduler::StopReminders() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    if (!running_) {
+      return;
+    }
+    stopping_ = true;
+  }
+  wake_up_.notify_one();
+  if (thread_.joinable()) {
+    thread_.join();
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  running_ = false;
+  reminders_.clear();
+  reminders_.shrink_to_fit();
+  callback_ = {};
+}
+
+std::size_t AppointmentScheduler::CheckReminders() {
+  const std::time_t now = clock_();
+  std::vector<Appointment> due{};
+  ReminderCallback callback{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    while (!reminders_.empty() &&
+           reminders_.front().timestamp_ - lead_time_ <= now) {
+      std::pop_heap(reminders_.begin(), reminders_.end(), LaterReminder{});
+      if (appointments_.count(reminders_.back()) > 0U) {
+        due.push_back(std::move(reminders_.back()));
+      }
+      reminders_.pop_back();
+    }
+    reminded_until_ = std::max(reminded_until_, now + lead_time_);
+
+    DropPast(now);
+    callback = callback_;
+  }
+
+  if (callback) {
+    for (const auto& appointment : due) {
+      callback(appointment);
+    }
+  }
+  return due.size();
+}
+
+std::size_t AppointmentScheduler::GetSize() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return appointments_.size();
+}
+
+std::uint64_t AppointmentScheduler::GetMemoryUsage() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return appointments_.size() * tree_node_size<Appointment>() +
+         vector_buffer_size(reminders_);
+}
+
+void AppointmentScheduler::Run() {
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (!stopping_) {
+    lock.unlock();
+    CheckReminders();
+    lock.lock();
+    if (stopping_) {
+      break;
+    }
+
+    std::time_t wait = MAX_REMINDER_WAIT;
+    if (!reminders_.empty()) {
+      const std::time_t until_due =
+          reminders_.front().timestamp_ - lead_time_ - clock_();
+      wait = std::clamp<std::time_t>(until_due, 1, MAX_REMINDER_WAIT);
+    }
+    wake_up_.wait_for(lock, std::chrono::seconds{wait});
+  }
+}
+
+void AppointmentScheduler::QueueReminders(const std::time_t from_timestamp) {
+  Appointment first{};
+  first.timestamp_ = from_timestamp;
+  reminders_.assign(appointments_.lower_bound(first), appointments_.cend());
+  std::make_heap(reminders_.begin(), reminders_.end(), LaterReminder{});
+}
+
+void AppointmentScheduler::DropPast(const std::time_t now) {
+  const std::time_t cutoff_timestamp = GetCutoff(now);
+  while (!appointments_.empty() &&
+         appointments_.cbegin()->timestamp_ < cutoff_timestamp) {
+    appointments_.erase(appointments_.cbegin());
+  }
+}
+
+std::time_t AppointmentScheduler::GetCutoff(const std::time_t now) {
+  return now - PAST_APPOINTMENTS_KEPT;
+}
+
+bool AppointmentScheduler::IsScheduled(const Interaction& interaction,
+                                       const std::time_t cutoff_timestamp) {
+  return interaction.dated_ &&
+         interaction.details_.kind_ == EInteractionKind::APPOINTMENT &&
+         interaction.timestamp_ >= cutoff_timestamp;
+}
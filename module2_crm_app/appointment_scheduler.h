@@ -0,0 +1,196 @@
+#ifndef __APPOINTMENT_SCHEDULER_H__
+#define __APPOINTMENT_SCHEDULER_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+
+#include "customers.h"
+
+/// @brief An appointment with a customer
+struct Appointment {
+  /// @brief When the appointment is, as a UNIX Timestamp
+  std::time_t timestamp_;
+  /// @brief Customer met
+  Customer::ID customer_id_;
+  /// @brief Interaction recording the appointment
+  std::shared_ptr<const Interaction> interaction_;
+
+  Appointment() : timestamp_{}, customer_id_{INVALID_CUSTOMER_ID} {}
+
+  explicit Appointment(const Customer::ID customer_id,
+                       const std::shared_ptr<const Interaction>& interaction)
+      : timestamp_{interaction->timestamp_},
+        customer_id_{customer_id},
+        interaction_{interaction} {}
+};
+
+/// @brief Keeps the upcoming appointments of all customers ordered by date,
+/// so that the agenda of the next days is read without going through every
+/// customer, and reminds of them from a background thread as they approach.
+///
+/// Appointments are interactions of kind APPOINTMENT dated from one day ago
+/// on: older ones are dropped as time goes by. They are held in a tree
+/// ordered by date, which serves ranges and the next ones due in order.
+/// Reminders still to be sent sit in a min-heap on the same dates, so the
+/// thread only ever looks at the first one; the reminders of removed
+/// appointments are discarded when they reach the top.
+///
+/// Time is read from a clock that can be replaced, e.g. by a simulated one
+/// driving CheckReminders() directly, with no background thread. All methods
+/// may be called from any thread.
+class AppointmentScheduler {
+ public:
+  /// @brief Current time as a UNIX Timestamp
+  using Clock = std::function<std::time_t()>;
+
+  /// @brief Called from the reminder thread for every appointment due
+  using ReminderCallback = std::function<void(const Appointment&)>;
+
+  /// @brief Sets up an empty schedule
+  /// @param clock Where the time is read from, the system clock by default
+  explicit AppointmentScheduler(const Clock& clock = {});
+
+  /// @brief Stops the reminders
+  ~AppointmentScheduler();
+
+  // No move and copy constructors/operators
+  AppointmentScheduler(const AppointmentScheduler&) = delete;
+  AppointmentScheduler& operator=(const AppointmentScheduler&) = delete;
+  AppointmentScheduler(AppointmentScheduler&&) = delete;
+  AppointmentScheduler& operator=(AppointmentScheduler&&) = delete;
+
+  /// @brief Schedules an interaction, if it is an appointment recent enough
+  /// @param customer_id Customer of the interaction
+  /// @param interaction Interaction just added
+  void Add(const Customer::ID customer_id,
+           const std::shared_ptr<Interaction>& interaction);
+
+  /// @brief Drops all appointments of a customer
+  /// @param customer Customer about to be removed
+  void RemoveCustomer(const Customer& customer);
+
+  /// @brief Schedules the appointments of all customers from scratch. If
+  /// the reminders are running, the ones sent already are not sent again and
+  /// the ones that became due meanwhile are still sent.
+  /// @param customers All customers
+  void Rebuild(const CustomerMap& customers);
+
+  /// @brief Lists the appointments in a time interval, by date
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param max_count Maximum number of appointments to list
+  /// @param appointments Where to store the appointments
+  void GetAppointments(const std::time_t from_timestamp,
+                       const std::time_t to_timestamp,
+                       const std::size_t max_count,
+                       std::vector<Appointment>& appointments) const;
+
+  /// @brief Lists the next appointments from now on, by date
+  /// @param count Number of appointments to list
+  /// @param appointments Where to store the appointments
+  void GetNextAppointments(const std::size_t count,
+                           std::vector<Appointment>& appointments) const;
+
+  /// @brief Starts reminding of the appointments some time before they are
+  /// due. Restarts the reminders if running.
+  /// @param lead_time Seconds before the appointment the reminder is sent
+  /// @param callback Called for every reminder, outside of any lock
+  /// @param background Whether a background thread sends the reminders;
+  /// otherwise they are only sent by calling CheckReminders()
+  void StartReminders(const std::time_t lead_time,
+                      const ReminderCallback& callback,
+                      const bool background = true);
+
+  /// @brief Stops the reminders and the background thread, if running. Must
+  /// not be called from the reminder callback.
+  void StopReminders();
+
+  /// @brief Sends the reminders due by now and drops the appointments too
+  /// old to be kept. Called by the background thread; callers driving a
+  /// simulated clock call it after moving the clock, and start the reminders
+  /// without the thread so that it sends nothing behind their back.
+  /// @return Number of reminders sent
+  std::size_t CheckReminders();
+
+  /// @brief Number of appointments kept
+  /// @return Appointment count
+  std::size_t GetSize() const;
+
+  /// @brief Memory taken by the appointments and the pending reminders
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+ private:
+  /// @brief Orders appointments by date, then by customer and interaction
+  struct EarlierAppointment {
+    bool operator()(const Appointment& left, const Appointment& right) const;
+  };
+
+  /// @brief Orders the heap of the reminders, the earliest on top
+  struct LaterReminder {
+    bool operator()(const Appointment& left, const Appointment& right) const {
+      return left.timestamp_ > right.timestamp_;
+    }
+  };
+
+  /// @brief Body of the background thread
+  void Run();
+
+  /// @brief Queues the reminders of all appointments from a point in time
+  /// on. The lock must be held.
+  /// @param from_timestamp Date of the first appointment to remind of
+  void QueueReminders(const std::time_t from_timestamp);
+
+  /// @brief Drops the appointments too old to be kept. The lock must be
+  /// held.
+  /// @param now Current time as a UNIX Timestamp
+  void DropPast(const std::time_t now);
+
+  /// @brief Oldest date of the appointments kept
+  /// @param now Current time as a UNIX Timestamp
+  /// @return Date as a UNIX Timestamp
+  static std::time_t GetCutoff(const std::time_t now);
+
+  /// @brief Checks if an interaction belongs to the schedule
+  /// @param interaction Interaction
+  /// @param cutoff_timestamp Oldest date kept
+  /// @return True for appointments dated from the cutoff on
+  static bool IsScheduled(const Interaction& interaction,
+                          const std::time_t cutoff_timestamp);
+
+  Clock clock_;
+
+  /// @brief Guards everything below
+  mutable std::mutex mutex_;
+  /// @brief Wakes up the background thread
+  std::condition_variable wake_up_;
+
+  /// @brief Appointments kept, by date
+  std::set<Appointment, EarlierAppointment> appointments_;
+  /// @brief Reminders not sent yet, as a heap on the dates. Only filled
+  /// while the reminders run.
+  std::vector<Appointment> reminders_;
+
+  /// @brief Seconds before the appointment the reminder is sent
+  std::time_t lead_time_;
+  /// @brief Appointments up to this date have been reminded of, or were held
+  /// already when the reminders started
+  std::time_t reminded_until_;
+  /// @brief Called for every reminder
+  ReminderCallback callback_;
+  /// @brief Whether the reminders run, see StartReminders()
+  bool running_;
+  /// @brief Set to ask the background thread to stop
+  bool stopping_;
+  std::thread thread_;
+};
+
+#endif  // __APPOINTMENT_SCHEDULER_H__
@@ -0,0 +1,139 @@
+#include "arena.h"
+
+#include <algorithm>
+
+namespace {
+
+/// @brief Size of the first chunk of an arena
+constexpr std::size_t FIRST_CHUNK_SIZE{64U * 1024U};
+
+/// @brief Chunks double in size up to this limit
+constexpr std::size_t MAX_CHUNK_SIZE{4U * 1024U * 1024U};
+
+}  // namespace
+
+constexpr std::size_t Arena::GRANULARITY;
+constexpr std::size_t Arena::SIZE_CLASSES;
+
+Arena::Handle Arena::Create(const bool passthrough) {
+  return Handle{new Arena{passthrough}};
+}
+
+Arena* Arena::GetCurrent() { return Current(); }
+
+Arena*& Arena::Current() {
+  static thread_local Arena* current{nullptr};
+  return current;
+}
+
+Arena::Arena(const bool passthrough)
+    : mutex_{},
+      passthrough_{passthrough},
+      released_{false},
+      live_blocks_{},
+      chunks_{},
+      chunk_position_{nullptr},
+      chunk_end_{nullptr},
+      next_chunk_size_{FIRST_CHUNK_SIZE},
+      free_lists_{},
+      stats_{} {}
+
+Arena::~Arena() {
+  // All at once, whatever was allocated out of them
+  for (char* chunk : chunks_) {
+    ::operator delete(chunk);
+  }
+}
+
+void Arena::Release() {
+  bool unused{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    released_ = true;
+    unused = live_blocks_ == 0U;
+  }
+
+  if (unused) {
+    delete this;
+  }
+}
+
+void* Arena::Allocate(const std::size_t size) {
+  const std::size_t size_class = (std::max<std::size_t>(size, 1U) - 1U) /
+                                 GRANULARITY;
+
+  std::unique_lock<std::mutex> lock{mutex_};
+  stats_.allocations_++;
+  live_blocks_++;
+
+  if (passthrough_ || size_class >= SIZE_CLASSES) {
+    stats_.system_allocations_++;
+    stats_.bypassed_bytes_ += size;
+    lock.unlock();
+    return ::operator new(size);
+  }
+
+  stats_.pooled_bytes_ += size;
+  if (free_lists_[size_class] != nullptr) {
+    FreeBlock* const free_block = free_lists_[size_class];
+    free_lists_[size_class] = free_block->next_;
+    stats_.reused_++;
+    return free_block;
+  }
+  return AllocateFromChunk((size_class + 1U) * GRANULARITY);
+}
+
+void Arena::Deallocate(void* block, const std::size_t size) {
+  const std::size_t size_class = (std::max<std::size_t>(size, 1U) - 1U) /
+                                 GRANULARITY;
+  const bool pooled = !passthrough_ && size_class < SIZE_CLASSES;
+
+  if (!pooled) {
+    ::operator delete(block);
+  }
+
+  bool unused{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stats_.deallocations_++;
+    live_blocks_--;
+
+    if (pooled) {
+      stats_.pooled_bytes_ -= size;
+      FreeBlock* const free_block = static_cast<FreeBlock*>(block);
+      free_block->next_ = free_lists_[size_class];
+      free_lists_[size_class] = free_block;
+    } else {
+      stats_.bypassed_bytes_ -= size;
+    }
+
+    unused = released_ && live_blocks_ == 0U;
+  }
+
+  if (unused) {
+    delete this;
+  }
+}
+
+Arena::Stats Arena::GetStats() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return stats_;
+}
+
+void* Arena::AllocateFromChunk(const std::size_t size) {
+  if (static_cast<std::size_t>(chunk_end_ - chunk_position_) < size) {
+    const std::size_t chunk_size = std::max(next_chunk_size_, size);
+    char* const chunk = static_cast<char*>(::operator new(chunk_size));
+    chunks_.push_back(chunk);
+    chunk_position_ = chunk;
+    chunk_end_ = chunk + chunk_size;
+
+    next_chunk_size_ = std::min(next_chunk_size_ * 2U, MAX_CHUNK_SIZE);
+    stats_.system_allocations_++;
+    stats_.reserved_bytes_ += chunk_size;
+  }
+
+  void* const block = chunk_position_;
+  chunk_position_ += size;
+  return block;
+}
@@ -0,0 +1,198 @@
+#ifndef __ARENA_H__
+#define __ARENA_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <vector>
+
+/// @brief Memory arena serving many small allocations out of a few large
+/// chunks. Allocations are rounded up to size classes; freed blocks are kept
+/// in a free list per class and handed out again, so updated and removed
+/// records do not make the arena grow. Chunks are only returned to the system
+/// all at once, when the arena is destroyed.
+///
+/// The owner obtains the arena through Create() and gives it up through the
+/// returned handle. Blocks may outlive the owner (e.g. interactions handed
+/// out by the Database): the arena is destroyed once the owner has let go and
+/// the last block has been freed.
+///
+/// Allocating and freeing are serialized by a mutex, as blocks may be freed
+/// by any thread.
+class Arena {
+ public:
+  /// @brief Counters describing the activity of an arena
+  struct Stats {
+    /// @brief Blocks handed out
+    std::uint64_t allocations_;
+    /// @brief Blocks given back
+    std::uint64_t deallocations_;
+    /// @brief Blocks handed out again from a free list
+    std::uint64_t reused_;
+    /// @brief Requests that reached the system allocator: chunks, blocks too
+    /// large to be pooled, or every block when passing through
+    std::uint64_t system_allocations_;
+    /// @brief Bytes obtained from the system for chunks
+    std::uint64_t reserved_bytes_;
+    /// @brief Bytes currently handed out of the chunks, at the size requested
+    std::uint64_t pooled_bytes_;
+    /// @brief Bytes currently handed out straight from the system allocator,
+    /// which reserved_bytes_ does not include
+    std::uint64_t bypassed_bytes_;
+  };
+
+  /// @brief Gives up ownership of an arena
+  struct Releaser {
+    void operator()(Arena* arena) const { arena->Release(); }
+  };
+
+  /// @brief Owning handle of an arena
+  using Handle = std::unique_ptr<Arena, Releaser>;
+
+  // No default, move and copy constructors/operators
+  Arena(const Arena&) = delete;
+  Arena& operator=(const Arena&) = delete;
+  Arena(Arena&&) = delete;
+  Arena& operator=(Arena&&) = delete;
+
+  /// @brief Creates a new arena
+  /// @param passthrough When true, every request goes straight to the system
+  /// allocator while still being counted. Used as a baseline to compare
+  /// against.
+  /// @return Owning handle
+  static Handle Create(const bool passthrough = false);
+
+  /// @brief Arena used by allocators created on this thread without an
+  /// explicit arena, nullptr for the system allocator. See ArenaScope.
+  /// @return Current arena
+  static Arena* GetCurrent();
+
+  /// @brief Allocates a block
+  /// @param size Size in bytes
+  /// @return Block aligned for any type
+  void* Allocate(const std::size_t size);
+
+  /// @brief Frees a block allocated by this arena
+  /// @param block Block to free
+  /// @param size Size in bytes, as passed to Allocate()
+  void Deallocate(void* block, const std::size_t size);
+
+  /// @brief Snapshot of the counters
+  /// @return Counters
+  Stats GetStats() const;
+
+ private:
+  friend class ArenaScope;
+
+  explicit Arena(const bool passthrough);
+  ~Arena();
+
+  /// @brief Gives up ownership, destroying the arena if no block is in use
+  void Release();
+
+  /// @brief Carves a block out of the current chunk, allocating a new one if
+  /// needed. The mutex must be held.
+  void* AllocateFromChunk(const std::size_t size);
+
+  /// @brief Slot of the current arena of this thread
+  static Arena*& Current();
+
+  /// @brief A freed block, linked into the free list of its size class
+  struct FreeBlock {
+    FreeBlock* next_;
+  };
+
+  /// @brief Granularity of the size classes
+  static constexpr std::size_t GRANULARITY{16U};
+
+  /// @brief Number of size classes, larger blocks bypass the arena
+  static constexpr std::size_t SIZE_CLASSES{32U};
+
+  mutable std::mutex mutex_;
+  bool passthrough_;
+  bool released_;
+  std::uint64_t live_blocks_;
+
+  std::vector<char*> chunks_;
+  char* chunk_position_;
+  char* chunk_end_;
+  std::size_t next_chunk_size_;
+
+  std::array<FreeBlock*, SIZE_CLASSES> free_lists_;
+  Stats stats_;
+};
+
+/// @brief Makes an arena the current one of this thread for as long as the
+/// scope lives, so that containers and objects created meanwhile allocate
+/// from it. Scopes can be nested.
+class ArenaScope {
+ public:
+  // No default, move and copy constructors/operators
+  ArenaScope() = delete;
+  ArenaScope(const ArenaScope&) = delete;
+  ArenaScope& operator=(const ArenaScope&) = delete;
+  ArenaScope(ArenaScope&&) = delete;
+  ArenaScope& operator=(ArenaScope&&) = delete;
+
+  explicit ArenaScope(Arena* arena) : previous_{Arena::Current()} {
+    Arena::Current() = arena;
+  }
+
+  ~ArenaScope() { Arena::Current() = previous_; }
+
+ private:
+  Arena* previous_;
+};
+
+/// @brief Standard allocator drawing from an Arena. A default-constructed
+/// allocator binds to the current arena of the thread (see ArenaScope), or to
+/// the system allocator if there is none.
+/// @tparam T Type of the allocated objects
+template <typename T>
+class ArenaAllocator {
+ public:
+  using value_type = T;
+
+  ArenaAllocator() noexcept : arena_{Arena::GetCurrent()} {}
+
+  explicit ArenaAllocator(Arena* arena) noexcept : arena_{arena} {}
+
+  template <typename U>
+  ArenaAllocator(const ArenaAllocator<U>& other) noexcept
+      : arena_{other.GetArena()} {}
+
+  T* allocate(const std::size_t count) {
+    const std::size_t size = count * sizeof(T);
+    return static_cast<T*>(arena_ != nullptr ? arena_->Allocate(size)
+                                             : ::operator new(size));
+  }
+
+  void deallocate(T* block, const std::size_t count) noexcept {
+    if (arena_ != nullptr) {
+      arena_->Deallocate(block, count * sizeof(T));
+    } else {
+      ::operator delete(block);
+    }
+  }
+
+  /// @brief Arena the allocator draws from, nullptr for the system allocator
+  Arena* GetArena() const noexcept { return arena_; }
+
+  template <typename U>
+  bool operator==(const ArenaAllocator<U>& other) const noexcept {
+    return arena_ == other.GetArena();
+  }
+
+  template <typename U>
+  bool operator!=(const ArenaAllocator<U>& other) const noexcept {
+    return arena_ != other.GetArena();
+  }
+
+ private:
+  Arena* arena_;
+};
+
+#endif  // __ARENA_H__
@@ -0,0 +1,128 @@
+#include "async_crm.h"
+
+AsyncCRM::AsyncCRM(const std::string& database_path,
+                   const std::size_t thread_count)
+    : crm_{database_path},
+      crm_mutex_{},
+      writes_mutex_{},
+      pending_writes_{},
+      applying_writes_{false},
+      executor_{thread_count} {}
+
+AsyncCRM::~AsyncCRM() = default;
+
+std::future<bool> AsyncCRM::AddCustomer(const std::string& name,
+                                        const std::string& surname) {
+  return Write([name, surname](CRM& crm) {
+    return crm.AddCustomer(name, surname);
+  });
+}
+
+std::future<bool> AsyncCRM::UpdateClientInfo(const Customer::ID id,
+                                             const std::string& name,
+                                             const std::string& surname) {
+  return Write([id, name, surname](CRM& crm) {
+    return crm.UpdateClientInfo(id, name, surname);
+  });
+}
+
+std::future<bool> AsyncCRM::RemoveCustomer(const Customer::ID id) {
+  return Write([id](CRM& crm) { return crm.RemoveCustomer(id); });
+}
+
+std::future<bool> AsyncCRM::AddInteraction(const Customer::ID id,
+                                           const std::string& when,
+                                           const std::string& what) {
+  return Write([id, when, what](CRM& crm) {
+    return crm.AddInteraction(id, when, what);
+  });
+}
+
+std::future<bool> AsyncCRM::CommitTransaction(Transaction transaction) {
+  return Write([transaction](CRM& crm) mutable {
+    return crm.CommitTransaction(transaction);
+  });
+}
+
+std::future<Transaction> AsyncCRM::BeginTransaction() {
+  return Read([](const CRM& crm) { return crm.BeginTransaction(); });
+}
+
+std::future<bool> AsyncCRM::HasCustomer(const Customer::ID id) {
+  return Read([id](const CRM& crm) { return crm.HasCustomer(id); });
+}
+
+std::future<std::vector<Customer::ID>> AsyncCRM::FindCustomers(
+    const CustomerQuery& query) {
+  return Read([query](const CRM& crm) {
+    std::vector<Customer::ID> found_customers{};
+    crm.FindCustomers(query, found_customers);
+    return found_customers;
+  });
+}
+
+std::future<std::vector<std::shared_ptr<Interaction>>>
+AsyncCRM::GetCustomerInteractions(const Customer::ID id,
+                                  const std::time_t from_timestamp,
+                                  const std::time_t to_timestamp) {
+  return Read([id, from_timestamp, to_timestamp](const CRM& crm) {
+    std::vector<std::shared_ptr<Interaction>> interactions{};
+    crm.GetCustomerInteractions(id, from_timestamp, to_timestamp,
+                                interactions);
+    return interactions;
+  });
+}
+
+void AsyncCRM::EnqueueWrite(WriteRequest request) {
+  {
+    std::lock_guard<std::mutex> lock{writes_mutex_};
+    pending_writes_.push_back(std::move(request));
+
+    if (applying_writes_) {
+      // Picked up by the batch currently running
+      return;
+    }
+    applying_writes_ = true;
+  }
+
+  executor_.Submit([this]() { ApplyWrites(); });
+}
+
+void AsyncCRM::ApplyWrites() {
+  while (true) {
+    std::vector<WriteRequest> batch{};
+    {
+      std::lock_guard<std::mutex> lock{writes_mutex_};
+      if (pending_writes_.empty()) {
+        applying_writes_ = false;
+        return;
+      }
+      batch.swap(pending_writes_);
+    }
+
+    std::vector<Completion> completions{};
+    completions.reserve(batch.size());
+
+    bool persisted{};
+    {
+      // Persisting moves the sequence number on and writes the journal and
+      // the storage engine, so reads wait for it as well
+      std::unique_lock<std::shared_timed_mutex> lock{crm_mutex_};
+      crm_.DeferPersistence();
+      for (auto& request : batch) {
+        // Must not stop the batch: the writes after it would never run and
+        // no later write would schedule a batch again
+        try {
+          completions.push_back(request(crm_));
+        } catch (...) {
+          // Dropping the request breaks its promise, which reports it
+        }
+      }
+      persisted = crm_.FlushDeferredChanges();
+    }
+
+    for (auto& completion : completions) {
+      completion(persisted);
+    }
+  }
+}
@@ -0,0 +1,312 @@
+#ifndef __ASYNC_CRM_H__
+#define __ASYNC_CRM_H__
+
+#include <ctime>
+#include <exception>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "crm.h"
+#include "executor.h"
+
+#if defined(__cpp_impl_coroutine) && __cpp_impl_coroutine >= 201902L
+#include <coroutine>
+#include <optional>
+#define ASYNC_CRM_HAS_COROUTINES 1
+#else
+#define ASYNC_CRM_HAS_COROUTINES 0
+#endif
+
+/// @brief Non-blocking façade over the CRM. Every operation is queued and
+/// runs on an internal pool of worker threads; results are delivered through
+/// std::future (or co_await when built as C++20).
+///
+/// Reads run concurrently with each other. Writes are applied one batch at a
+/// time: all writes queued while the previous batch was running are applied
+/// together and persisted with a single write, while reads wait. The result
+/// of a write is delivered only once it has been persisted, so callers can
+/// pipeline many requests without waiting for each one.
+///
+/// If a batch cannot be persisted, its writes report PendingWrite instead of
+/// their result. They stay applied, and are persisted with the next batch or
+/// when the CRM is closed: retrying them would apply them twice.
+class AsyncCRM {
+ public:
+  /// @brief Reported by a write that was applied but whose batch could not
+  /// be persisted yet
+  class PendingWrite : public std::runtime_error {
+   public:
+    PendingWrite()
+        : std::runtime_error{"Write applied, but not persisted yet"} {}
+  };
+
+  // No default, move and copy constructors/operators
+  AsyncCRM() = delete;
+  AsyncCRM(const AsyncCRM&) = delete;
+  AsyncCRM& operator=(const AsyncCRM&) = delete;
+  AsyncCRM(AsyncCRM&&) = delete;
+  AsyncCRM& operator=(AsyncCRM&&) = delete;
+
+  /// @brief Opens the CRM and starts the worker threads
+  /// @param database_path Path of the database file
+  /// @param thread_count Number of worker threads, 0 for one per hardware
+  /// thread
+  explicit AsyncCRM(const std::string& database_path,
+                    const std::size_t thread_count = 0U);
+
+  /// @brief Completes all queued operations before closing the CRM
+  ~AsyncCRM();
+
+  /// @brief Runs a read-only function on the CRM
+  /// @tparam Function Callable taking a const CRM&
+  /// @param function Function to run
+  /// @param on_result Receives the result of the function, on a worker
+  /// thread
+  /// @param on_error Receives the exception thrown by the function instead,
+  /// on a worker thread
+  template <typename Function, typename OnResult, typename OnError>
+  void SubmitRead(Function function, OnResult on_result, OnError on_error) {
+    executor_.Submit([this, function, on_result, on_error]() mutable {
+      using Result = decltype(function(std::declval<const CRM&>()));
+      std::unique_ptr<Result> result{};
+      {
+        std::shared_lock<std::shared_timed_mutex> lock{crm_mutex_};
+        // Escaping the task would terminate the process
+        try {
+          result = std::make_unique<Result>(
+              function(static_cast<const CRM&>(crm_)));
+        } catch (...) {
+          lock.unlock();
+          on_error(std::current_exception());
+          return;
+        }
+      }
+
+      on_result(std::move(*result));
+    });
+  }
+
+  /// @brief Runs a function changing the CRM. It becomes part of the next
+  /// batch of writes.
+  /// @tparam Function Callable taking a CRM&
+  /// @param function Function to run
+  /// @param on_result Receives the result of the function, on a worker
+  /// thread, once the batch it belongs to has been persisted
+  /// @param on_error Receives instead, on a worker thread, the exception
+  /// thrown by the function, or PendingWrite if the batch could not be
+  /// persisted
+  template <typename Function, typename OnResult, typename OnError>
+  void SubmitWrite(Function function, OnResult on_result, OnError on_error) {
+    EnqueueWrite([function, on_result,
+                  on_error](CRM& crm) mutable -> Completion {
+      using Result = decltype(function(crm));
+      std::shared_ptr<Result> result{};
+      try {
+        result = std::make_shared<Result>(function(crm));
+      } catch (...) {
+        const std::exception_ptr error = std::current_exception();
+        return [on_error, error](const bool) mutable { on_error(error); };
+      }
+
+      return [on_result, on_error, result](const bool persisted) mutable {
+        if (persisted) {
+          on_result(std::move(*result));
+        } else {
+          on_error(std::make_exception_ptr(PendingWrite{}));
+        }
+      };
+    });
+  }
+
+  /// @brief Runs a read-only function on the CRM
+  /// @param function Callable taking a const CRM&
+  /// @return Future holding the result of the function, or the exception it
+  /// threw
+  template <typename Function>
+  auto Read(Function function)
+      -> std::future<decltype(function(std::declval<const CRM&>()))> {
+    using Result = decltype(function(std::declval<const CRM&>()));
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto future = promise->get_future();
+
+    SubmitRead(
+        function,
+        [promise](Result result) { promise->set_value(std::move(result)); },
+        [promise](const std::exception_ptr error) {
+          promise->set_exception(error);
+        });
+    return future;
+  }
+
+  /// @brief Runs a function changing the CRM
+  /// @param function Callable taking a CRM&
+  /// @return Future holding the result of the function, ready once it has
+  /// been persisted. It holds the exception thrown by the function instead,
+  /// or PendingWrite if its batch could not be persisted.
+  template <typename Function>
+  auto Write(Function function)
+      -> std::future<decltype(function(std::declval<CRM&>()))> {
+    using Result = decltype(function(std::declval<CRM&>()));
+    auto promise = std::make_shared<std::promise<Result>>();
+    auto future = promise->get_future();
+
+    SubmitWrite(
+        function,
+        [promise](Result result) { promise->set_value(std::move(result)); },
+        [promise](const std::exception_ptr error) {
+          promise->set_exception(error);
+        });
+    return future;
+  }
+
+  /// @brief See CRM::AddCustomer()
+  std::future<bool> AddCustomer(const std::string& name,
+                                const std::string& surname);
+
+  /// @brief See CRM::UpdateClientInfo()
+  std::future<bool> UpdateClientInfo(const Customer::ID id,
+                                     const std::string& name,
+                                     const std::string& surname);
+
+  /// @brief See CRM::RemoveCustomer()
+  std::future<bool> RemoveCustomer(const Customer::ID id);
+
+  /// @brief See CRM::AddInteraction()
+  std::future<bool> AddInteraction(const Customer::ID id,
+                                   const std::string& when,
+                                   const std::string& what);
+
+  /// @brief See CRM::CommitTransaction(). The transaction must have been
+  /// opened through BeginTransaction().
+  std::future<bool> CommitTransaction(Transaction transaction);
+
+  /// @brief See CRM::BeginTransaction()
+  std::future<Transaction> BeginTransaction();
+
+  /// @brief See CRM::HasCustomer()
+  std::future<bool> HasCustomer(const Customer::ID id);
+
+  /// @brief See CRM::FindCustomers()
+  /// @return Future holding the IDs of all matching customers
+  std::future<std::vector<Customer::ID>> FindCustomers(
+      const CustomerQuery& query);
+
+  /// @brief See CRM::GetCustomerInteractions()
+  /// @return Future holding all interactions found
+  std::future<std::vector<std::shared_ptr<Interaction>>>
+  GetCustomerInteractions(const Customer::ID id,
+                          const std::time_t from_timestamp,
+                          const std::time_t to_timestamp);
+
+#if ASYNC_CRM_HAS_COROUTINES
+  /// @brief Awaitable running an operation on the CRM. The awaiting
+  /// coroutine is resumed on a worker thread once the result is available;
+  /// an exception reported by the operation is thrown by co_await.
+  /// @tparam Result Type returned by the operation
+  template <typename Result>
+  class Awaitable {
+   public:
+    using OnResult = std::function<void(Result)>;
+    using OnError = std::function<void(std::exception_ptr)>;
+    using Submitter = std::function<void(OnResult, OnError)>;
+
+    explicit Awaitable(Submitter submitter)
+        : submitter_{std::move(submitter)}, result_{}, error_{} {}
+
+    bool await_ready() const noexcept { return false; }
+
+    void await_suspend(std::coroutine_handle<> handle) {
+      submitter_(
+          [this, handle](Result result) {
+            result_.emplace(std::move(result));
+            handle.resume();
+          },
+          [this, handle](std::exception_ptr error) {
+            error_ = error;
+            handle.resume();
+          });
+    }
+
+    Result await_resume() {
+      if (error_) {
+        std::rethrow_exception(error_);
+      }
+      return std::move(*result_);
+    }
+
+   private:
+    Submitter submitter_;
+    std::optional<Result> result_;
+    std::exception_ptr error_;
+  };
+
+  /// @brief co_await-able version of Read()
+  template <typename Function>
+  auto AwaitRead(Function function)
+      -> Awaitable<decltype(function(std::declval<const CRM&>()))> {
+    using Result = decltype(function(std::declval<const CRM&>()));
+    using Await = Awaitable<Result>;
+    return Await{[this, function](typename Await::OnResult on_result,
+                                  typename Await::OnError on_error) {
+      SubmitRead(function, std::move(on_result), std::move(on_error));
+    }};
+  }
+
+  /// @brief co_await-able version of Write()
+  template <typename Function>
+  auto AwaitWrite(Function function)
+      -> Awaitable<decltype(function(std::declval<CRM&>()))> {
+    using Result = decltype(function(std::declval<CRM&>()));
+    using Await = Awaitable<Result>;
+    return Await{[this, function](typename Await::OnResult on_result,
+                                  typename Await::OnError on_error) {
+      SubmitWrite(function, std::move(on_result), std::move(on_error));
+    }};
+  }
+#endif
+
+ private:
+  /// @brief Delivers the result of a write once its batch has been
+  /// persisted, or could not be
+  using Completion = std::function<void(const bool persisted)>;
+
+  /// @brief Applies a write to the CRM and returns how to deliver its result
+  using WriteRequest = std::function<Completion(CRM&)>;
+
+  /// @brief Queues a write, scheduling a new batch if none is running
+  /// @param request Write to queue
+  void EnqueueWrite(WriteRequest request);
+
+  /// @brief Applies and persists queued writes, one batch at a time, until
+  /// the queue is empty
+  void ApplyWrites();
+
+  /// @brief Wrapped CRM
+  CRM crm_;
+
+  /// @brief Shared by reads, exclusive while a batch is applied and
+  /// persisted
+  std::shared_timed_mutex crm_mutex_;
+
+  /// @brief Protects pending_writes_ and applying_writes_
+  std::mutex writes_mutex_;
+
+  /// @brief Writes waiting for the next batch
+  std::vector<WriteRequest> pending_writes_;
+
+  /// @brief Whether a worker is currently applying batches
+  bool applying_writes_;
+
+  /// @brief Runs all operations. Declared last so it is destroyed first,
+  /// completing queued operations while the CRM still exists.
+  Executor executor_;
+};
+
+#endif  // __ASYNC_CRM_H__
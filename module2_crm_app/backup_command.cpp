@@ -0,0 +1,111 @@
+#include "backup_command.h"
+
+#include <chrono>
+#include <fstream>
+#include <iostream>
+
+#include "backup_set.h"
+#include "database.h"
+#include "utilities.h"
+
+BackupCommand::BackupCommand(const Config& config) : config_{config} {}
+
+std::int32_t BackupCommand::Run() {
+  if (config_.command_arguments_.size() != 1U) {
+    std::cerr << "Indica la cartella dei backup." << std::endl;
+    return EXIT_FAILURE;
+  }
+  return config_.command_ == "restore" ? Restore() : Backup();
+}
+
+std::int32_t BackupCommand::Backup() {
+  const Database database{config_.database_path_, true,
+                          config_.storage_engine_};
+  const BackupSet backup_set{config_.command_arguments_[0]};
+
+  const auto start = std::chrono::steady_clock::now();
+  BackupSet::BackupSummary summary{};
+  if (!backup_set.Write(database.GetCustomers(), database.GetSequence(),
+                        database.GetLastCustomerID(),
+                        config_.database_path_ + DATABASE_ARCHIVE_SUFFIX,
+                        config_.backup_full_, summary)) {
+    std::cerr << "Impossibile scrivere il backup." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  std::cout << (summary.full_ ? "Backup completo n. "
+                             : "Backup incrementale n. ")
+            << summary.generation_ << std::endl
+            << "Clienti salvati: " << summary.customers_ << std::endl
+            << "Clienti rimossi: " << summary.removed_ << std::endl
+            << "File dell'archivio copiati: " << summary.archive_files_
+            << std::endl
+            << "Dimensione: " << summary.bytes_ / 1024U << " KiB" << std::endl
+            << "Tempo impiegato: " << elapsed.count() << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+std::int32_t BackupCommand::Restore() {
+  std::time_t at = std::time(nullptr);
+  if (!config_.restore_at_.empty() &&
+      !utilities::to_timestamp(config_.restore_at_, DATE_FORMAT, at)) {
+    std::cerr << "Indica il momento da ripristinare come gg/mm/aaaa hh:mm."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const auto engine = StorageEngine::Create(config_.storage_engine_,
+                                            config_.database_path_, false);
+  if (engine == nullptr) {
+    return EXIT_FAILURE;
+  }
+
+  // Never mixed with the data or the journal of another database
+  CustomerMap customers{};
+  std::uint64_t sequence{};
+  Customer::ID last_customer_id{};
+  if (engine->Load(customers, sequence, last_customer_id) ||
+      std::ifstream{config_.database_path_ + DATABASE_JOURNAL_SUFFIX}.good()) {
+    std::cerr << "Il database esiste già: spostalo o indica un altro "
+                 "percorso con --database."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const auto start = std::chrono::steady_clock::now();
+  const BackupSet backup_set{config_.command_arguments_[0]};
+  BackupSet::RestoreSummary summary{};
+  if (!backup_set.Restore(at, customers, sequence, last_customer_id,
+                          summary)) {
+    std::cerr << "Nessun backup completo da ripristinare a quella data, o "
+                 "backup danneggiati."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // Every customer is new to the storage engine
+  std::vector<Change> changes{};
+  changes.reserve(customers.size());
+  for (const auto& customer : customers) {
+    changes.emplace_back(Change::EType::UPDATE_CUSTOMER, customer.first);
+  }
+  engine->Stage(changes, customers);
+  if (!backup_set.RestoreArchive(config_.database_path_ +
+                                 DATABASE_ARCHIVE_SUFFIX) ||
+      !engine->Checkpoint(sequence, last_customer_id, customers, true)) {
+    std::cerr << "Impossibile scrivere il database." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  std::cout << "Ripristinato il backup n. " << summary.generation_ << " del "
+            << utilities::to_date(summary.created_, DATE_FORMAT) << std::endl
+            << "Backup incrementali applicati: " << summary.deltas_
+            << std::endl
+            << "Clienti ripristinati: " << customers.size() << std::endl
+            << "Tempo impiegato: " << elapsed.count() << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,42 @@
+#ifndef __BACKUP_COMMAND_H__
+#define __BACKUP_COMMAND_H__
+
+#include <cstdint>
+
+#include "config.h"
+
+/// @brief Backs up the customers to a directory ("backup"), writing only the
+/// ones changed since the previous backup, or rebuilds a database from the
+/// backups as of a point in time ("restore"). Backups open the database
+/// read-only; restores only write to a database that does not exist yet.
+class BackupCommand {
+ public:
+  // No default, move and copy constructors/operators
+  BackupCommand() = delete;
+  BackupCommand(const BackupCommand&) = delete;
+  BackupCommand& operator=(const BackupCommand&) = delete;
+  BackupCommand(BackupCommand&&) = delete;
+  BackupCommand& operator=(BackupCommand&&) = delete;
+
+  /// @brief Prepares the backup or the restore
+  /// @param config Command, directory of the backups, database and storage
+  /// engine
+  explicit BackupCommand(const Config& config);
+
+  /// @brief Runs the command and prints a summary
+  /// @return Exit status code, failure if nothing was written
+  std::int32_t Run();
+
+ private:
+  /// @brief Writes a new backup of the database
+  /// @return Exit status code
+  std::int32_t Backup();
+
+  /// @brief Rebuilds the database from the backups
+  /// @return Exit status code
+  std::int32_t Restore();
+
+  Config config_;
+};
+
+#endif  // __BACKUP_COMMAND_H__
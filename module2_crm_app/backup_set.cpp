@@ -0,0 +1,510 @@
+#include "backup_set.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iterator>
+#include <sstream>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Marks the header line of a generation
+constexpr char GENERATION_HEADER_MARKER{'#'};
+
+/// @brief Marks the lines of the customers removed since the previous
+/// generation
+constexpr char REMOVED_MARKER{'-'};
+
+/// @brief Suffix of the full generations
+constexpr char FULL_SUFFIX[]{".full.tsv"};
+
+/// @brief Suffix of the delta generations
+constexpr char DELTA_SUFFIX[]{".delta.tsv"};
+
+/// @brief Digits of the generation number in the file names, so that they
+/// also sort by name
+constexpr int GENERATION_DIGITS{6};
+
+/// @brief Suffix of the hashes of each generation
+constexpr char HASHES_SUFFIX[]{".hashes"};
+
+/// @brief Start of the hashes of a generation
+constexpr char HASHES_MAGIC[]{"CRMBKHSH"};
+
+/// @brief Size of the header of the hashes: magic, counts of written and
+/// removed customers and checksum
+constexpr std::size_t HASHES_HEADER_SIZE{sizeof(HASHES_MAGIC) - 1U +
+                                         3U * sizeof(std::uint64_t)};
+
+/// @brief Subdirectory holding the copies of the archive segments
+constexpr char ARCHIVE_DIRECTORY[]{"archive"};
+
+/// @brief Suffix of the files being written
+constexpr char TEMPORARY_SUFFIX[]{".tmp"};
+
+/// @brief Checks whether a string ends with a suffix
+/// @param str String to check
+/// @param suffix Suffix to look for
+/// @return True if str ends with suffix
+bool ends_with(const std::string& str, const std::string& suffix) {
+  return str.size() >= suffix.size() &&
+         str.compare(str.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/// @brief Appends the bytes of a value to a buffer
+/// @param buffer Buffer to append to
+/// @param value Value to append
+template <typename T>
+void append_bytes(std::string& buffer, const T& value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/// @brief Serializes a customer the way the snapshot does, without the
+/// newline
+/// @param customer Customer to serialize
+/// @param record Stream to reuse for the serialization
+/// @param line Where to store the record
+void serialize(const Customer& customer, std::ostringstream& record,
+               std::string& line) {
+  record.str(std::string{});
+  record << customer;
+  line = record.str();
+  line.pop_back();
+}
+
+}  // namespace
+
+BackupSet::BackupSet(const std::string& directory_path)
+    : directory_path_{directory_path} {}
+
+bool BackupSet::Write(const CustomerMap& customers,
+                      const std::uint64_t sequence,
+                      const Customer::ID last_customer_id,
+                      const std::string& archive_path, const bool full,
+                      BackupSummary& result) const {
+  const TraceSpan trace_span{"backup", "BackupSet::Write"};
+  result = BackupSummary{};
+
+  std::vector<Generation> generations{};
+  if (!utilities::create_directory(directory_path_) ||
+      !ListGenerations(generations)) {
+    return false;
+  }
+
+  // Deltas are only meaningful against the customers of the generation
+  // right before them
+  std::vector<Customer::ID> previous_ids{};
+  std::vector<std::uint64_t> previous_hashes{};
+  result.full_ =
+      full || !ReadHashes(generations, previous_ids, previous_hashes);
+  if (result.full_) {
+    previous_ids.clear();
+    previous_hashes.clear();
+  }
+  result.generation_ =
+      generations.empty() ? 1U : generations.back().number_ + 1U;
+
+  // Copied first, so that no generation refers to a segment that is missing
+  if (!CopyNewFiles(archive_path, directory_path_ + "/" + ARCHIVE_DIRECTORY,
+                    result.archive_files_, result.bytes_)) {
+    return false;
+  }
+
+  const std::string path{GetPath(result.generation_,
+                                 result.full_ ? FULL_SUFFIX : DELTA_SUFFIX)};
+  const std::string temporary_path{path + TEMPORARY_SUFFIX};
+  std::ofstream file_stream{temporary_path, std::ios::trunc};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  const auto write_line = [&file_stream, &result](std::string& line) {
+    utilities::append_crc32c(line);
+    file_stream << line << '\n';
+    result.bytes_ += line.size() + 1U;
+  };
+  std::vector<Customer::ID> written_ids{};
+  std::vector<std::uint64_t> written_hashes{};
+  std::vector<Customer::ID> removed_ids{};
+  const auto write_removed = [&write_line,
+                              &removed_ids](const Customer::ID id) {
+    std::string line{REMOVED_MARKER};
+    line += std::to_string(id);
+    write_line(line);
+    removed_ids.push_back(id);
+  };
+
+  std::string line{GENERATION_HEADER_MARKER};
+  line += std::to_string(std::time(nullptr));
+  line += SERIALIZATION_DELIMITER;
+  line += std::to_string(sequence);
+  line += SERIALIZATION_DELIMITER;
+  line += std::to_string(last_customer_id);
+  write_line(line);
+
+  // Both sides are sorted by ID, so each is walked only once
+  std::ostringstream record{};
+  std::size_t previous{};
+  for (const auto& customer : customers) {
+    serialize(customer.second, record, line);
+    const std::uint64_t hash = utilities::checksum(line.data(), line.size());
+
+    while (previous < previous_ids.size() &&
+           previous_ids[previous] < customer.first) {
+      write_removed(previous_ids[previous++]);
+    }
+    bool unchanged = false;
+    if (previous < previous_ids.size() &&
+        previous_ids[previous] == customer.first) {
+      unchanged = previous_hashes[previous++] == hash;
+    }
+    if (!unchanged) {
+      write_line(line);
+      written_ids.push_back(customer.first);
+      written_hashes.push_back(hash);
+    }
+  }
+  while (previous < previous_ids.size()) {
+    write_removed(previous_ids[previous++]);
+  }
+
+  result.customers_ = written_ids.size();
+  result.removed_ = removed_ids.size();
+
+  // Written before the generation, so that every generation has its hashes
+  file_stream.close();
+  return !file_stream.fail() &&
+         WriteHashes(result.generation_, written_ids, written_hashes,
+                     removed_ids, result.bytes_) &&
+         utilities::sync_file(temporary_path) &&
+         utilities::replace_file(temporary_path, path);
+}
+
+bool BackupSet::Restore(const std::time_t at, CustomerMap& customers,
+                        std::uint64_t& sequence,
+                        Customer::ID& last_customer_id,
+                        RestoreSummary& result) const {
+  const TraceSpan trace_span{"backup", "BackupSet::Restore"};
+  result = RestoreSummary{};
+
+  std::vector<Generation> generations{};
+  if (!ListGenerations(generations)) {
+    return false;
+  }
+
+  std::size_t base = generations.size();
+  for (std::size_t i = 0U; i < generations.size(); i++) {
+    if (generations[i].full_ && generations[i].created_ <= at) {
+      base = i;
+    }
+  }
+  if (base == generations.size()) {
+    return false;
+  }
+
+  // A later full generation was necessarily taken after the point in time
+  std::size_t last = base;
+  for (std::size_t i = base + 1U; i < generations.size() &&
+                                  !generations[i].full_ &&
+                                  generations[i].created_ <= at;
+       i++) {
+    if (generations[i].number_ != generations[last].number_ + 1U) {
+      return false;
+    }
+    last = i;
+  }
+
+  for (std::size_t i = base; i <= last; i++) {
+    if (!Apply(generations[i], customers)) {
+      return false;
+    }
+  }
+
+  sequence = generations[last].sequence_;
+  last_customer_id = generations[last].last_customer_id_;
+  result.base_generation_ = generations[base].number_;
+  result.generation_ = generations[last].number_;
+  result.created_ = generations[last].created_;
+  result.deltas_ = last - base;
+  return true;
+}
+
+bool BackupSet::RestoreArchive(const std::string& archive_path) const {
+  std::size_t copied{};
+  std::uint64_t bytes{};
+  return CopyNewFiles(directory_path_ + "/" + ARCHIVE_DIRECTORY, archive_path,
+                      copied, bytes);
+}
+
+bool BackupSet::ListGenerations(std::vector<Generation>& generations) const {
+  std::vector<std::string> file_names{};
+  if (!utilities::list_directory(directory_path_, file_names)) {
+    // Nothing backed up yet
+    return true;
+  }
+
+  for (const auto& file_name : file_names) {
+    Generation generation{};
+    std::size_t digits{};
+    if (ends_with(file_name, FULL_SUFFIX)) {
+      generation.full_ = true;
+      digits = file_name.size() - (sizeof(FULL_SUFFIX) - 1U);
+    } else if (ends_with(file_name, DELTA_SUFFIX)) {
+      digits = file_name.size() - (sizeof(DELTA_SUFFIX) - 1U);
+    } else {
+      continue;
+    }
+    const std::string number{file_name.substr(0U, digits)};
+    if (number.empty() ||
+        !std::all_of(number.cbegin(), number.cend(),
+                     [](const char c) { return c >= '0' && c <= '9'; }) ||
+        !utilities::try_convert(number, generation.number_)) {
+      continue;
+    }
+    generation.path_ = directory_path_ + "/" + file_name;
+
+    std::ifstream file_stream{generation.path_};
+    std::string line{};
+    if (!std::getline(file_stream, line) || !utilities::strip_crc32c(line) ||
+        line.empty() || line[0] != GENERATION_HEADER_MARKER) {
+      return false;
+    }
+    std::stringstream header{line.substr(1U)};
+    std::string created{};
+    std::string sequence{};
+    std::string last_customer_id{};
+    std::getline(header, created, SERIALIZATION_DELIMITER);
+    std::getline(header, sequence, SERIALIZATION_DELIMITER);
+    std::getline(header, last_customer_id);
+    if (!utilities::try_convert(created, generation.created_) ||
+        !utilities::try_convert(sequence, generation.sequence_) ||
+        !utilities::try_convert(last_customer_id,
+                                generation.last_customer_id_)) {
+      return false;
+    }
+    generations.push_back(std::move(generation));
+  }
+
+  std::sort(generations.begin(), generations.end(),
+            [](const Generation& left, const Generation& right) {
+              return left.number_ < right.number_;
+            });
+  return true;
+}
+
+bool BackupSet::ReadHashes(const std::vector<Generation>& generations,
+                           std::vector<Customer::ID>& ids,
+                           std::vector<std::uint64_t>& hashes) const {
+  std::size_t base = generations.size();
+  for (std::size_t i = 0U; i < generations.size(); i++) {
+    if (generations[i].full_) {
+      base = i;
+    }
+  }
+  if (base == generations.size()) {
+    return false;
+  }
+
+  std::vector<Customer::ID> merged_ids{};
+  std::vector<std::uint64_t> merged_hashes{};
+  for (std::size_t i = base; i < generations.size(); i++) {
+    const std::uint64_t generation = generations[i].number_;
+    if (generation != generations[base].number_ + (i - base)) {
+      return false;
+    }
+
+    std::ifstream file_stream{GetPath(generation, HASHES_SUFFIX),
+                              std::ios::binary};
+    if (!file_stream.good()) {
+      return false;
+    }
+    const std::string content{std::istreambuf_iterator<char>{file_stream},
+                              std::istreambuf_iterator<char>{}};
+
+    const std::size_t magic_size{sizeof(HASHES_MAGIC) - 1U};
+    if (content.size() < HASHES_HEADER_SIZE ||
+        content.compare(0U, magic_size, HASHES_MAGIC) != 0) {
+      return false;
+    }
+
+    std::uint64_t written{};
+    std::uint64_t removed{};
+    std::uint64_t checksum{};
+    const char* const header = content.data() + magic_size;
+    std::memcpy(&written, header, sizeof(written));
+    std::memcpy(&removed, header + sizeof(written), sizeof(removed));
+    std::memcpy(&checksum, header + sizeof(written) + sizeof(removed),
+                sizeof(checksum));
+
+    const char* body = content.data() + HASHES_HEADER_SIZE;
+    const std::size_t body_size = content.size() - HASHES_HEADER_SIZE;
+    if (body_size != written * (sizeof(Customer::ID) + sizeof(std::uint64_t)) +
+                         removed * sizeof(Customer::ID) ||
+        utilities::checksum(body, body_size) != checksum) {
+      return false;
+    }
+
+    std::vector<Customer::ID> written_ids(written);
+    std::vector<std::uint64_t> written_hashes(written);
+    std::vector<Customer::ID> removed_ids(removed);
+    // Empty vectors may have no storage at all
+    if (written > 0U) {
+      std::memcpy(written_ids.data(), body, written * sizeof(Customer::ID));
+      body += written * sizeof(Customer::ID);
+      std::memcpy(written_hashes.data(), body,
+                  written * sizeof(std::uint64_t));
+      body += written * sizeof(std::uint64_t);
+    }
+    if (removed > 0U) {
+      std::memcpy(removed_ids.data(), body, removed * sizeof(Customer::ID));
+    }
+
+    // All three are sorted by ID, so the generation is merged in one pass
+    merged_ids.clear();
+    merged_hashes.clear();
+    merged_ids.reserve(ids.size() + written_ids.size());
+    merged_hashes.reserve(ids.size() + written_ids.size());
+    std::size_t kept{};
+    std::size_t changed{};
+    auto removal = removed_ids.cbegin();
+    while (kept < ids.size() || changed < written_ids.size()) {
+      if (changed == written_ids.size() ||
+          (kept < ids.size() && ids[kept] < written_ids[changed])) {
+        while (removal != removed_ids.cend() && *removal < ids[kept]) {
+          ++removal;
+        }
+        if (removal == removed_ids.cend() || *removal != ids[kept]) {
+          merged_ids.push_back(ids[kept]);
+          merged_hashes.push_back(hashes[kept]);
+        }
+        kept++;
+        continue;
+      }
+
+      if (kept < ids.size() && ids[kept] == written_ids[changed]) {
+        kept++;
+      }
+      merged_ids.push_back(written_ids[changed]);
+      merged_hashes.push_back(written_hashes[changed]);
+      changed++;
+    }
+    ids.swap(merged_ids);
+    hashes.swap(merged_hashes);
+  }
+  return true;
+}
+
+bool BackupSet::WriteHashes(const std::uint64_t generation,
+                            const std::vector<Customer::ID>& ids,
+                            const std::vector<std::uint64_t>& hashes,
+                            const std::vector<Customer::ID>& removed,
+                            std::uint64_t& bytes) const {
+  std::string body{};
+  body.reserve(ids.size() * (sizeof(Customer::ID) + sizeof(std::uint64_t)) +
+               removed.size() * sizeof(Customer::ID));
+  body.append(reinterpret_cast<const char*>(ids.data()),
+              ids.size() * sizeof(Customer::ID));
+  body.append(reinterpret_cast<const char*>(hashes.data()),
+              hashes.size() * sizeof(std::uint64_t));
+  body.append(reinterpret_cast<const char*>(removed.data()),
+              removed.size() * sizeof(Customer::ID));
+
+  std::string file{HASHES_MAGIC};
+  file.reserve(HASHES_HEADER_SIZE + body.size());
+  append_bytes(file, static_cast<std::uint64_t>(ids.size()));
+  append_bytes(file, static_cast<std::uint64_t>(removed.size()));
+  append_bytes(file, utilities::checksum(body.data(), body.size()));
+  file += body;
+  bytes += file.size();
+  return utilities::write_file(GetPath(generation, HASHES_SUFFIX), file);
+}
+
+std::string BackupSet::GetPath(const std::uint64_t generation,
+                               const char* suffix) const {
+  std::ostringstream path{};
+  path << directory_path_ << '/' << std::setw(GENERATION_DIGITS)
+       << std::setfill('0') << generation << suffix;
+  return path.str();
+}
+
+bool BackupSet::Apply(const Generation& generation, CustomerMap& customers) {
+  std::ifstream file_stream{generation.path_};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string line{};
+  bool header = true;
+  while (std::getline(file_stream, line)) {
+    if (!utilities::strip_crc32c(line)) {
+      return false;
+    }
+    if (header) {
+      // Already read by ListGenerations()
+      header = false;
+      continue;
+    }
+
+    if (!line.empty() && line[0] == REMOVED_MARKER) {
+      Customer::ID id{};
+      if (!utilities::try_convert(line.substr(1U), id)) {
+        return false;
+      }
+      customers.erase(id);
+      continue;
+    }
+
+    std::stringstream ss{line};
+    Customer customer{};
+    ss >> customer;
+    if (!customer.IsValid()) {
+      return false;
+    }
+    customers[customer.id_] = std::move(customer);
+  }
+  return !file_stream.bad();
+}
+
+bool BackupSet::CopyNewFiles(const std::string& source_path,
+                             const std::string& destination_path,
+                             std::size_t& copied, std::uint64_t& bytes) {
+  std::vector<std::string> source_names{};
+  if (!utilities::list_directory(source_path, source_names)) {
+    // Nothing archived yet
+    return true;
+  }
+
+  std::vector<std::string> destination_names{};
+  if (!utilities::create_directory(destination_path) ||
+      !utilities::list_directory(destination_path, destination_names)) {
+    return false;
+  }
+  std::sort(destination_names.begin(), destination_names.end());
+
+  for (const auto& file_name : source_names) {
+    if (ends_with(file_name, TEMPORARY_SUFFIX) ||
+        std::binary_search(destination_names.cbegin(),
+                           destination_names.cend(), file_name)) {
+      continue;
+    }
+
+    // Copied aside first, so that an interrupted copy is copied again
+    const std::string path{destination_path + "/" + file_name};
+    const std::string temporary_path{path + TEMPORARY_SUFFIX};
+    std::ifstream file_stream{source_path + "/" + file_name,
+                              std::ios::binary | std::ios::ate};
+    if (!utilities::copy_file(source_path + "/" + file_name,
+                              temporary_path) ||
+        !utilities::sync_file(temporary_path) ||
+        !utilities::replace_file(temporary_path, path)) {
+      return false;
+    }
+    copied++;
+    bytes += static_cast<std::uint64_t>(file_stream.tellg());
+  }
+  return true;
+}
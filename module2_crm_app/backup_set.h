@@ -0,0 +1,177 @@
+#ifndef __BACKUP_SET_H__
+#define __BACKUP_SET_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "customers.h"
+
+/// @brief Chain of backups of the customers kept in a directory: a full
+/// generation holding every customer, followed by delta generations holding
+/// only the customers changed, added or removed since the previous one, so
+/// that the nightly backup writes as much as the daily churn rather than the
+/// whole database.
+///
+/// Every generation is a TSV file, "<generation>.full.tsv" or
+/// "<generation>.delta.tsv", whose header holds the time it was taken, the
+/// sequence number of the last batch of changes it includes and the highest
+/// customer ID ever assigned. Lines are customer records as in the snapshot,
+/// or "-<id>" for removed customers, each ending with its CRC32C.
+///
+/// Changed customers are found by comparing a hash of each record with the
+/// ones of the previous generations. Every generation comes with a
+/// "<generation>.hashes" file listing the hashes of the records it holds and
+/// the customers it removes, so the hashes are tracked without reading the
+/// generations back and without rewriting them all on every backup. The
+/// sealed segments of the archive never change, so only the new ones are
+/// copied, to the "archive" subdirectory.
+class BackupSet {
+ public:
+  /// @brief Outcome of a backup
+  struct BackupSummary {
+    /// @brief Generation written
+    std::uint64_t generation_;
+    /// @brief Whether the generation holds every customer
+    bool full_;
+    /// @brief Customers written
+    std::size_t customers_;
+    /// @brief Customers marked as removed
+    std::size_t removed_;
+    /// @brief Archive segment files copied
+    std::size_t archive_files_;
+    /// @brief Bytes written, archive and hashes included
+    std::uint64_t bytes_;
+  };
+
+  /// @brief Outcome of a restore
+  struct RestoreSummary {
+    /// @brief Full generation the restore started from
+    std::uint64_t base_generation_;
+    /// @brief Last generation applied
+    std::uint64_t generation_;
+    /// @brief When the last generation applied was taken, as a UNIX
+    /// Timestamp
+    std::time_t created_;
+    /// @brief Delta generations applied on top of the full one
+    std::size_t deltas_;
+  };
+
+  // No default, move and copy constructors/operators
+  BackupSet() = delete;
+  BackupSet(const BackupSet&) = delete;
+  BackupSet& operator=(const BackupSet&) = delete;
+  BackupSet(BackupSet&&) = delete;
+  BackupSet& operator=(BackupSet&&) = delete;
+
+  /// @brief Binds to a directory, created on the first backup
+  /// @param directory_path Directory holding the generations
+  explicit BackupSet(const std::string& directory_path);
+
+  /// @brief Writes a new generation. A full one is written when asked to,
+  /// when the directory holds none yet or when the hashes of a generation
+  /// since the latest full one are missing or corrupted.
+  /// @param customers All customers
+  /// @param sequence Sequence number of the last batch applied to them
+  /// @param last_customer_id Highest customer ID ever assigned
+  /// @param archive_path Directory of the archive segments of the database
+  /// @param full Whether to write every customer, even if unchanged
+  /// @param result Where to store the outcome
+  /// @return False if the generation or its hashes cannot be written
+  bool Write(const CustomerMap& customers, const std::uint64_t sequence,
+             const Customer::ID last_customer_id,
+             const std::string& archive_path, const bool full,
+             BackupSummary& result) const;
+
+  /// @brief Rebuilds the customers as of a point in time, from the latest
+  /// full generation taken by then and the delta generations following it
+  /// @param at Point in time as a UNIX Timestamp
+  /// @param customers Where to store the customers, expected empty
+  /// @param sequence Where to store the sequence number of the last batch
+  /// included
+  /// @param last_customer_id Where to store the highest customer ID ever
+  /// assigned
+  /// @param result Where to store the outcome
+  /// @return False if no full generation was taken by then, a generation is
+  /// missing from the chain or a line does not match its checksum
+  bool Restore(const std::time_t at, CustomerMap& customers,
+               std::uint64_t& sequence, Customer::ID& last_customer_id,
+               RestoreSummary& result) const;
+
+  /// @brief Copies the archive segments of the backups to the archive of a
+  /// database. Segments sealed after the restored generation are discarded
+  /// by the archive itself when the database is opened.
+  /// @param archive_path Directory of the archive segments of the database
+  /// @return False if a segment cannot be copied
+  bool RestoreArchive(const std::string& archive_path) const;
+
+ private:
+  /// @brief Generation found in the directory
+  struct Generation {
+    std::uint64_t number_;
+    bool full_;
+    std::string path_;
+    std::time_t created_;
+    std::uint64_t sequence_;
+    Customer::ID last_customer_id_;
+  };
+
+  /// @brief Lists the generations in the directory, reading their headers
+  /// @param generations Where to store the generations, oldest first
+  /// @return False if the header of a generation is missing or corrupted
+  bool ListGenerations(std::vector<Generation>& generations) const;
+
+  /// @brief Rebuilds the hashes of the customers as of the latest
+  /// generation, from the hashes of the generations since the latest full one
+  /// @param generations Generations in the directory, oldest first
+  /// @param ids Where to store the IDs of the customers, ascending
+  /// @param hashes Where to store the hashes of their records
+  /// @return False if there is no full generation or hashes are missing or
+  /// corrupted
+  bool ReadHashes(const std::vector<Generation>& generations,
+                  std::vector<Customer::ID>& ids,
+                  std::vector<std::uint64_t>& hashes) const;
+
+  /// @brief Writes the hashes of a generation
+  /// @param generation Generation number
+  /// @param ids IDs of the customers written, ascending
+  /// @param hashes Hashes of their records
+  /// @param removed IDs of the customers removed, ascending
+  /// @param bytes Where to add the size of the file
+  /// @return False if the file cannot be written
+  bool WriteHashes(const std::uint64_t generation,
+                   const std::vector<Customer::ID>& ids,
+                   const std::vector<std::uint64_t>& hashes,
+                   const std::vector<Customer::ID>& removed,
+                   std::uint64_t& bytes) const;
+
+  /// @brief Path of a file of a generation
+  /// @param generation Generation number
+  /// @param suffix Suffix of the file
+  /// @return Path within the directory
+  std::string GetPath(const std::uint64_t generation,
+                      const char* suffix) const;
+
+  /// @brief Applies the lines of a generation to the customers
+  /// @param generation Generation to apply
+  /// @param customers Customers to update
+  /// @return False if the file cannot be read or a line is corrupted
+  static bool Apply(const Generation& generation, CustomerMap& customers);
+
+  /// @brief Copies the files of a directory missing from another one
+  /// @param source_path Directory to copy from
+  /// @param destination_path Directory to copy to, created if needed
+  /// @param copied Where to add the number of files copied
+  /// @param bytes Where to add the bytes copied
+  /// @return False if a file cannot be copied
+  static bool CopyNewFiles(const std::string& source_path,
+                           const std::string& destination_path,
+                           std::size_t& copied, std::uint64_t& bytes);
+
+  /// @brief Directory holding the generations
+  std::string directory_path_;
+};
+
+#endif  // __BACKUP_SET_H__
@@ -0,0 +1,103 @@
+#include "benchmark.h"
+
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+#include "customers.h"
+#include "storage_engine.h"
+
+namespace {
+
+/// @brief Converts a duration to fractional milliseconds
+/// @param duration Duration to convert
+/// @return Milliseconds
+double to_milliseconds(const std::chrono::nanoseconds duration) {
+  return static_cast<double>(duration.count()) / 1000000.0;
+}
+
+}  // namespace
+
+LoadBenchmark::LoadBenchmark(const Config& config) : config_{config} {}
+
+std::int32_t LoadBenchmark::Run() {
+  std::vector<Sample> system_samples{};
+  std::vector<Sample> arena_samples{};
+
+  // Alternated, so that both modes see the same state of the page cache
+  for (std::uint32_t i = 0U; i < config_.benchmark_iterations_; i++) {
+    Sample system_sample{};
+    Sample arena_sample{};
+    if (!RunOnce(true, system_sample) || !RunOnce(false, arena_sample)) {
+      std::cout << "Impossibile caricare il database." << std::endl;
+      return EXIT_FAILURE;
+    }
+    system_samples.push_back(system_sample);
+    arena_samples.push_back(arena_sample);
+  }
+
+  std::cout << "Clienti: " << arena_samples.front().customers_
+            << ", iterazioni: " << config_.benchmark_iterations_ << std::endl
+            << std::endl;
+
+  std::cout << std::left << std::setw(12) << "Allocatore" << std::right
+            << std::setw(14) << "load (ms)" << std::setw(16)
+            << "teardown (ms)" << std::setw(14) << "allocazioni"
+            << std::setw(12) << "di sistema" << std::setw(12) << "riusati"
+            << std::setw(16) << "riservati (KiB)" << std::endl;
+
+  PrintRow("sistema", system_samples);
+  PrintRow("arena", arena_samples);
+  return EXIT_SUCCESS;
+}
+
+bool LoadBenchmark::RunOnce(const bool passthrough, Sample& sample) const {
+  auto engine = StorageEngine::Create(config_.storage_engine_,
+                                      config_.database_path_, true);
+  if (engine == nullptr) {
+    return false;
+  }
+
+  Arena::Handle arena{Arena::Create(passthrough)};
+  Arena* const arena_pointer = arena.get();
+  std::uint64_t sequence{};
+  Customer::ID last_customer_id{};
+
+  auto start = std::chrono::steady_clock::now();
+  {
+    ArenaScope arena_scope{arena_pointer};
+    CustomerMap customers{CustomerMap::allocator_type{arena_pointer}};
+    if (!engine->Load(customers, sequence, last_customer_id)) {
+      return false;
+    }
+    sample.load_ = std::chrono::steady_clock::now() - start;
+    sample.customers_ = customers.size();
+    sample.stats_ = arena_pointer->GetStats();
+
+    start = std::chrono::steady_clock::now();
+  }
+  // Gives the chunks back all at once, no block is in use anymore
+  arena.reset();
+  sample.teardown_ = std::chrono::steady_clock::now() - start;
+  return true;
+}
+
+void LoadBenchmark::PrintRow(const char* mode,
+                             const std::vector<Sample>& samples) const {
+  double load_ms{};
+  double teardown_ms{};
+  for (const auto& sample : samples) {
+    load_ms += to_milliseconds(sample.load_);
+    teardown_ms += to_milliseconds(sample.teardown_);
+  }
+  const double count = static_cast<double>(samples.size());
+
+  // Allocations do not change between iterations
+  const Arena::Stats& stats = samples.front().stats_;
+  std::cout << std::left << std::setw(12) << mode << std::right << std::fixed
+            << std::setprecision(1) << std::setw(14) << load_ms / count
+            << std::setw(16) << teardown_ms / count << std::setw(14)
+            << stats.allocations_ << std::setw(12)
+            << stats.system_allocations_ << std::setw(12) << stats.reused_
+            << std::setw(16) << stats.reserved_bytes_ / 1024U << std::endl;
+}
@@ -0,0 +1,55 @@
+#ifndef __BENCHMARK_H__
+#define __BENCHMARK_H__
+
+#include <chrono>
+#include <cstdint>
+
+#include "arena.h"
+#include "config.h"
+
+/// @brief Measures loading and freeing the snapshot of the database, once
+/// with every allocation going to the system allocator and once with the
+/// customers held in an Arena, and reports time and allocation counts.
+class LoadBenchmark {
+ public:
+  // No default, move and copy constructors/operators
+  LoadBenchmark() = delete;
+  LoadBenchmark(const LoadBenchmark&) = delete;
+  LoadBenchmark& operator=(const LoadBenchmark&) = delete;
+  LoadBenchmark(LoadBenchmark&&) = delete;
+  LoadBenchmark& operator=(LoadBenchmark&&) = delete;
+
+  /// @brief Prepares the benchmark
+  /// @param config Options of the benchmark: database, storage engine and
+  /// number of iterations
+  explicit LoadBenchmark(const Config& config);
+
+  /// @brief Runs the benchmark and prints the report
+  /// @return Exit status code
+  std::int32_t Run();
+
+ private:
+  /// @brief Outcome of a single load
+  struct Sample {
+    std::size_t customers_;
+    std::chrono::nanoseconds load_;
+    std::chrono::nanoseconds teardown_;
+    Arena::Stats stats_;
+  };
+
+  /// @brief Loads the snapshot once and frees it
+  /// @param passthrough Whether the arena forwards every allocation to the
+  /// system allocator
+  /// @param sample Where to store the measurements
+  /// @return False if the snapshot cannot be loaded
+  bool RunOnce(const bool passthrough, Sample& sample) const;
+
+  /// @brief Prints the average of the samples of a mode
+  /// @param mode Name of the mode
+  /// @param samples Measurements of every iteration
+  void PrintRow(const char* mode, const std::vector<Sample>& samples) const;
+
+  Config config_;
+};
+
+#endif  // __BENCHMARK_H__
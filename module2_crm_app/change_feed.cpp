@@ -0,0 +1,146 @@
+#include "change_feed.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+namespace {
+
+/// @brief How long the writer thread sleeps when there is nothing to write
+constexpr std::chrono::milliseconds WRITER_IDLE_INTERVAL{10};
+
+}  // namespace
+
+constexpr std::size_t ChangeFeed::DEFAULT_CAPACITY;
+
+ChangeSubscription::ChangeSubscription(const std::size_t capacity)
+    : events_{capacity}, dropped_events_{0U} {}
+
+bool ChangeSubscription::Poll(ChangeEvent& event) {
+  return events_.TryPop(event);
+}
+
+std::uint64_t ChangeSubscription::GetDroppedEvents() const {
+  return dropped_events_.load(std::memory_order_relaxed);
+}
+
+void ChangeSubscription::Deliver(ChangeEvent event) {
+  if (!events_.TryPush(std::move(event))) {
+    dropped_events_.fetch_add(1U, std::memory_order_relaxed);
+  }
+}
+
+ChangeFeed::ChangeFeed()
+    : subscribers_{std::make_shared<const Subscribers>()},
+      subscribers_mutex_{},
+      last_event_id_{} {}
+
+std::shared_ptr<ChangeSubscription> ChangeFeed::Subscribe(
+    const std::size_t capacity) {
+  auto subscription = std::make_shared<ChangeSubscription>(capacity);
+
+  std::lock_guard<std::mutex> lock{subscribers_mutex_};
+  auto subscribers = std::make_shared<Subscribers>(*std::atomic_load(&subscribers_));
+  subscribers->push_back(subscription);
+  std::atomic_store(&subscribers_,
+                    std::shared_ptr<const Subscribers>{std::move(subscribers)});
+
+  return subscription;
+}
+
+void ChangeFeed::Unsubscribe(
+    const std::shared_ptr<ChangeSubscription>& subscription) {
+  std::lock_guard<std::mutex> lock{subscribers_mutex_};
+  auto subscribers = std::make_shared<Subscribers>(*std::atomic_load(&subscribers_));
+  subscribers->erase(
+      std::remove(subscribers->begin(), subscribers->end(), subscription),
+      subscribers->end());
+  std::atomic_store(&subscribers_,
+                    std::shared_ptr<const Subscribers>{std::move(subscribers)});
+}
+
+void ChangeFeed::Publish(const std::uint64_t batch_sequence,
+                         const std::vector<Change>& changes) {
+  const auto subscribers = std::atomic_load(&subscribers_);
+
+  for (const auto& change : changes) {
+    ChangeEvent event{};
+    event.event_id_ = ++last_event_id_;
+    event.batch_sequence_ = batch_sequence;
+    event.change_ = change;
+
+    for (const auto& subscriber : *subscribers) {
+      subscriber->Deliver(event);
+    }
+  }
+}
+
+ChangeLogWriter::ChangeLogWriter(ChangeFeed& change_feed,
+                                 const std::string& path,
+                                 const std::uint64_t max_file_size,
+                                 const std::uint32_t max_files)
+    : change_feed_{change_feed},
+      subscription_{change_feed.Subscribe()},
+      path_{path},
+      max_file_size_{max_file_size},
+      max_files_{max_files},
+      file_stream_{path, std::ios::out | std::ios::app},
+      file_size_{},
+      running_{true},
+      thread_{} {
+  file_stream_.seekp(0, std::ios::end);
+  file_size_ = static_cast<std::uint64_t>(file_stream_.tellp());
+  thread_ = std::thread{&ChangeLogWriter::Run, this};
+}
+
+ChangeLogWriter::~ChangeLogWriter() {
+  running_ = false;
+  thread_.join();
+
+  change_feed_.Unsubscribe(subscription_);
+  Drain();
+}
+
+void ChangeLogWriter::Run() {
+  while (running_) {
+    Drain();
+    std::this_thread::sleep_for(WRITER_IDLE_INTERVAL);
+  }
+}
+
+void ChangeLogWriter::Drain() {
+  ChangeEvent event{};
+  bool written = false;
+
+  while (subscription_->Poll(event)) {
+    if (file_size_ >= max_file_size_) {
+      Rotate();
+    }
+
+    const auto position = file_stream_.tellp();
+    file_stream_ << event;
+    file_size_ += static_cast<std::uint64_t>(file_stream_.tellp() - position);
+    written = true;
+  }
+
+  if (written) {
+    file_stream_.flush();
+  }
+}
+
+void ChangeLogWriter::Rotate() {
+  file_stream_.close();
+
+  // Shift <path>.N-1 into <path>.N, dropping the oldest one
+  std::remove((path_ + "." + std::to_string(max_files_)).c_str());
+  for (std::uint32_t i = max_files_; i > 1U; i--) {
+    std::rename((path_ + "." + std::to_string(i - 1U)).c_str(),
+                (path_ + "." + std::to_string(i)).c_str());
+  }
+  if (max_files_ > 0U) {
+    std::rename(path_.c_str(), (path_ + ".1").c_str());
+  }
+
+  file_stream_.open(path_, std::ios::out | std::ios::trunc);
+  file_size_ = 0U;
+}
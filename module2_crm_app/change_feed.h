@@ -0,0 +1,173 @@
+#ifndef __CHANGE_FEED_H__
+#define __CHANGE_FEED_H__
+
+#include <atomic>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "changes.h"
+#include "ring_buffer.h"
+
+/// @brief A change published by the Database once it has been persisted
+struct ChangeEvent {
+  /// @brief Position of the event in the feed, increasing by one for every
+  /// published event. A jump means events have been dropped.
+  std::uint64_t event_id_;
+  /// @brief Sequence number of the committed batch the change belongs to
+  std::uint64_t batch_sequence_;
+  /// @brief The change itself
+  Change change_;
+
+  ChangeEvent() : event_id_{}, batch_sequence_{}, change_{} {}
+
+  /// @brief Stream overload to serialize the event into a single line
+  /// @param os Output stream where to serialize the data into
+  /// @param event Event to serialize
+  /// @return Reference to the output stream
+  friend std::ostream& operator<<(std::ostream& os, const ChangeEvent& event) {
+    os << event.event_id_ << SERIALIZATION_DELIMITER;
+    os << event.batch_sequence_ << SERIALIZATION_DELIMITER;
+    os << event.change_;
+    return os;
+  }
+};
+
+/// @brief Queue of events delivered to a single subscriber. The Database
+/// never waits for a subscriber: when the queue is full, new events are
+/// dropped and counted, so slow consumers only ever hurt themselves.
+class ChangeSubscription {
+ public:
+  // No default, move and copy constructors/operators
+  ChangeSubscription() = delete;
+  ChangeSubscription(const ChangeSubscription&) = delete;
+  ChangeSubscription& operator=(const ChangeSubscription&) = delete;
+  ChangeSubscription(ChangeSubscription&&) = delete;
+  ChangeSubscription& operator=(ChangeSubscription&&) = delete;
+
+  explicit ChangeSubscription(const std::size_t capacity);
+
+  /// @brief Takes the oldest pending event. Must always be called from the
+  /// same thread.
+  /// @param event Where to store the event
+  /// @return False if no event is pending, true otherwise
+  bool Poll(ChangeEvent& event);
+
+  /// @brief Number of events that could not be delivered because the queue
+  /// was full
+  /// @return Number of dropped events
+  std::uint64_t GetDroppedEvents() const;
+
+ private:
+  friend class ChangeFeed;
+
+  /// @brief Delivers an event, dropping it if the queue is full
+  /// @param event Event to deliver
+  void Deliver(ChangeEvent event);
+
+  RingBuffer<ChangeEvent> events_;
+  std::atomic<std::uint64_t> dropped_events_;
+};
+
+/// @brief Publishes the changes persisted by the Database, in commit order,
+/// to all registered subscribers.
+/// Events must be published from one thread at a time, i.e. the thread
+/// writing to the Database.
+class ChangeFeed {
+ public:
+  /// @brief Default number of events a subscriber can have pending
+  static constexpr std::size_t DEFAULT_CAPACITY{4096U};
+
+  ChangeFeed();
+
+  // No move and copy constructors/operators
+  ChangeFeed(const ChangeFeed&) = delete;
+  ChangeFeed& operator=(const ChangeFeed&) = delete;
+  ChangeFeed(ChangeFeed&&) = delete;
+  ChangeFeed& operator=(ChangeFeed&&) = delete;
+
+  /// @brief Registers a new subscriber. It receives all events published
+  /// from now on.
+  /// @param capacity Maximum number of pending events before dropping
+  /// @return Subscription to poll events from
+  std::shared_ptr<ChangeSubscription> Subscribe(
+      const std::size_t capacity = DEFAULT_CAPACITY);
+
+  /// @brief Stops delivering events to a subscriber
+  /// @param subscription Subscription returned by Subscribe()
+  void Unsubscribe(const std::shared_ptr<ChangeSubscription>& subscription);
+
+  /// @brief Publishes a committed batch of changes
+  /// @param batch_sequence Sequence number of the batch
+  /// @param changes Changes of the batch, in commit order
+  void Publish(const std::uint64_t batch_sequence,
+               const std::vector<Change>& changes);
+
+ private:
+  using Subscribers = std::vector<std::shared_ptr<ChangeSubscription>>;
+
+  /// @brief Current list of subscribers. Replaced as a whole on every
+  /// (un)subscription, so publishing never waits for the mutex.
+  std::shared_ptr<const Subscribers> subscribers_;
+
+  /// @brief Serializes (un)subscriptions
+  std::mutex subscribers_mutex_;
+
+  /// @brief ID assigned to the last published event
+  std::uint64_t last_event_id_;
+};
+
+/// @brief Writes every event of a ChangeFeed to a set of rotating files from
+/// a background thread. The current file is <path>, older ones are renamed
+/// to <path>.1, <path>.2, ... and the oldest one beyond the limit is deleted.
+/// Events dropped because the writer fell behind show up as gaps in the
+/// event IDs.
+class ChangeLogWriter {
+ public:
+  // No default, move and copy constructors/operators
+  ChangeLogWriter() = delete;
+  ChangeLogWriter(const ChangeLogWriter&) = delete;
+  ChangeLogWriter& operator=(const ChangeLogWriter&) = delete;
+  ChangeLogWriter(ChangeLogWriter&&) = delete;
+  ChangeLogWriter& operator=(ChangeLogWriter&&) = delete;
+
+  /// @brief Subscribes to the feed and starts writing
+  /// @param change_feed Feed to follow
+  /// @param path Path of the current log file
+  /// @param max_file_size Size in bytes after which the file is rotated
+  /// @param max_files Number of rotated files to keep
+  explicit ChangeLogWriter(ChangeFeed& change_feed, const std::string& path,
+                           const std::uint64_t max_file_size,
+                           const std::uint32_t max_files);
+
+  /// @brief Writes all pending events, then stops
+  ~ChangeLogWriter();
+
+ private:
+  /// @brief Body of the background thread
+  void Run();
+
+  /// @brief Writes all pending events
+  void Drain();
+
+  /// @brief Closes the current file and shifts the older ones
+  void Rotate();
+
+  ChangeFeed& change_feed_;
+  std::shared_ptr<ChangeSubscription> subscription_;
+  std::string path_;
+  std::uint64_t max_file_size_;
+  std::uint32_t max_files_;
+
+  std::fstream file_stream_;
+  std::uint64_t file_size_;
+
+  std::atomic<bool> running_;
+  std::thread thread_;
+};
+
+#endif  // __CHANGE_FEED_H__
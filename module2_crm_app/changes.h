@@ -0,0 +1,92 @@
+#ifndef __CHANGES_H__
+#define __CHANGES_H__
+
+#include <cstdint>
+#include <iostream>
+#include <string>
+
+#include "customers.h"
+#include "utilities.h"
+
+/// @brief Describes a single mutation of the customer book. Every write to the
+/// Database is expressed as a Change, so that it can be staged inside a
+/// Transaction and applied later on.
+struct Change {
+  /// @brief Kind of mutation
+  enum class EType : std::uint32_t {
+    ADD_CUSTOMER = 1,
+    UPDATE_CUSTOMER,
+    REMOVE_CUSTOMER,
+    ADD_INTERACTION,
+    /// Moves every interaction older than a cutoff out of memory, into the
+    /// sealed segments of the InteractionArchive. Not bound to a customer.
+    ARCHIVE_INTERACTIONS,
+
+    INVALID = UINT32_MAX,
+  };
+
+  /// @brief Kind of mutation
+  EType type_;
+  /// @brief Customer affected by the mutation
+  Customer::ID id_;
+  /// @brief Name for customer changes, date for interactions, cutoff
+  /// timestamp for archival
+  std::string first_;
+  /// @brief Surname for customer changes, description for interactions
+  std::string second_;
+
+  Change() : type_{EType::INVALID}, id_{INVALID_CUSTOMER_ID} {}
+
+  explicit Change(EType type, Customer::ID id, const std::string& first = "",
+                  const std::string& second = "")
+      : type_{type}, id_{id}, first_{first}, second_{second} {}
+
+  /// @brief Stream overload to serialize a change into a single line.
+  /// @param os Output stream where to serialize the data into
+  /// @param change Change to serialize
+  /// @return Reference to the output stream
+  friend std::ostream& operator<<(std::ostream& os, const Change& change) {
+    os << static_cast<std::uint32_t>(change.type_) << SERIALIZATION_DELIMITER;
+    os << change.id_ << SERIALIZATION_DELIMITER;
+    os << change.first_ << SERIALIZATION_DELIMITER;
+    os << change.second_ << std::endl;
+    return os;
+  }
+
+  /// @brief Stream overload to deserialize a change from a single line.
+  /// On malformed input the type is set to INVALID.
+  /// @param is Input stream to read the data from
+  /// @param change Change to store the extracted data into
+  /// @return Reference to the input stream
+  friend std::istream& operator>>(std::istream& is, Change& change) {
+    std::string type{};
+    std::string id{};
+    std::uint32_t type_value{};
+
+    change.type_ = EType::INVALID;
+    if (!std::getline(is, type, SERIALIZATION_DELIMITER) ||
+        !std::getline(is, id, SERIALIZATION_DELIMITER) ||
+        !std::getline(is, change.first_, SERIALIZATION_DELIMITER) ||
+        !utilities::try_convert(type, type_value) ||
+        !utilities::try_convert(id, change.id_)) {
+      return is;
+    }
+
+    // Empty for some kinds of changes (e.g. removals): the line ending right
+    // there is not a malformed change
+    change.second_.clear();
+    if (!std::getline(is, change.second_) && is.eof()) {
+      is.clear(std::ios::eofbit);
+    }
+
+    if (type_value >= static_cast<std::uint32_t>(EType::ADD_CUSTOMER) &&
+        type_value <=
+            static_cast<std::uint32_t>(EType::ARCHIVE_INTERACTIONS)) {
+      change.type_ = static_cast<EType>(type_value);
+    }
+
+    return is;
+  }
+};
+
+#endif  // __CHANGES_H__
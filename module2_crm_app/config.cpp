@@ -0,0 +1,277 @@
+#include "config.h"
+
+#include <iostream>
+
+#include "tracer.h"
+#include "utilities.h"
+
+bool Config::FromCommandLine(const int argc, const char* const argv[],
+                             Config& config) {
+  for (int i = 1; i < argc; i++) {
+    const std::string argument{argv[i]};
+    const bool has_value = (i + 1) < argc;
+
+    if (argument == "--database" && has_value) {
+      config.database_path_ = argv[++i];
+    } else if (argument == "--storage" && has_value) {
+      const std::string storage_engine{argv[++i]};
+      if (storage_engine == "tsv") {
+        config.storage_engine_ = EStorageEngine::TSV;
+      } else if (storage_engine == "lsm") {
+        config.storage_engine_ = EStorageEngine::LSM;
+      } else {
+        return false;
+      }
+    } else if (argument == "--replica") {
+      config.replica_ = true;
+    } else if (argument == "--max-lag" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.replica_max_lag_ms_)) {
+        return false;
+      }
+    } else if (argument == "--change-log" && has_value) {
+      config.change_log_path_ = argv[++i];
+    } else if (argument == "--change-log-size" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.change_log_size_mb_)) {
+        return false;
+      }
+    } else if (argument == "--archive-after" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.archive_after_months_)) {
+        return false;
+      }
+    } else if (argument == "--tenants" && has_value) {
+      config.tenants_directory_ = argv[++i];
+    } else if (argument == "--tenant" && has_value) {
+      config.tenant_ = argv[++i];
+    } else if (argument == "--memory-budget" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.memory_budget_mb_)) {
+        return false;
+      }
+    } else if (argument == "--idle-timeout" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.tenant_idle_timeout_s_)) {
+        return false;
+      }
+    } else if (argument == "--remind" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.reminder_minutes_)) {
+        return false;
+      }
+    } else if (argument == "--record" && has_value) {
+      config.record_path_ = argv[++i];
+    } else if (argument == "--trace" && has_value) {
+      config.trace_path_ = argv[++i];
+    } else if (argument == "--concurrency" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.replay_concurrency_) ||
+          config.replay_concurrency_ == 0U) {
+        return false;
+      }
+    } else if (argument == "--speedup" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.replay_speedup_)) {
+        return false;
+      }
+    } else if (argument == "--iterations" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.benchmark_iterations_) ||
+          config.benchmark_iterations_ == 0U) {
+        return false;
+      }
+    } else if (argument == "--id" && has_value) {
+      config.filter_id_ = argv[++i];
+    } else if (argument == "--name" && has_value) {
+      config.filter_name_ = argv[++i];
+    } else if (argument == "--surname" && has_value) {
+      config.filter_surname_ = argv[++i];
+    } else if (argument == "--text" && has_value) {
+      config.filter_text_ = argv[++i];
+    } else if (argument == "--contains" && has_value) {
+      config.filter_name_part_ = argv[++i];
+    } else if (argument == "--from" && has_value) {
+      config.filter_from_ = argv[++i];
+    } else if (argument == "--to" && has_value) {
+      config.filter_to_ = argv[++i];
+    } else if (argument == "--kind" && has_value) {
+      config.filter_kind_ = argv[++i];
+    } else if (argument == "--explain") {
+      config.explain_ = true;
+    } else if (argument == "--ids" && has_value) {
+      config.filter_ids_path_ = argv[++i];
+    } else if (argument == "--threads" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.export_threads_)) {
+        return false;
+      }
+    } else if (argument == "--full") {
+      config.backup_full_ = true;
+    } else if (argument == "--at" && has_value) {
+      config.restore_at_ = argv[++i];
+    } else if (argument == "--customers" && has_value) {
+      if (!utilities::try_convert(argv[++i], config.projected_customers_)) {
+        return false;
+      }
+    } else if (argument == "--interactions" && has_value) {
+      if (!utilities::try_convert(argv[++i],
+                                  config.projected_interactions_)) {
+        return false;
+      }
+    } else if (argument == "--format" && has_value) {
+      const std::string output_format{argv[++i]};
+      if (output_format == "tsv") {
+        config.output_format_ = EOutputFormat::TSV;
+      } else if (output_format == "json") {
+        config.output_format_ = EOutputFormat::JSON;
+      } else if (output_format == "csv") {
+        config.output_format_ = EOutputFormat::CSV;
+      } else if (output_format == "fixed") {
+        config.output_format_ = EOutputFormat::FIXED_WIDTH;
+      } else {
+        return false;
+      }
+    } else if (argument.compare(0, 2, "--") == 0) {
+      return false;
+    } else if (config.command_.empty()) {
+      config.command_ = argument;
+    } else {
+      config.command_arguments_.push_back(argument);
+    }
+  }
+
+  return config.command_.empty() || config.command_ == "replay" ||
+         config.command_ == "benchmark" || config.command_ == "verify" ||
+         config.command_ == "find" || config.command_ == "interactions" ||
+         config.command_ == "count" || config.command_ == "import-scores" ||
+         config.command_ == "export" || config.command_ == "backup" ||
+         config.command_ == "restore" || config.command_ == "stats";
+}
+
+void Config::PrintUsage(const char* program_name) {
+  std::cout
+      << "Utilizzo: " << program_name << " [comando] [opzioni]" << std::endl
+      << std::endl
+      << "Senza comando viene avviato il menu interattivo." << std::endl
+      << "  --database <percorso>     File del database (default: "
+      << DEFAULT_DATABASE_PATH << ")" << std::endl
+      << "  --storage <tsv|lsm>       Formato dei dati su disco: un unico "
+         "file TSV (default) o un LSM-tree in <database>.lsm"
+      << std::endl
+      << "  --replica                 Apre il database in sola lettura e "
+         "segue le modifiche del processo principale"
+      << std::endl
+      << "  --max-lag <ms>            Ritardo massimo della replica "
+         "(default: "
+      << DEFAULT_REPLICA_MAX_LAG_MS << ")" << std::endl
+      << "  --change-log <percorso>   Scrive ogni modifica salvata su file a "
+         "rotazione"
+      << std::endl
+      << "  --change-log-size <MiB>   Dimensione oltre la quale il file viene "
+         "ruotato (default: "
+      << DEFAULT_CHANGE_LOG_SIZE_MB << ")" << std::endl
+      << "  --archive-after <mesi>    Archivia le interazioni più vecchie, 0 "
+         "per disattivare (default: "
+      << DEFAULT_ARCHIVE_AFTER_MONTHS << ")" << std::endl
+      << "  --tenants <cartella>      Ospita i database di più agenzie, uno "
+         "per file <cartella>/<agenzia>.tsv"
+      << std::endl
+      << "  --tenant <agenzia>        Agenzia da aprire all'avvio" << std::endl
+      << "  --memory-budget <MiB>     Memoria oltre la quale le agenzie "
+         "inattive vengono chiuse (default: "
+      << DEFAULT_MEMORY_BUDGET_MB << ")" << std::endl
+      << "  --idle-timeout <s>        Inattività dopo cui un'agenzia viene "
+         "chiusa (default: "
+      << DEFAULT_TENANT_IDLE_TIMEOUT_S << ")" << std::endl
+      << "  --remind <minuti>         Ricorda gli appuntamenti con il "
+         "numero di minuti di anticipo indicato (default: 0, nessun "
+         "promemoria)"
+      << std::endl
+      << "  --record <percorso>       Registra la sessione per poterla "
+         "riprodurre"
+      << std::endl
+      << "  --trace <percorso>        Registra la traccia temporale delle "
+         "operazioni, apribile con Perfetto. SIGUSR1 la attiva e disattiva "
+         "e scrive quanto registrato finora (default: "
+      << DEFAULT_TRACE_PATH << ")" << std::endl
+      << std::endl
+      << "Comandi:" << std::endl
+      << "  replay <percorso>         Riproduce una sessione registrata e "
+         "misura la latenza dei comandi"
+      << std::endl
+      << "    --concurrency <n>       Sessioni eseguite in parallelo "
+         "(default: "
+      << DEFAULT_REPLAY_CONCURRENCY << ")" << std::endl
+      << "    --speedup <n>           Accelera le pause tra i comandi, 0 per "
+         "eliminarle (default: 0)"
+      << std::endl
+      << "  benchmark                 Misura tempi e allocazioni del "
+         "caricamento del database, con e senza arena"
+      << std::endl
+      << "    --iterations <n>        Caricamenti eseguiti per modalità "
+         "(default: "
+      << DEFAULT_BENCHMARK_ITERATIONS << ")" << std::endl
+      << "  verify                    Controlla il checksum di ogni cliente "
+         "salvato, senza caricare il database"
+      << std::endl
+      << "  import-scores <percorso>  Importa i punteggi dei clienti da un "
+         "file CSV (id,punteggio) o binario, ordinato per ID"
+      << std::endl
+      << "  find                      Elenca i clienti che soddisfano i "
+         "filtri, almeno uno obbligatorio"
+      << std::endl
+      << "  interactions --id <id>    Elenca le interazioni di un cliente"
+      << std::endl
+      << "  count                     Conta i clienti che soddisfano i "
+         "filtri, tutti se non ce ne sono"
+      << std::endl
+      << "    --id <id>               Filtra per ID del cliente" << std::endl
+      << "    --name <nome>           Filtra per nome esatto" << std::endl
+      << "    --surname <cognome>     Filtra per cognome esatto" << std::endl
+      << "    --text <testo>          Filtra per testo contenuto nel nome, "
+         "nel cognome o nelle interazioni"
+      << std::endl
+      << "    --contains <testo>      Filtra per testo contenuto nel nome o "
+         "nel cognome, senza distinguere maiuscole e minuscole"
+      << std::endl
+      << "    --from <gg/mm/aaaa>     Filtra per interazioni a partire dal "
+         "giorno indicato"
+      << std::endl
+      << "    --to <gg/mm/aaaa>       Filtra per interazioni fino al giorno "
+         "indicato"
+      << std::endl
+      << "    --kind <tipo>           Filtra per interazioni del tipo "
+         "indicato: appuntamento, contratto o nota"
+      << std::endl
+      << "    --explain               Mostra come verrebbe eseguita la "
+         "ricerca (find e count), senza eseguirla"
+      << std::endl
+      << "    --format <tsv|json>     Formato dei risultati (default: tsv)"
+      << std::endl
+      << "  export <customers|interactions> <percorso>" << std::endl
+      << "                            Esporta l'elenco dei clienti o delle "
+         "loro interazioni"
+      << std::endl
+      << "    --format <tsv|csv|fixed> Formato del file, fixed a larghezza "
+         "fissa (default: tsv)"
+      << std::endl
+      << "    --from, --to, --kind    Filtrano le interazioni come per find"
+      << std::endl
+      << "    --ids <percorso>        Esporta solo i clienti elencati nel "
+         "file, un ID per riga"
+      << std::endl
+      << "    --threads <n>           Thread usati per formattare, 0 per uno "
+         "per core (default: 0)"
+      << std::endl
+      << "  backup <cartella>         Salva i clienti cambiati dall'ultimo "
+         "backup, tutti al primo"
+      << std::endl
+      << "    --full                  Salva tutti i clienti e inizia una "
+         "nuova catena di backup"
+      << std::endl
+      << "  restore <cartella>        Ricostruisce il database, che non deve "
+         "esistere, dai backup"
+      << std::endl
+      << "    --at <gg/mm/aaaa hh:mm> Momento da ripristinare (default: "
+         "ultimo backup)"
+      << std::endl
+      << "  stats                     Mostra il tempo di caricamento e la "
+         "memoria occupata, per categoria"
+      << std::endl
+      << "    --customers <n>         Stima la memoria per n clienti"
+      << std::endl
+      << "    --interactions <n>      Stima la memoria per n interazioni "
+         "(default: in proporzione ai clienti)"
+      << std::endl;
+}
@@ -0,0 +1,197 @@
+#ifndef __CONFIG_H__
+#define __CONFIG_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "storage_engine.h"
+
+/// @brief Default path where the database is stored
+#define DEFAULT_DATABASE_PATH "./data.tsv"
+
+/// @brief Default maximum lag of a replica, in milliseconds
+#define DEFAULT_REPLICA_MAX_LAG_MS 1000U
+
+/// @brief Default size in MiB after which the change log is rotated
+#define DEFAULT_CHANGE_LOG_SIZE_MB 16U
+
+/// @brief Number of rotated change log files kept
+#define CHANGE_LOG_MAX_FILES 8U
+
+/// @brief Default number of months of interactions kept in memory, older
+/// ones are archived
+#define DEFAULT_ARCHIVE_AFTER_MONTHS 18U
+
+/// @brief Default memory budget of the open tenants, in MiB
+#define DEFAULT_MEMORY_BUDGET_MB 1024U
+
+/// @brief Default number of seconds after which an idle tenant is closed
+#define DEFAULT_TENANT_IDLE_TIMEOUT_S 600U
+
+/// @brief Default number of sessions replayed concurrently
+#define DEFAULT_REPLAY_CONCURRENCY 1U
+
+/// @brief Default number of times the snapshot is loaded by the benchmark
+#define DEFAULT_BENCHMARK_ITERATIONS 5U
+
+/// @brief Output formats of the query commands
+enum class EOutputFormat : std::uint32_t {
+  /// One record per line, fields separated by tabs, with a header line
+  TSV = 1,
+  /// A JSON document
+  JSON,
+  /// One record per line, fields separated by commas and quoted when needed,
+  /// with a header line. Only for exports.
+  CSV,
+  /// One record per line, every field padded or truncated to a fixed width,
+  /// without header. Only for exports.
+  FIXED_WIDTH,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Runtime options of the App, parsed from the command line.
+/// The first argument not starting with "--" selects a non-interactive
+/// command (e.g. "replay"), the following ones are its arguments.
+struct Config {
+  /// @brief Non-interactive command to run, empty to start the App
+  std::string command_;
+  /// @brief Positional arguments of the command
+  std::vector<std::string> command_arguments_;
+  /// @brief Path where the database is loaded from/saved to
+  std::string database_path_;
+  /// @brief How customers are stored on disk
+  EStorageEngine storage_engine_;
+  /// @brief Whether to run as a read-only replica following another crm
+  /// process that writes to database_path_
+  bool replica_;
+  /// @brief How stale, in milliseconds, the data of a replica may get
+  std::uint32_t replica_max_lag_ms_;
+  /// @brief Where to write the stream of persisted changes, disabled if empty
+  std::string change_log_path_;
+  /// @brief Size in MiB after which the change log is rotated
+  std::uint32_t change_log_size_mb_;
+  /// @brief Months of interactions kept in memory before being archived, 0
+  /// to never archive them
+  std::uint32_t archive_after_months_;
+  /// @brief Directory holding the databases of all tenants, empty to host a
+  /// single database at database_path_
+  std::string tenants_directory_;
+  /// @brief Tenant selected at startup, the App asks for one if empty
+  std::string tenant_;
+  /// @brief Memory the open tenants may hold before idle ones are closed, in
+  /// MiB
+  std::uint32_t memory_budget_mb_;
+  /// @brief Seconds after which an idle tenant is closed
+  std::uint32_t tenant_idle_timeout_s_;
+  /// @brief Minutes before an appointment the App reminds of it, 0 to send
+  /// no reminders
+  std::uint32_t reminder_minutes_;
+  /// @brief Where to record the answers typed during the session, disabled
+  /// if empty
+  std::string record_path_;
+  /// @brief Where to write the trace of the run, tracing starts turned off
+  /// if empty
+  std::string trace_path_;
+  /// @brief Number of sessions replayed at the same time
+  std::uint32_t replay_concurrency_;
+  /// @brief How many times faster than recorded the think time between
+  /// commands is replayed, 0 to skip it entirely
+  std::uint32_t replay_speedup_;
+  /// @brief How many times the benchmark loads the snapshot
+  std::uint32_t benchmark_iterations_;
+  /// @brief Customer ID the query commands filter on, empty if not set
+  std::string filter_id_;
+  /// @brief Exact name the query commands filter on, empty if not set
+  std::string filter_name_;
+  /// @brief Exact surname the query commands filter on, empty if not set
+  std::string filter_surname_;
+  /// @brief Text the query commands look for, empty if not set
+  std::string filter_text_;
+  /// @brief Part of the name or surname the query commands filter on,
+  /// ignoring case, empty if not set
+  std::string filter_name_part_;
+  /// @brief Start date of the interactions the query commands filter on, as
+  /// Giorno/Mese/Anno, empty if not set
+  std::string filter_from_;
+  /// @brief End date of the interactions the query commands filter on, as
+  /// Giorno/Mese/Anno, empty if not set
+  std::string filter_to_;
+  /// @brief Kind of the interactions the query commands filter on
+  /// (appuntamento, contratto or nota), empty if not set
+  std::string filter_kind_;
+  /// @brief Whether find and count print how the query would be executed,
+  /// instead of its results
+  bool explain_;
+  /// @brief File listing the IDs of the customers an export is limited to,
+  /// one per line, empty to export every customer
+  std::string filter_ids_path_;
+  /// @brief Whether the backup command writes every customer instead of
+  /// only the ones changed since the previous backup
+  bool backup_full_;
+  /// @brief Point in time the restore command goes back to, as
+  /// Giorno/Mese/Anno Ora:Minuti, empty for the latest backup
+  std::string restore_at_;
+  /// @brief Customers the stats command projects the memory for, 0 if not
+  /// set
+  std::uint64_t projected_customers_;
+  /// @brief Interactions the stats command projects the memory for, 0 if
+  /// not set
+  std::uint64_t projected_interactions_;
+  /// @brief How the query commands print their results
+  EOutputFormat output_format_;
+  /// @brief Threads formatting an export, 0 to use one per hardware thread
+  std::uint32_t export_threads_;
+
+  Config()
+      : command_{},
+        command_arguments_{},
+        database_path_{DEFAULT_DATABASE_PATH},
+        storage_engine_{EStorageEngine::TSV},
+        replica_{false},
+        replica_max_lag_ms_{DEFAULT_REPLICA_MAX_LAG_MS},
+        change_log_path_{},
+        change_log_size_mb_{DEFAULT_CHANGE_LOG_SIZE_MB},
+        archive_after_months_{DEFAULT_ARCHIVE_AFTER_MONTHS},
+        tenants_directory_{},
+        tenant_{},
+        memory_budget_mb_{DEFAULT_MEMORY_BUDGET_MB},
+        tenant_idle_timeout_s_{DEFAULT_TENANT_IDLE_TIMEOUT_S},
+        reminder_minutes_{0U},
+        record_path_{},
+        trace_path_{},
+        replay_concurrency_{DEFAULT_REPLAY_CONCURRENCY},
+        replay_speedup_{0U},
+        benchmark_iterations_{DEFAULT_BENCHMARK_ITERATIONS},
+        filter_id_{},
+        filter_name_{},
+        filter_surname_{},
+        filter_text_{},
+        filter_name_part_{},
+        filter_from_{},
+        filter_to_{},
+        filter_kind_{},
+        explain_{false},
+        filter_ids_path_{},
+        backup_full_{false},
+        restore_at_{},
+        projected_customers_{0U},
+        projected_interactions_{0U},
+        output_format_{EOutputFormat::TSV},
+        export_threads_{0U} {}
+
+  /// @brief Parses the command line arguments
+  /// @param argc Number of arguments
+  /// @param argv Arguments, the first being the program name
+  /// @param config Where to store the parsed options
+  /// @return False if an argument is unknown or malformed, true otherwise
+  static bool FromCommandLine(const int argc, const char* const argv[],
+                              Config& config);
+
+  /// @brief Prints the available command line options to screen
+  /// @param program_name Name of the executable
+  static void PrintUsage(const char* program_name);
+};
+
+#endif  // __CONFIG_H__
@@ -1,104 +1,273 @@
-#include "crm.h"
-
-#include <iostream>
-#include <memory>
-
-CRM::CRM(const std::string& database_path) : database_{database_path} {}
-
-bool CRM::AddCustomer(const std::string& name, const std::string& surname) {
-  if (database_.HasCustomer(name, surname)) {
-    return false;
-  }
-
-  return database_.AddCustomer(name, surname) != INVALID_CUSTOMER_ID;
-}
-
-bool CRM::PrintAllCustomers() const {
-  bool has_customers = false;
-
-  for (const auto& customer_entry : database_.GetCustomers()) {
-    const Customer& customer = customer_entry.second;
-    customer.PrintInfo();
-
-    has_customers = true;
-  }
-
-  return has_customers;
-}
-
-void CRM::PrintCustomersByID(
-    const std::vector<Customer::ID>& customer_ids) const {
-  for (const auto& id : customer_ids) {
-    if (!database_.HasCustomer(id)) {
-      continue;
-    }
-
-    const auto& customer = database_.GetCustomer(id);
-    customer.PrintInfo();
-  }
-}
-
-bool CRM::FindCustomers(const std::string& id, const std::string& name,
-                        const std::string& surname,
-                        std::vector<Customer::ID>& found_customers) const {
-  Customer::ID customer_id{};
-
-  if (utilities::try_convert(id, customer_id)) {
-    if (database_.HasCustomer(customer_id)) {
-      found_customers.emplace_back(customer_id);
-    }
-  } else {
-    for (const auto& customer_entry : database_.GetCustomers()) {
-      const Customer& customer = customer_entry.second;
-
-      if (!name.empty() && !surname.empty()) {
-        if (customer.name_ == name && customer.surname_ == surname) {
-          found_customers.emplace_back(customer.id_);
-        }
-      } else if (!name.empty()) {
-        if (customer.name_ == name) {
-          found_customers.emplace_back(customer.id_);
-        }
-      } else if (!surname.empty()) {
-        if (customer.surname_ == surname) {
-          found_customers.emplace_back(customer.id_);
-        }
-      }
-    }
-  }
-
-  return !found_customers.empty();
-}
-
-const Customer& CRM::GetCustomer(const Customer::ID id) const {
-  return database_.GetCustomer(id);
-}
-
-bool CRM::UpdateClientInfo(const Customer::ID id, const std::string& name,
-                           const std::string& surname) {
-  return database_.UpdateClientInfo(id, name, surname);
-}
-
-bool CRM::RemoveCustomer(const Customer::ID id) {
-  return database_.RemoveCustomer(id);
-}
-
-bool CRM::AddInteraction(const Customer::ID id, const std::string& when,
-                         const std::string& what) {
-  return database_.AddInteraction(id, when, what);
-}
-
-bool CRM::PrintCustomerInteractions(const Customer::ID id,
-                                    const std::time_t from_timestamp,
-                                    const std::time_t to_timestamp) const {
-  // shared_ptr's so we don't make unnecessary copies of objects
-  std::vector<std::shared_ptr<Interaction>> interactions{};
-  database_.GetCustomerInteractionsInRange(id, from_timestamp, to_timestamp,
-                                           interactions);
-
-  for (const auto& interaction : interactions) {
-    interaction->Print();
-  }
-
-  return !interactions.empty();
-}
+#include "crm.h"
+
+#include <iostream>
+#include <memory>
+
+#include "tracer.h"
+
+CRM::CRM(const std::string& database_path, const bool replica,
+         const std::chrono::milliseconds max_lag,
+         const EStorageEngine storage_engine)
+    : database_{database_path, replica, storage_engine},
+      query_planner_{database_},
+      max_lag_{max_lag},
+      last_refresh_{std::chrono::steady_clock::now()},
+      change_log_writer_{} {}
+
+bool CRM::IsReplica() const { return database_.IsReadOnly(); }
+
+bool CRM::Refresh() {
+  if (!database_.IsReadOnly()) {
+    return true;
+  }
+
+  const auto now = std::chrono::steady_clock::now();
+  if (now - last_refresh_ < max_lag_) {
+    return true;
+  }
+
+  last_refresh_ = now;
+  return database_.CatchUp();
+}
+
+bool CRM::GetCustomerInteractions(
+    const Customer::ID id, const std::time_t from_timestamp,
+    const std::time_t to_timestamp,
+    std::vector<std::shared_ptr<Interaction>>& interactions) const {
+  const TraceSpan trace_span{"crm", "CRM::GetCustomerInteractions"};
+  database_.GetCustomerInteractionsInRange(id, from_timestamp, to_timestamp,
+                                           interactions);
+  return !interactions.empty();
+}
+
+InteractionRange CRM::GetCustomerInteractions(
+    const Customer::ID id, const std::time_t from_timestamp,
+    const std::time_t to_timestamp) const {
+  return database_.GetCustomerInteractions(id, from_timestamp, to_timestamp);
+}
+
+void CRM::DeferPersistence() { database_.DeferPersistence(); }
+
+bool CRM::FlushDeferredChanges() { return database_.FlushDeferredChanges(); }
+
+bool CRM::ArchiveInteractions(const std::uint32_t hot_months) {
+  const TraceSpan trace_span{"crm", "CRM::ArchiveInteractions"};
+  return database_.ArchiveInteractions(hot_months);
+}
+
+std::uint64_t CRM::GetMemoryUsage() const {
+  return database_.GetMemoryUsage();
+}
+
+void CRM::GetAppointments(const std::time_t from_timestamp,
+                          const std::time_t to_timestamp,
+                          const std::size_t max_count,
+                          std::vector<Appointment>& appointments) const {
+  const TraceSpan trace_span{"crm", "CRM::GetAppointments"};
+  database_.GetAppointmentScheduler().GetAppointments(
+      from_timestamp, to_timestamp, max_count, appointments);
+}
+
+void CRM::StartReminders(
+    const std::time_t lead_time,
+    const AppointmentScheduler::ReminderCallback& callback) {
+  database_.GetAppointmentScheduler().StartReminders(lead_time, callback);
+}
+
+void CRM::StopReminders() {
+  database_.GetAppointmentScheduler().StopReminders();
+}
+
+std::shared_ptr<ChangeSubscription> CRM::SubscribeToChanges(
+    const std::size_t capacity) {
+  return database_.GetChangeFeed().Subscribe(capacity);
+}
+
+void CRM::UnsubscribeFromChanges(
+    const std::shared_ptr<ChangeSubscription>& subscription) {
+  database_.GetChangeFeed().Unsubscribe(subscription);
+}
+
+void CRM::EnableChangeLog(const std::string& path,
+                          const std::uint64_t max_file_size,
+                          const std::uint32_t max_files) {
+  change_log_writer_.reset();
+  change_log_writer_.reset(new ChangeLogWriter{
+      database_.GetChangeFeed(), path, max_file_size, max_files});
+}
+
+bool CRM::HasCustomer(const Customer::ID id) const {
+  return database_.HasCustomer(id);
+}
+
+bool CRM::AddCustomer(const std::string& name, const std::string& surname) {
+  const TraceSpan trace_span{"crm", "CRM::AddCustomer"};
+  if (database_.HasCustomer(name, surname)) {
+    return false;
+  }
+
+  return database_.AddCustomer(name, surname) != INVALID_CUSTOMER_ID;
+}
+
+std::size_t CRM::GetCustomerCount() const {
+  return database_.GetCustomers().size();
+}
+
+std::size_t CRM::PrintCustomerPage(const ECustomerOrder order,
+                                   Customer::ID& after,
+                                   const std::size_t count) const {
+  const TraceSpan trace_span{"crm", "CRM::PrintCustomerPage"};
+  std::vector<Customer::ID> page{};
+  if (!database_.GetCustomerPage(order, after, count, page)) {
+    database_.GetCustomerPage(order, INVALID_CUSTOMER_ID, count, page);
+  }
+
+  PrintCustomersByID(page);
+  if (!page.empty()) {
+    after = page.back();
+  }
+  return page.size();
+}
+
+void CRM::PrintCustomersByID(
+    const std::vector<Customer::ID>& customer_ids) const {
+  for (const auto& id : customer_ids) {
+    if (!database_.HasCustomer(id)) {
+      continue;
+    }
+
+    PrintCustomer(database_.GetCustomer(id));
+  }
+}
+
+const ActivitySummary& CRM::GetActivitySummary(const Customer::ID id) const {
+  return database_.GetActivitySummary(id);
+}
+
+bool CRM::PrintCustomerActivity(const Customer::ID id) const {
+  const ActivitySummary& summary = database_.GetActivitySummary(id);
+  if (!summary.HasInteractions()) {
+    return false;
+  }
+
+  std::cout << "Interazioni: " << summary.interaction_count_ << std::endl;
+  if (summary.IsDated()) {
+    std::cout << "Primo contatto: "
+              << utilities::to_date(summary.first_timestamp_, DATE_FORMAT)
+              << std::endl;
+    std::cout << "Ultimo contatto: "
+              << utilities::to_date(summary.last_timestamp_, DATE_FORMAT)
+              << std::endl;
+  }
+
+  if (summary.recent_count_ > 0U) {
+    std::cout << "Interazioni recenti:" << std::endl;
+    for (std::size_t i = 0U; i < summary.recent_count_; i++) {
+      summary.recent_[i]->Print();
+    }
+  }
+
+  return true;
+}
+
+void CRM::PrintCustomer(const Customer& customer) const {
+  const ActivitySummary& summary = database_.GetActivitySummary(customer.id_);
+
+  std::cout << customer.id_ << ") " << customer.name_ << " "
+            << customer.surname_;
+  if (summary.IsDated()) {
+    std::cout << " - ultimo contatto: "
+              << utilities::to_date(summary.last_timestamp_, DATE_FORMAT);
+  }
+  float score{};
+  if (database_.GetScore(customer.id_, score)) {
+    std::cout << " - punteggio: " << score;
+  }
+  std::cout << std::endl;
+}
+
+bool CRM::FindCustomers(const std::string& id, const std::string& name,
+                        const std::string& surname,
+                        std::vector<Customer::ID>& found_customers) const {
+  CustomerQuery query{};
+
+  if (utilities::try_convert(id, query.id_)) {
+    query.has_id_ = true;
+  } else {
+    query.name_ = name;
+    query.surname_ = surname;
+  }
+
+  return FindCustomers(query, found_customers);
+}
+
+bool CRM::FindCustomers(const CustomerQuery& query,
+                        std::vector<Customer::ID>& found_customers) const {
+  const TraceSpan trace_span{"crm", "CRM::FindCustomers"};
+  // An empty search does not select anything
+  if (query.IsEmpty()) {
+    return false;
+  }
+
+  query_planner_.Execute(query, found_customers);
+  return !found_customers.empty();
+}
+
+CustomerRange CRM::FindCustomers(const std::string_view name,
+                                 const std::string_view surname) const {
+  return database_.FindCustomers(name, surname);
+}
+
+QueryPlan CRM::ExplainQuery(const CustomerQuery& query) const {
+  return query_planner_.Plan(query);
+}
+
+const Customer& CRM::GetCustomer(const Customer::ID id) const {
+  return database_.GetCustomer(id);
+}
+
+bool CRM::UpdateClientInfo(const Customer::ID id, const std::string& name,
+                           const std::string& surname) {
+  const TraceSpan trace_span{"crm", "CRM::UpdateClientInfo"};
+  return database_.UpdateClientInfo(id, name, surname);
+}
+
+bool CRM::RemoveCustomer(const Customer::ID id) {
+  const TraceSpan trace_span{"crm", "CRM::RemoveCustomer"};
+  return database_.RemoveCustomer(id);
+}
+
+bool CRM::AddInteraction(const Customer::ID id, const std::string& when,
+                         const std::string& what) {
+  const TraceSpan trace_span{"crm", "CRM::AddInteraction"};
+  return database_.AddInteraction(id, when, what);
+}
+
+bool CRM::PrintCustomerInteractions(const Customer::ID id,
+                                    const std::time_t from_timestamp,
+                                    const std::time_t to_timestamp) const {
+  const TraceSpan trace_span{"crm", "CRM::PrintCustomerInteractions"};
+  // shared_ptr's so we don't make unnecessary copies of objects
+  std::vector<std::shared_ptr<Interaction>> interactions{};
+  database_.GetCustomerInteractionsInRange(id, from_timestamp, to_timestamp,
+                                           interactions);
+
+  for (const auto& interaction : interactions) {
+    interaction->Print();
+  }
+
+  return !interactions.empty();
+}
+
+Transaction CRM::BeginTransaction() const {
+  return database_.BeginTransaction();
+}
+
+bool CRM::CommitTransaction(Transaction& transaction) {
+  const TraceSpan trace_span{"crm", "CRM::CommitTransaction"};
+  return database_.CommitTransaction(transaction);
+}
+
+void CRM::RollbackTransaction(Transaction& transaction) const {
+  database_.RollbackTransaction(transaction);
+}
\ No newline at end of file
@@ -1,87 +1,277 @@
-#ifndef __CRM_H__
-#define __CRM_H__
-
-#include <ctime>
-#include <string>
-
-#include "database.h"
-
-/// @brief Manages all client information and interfaces directly with the
-/// database
-class CRM {
- public:
-  // No default, move and copy constructors/operators
-  CRM() = delete;
-  CRM(const CRM&) = delete;
-  CRM& operator=(const CRM&) = delete;
-  CRM(CRM&&) = delete;
-  CRM& operator=(CRM&&) = delete;
-
-  explicit CRM(const std::string& database_path);
-
-  /// @brief Adds a new customer
-  /// @param name Name of customer
-  /// @param surname Surname of customer
-  /// @return True if added, False if already exists
-  bool AddCustomer(const std::string& name, const std::string& surname);
-
-  /// @brief Prints all customer information to terminal
-  /// @return True if database has customers, false if none available
-  bool PrintAllCustomers() const;
-
-  /// @brief Prints the client information to terminal
-  /// @param customer_ids Set of client IDs whose information shall be printed
-  void PrintCustomersByID(const std::vector<Customer::ID>& customer_ids) const;
-
-  /// @brief Fetches the Client IDs of all customers that match the given search
-  /// criterias. All arguments are optional.
-  /// @param id Client ID
-  /// @param name Name
-  /// @param surname Surname
-  /// @param found_customers Where to store all found Client IDs
-  /// @return True if clients were found, false otherwise
-  bool FindCustomers(const std::string& id, const std::string& name,
-                     const std::string& surname,
-                     std::vector<Customer::ID>& found_customers) const;
-
-  /// @brief Gets the customer under the specified ID
-  /// @param id Client ID
-  /// @return Read-only Customer object containing all its information
-  const Customer& GetCustomer(const Customer::ID id) const;
-
-  /// @brief Updates the information of a client
-  /// @param id Client ID
-  /// @param name New name
-  /// @param surname New surname
-  /// @return False if client was not found, true otherwise
-  bool UpdateClientInfo(const Customer::ID id, const std::string& name,
-                        const std::string& surname);
-
-  /// @brief Deletes a client from the database
-  /// @param id Client ID
-  /// @return False if client was not found, true otherwise
-  bool RemoveCustomer(const Customer::ID id);
-
-  /// @brief Adds a new interaction to a given client
-  /// @param id Client ID
-  /// @param when String containing a valid date
-  /// @param what Description of the interaction
-  /// @return False if client was not found, true otherwise
-  bool AddInteraction(const Customer::ID id, const std::string& when,
-                      const std::string& what);
-
-  /// @brief Prints all client interactions in a user-specified time interval
-  /// @param id Client ID
-  /// @param from_timestamp Start date as a UNIX Timestamp
-  /// @param to_timestamp End date as a UNIX Timestamp
-  /// @return True if client had any interactions in the given timeframe, false
-  /// otherwise
-  bool PrintCustomerInteractions(const Customer::ID id,
-                                 const std::time_t from_timestamp,
-                                 const std::time_t to_timestamp) const;
-
- private:
-  Database database_;
-};
-
-#endif  // __CRM_H__
+#ifndef __CRM_H__
+#define __CRM_H__
+
+#include <chrono>
+#include <ctime>
+#include <memory>
+#include <string>
+#include <string_view>
+
+#include "database.h"
+#include "query.h"
+
+/// @brief Manages all client information and interfaces directly with the
+/// database
+class CRM {
+ public:
+  // No default, move and copy constructors/operators
+  CRM() = delete;
+  CRM(const CRM&) = delete;
+  CRM& operator=(const CRM&) = delete;
+  CRM(CRM&&) = delete;
+  CRM& operator=(CRM&&) = delete;
+
+  /// @brief Opens the CRM on the given database
+  /// @param database_path Path of the database file
+  /// @param replica When true, the database is opened read-only and follows
+  /// the changes persisted by the primary process through Refresh()
+  /// @param max_lag How stale the data of a replica may get before Refresh()
+  /// looks for new changes
+  /// @param storage_engine How customers are stored on disk
+  explicit CRM(const std::string& database_path, const bool replica = false,
+               const std::chrono::milliseconds max_lag =
+                   std::chrono::milliseconds{},
+               const EStorageEngine storage_engine = EStorageEngine::TSV);
+
+  /// @brief Checks whether this CRM is a read-only replica
+  /// @return True if changes are refused
+  bool IsReplica() const;
+
+  /// @brief Brings a replica up to date with the primary, if its data is
+  /// older than the configured maximum lag. Does nothing on a primary.
+  /// @return False if the replica could not catch up, true otherwise
+  bool Refresh();
+
+  /// @brief Collects the interactions of a client in a time interval
+  /// @param id Client ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param interactions Where to store the interactions found
+  /// @return True if any interaction was found, false otherwise
+  bool GetCustomerInteractions(
+      const Customer::ID id, const std::time_t from_timestamp,
+      const std::time_t to_timestamp,
+      std::vector<std::shared_ptr<Interaction>>& interactions) const;
+
+  /// @brief Visits the interactions of a client in a time interval as they
+  /// are iterated, without collecting them, see
+  /// Database::GetCustomerInteractions(). Archived interactions are not
+  /// visited.
+  /// @param id Client ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @return Lazy range of the interactions, valid until the next change
+  InteractionRange GetCustomerInteractions(
+      const Customer::ID id, const std::time_t from_timestamp,
+      const std::time_t to_timestamp) const;
+
+  /// @brief Starts collecting changes so that they are persisted together
+  /// by FlushDeferredChanges() (group commit)
+  void DeferPersistence();
+
+  /// @brief Persists all changes collected since DeferPersistence() with a
+  /// single write
+  /// @return False if the changes could not be saved, in which case they stay
+  /// collected for the next call, true otherwise
+  bool FlushDeferredChanges();
+
+  /// @brief Moves old interactions out of memory into the archive, see
+  /// Database::ArchiveInteractions()
+  /// @param hot_months Number of months of interactions kept in memory
+  /// @return False if the archive could not be written, true otherwise
+  bool ArchiveInteractions(const std::uint32_t hot_months);
+
+  /// @brief Memory held by the data of the CRM, see
+  /// Database::GetMemoryUsage()
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+  /// @brief Lists the appointments of all customers in a time interval, by
+  /// date, see AppointmentScheduler::GetAppointments()
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param max_count Maximum number of appointments to list
+  /// @param appointments Where to store the appointments
+  void GetAppointments(const std::time_t from_timestamp,
+                       const std::time_t to_timestamp,
+                       const std::size_t max_count,
+                       std::vector<Appointment>& appointments) const;
+
+  /// @brief Starts reminding of the appointments from a background thread
+  /// @param lead_time Seconds before the appointment the reminder is sent
+  /// @param callback Called for every reminder, from the background thread:
+  /// it must not access the CRM
+  void StartReminders(const std::time_t lead_time,
+                      const AppointmentScheduler::ReminderCallback& callback);
+
+  /// @brief Stops the reminders, if running
+  void StopReminders();
+
+  /// @brief Registers a subscriber for all changes persisted from now on
+  /// @param capacity Maximum number of events the subscriber can have pending
+  /// before new ones are dropped
+  /// @return Subscription to poll change events from
+  std::shared_ptr<ChangeSubscription> SubscribeToChanges(
+      const std::size_t capacity = ChangeFeed::DEFAULT_CAPACITY);
+
+  /// @brief Stops delivering changes to a subscriber
+  /// @param subscription Subscription returned by SubscribeToChanges()
+  void UnsubscribeFromChanges(
+      const std::shared_ptr<ChangeSubscription>& subscription);
+
+  /// @brief Starts writing all persisted changes to a set of rotating files
+  /// @param path Path of the current change log file
+  /// @param max_file_size Size in bytes after which the file is rotated
+  /// @param max_files Number of rotated files to keep
+  void EnableChangeLog(const std::string& path,
+                       const std::uint64_t max_file_size,
+                       const std::uint32_t max_files);
+
+  /// @brief Number of customers
+  /// @return Customer count
+  std::size_t GetCustomerCount() const;
+
+  /// @brief Checks if a customer exists
+  /// @param id Client ID
+  /// @return True if found, false otherwise
+  bool HasCustomer(const Customer::ID id) const;
+
+  /// @brief Adds a new customer
+  /// @param name Name of customer
+  /// @param surname Surname of customer
+  /// @return True if added, False if already exists
+  bool AddCustomer(const std::string& name, const std::string& surname);
+
+  /// @brief Prints a page of customers to terminal, in the given order
+  /// @param order Order of the listing
+  /// @param after ID of the last customer of the previous page,
+  /// INVALID_CUSTOMER_ID for the first page. Updated to the last customer
+  /// printed. If that customer has been removed meanwhile, the listing starts
+  /// over.
+  /// @param count Maximum number of customers to print
+  /// @return Number of customers printed, 0 once the listing is over
+  std::size_t PrintCustomerPage(const ECustomerOrder order,
+                                Customer::ID& after,
+                                const std::size_t count) const;
+
+  /// @brief Prints the client information to terminal
+  /// @param customer_ids Set of client IDs whose information shall be printed
+  void PrintCustomersByID(const std::vector<Customer::ID>& customer_ids) const;
+
+  /// @brief Summary of the interactions of a client
+  /// @param id Client ID
+  /// @return Summary, empty if the client has no interactions
+  const ActivitySummary& GetActivitySummary(const Customer::ID id) const;
+
+  /// @brief Prints the activity of a client to terminal: number of
+  /// interactions, first and last contact and the most recent interactions
+  /// @param id Client ID
+  /// @return False if the client has no interactions
+  bool PrintCustomerActivity(const Customer::ID id) const;
+
+  /// @brief Fetches the Client IDs of all customers that match the given search
+  /// criterias. All arguments are optional.
+  /// @param id Client ID
+  /// @param name Name
+  /// @param surname Surname
+  /// @param found_customers Where to store all found Client IDs
+  /// @return True if clients were found, false otherwise
+  bool FindCustomers(const std::string& id, const std::string& name,
+                     const std::string& surname,
+                     std::vector<Customer::ID>& found_customers) const;
+
+  /// @brief Fetches the Client IDs of all customers matching every criteria of
+  /// the query. The most selective index available is used to collect the
+  /// candidates, remaining criterias are checked on each of them.
+  /// @param query Search criterias
+  /// @param found_customers Where to store all found Client IDs
+  /// @return True if clients were found, false otherwise
+  bool FindCustomers(const CustomerQuery& query,
+                     std::vector<Customer::ID>& found_customers) const;
+
+  /// @brief Visits the clients with the given name and surname as they are
+  /// iterated, without collecting their IDs, see Database::FindCustomers().
+  /// Nothing is allocated, so it suits callers running many queries.
+  /// @param name Exact name, empty to match any
+  /// @param surname Exact surname, empty to match any
+  /// @return Lazy range of the clients, valid until the next change
+  CustomerRange FindCustomers(const std::string_view name,
+                              const std::string_view surname) const;
+
+  /// @brief Describes how a query would be executed, without running it
+  /// @param query Search criterias
+  /// @return Plan chosen for the query
+  QueryPlan ExplainQuery(const CustomerQuery& query) const;
+
+  /// @brief Gets the customer under the specified ID
+  /// @param id Client ID
+  /// @return Read-only Customer object containing all its information
+  const Customer& GetCustomer(const Customer::ID id) const;
+
+  /// @brief Updates the information of a client
+  /// @param id Client ID
+  /// @param name New name
+  /// @param surname New surname
+  /// @return False if client was not found, true otherwise
+  bool UpdateClientInfo(const Customer::ID id, const std::string& name,
+                        const std::string& surname);
+
+  /// @brief Deletes a client from the database
+  /// @param id Client ID
+  /// @return False if client was not found, true otherwise
+  bool RemoveCustomer(const Customer::ID id);
+
+  /// @brief Adds a new interaction to a given client
+  /// @param id Client ID
+  /// @param when String containing a valid date
+  /// @param what Description of the interaction
+  /// @return False if client was not found, true otherwise
+  bool AddInteraction(const Customer::ID id, const std::string& when,
+                      const std::string& what);
+
+  /// @brief Prints all client interactions in a user-specified time interval
+  /// @param id Client ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @return True if client had any interactions in the given timeframe, false
+  /// otherwise
+  bool PrintCustomerInteractions(const Customer::ID id,
+                                 const std::time_t from_timestamp,
+                                 const std::time_t to_timestamp) const;
+
+  /// @brief Opens a transaction to group multiple changes together, so that
+  /// they are either all applied or none of them is
+  /// @return Empty transaction
+  Transaction BeginTransaction() const;
+
+  /// @brief Applies and saves all changes staged in the transaction at once
+  /// @param transaction Transaction to commit
+  /// @return False if any change could not be applied or saved, true otherwise
+  bool CommitTransaction(Transaction& transaction);
+
+  /// @brief Discards all changes staged in the transaction
+  /// @param transaction Transaction to roll back
+  void RollbackTransaction(Transaction& transaction) const;
+
+ private:
+  /// @brief Prints a line of client information, with the date of the last
+  /// contact
+  /// @param customer Client to print
+  void PrintCustomer(const Customer& customer) const;
+
+  Database database_;
+
+  /// @brief Chooses how customer searches are executed
+  QueryPlanner query_planner_;
+
+  /// @brief Maximum age of the data of a replica
+  std::chrono::milliseconds max_lag_;
+
+  /// @brief When the replica last caught up with the primary
+  std::chrono::steady_clock::time_point last_refresh_;
+
+  /// @brief Writes the change feed to disk, if enabled
+  std::unique_ptr<ChangeLogWriter> change_log_writer_;
+};
+
+#endif  // __CRM_H__
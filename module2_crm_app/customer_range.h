@@ -0,0 +1,250 @@
+#ifndef __CUSTOMER_RANGE_H__
+#define __CUSTOMER_RANGE_H__
+
+#include <cstddef>
+#include <ctime>
+#include <iterator>
+#include <string_view>
+#include <vector>
+
+#include "customers.h"
+
+/// @brief Customers matching an exact name and surname, visited lazily: each
+/// step of the iteration looks up the next candidate, so nothing is copied or
+/// allocated however many customers match.
+///
+/// The candidates are either the IDs listed by a secondary index or, when
+/// there is no index to use, every customer. Empty filters match everything.
+/// Like any iterator over the Database, the range is only valid until the
+/// next change of the customers and the range must outlive its iterators.
+///
+/// The filters are looked up once in the StringPool, so that each candidate
+/// is checked by comparing integers; a filter missing from the pool matches
+/// no customer.
+class CustomerRange {
+ public:
+  /// @brief Forward iterator over the matching customers, in ID order
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Customer;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Customer*;
+    using reference = const Customer&;
+
+    Iterator() : range_{nullptr}, candidate_{}, customer_{} {}
+
+    reference operator*() const { return customer_->second; }
+    pointer operator->() const { return &customer_->second; }
+
+    Iterator& operator++() {
+      if (range_->candidates_ == nullptr) {
+        customer_ = range_->FindMatch(std::next(customer_));
+      } else {
+        customer_ = range_->FindMatch(++candidate_);
+      }
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator previous{*this};
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return customer_ == other.customer_;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class CustomerRange;
+
+    Iterator(const CustomerRange* range, const std::size_t candidate,
+             const CustomerMap::const_iterator customer)
+        : range_{range}, candidate_{candidate}, customer_{customer} {}
+
+    const CustomerRange* range_;
+    /// @brief Position of the current customer among the candidates, unused
+    /// when scanning every customer
+    std::size_t candidate_;
+    CustomerMap::const_iterator customer_;
+  };
+
+  /// @brief Creates the range
+  /// @param customers All customers
+  /// @param candidates Sorted IDs of the only customers that may match,
+  /// nullptr to check every customer
+  /// @param name Exact name to match, empty to match any
+  /// @param surname Exact surname to match, empty to match any
+  CustomerRange(const CustomerMap& customers,
+                const std::vector<Customer::ID>* candidates,
+                const std::string_view name, const std::string_view surname)
+      : customers_{&customers},
+        candidates_{candidates},
+        name_{},
+        surname_{},
+        unknown_{!InternedString::Find(name, name_) ||
+                 !InternedString::Find(surname, surname_)} {}
+
+  Iterator begin() const {
+    if (unknown_) {
+      return end();
+    }
+    std::size_t candidate{0U};
+    const auto customer = candidates_ != nullptr
+                              ? FindMatch(candidate)
+                              : FindMatch(customers_->cbegin());
+    return Iterator{this, candidate, customer};
+  }
+
+  Iterator end() const { return Iterator{this, 0U, customers_->cend()}; }
+
+  /// @brief Checks if no customer matches. Stops at the first match.
+  /// @return True if the range is empty
+  bool empty() const { return begin() == end(); }
+
+ private:
+  /// @brief Checks the filters on a customer, comparing pool handles
+  /// @param customer Candidate customer
+  /// @return True if the customer matches
+  bool Matches(const Customer& customer) const {
+    return (name_.IsEmpty() || customer.name_ == name_) &&
+           (surname_.IsEmpty() || customer.surname_ == surname_);
+  }
+
+  /// @brief Finds the first matching customer among the candidates
+  /// @param candidate Position of the candidate to start from, advanced to
+  /// the match
+  /// @return Matching customer, the end of the customers if none is left
+  CustomerMap::const_iterator FindMatch(std::size_t& candidate) const;
+
+  /// @brief Finds the first matching customer while scanning every customer
+  /// @param customer Customer to start from
+  /// @return Matching customer, the end of the customers if none is left
+  CustomerMap::const_iterator FindMatch(
+      CustomerMap::const_iterator customer) const {
+    while (customer != customers_->cend() && !Matches(customer->second)) {
+      ++customer;
+    }
+    return customer;
+  }
+
+  const CustomerMap* customers_;
+  const std::vector<Customer::ID>* candidates_;
+  InternedString name_;
+  InternedString surname_;
+  /// @brief Whether a filter is a string no customer holds
+  bool unknown_;
+};
+
+/// @brief Interactions of a customer within a time interval, filtered while
+/// iterating instead of being collected. Only the interactions in memory are
+/// visited: archived ones are read from disk by
+/// Database::GetCustomerInteractionsInRange(). Valid until the next change of
+/// the customer.
+class InteractionRange {
+ public:
+  using Interactions = decltype(Customer::customer_interactions_);
+
+  /// @brief Forward iterator over the interactions in the interval, oldest
+  /// first
+  class Iterator {
+   public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Interaction;
+    using difference_type = std::ptrdiff_t;
+    using pointer = const Interaction*;
+    using reference = const Interaction&;
+
+    Iterator() : range_{nullptr}, interaction_{} {}
+
+    reference operator*() const { return **interaction_; }
+    pointer operator->() const { return interaction_->get(); }
+
+    Iterator& operator++() {
+      interaction_ = range_->FindMatch(interaction_ + 1);
+      return *this;
+    }
+
+    Iterator operator++(int) {
+      Iterator previous{*this};
+      ++*this;
+      return previous;
+    }
+
+    bool operator==(const Iterator& other) const {
+      return interaction_ == other.interaction_;
+    }
+    bool operator!=(const Iterator& other) const { return !(*this == other); }
+
+   private:
+    friend class InteractionRange;
+
+    Iterator(const InteractionRange* range,
+             const Interactions::const_iterator interaction)
+        : range_{range}, interaction_{interaction} {}
+
+    const InteractionRange* range_;
+    Interactions::const_iterator interaction_;
+  };
+
+  /// @brief Creates the range
+  /// @param interactions Interactions of the customer, nullptr if the
+  /// customer does not exist
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  InteractionRange(const Interactions* interactions,
+                   const std::time_t from_timestamp,
+                   const std::time_t to_timestamp)
+      : interactions_{interactions != nullptr ? interactions
+                                              : &NoInteractions()},
+        from_timestamp_{from_timestamp},
+        to_timestamp_{to_timestamp} {}
+
+  Iterator begin() const {
+    return Iterator{this, FindMatch(interactions_->cbegin())};
+  }
+
+  Iterator end() const { return Iterator{this, interactions_->cend()}; }
+
+  /// @brief Checks if no interaction is in the interval
+  /// @return True if the range is empty
+  bool empty() const { return begin() == end(); }
+
+ private:
+  /// @brief Interactions of customers that do not exist
+  static const Interactions& NoInteractions() {
+    static const Interactions no_interactions{};
+    return no_interactions;
+  }
+
+  /// @brief Finds the first interaction in the interval
+  /// @param interaction Interaction to start from
+  /// @return Interaction found, the end of the interactions if none is left
+  Interactions::const_iterator FindMatch(
+      Interactions::const_iterator interaction) const {
+    while (interaction != interactions_->cend() &&
+           !(*interaction)->InRange(from_timestamp_, to_timestamp_)) {
+      ++interaction;
+    }
+    return interaction;
+  }
+
+  const Interactions* interactions_;
+  std::time_t from_timestamp_;
+  std::time_t to_timestamp_;
+};
+
+inline CustomerMap::const_iterator CustomerRange::FindMatch(
+    std::size_t& candidate) const {
+  for (; candidate < candidates_->size(); candidate++) {
+    const auto customer = customers_->find((*candidates_)[candidate]);
+    if (customer != customers_->cend() && Matches(customer->second)) {
+      return customer;
+    }
+  }
+  return customers_->cend();
+}
+
+#endif  // __CUSTOMER_RANGE_H__
@@ -1,160 +1,452 @@
-#ifndef __CUSTOMERS_H__
-#define __CUSTOMERS_H__
-
-#include <ctime>
-#include <fstream>
-#include <iostream>
-#include <memory>
-#include <string>
-#include <vector>
-
-#include "utilities.h"
-
-#define DATE_FORMAT "%d/%m/%Y %H:%M"
-#define SERIALIZATION_DELIMITER '\t'
-#define INVALID_CUSTOMER_ID 0U
-
-/// @brief Holds the information for a single interaction
-struct Interaction {
-  std::string when_;
-  std::string what_;
-
-  Interaction() = default;
-
-  explicit Interaction(const std::string& when, const std::string& what)
-      : when_{when}, what_{what} {}
-
-  /// @brief Stream overload to easily serialize the data into a stream.
-  /// Defined as a friend-method here for convenience, instead of having it in
-  /// global-scope.
-  /// @param os Output stream where to serialize the data into
-  /// @param interaction Interaction object to serialue
-  /// @return Reference to the output stream
-  friend std::ostream& operator<<(std::ostream& os,
-                                  const Interaction& interaction) {
-    os << interaction.when_ << SERIALIZATION_DELIMITER;
-    os << interaction.what_;
-    return os;
-  }
-
-  /// @brief Checks if the current interaction has a date within the supplied
-  /// timeframe
-  /// @param from_timestamp Start date as a UNIX Timestamp
-  /// @param to_timestamp End date as a UNIX Timestamp
-  /// @return True if date is within the given range, false otherwise
-  bool InRange(const std::time_t from_timestamp,
-               const std::time_t to_timestamp) const {
-    std::time_t timestamp{};
-    utilities::to_timestamp(when_, DATE_FORMAT, timestamp);
-
-    return (timestamp >= from_timestamp && timestamp <= to_timestamp);
-  }
-
-  /// @brief Convenience method to print the information of this interaction to
-  /// screen
-  void Print() const { std::cout << when_ << "\t\t" << what_ << std::endl; }
-};
-
-/// @brief Holds all the information of a Customer
-struct Customer {
-  /// @brief Type of the Customer ID
-  using ID = std::uint32_t;
-
-  /// @brief Associated ID for this customer
-  ID id_;
-  /// @brief Customer Name
-  std::string name_;
-  /// @brief Customer Surname
-  std::string surname_;
-  /// @brief Interactions with this Customer
-  std::vector<std::shared_ptr<Interaction>> customer_interactions_;
-
-  Customer() = default;
-
-  explicit Customer(ID id, const std::string& name, const std::string surname)
-      : id_{id}, name_{name}, surname_{surname}, customer_interactions_{} {}
-
-  explicit Customer(const std::string& name, const std::string surname)
-      : id_{}, name_{name}, surname_{surname}, customer_interactions_{} {}
-
-  explicit Customer(Customer&& customer)
-      : id_{customer.id_},
-        name_{std::move(customer.name_)},
-        surname_{std::move(customer.surname_)},
-        customer_interactions_{std::move(customer.customer_interactions_)} {}
-
-  Customer& operator=(Customer&& customer) {
-    id_ = customer.id_;
-    name_ = std::move(customer.name_);
-    surname_ = std::move(customer.surname_);
-    customer_interactions_ = std::move(customer.customer_interactions_);
-    return *this;
-  }
-
-  /// @brief A customer is valid when its ID is valid.
-  /// Valid IDs start at 1 while 0 is a reserved value.
-  /// @return True if the ID is greater than 0
-  bool IsValid() const { return id_ > INVALID_CUSTOMER_ID; }
-
-  /// @brief Stream operator overload to easily serialize the customer into an
-  /// output stream. Defined as a friend method for convenience instead of
-  /// defining it into the global scope.
-  /// @param os Output stream to save the data into
-  /// @param customer Customer object
-  /// @return Reference to output stream
-  friend std::ostream& operator<<(std::ostream& os, const Customer& customer) {
-    os << customer.id_ << SERIALIZATION_DELIMITER;
-    os << customer.name_ << SERIALIZATION_DELIMITER;
-    os << customer.surname_;
-    for (const auto& interaction : customer.customer_interactions_) {
-      os << SERIALIZATION_DELIMITER << *interaction;
-    }
-    os << std::endl;
-    return os;
-  }
-
-  /// @brief Stream operator overload to easily deserialize a stream and extract
-  /// all the information for a Customer. Defined as a friend method for
-  /// convenience instead of defining it into the global scope.
-  /// @param is Input stream to read the data from
-  /// @param customer Customer object to store the extracted data into
-  /// @return Reference to input stream
-  friend std::istream& operator>>(std::istream& is, Customer& customer) {
-    std::string id{};
-    std::getline(is, id, SERIALIZATION_DELIMITER);
-    utilities::try_convert(id, customer.id_);
-
-    std::getline(is, customer.name_, SERIALIZATION_DELIMITER);
-    std::getline(is, customer.surname_, SERIALIZATION_DELIMITER);
-
-    while (!is.eof()) {
-      std::shared_ptr<Interaction> interaction{std::make_shared<Interaction>()};
-      if (!std::getline(is, interaction->when_, SERIALIZATION_DELIMITER) ||
-          !std::getline(is, interaction->what_, SERIALIZATION_DELIMITER)) {
-        break;
-      }
-
-      customer.customer_interactions_.push_back(interaction);
-    }
-
-    return is;
-  }
-
-  /// @brief Helper method to print Customer information to screen
-  void PrintInfo() const {
-    std::cout << id_ << ") " << name_ << " " << surname_ << std::endl;
-  }
-
-  /// @brief Checks if the user has had any interactions yet
-  /// @return True if interactions are stored, false otherwise
-  bool HasInteractions() const { return !customer_interactions_.empty(); }
-
-  /// @brief Helper method to print all customer interactions to screen
-  void PrintInteractions() const {
-    for (const auto& interaction : customer_interactions_) {
-      interaction->Print();
-    }
-  }
-};
-
-#endif  // __CUSTOMERS_H__
+#ifndef __CUSTOMERS_H__
+#define __CUSTOMERS_H__
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "arena.h"
+#include "string_pool.h"
+#include "utilities.h"
+
+#define DATE_FORMAT "%d/%m/%Y %H:%M"
+#define SERIALIZATION_DELIMITER '\t'
+#define INVALID_CUSTOMER_ID 0U
+#define INTERACTION_DETAILS_DELIMITER '|'
+
+/// @brief String whose buffer is allocated from the current Arena
+using ArenaString =
+    std::basic_string<char, std::char_traits<char>, ArenaAllocator<char>>;
+
+/// @brief Kind of an interaction
+enum class EInteractionKind : std::uint32_t {
+  /// Sales appointment
+  APPOINTMENT = 1,
+  /// Signed contract, with the details of the policy
+  CONTRACT,
+  /// Anything else, e.g. a phone call
+  NOTE,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Type of the policy of a contract
+enum class EPolicyType : std::uint32_t {
+  CAR = 1,
+  HOME,
+  LIFE,
+  HEALTH,
+  OTHER,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Typed fields of an interaction, all of fixed width. The policy
+/// fields are only set for contracts.
+struct InteractionDetails {
+  EInteractionKind kind_;
+  EPolicyType policy_;
+  /// @brief Yearly premium in cents
+  std::uint32_t premium_cents_;
+  /// @brief Duration of the contract in months
+  std::uint32_t duration_months_;
+
+  InteractionDetails()
+      : kind_{EInteractionKind::NOTE},
+        policy_{EPolicyType::INVALID},
+        premium_cents_{},
+        duration_months_{} {}
+
+  explicit InteractionDetails(const EInteractionKind kind,
+                              const EPolicyType policy = EPolicyType::INVALID,
+                              const std::uint32_t premium_cents = 0U,
+                              const std::uint32_t duration_months = 0U)
+      : kind_{kind},
+        policy_{policy},
+        premium_cents_{premium_cents},
+        duration_months_{duration_months} {}
+};
+
+/// @brief Name of a kind of interactions, as used by the commands for scripts
+/// @param kind Kind of interactions
+/// @return Name, e.g. "contratto", empty if the kind is invalid
+inline const char* to_kind_name(const EInteractionKind kind) {
+  static constexpr const char* names[]{"appuntamento", "contratto", "nota"};
+  const auto index = static_cast<std::uint32_t>(kind) - 1U;
+  return index < std::size(names) ? names[index] : "";
+}
+
+/// @brief Parses the name of a kind of interactions
+/// @param name Name, as returned by to_kind_name()
+/// @param kind Where to store the kind
+/// @return False if the name is unknown
+inline bool from_kind_name(const std::string_view name,
+                           EInteractionKind& kind) {
+  for (const auto value : {EInteractionKind::APPOINTMENT,
+                           EInteractionKind::CONTRACT,
+                           EInteractionKind::NOTE}) {
+    if (name == to_kind_name(value)) {
+      kind = value;
+      return true;
+    }
+  }
+  return false;
+}
+
+/// @brief Name of the type of a policy, as used by the reports
+/// @param policy Type of the policy
+/// @return Name, e.g. "vita", empty if the type is invalid
+inline const char* to_policy_name(const EPolicyType policy) {
+  static constexpr const char* names[]{"auto", "casa", "vita", "salute",
+                                       "altro"};
+  const auto index = static_cast<std::uint32_t>(policy) - 1U;
+  return index < std::size(names) ? names[index] : "";
+}
+
+/// @brief Holds the information for a single interaction.
+///
+/// The date field is saved as "<date>|<kind>" or, for contracts,
+/// "<date>|<kind>|<policy>|<premium in cents>|<months>", so that every
+/// storage format, the journal and the archive keep two fields per
+/// interaction. The date and the typed fields are decoded once, when the
+/// interaction is created or read; dates saved before interactions had a
+/// kind get one from the words of their description, and are rewritten in
+/// the typed form.
+struct Interaction {
+  ArenaString when_;
+  ArenaString what_;
+  /// @brief Date of the interaction as a UNIX Timestamp, decoded from when_
+  std::time_t timestamp_;
+  /// @brief Whether when_ holds a valid date
+  bool dated_;
+  /// @brief Typed fields, decoded from when_
+  InteractionDetails details_;
+
+  Interaction() : when_{}, what_{}, timestamp_{}, dated_{false}, details_{} {}
+
+  explicit Interaction(const std::string& when, const std::string& what)
+      : when_{when.data(), when.size()},
+        what_{what.data(), what.size()},
+        timestamp_{},
+        dated_{false},
+        details_{} {
+    Decode();
+  }
+
+  /// @brief Builds the date field of an interaction out of its date and its
+  /// typed fields
+  /// @param date Date in DATE_FORMAT
+  /// @param details Typed fields
+  /// @return Date field, to be passed as when to AddInteraction()
+  static std::string FormatWhen(const std::string& date,
+                                const InteractionDetails& details) {
+    std::string when{date};
+    when += INTERACTION_DETAILS_DELIMITER;
+    when += std::to_string(static_cast<std::uint32_t>(details.kind_));
+    if (details.kind_ == EInteractionKind::CONTRACT) {
+      when += INTERACTION_DETAILS_DELIMITER;
+      when += std::to_string(static_cast<std::uint32_t>(details.policy_));
+      when += INTERACTION_DETAILS_DELIMITER;
+      when += std::to_string(details.premium_cents_);
+      when += INTERACTION_DETAILS_DELIMITER;
+      when += std::to_string(details.duration_months_);
+    }
+    return when;
+  }
+
+  /// @brief Decodes the date and the typed fields out of when_ and what_.
+  /// Must be called whenever they are assigned directly.
+  void Decode() {
+    const std::string_view when{when_.data(), when_.size()};
+    const std::size_t date_end = when.find(INTERACTION_DETAILS_DELIMITER);
+    dated_ = utilities::to_timestamp(when.substr(0U, date_end), DATE_FORMAT,
+                                     timestamp_);
+
+    if (date_end == std::string_view::npos) {
+      // Saved before interactions had a kind: the kind is written along with
+      // the date, so the next checkpoint stores it and the description is
+      // not read again
+      details_ = InteractionDetails{InferKind()};
+      const std::string typed_when = FormatWhen(std::string{when}, details_);
+      when_.assign(typed_when.data(), typed_when.size());
+    } else if (!DecodeDetails(when.substr(date_end + 1U))) {
+      details_ = InteractionDetails{InferKind()};
+    }
+  }
+
+  /// @brief Date of the interaction, without the typed fields
+  /// @return Date in DATE_FORMAT
+  std::string_view GetDate() const {
+    const std::string_view when{when_.data(), when_.size()};
+    return when.substr(0U, when.find(INTERACTION_DETAILS_DELIMITER));
+  }
+
+  /// @brief Stream overload to easily serialize the data into a stream.
+  /// Defined as a friend-method here for convenience, instead of having it in
+  /// global-scope.
+  /// @param os Output stream where to serialize the data into
+  /// @param interaction Interaction object to serialue
+  /// @return Reference to the output stream
+  friend std::ostream& operator<<(std::ostream& os,
+                                  const Interaction& interaction) {
+    os << interaction.when_ << SERIALIZATION_DELIMITER;
+    os << interaction.what_;
+    return os;
+  }
+
+  /// @brief Checks if the current interaction has a date within the supplied
+  /// timeframe
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @return True if date is within the given range, false otherwise
+  bool InRange(const std::time_t from_timestamp,
+               const std::time_t to_timestamp) const {
+    return (timestamp_ >= from_timestamp && timestamp_ <= to_timestamp);
+  }
+
+  /// @brief Date of this interaction as a timestamp
+  /// @param timestamp Where to store the UNIX Timestamp
+  /// @return False if the date is malformed
+  bool GetTimestamp(std::time_t& timestamp) const {
+    timestamp = timestamp_;
+    return dated_;
+  }
+
+  /// @brief Describes the kind of the interaction and its typed fields
+  /// @return Description in Italian, e.g. "Contratto (Auto, 350.00 euro, 12
+  /// mesi)"
+  std::string DescribeKind() const {
+    switch (details_.kind_) {
+      case EInteractionKind::APPOINTMENT:
+        return "Appuntamento";
+      case EInteractionKind::CONTRACT: {
+        // Contracts saved before interactions had a kind have no details
+        if (details_.policy_ == EPolicyType::INVALID) {
+          return "Contratto";
+        }
+        // Same names as the reports, capitalized
+        std::string policy{to_policy_name(details_.policy_)};
+        if (policy.empty()) {
+          policy = to_policy_name(EPolicyType::OTHER);
+        }
+        policy[0] = static_cast<char>(
+            std::toupper(static_cast<unsigned char>(policy[0])));
+        char premium[32];
+        std::snprintf(premium, sizeof(premium), "%u.%02u",
+                      details_.premium_cents_ / 100U,
+                      details_.premium_cents_ % 100U);
+        return "Contratto (" + policy + ", " + premium + " euro, " +
+               std::to_string(details_.duration_months_) + " mesi)";
+      }
+      case EInteractionKind::NOTE:
+      default:
+        return "Nota";
+    }
+  }
+
+  /// @brief Convenience method to print the information of this interaction to
+  /// screen
+  void Print() const {
+    std::cout << GetDate() << "\t\t" << DescribeKind() << "\t" << what_
+              << std::endl;
+  }
+
+ private:
+  /// @brief Decodes the typed fields saved after the date
+  /// @param fields Fields after the date, separated by
+  /// INTERACTION_DETAILS_DELIMITER
+  /// @return False if they are malformed
+  bool DecodeDetails(std::string_view fields) {
+    std::uint32_t values[4]{};
+    std::size_t count{};
+    for (; count < 4U && !fields.empty(); count++) {
+      const auto result = std::from_chars(
+          fields.data(), fields.data() + fields.size(), values[count]);
+      if (result.ec != std::errc{}) {
+        return false;
+      }
+      fields.remove_prefix(
+          static_cast<std::size_t>(result.ptr - fields.data()));
+      if (!fields.empty()) {
+        if (fields.front() != INTERACTION_DETAILS_DELIMITER) {
+          return false;
+        }
+        fields.remove_prefix(1U);
+      }
+    }
+
+    const auto kind = static_cast<EInteractionKind>(values[0]);
+    if (!fields.empty() || count == 0U ||
+        (kind != EInteractionKind::APPOINTMENT &&
+         kind != EInteractionKind::CONTRACT &&
+         kind != EInteractionKind::NOTE) ||
+        (count != 1U && count != 4U) ||
+        (count == 4U) != (kind == EInteractionKind::CONTRACT)) {
+      return false;
+    }
+
+    details_ = InteractionDetails{
+        kind,
+        count == 4U ? static_cast<EPolicyType>(values[1])
+                    : EPolicyType::INVALID,
+        values[2], values[3]};
+    return true;
+  }
+
+  /// @brief Guesses the kind of an interaction saved before interactions had
+  /// one, from the words of its description
+  /// @return Kind of the interaction
+  EInteractionKind InferKind() const {
+    const auto contains = [this](const std::string_view word) {
+      return std::search(what_.cbegin(), what_.cend(), word.cbegin(),
+                         word.cend(), [](const char left, const char right) {
+                           return std::tolower(static_cast<unsigned char>(
+                                      left)) == right;
+                         }) != what_.cend();
+    };
+
+    if (contains("contratt") || contains("firmat")) {
+      return EInteractionKind::CONTRACT;
+    }
+    if (contains("appuntament") || contains("incontr")) {
+      return EInteractionKind::APPOINTMENT;
+    }
+    return EInteractionKind::NOTE;
+  }
+};
+
+/// @brief Creates an interaction, allocated from the current Arena along
+/// with its reference count
+/// @param args Arguments of the Interaction constructor
+/// @return Shared interaction
+template <typename... Args>
+std::shared_ptr<Interaction> make_interaction(Args&&... args) {
+  return std::allocate_shared<Interaction>(ArenaAllocator<Interaction>{},
+                                           std::forward<Args>(args)...);
+}
+
+/// @brief Holds all the information of a Customer
+struct Customer {
+  /// @brief Type of the Customer ID
+  using ID = std::uint32_t;
+
+  /// @brief Associated ID for this customer
+  ID id_;
+  /// @brief Customer Name, shared with the customers with the same name
+  InternedString name_;
+  /// @brief Customer Surname, shared with the customers with the same surname
+  InternedString surname_;
+  /// @brief Interactions with this Customer
+  std::vector<std::shared_ptr<Interaction>,
+              ArenaAllocator<std::shared_ptr<Interaction>>>
+      customer_interactions_;
+
+  Customer() = default;
+
+  explicit Customer(ID id, const std::string& name, const std::string surname)
+      : id_{id}, name_{name}, surname_{surname}, customer_interactions_{} {}
+
+  explicit Customer(const std::string& name, const std::string surname)
+      : id_{}, name_{name}, surname_{surname}, customer_interactions_{} {}
+
+  explicit Customer(Customer&& customer)
+      : id_{customer.id_},
+        name_{std::move(customer.name_)},
+        surname_{std::move(customer.surname_)},
+        customer_interactions_{std::move(customer.customer_interactions_)} {}
+
+  Customer& operator=(Customer&& customer) {
+    id_ = customer.id_;
+    name_ = std::move(customer.name_);
+    surname_ = std::move(customer.surname_);
+    customer_interactions_ = std::move(customer.customer_interactions_);
+    return *this;
+  }
+
+  /// @brief A customer is valid when its ID is valid.
+  /// Valid IDs start at 1 while 0 is a reserved value.
+  /// @return True if the ID is greater than 0
+  bool IsValid() const { return id_ > INVALID_CUSTOMER_ID; }
+
+  /// @brief Stream operator overload to easily serialize the customer into an
+  /// output stream. Defined as a friend method for convenience instead of
+  /// defining it into the global scope.
+  /// @param os Output stream to save the data into
+  /// @param customer Customer object
+  /// @return Reference to output stream
+  friend std::ostream& operator<<(std::ostream& os, const Customer& customer) {
+    os << customer.id_ << SERIALIZATION_DELIMITER;
+    os << customer.name_ << SERIALIZATION_DELIMITER;
+    os << customer.surname_;
+    for (const auto& interaction : customer.customer_interactions_) {
+      os << SERIALIZATION_DELIMITER << *interaction;
+    }
+    os << std::endl;
+    return os;
+  }
+
+  /// @brief Stream operator overload to easily deserialize a stream and extract
+  /// all the information for a Customer. Defined as a friend method for
+  /// convenience instead of defining it into the global scope.
+  /// @param is Input stream to read the data from
+  /// @param customer Customer object to store the extracted data into
+  /// @return Reference to input stream
+  friend std::istream& operator>>(std::istream& is, Customer& customer) {
+    std::string id{};
+    std::getline(is, id, SERIALIZATION_DELIMITER);
+    utilities::try_convert(id, customer.id_);
+
+    std::string field{};
+    std::getline(is, field, SERIALIZATION_DELIMITER);
+    customer.name_ = field;
+    std::getline(is, field, SERIALIZATION_DELIMITER);
+    customer.surname_ = field;
+
+    while (!is.eof()) {
+      std::shared_ptr<Interaction> interaction{make_interaction()};
+      if (!std::getline(is, interaction->when_, SERIALIZATION_DELIMITER) ||
+          !std::getline(is, interaction->what_, SERIALIZATION_DELIMITER)) {
+        break;
+      }
+      interaction->Decode();
+
+      customer.customer_interactions_.push_back(interaction);
+    }
+
+    return is;
+  }
+
+  /// @brief Helper method to print Customer information to screen
+  void PrintInfo() const {
+    std::cout << id_ << ") " << name_ << " " << surname_ << std::endl;
+  }
+
+  /// @brief Checks if the user has had any interactions yet
+  /// @return True if interactions are stored, false otherwise
+  bool HasInteractions() const { return !customer_interactions_.empty(); }
+
+  /// @brief Helper method to print all customer interactions to screen
+  void PrintInteractions() const {
+    for (const auto& interaction : customer_interactions_) {
+      interaction->Print();
+    }
+  }
+};
+
+/// @brief All customers by ID, with the nodes allocated from an Arena
+using CustomerMap =
+    std::map<Customer::ID, Customer, std::less<Customer::ID>,
+             ArenaAllocator<std::pair<const Customer::ID, Customer>>>;
+
+#endif  // __CUSTOMERS_H__
@@ -1,158 +1,1003 @@
-#include "database.h"
-
-#include <algorithm>
-#include <iostream>
-#include <iterator>
-#include <sstream>
-
-#include "utilities.h"
-
-Database::Database(const std::string& database_path)
-    : database_path_{database_path} {
-  LoadFromFile();
-}
-
-Database::~Database() { SaveDatabase(); }
-
-bool Database::LoadFromFile() {
-  std::fstream file_stream{database_path_, std::ios::in};
-
-  if (!file_stream.good()) {
-    return false;
-  }
-
-  std::string line;
-  while (std::getline(file_stream, line)) {
-    std::stringstream ss{line};
-
-    Customer customer{};
-    ss >> customer;
-
-    if (!customer.IsValid()) {
-      std::cout << "Found invalid entry: " << std::endl;
-      customer.PrintInfo();
-      continue;
-    }
-
-    customers_[customer.id_] = std::move(customer);
-  }
-
-  file_stream.close();
-  return true;
-}
-
-// Quite inefficient implementation since the file is truncated everytime..
-// but simplest approach.
-void Database::SaveDatabase() const {
-  std::fstream file_stream{database_path_, std::ios::out | std::ios::trunc};
-
-  if (!file_stream.good()) {
-    return;
-  }
-
-  for (const auto& customer : customers_) {
-    file_stream << customer.second;
-  }
-
-  file_stream.close();
-}
-
-Customer::ID Database::AddCustomer(const std::string& name,
-                                   const std::string& surname) {
-  Customer::ID customer_id{GetHighestCustomerID()};
-  customer_id++;  // New customer, new ID
-
-  customers_.insert(
-      std::make_pair(customer_id, Customer{customer_id, name, surname}));
-
-  SaveDatabase();
-  return customer_id;
-}
-
-bool Database::HasCustomer(const std::string& name,
-                           const std::string& surname) const {
-  return std::find_if(customers_.cbegin(), customers_.cend(),
-                      [&name, &surname](const auto& customer) {
-                        return (customer.second.name_ == name) &&
-                               (customer.second.surname_ == surname);
-                      }) != customers_.cend();
-};
-
-bool Database::HasCustomer(Customer::ID customer_id) const {
-  return customers_.find(customer_id) != customers_.end();
-}
-
-const Customer& Database::GetCustomer(const Customer::ID customer_id) const {
-  // Will throw an exception and crash the app if access is attempted
-  // without calling HasCustomer first
-  return customers_.find(customer_id)->second;
-}
-
-Customer::ID Database::GetHighestCustomerID() const {
-  Customer::ID last_customer_id{1U};  // Start at 1 not 0
-
-  if (!customers_.empty()) {
-    last_customer_id = customers_.rbegin()->first;
-  }
-
-  return last_customer_id;
-}
-
-bool Database::UpdateClientInfo(const Customer::ID id, const std::string& name,
-                                const std::string& surname) {
-  if (!HasCustomer(id)) {
-    return false;
-  }
-
-  auto customer = customers_.find(id);
-  customer->second.name_ = name;
-  customer->second.surname_ = surname;
-
-  SaveDatabase();
-  return true;
-}
-
-bool Database::RemoveCustomer(const Customer::ID id) {
-  if (!HasCustomer(id)) {
-    return false;
-  }
-
-  customers_.erase(id);
-  SaveDatabase();
-  return true;
-}
-
-bool Database::AddInteraction(const Customer::ID id, const std::string& when,
-                              const std::string& what) {
-  if (!HasCustomer(id)) {
-    return false;
-  }
-
-  auto customer = customers_.find(id);
-  customer->second.customer_interactions_.emplace_back(
-      std::make_shared<Interaction>(when, what));
-
-  SaveDatabase();
-  return true;
-}
-
-void Database::GetCustomerInteractionsInRange(
-    const Customer::ID id, const std::time_t from_timestamp,
-    const std::time_t to_timestamp,
-    std::vector<std::shared_ptr<Interaction>>& interactions) const {
-  if (!HasCustomer(id)) {
-    return;
-  }
-
-  auto customer = customers_.find(id);
-
-  for (const auto& interaction : customer->second.customer_interactions_) {
-    if (interaction->InRange(from_timestamp, to_timestamp)) {
-      interactions.emplace_back(interaction);
-    }
-  }
-}
-
-const std::map<Customer::ID, Customer>& Database::GetCustomers() const {
-  return customers_;
-}
+#include "database.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <set>
+#include <sstream>
+
+#include "lsm_storage_engine.h"
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Once the journal grows beyond this size, it is emptied as soon as
+/// the storage engine has made all of its batches durable
+constexpr std::uint64_t MAX_JOURNAL_SIZE{4U * 1024U * 1024U};
+
+/// @brief Applies a change to the record of a single customer. Shared by
+/// Database::Apply(), which keeps the indexes and views in step around it,
+/// and by the lookups reading the journal without loading the database.
+/// @param change Change to apply. ARCHIVE_INTERACTIONS concerns every
+/// customer, the other changes only the one they refer to.
+/// @param customer Record of the customer, replaced by ADD_CUSTOMER
+/// @return False if the customer no longer exists after the change
+bool apply_to_customer(const Change& change, Customer& customer) {
+  switch (change.type_) {
+    case Change::EType::ADD_CUSTOMER:
+      customer = Customer{change.id_, change.first_, change.second_};
+      return true;
+    case Change::EType::UPDATE_CUSTOMER:
+      customer.name_ = change.first_;
+      customer.surname_ = change.second_;
+      return true;
+    case Change::EType::REMOVE_CUSTOMER:
+      return false;
+    case Change::EType::ADD_INTERACTION:
+      customer.customer_interactions_.emplace_back(
+          make_interaction(change.first_, change.second_));
+      return true;
+    case Change::EType::ARCHIVE_INTERACTIONS: {
+      std::time_t cutoff_timestamp{};
+      if (!utilities::try_convert(change.first_, cutoff_timestamp)) {
+        return true;
+      }
+
+      auto& interactions = customer.customer_interactions_;
+      interactions.erase(
+          std::remove_if(interactions.begin(), interactions.end(),
+                         [cutoff_timestamp](
+                             const std::shared_ptr<Interaction>& interaction) {
+                           std::time_t timestamp{};
+                           return interaction->GetTimestamp(timestamp) &&
+                                  timestamp < cutoff_timestamp;
+                         }),
+          interactions.end());
+      return true;
+    }
+    default:
+      return true;
+  }
+}
+
+}  // namespace
+
+const std::vector<Database::File>& Database::GetFiles() {
+  static const std::vector<File> files{
+      {DATABASE_JOURNAL_SUFFIX, false}, {DATABASE_INDEX_SUFFIX, false},
+      {DATABASE_SCORES_SUFFIX, false},  {DATABASE_ARCHIVE_SUFFIX, true},
+      {LSM_DIRECTORY_SUFFIX, true},
+  };
+  return files;
+}
+
+Database::Database(const std::string& database_path, const bool read_only,
+                   const EStorageEngine storage_engine)
+    : database_path_{database_path},
+      read_only_{read_only},
+      storage_{StorageEngine::Create(storage_engine, database_path, read_only)},
+      sequence_{},
+      journal_{database_path + DATABASE_JOURNAL_SUFFIX},
+      journal_offset_{},
+      archive_{database_path + DATABASE_ARCHIVE_SUFFIX},
+      index_file_{database_path + DATABASE_INDEX_SUFFIX},
+      index_generation_{},
+      change_feed_{},
+      persistence_deferred_{false},
+      deferred_changes_{},
+      last_customer_id_{},
+      arena_{Arena::Create()},
+      customers_{CustomerMap::allocator_type{arena_.get()}},
+      name_index_{},
+      surname_index_{},
+      activity_{ActivityMap::allocator_type{arena_.get()}},
+      name_view_{arena_.get()},
+      activity_view_{arena_.get()},
+      scores_{database_path + DATABASE_SCORES_SUFFIX},
+      interaction_columns_{},
+      name_column_{},
+      appointments_{} {
+  LoadFromFile();
+}
+
+Database::~Database() {
+  if (!read_only_) {
+    // A failed flush leaves them behind, already applied
+    FlushDeferredChanges();
+    SaveDatabase();
+  }
+}
+
+bool Database::SaveDatabase() {
+  const TraceSpan trace_span{"database", "Database::SaveDatabase"};
+  if (!storage_->Checkpoint(sequence_, last_customer_id_, customers_, true)) {
+    return false;
+  }
+
+  // The snapshot is durable up to sequence_: the indexes describe it exactly
+  // and the next start can load them instead of rebuilding them
+  if (index_generation_ == sequence_) {
+    return true;
+  }
+  if (!index_file_.Save(sequence_, customers_, name_index_, surname_index_,
+                        activity_)) {
+    // Only costs a rebuild on the next start: the data itself is safe
+    std::cerr << "Index file could not be saved, indexes will be rebuilt"
+              << std::endl;
+    return true;
+  }
+  index_generation_ = sequence_;
+  return true;
+}
+
+bool Database::LoadFromFile() {
+  const TraceSpan trace_span{"database", "Database::LoadFromFile"};
+  ArenaScope arena_scope{arena_.get()};
+
+  const bool loaded =
+      storage_->Load(customers_, sequence_, last_customer_id_);
+
+  // Saved along with the snapshot just loaded, unless it was written by a
+  // later commit or the process did not exit cleanly
+  const bool indexed =
+      loaded && index_file_.Load(sequence_, customers_, name_index_,
+                                 surname_index_, activity_);
+  if (indexed) {
+    index_generation_ = sequence_;
+  } else {
+    RebuildIndexes();
+  }
+
+  // Databases written before IDs were tracked
+  if (!customers_.empty()) {
+    last_customer_id_ = std::max(last_customer_id_, customers_.rbegin()->first);
+  }
+
+  // Recover the batches that were journaled but are not durable in the
+  // storage engine, or that were committed by the primary since it was
+  // loaded. The journal may hold changes even if nothing could be loaded, if
+  // the first checkpoint was never written.
+  ReplayJournal();
+  OpenArchive();
+  if (!indexed) {
+    RebuildActivity();
+  }
+  RebuildViews();
+  interaction_columns_.Rebuild(customers_);
+  name_column_.Rebuild(customers_);
+  appointments_.Rebuild(customers_);
+  scores_.Load();
+  return loaded;
+}
+
+void Database::OpenArchive() {
+  // Only the writing process may clean up after an interrupted seal, a
+  // replica may be looking at one that is still in progress
+  archive_.Open(sequence_, !read_only_);
+}
+
+bool Database::ReplayJournal() {
+  const TraceSpan trace_span{"database", "Database::ReplayJournal"};
+  bool in_sequence = true;
+
+  const bool readable = journal_.ReadBatches(
+      journal_offset_, [this, &in_sequence](const std::uint64_t sequence,
+                                            const std::vector<Change>& changes) {
+        if (sequence <= sequence_) {
+          // Already part of the snapshot
+          return true;
+        }
+
+        if (sequence != sequence_ + 1U) {
+          in_sequence = false;
+          return false;
+        }
+
+        for (const auto& change : changes) {
+          Apply(change);
+        }
+        sequence_ = sequence;
+
+        // Not durable in the storage engine yet: staged again, so that the
+        // journal can be emptied once it is
+        if (!read_only_) {
+          storage_->Stage(changes, customers_);
+        }
+        change_feed_.Publish(sequence_, changes);
+        return true;
+      });
+
+  return readable && in_sequence;
+}
+
+bool Database::CatchUp() {
+  const TraceSpan trace_span{"database", "Database::CatchUp"};
+  // A new import replaces the score file without going through the journal
+  scores_.Refresh();
+  if (ReplayJournal()) {
+    return true;
+  }
+
+  // Journal was reset or batches are missing: start over from the snapshot
+  customers_.clear();
+  sequence_ = 0U;
+  journal_offset_ = 0U;
+  last_customer_id_ = 0U;
+  return LoadFromFile();
+}
+
+bool Database::Persist(const std::vector<Change>& changes) {
+  const TraceSpan trace_span{"database", "Database::Persist"};
+  if (!JournalBatch(changes)) {
+    return false;
+  }
+
+  CommitBatch(changes);
+  return true;
+}
+
+bool Database::JournalBatch(const std::vector<Change>& changes) {
+  if (read_only_) {
+    return false;
+  }
+
+  // Numbered as the next batch: sequence_ only moves on once it is applied,
+  // as it does when the journal is replayed
+  return journal_.Append(sequence_ + 1U, changes);
+}
+
+void Database::CommitBatch(const std::vector<Change>& changes) {
+  sequence_++;
+
+  // Durable from here on, downstream systems can see it
+  change_feed_.Publish(sequence_, changes);
+
+  // The batch is safe in the journal already: if the storage engine fails,
+  // it stays there and is replayed on the next load
+  storage_->Stage(changes, customers_);
+  if (!storage_->Checkpoint(sequence_, last_customer_id_, customers_, false)) {
+    std::cerr << "Storage checkpoint failed, batch " << sequence_
+              << " is kept in the journal" << std::endl;
+    return;
+  }
+
+  // Only once everything in the journal is durable in the storage engine
+  if (journal_.GetSize() > MAX_JOURNAL_SIZE &&
+      storage_->GetDurableSequence() == sequence_) {
+    journal_.Reset();
+  }
+}
+
+Customer::ID Database::AddCustomer(const std::string& name,
+                                   const std::string& surname) {
+  Customer::ID customer_id{GetHighestCustomerID()};
+  customer_id++;  // New customer, new ID
+
+  if (!ApplyAndPersist(
+          Change{Change::EType::ADD_CUSTOMER, customer_id, name, surname})) {
+    return INVALID_CUSTOMER_ID;
+  }
+
+  return customer_id;
+}
+
+bool Database::HasCustomer(const std::string& name,
+                           const std::string& surname) const {
+  // A surname missing from the pool is held by no customer
+  InternedString interned_surname{};
+  if (!InternedString::Find(surname, interned_surname)) {
+    return false;
+  }
+
+  const auto& same_name = GetCustomersByName(name);
+  return std::any_of(same_name.cbegin(), same_name.cend(),
+                     [this, &interned_surname](const Customer::ID id) {
+                       return GetCustomer(id).surname_ == interned_surname;
+                     });
+}
+
+bool Database::HasCustomer(Customer::ID customer_id) const {
+  return customers_.find(customer_id) != customers_.end();
+}
+
+const Customer& Database::GetCustomer(const Customer::ID customer_id) const {
+  // Will throw an exception and crash the app if access is attempted
+  // without calling HasCustomer first
+  return customers_.find(customer_id)->second;
+}
+
+Customer::ID Database::GetHighestCustomerID() const {
+  // Start at 1 not 0. IDs of removed customers are never handed out again,
+  // as their interactions may still be archived.
+  return std::max<Customer::ID>(last_customer_id_, 1U);
+}
+
+bool Database::UpdateClientInfo(const Customer::ID id, const std::string& name,
+                                const std::string& surname) {
+  return ApplyAndPersist(
+      Change{Change::EType::UPDATE_CUSTOMER, id, name, surname});
+}
+
+bool Database::RemoveCustomer(const Customer::ID id) {
+  return ApplyAndPersist(Change{Change::EType::REMOVE_CUSTOMER, id});
+}
+
+bool Database::AddInteraction(const Customer::ID id, const std::string& when,
+                              const std::string& what) {
+  return ApplyAndPersist(
+      Change{Change::EType::ADD_INTERACTION, id, when, what});
+}
+
+bool Database::ApplyAndPersist(const Change& change) {
+  const std::vector<Change> changes{change};
+  if (read_only_ || !ValidateChanges(changes)) {
+    return false;
+  }
+
+  // Reaches the journal with the next flush
+  if (persistence_deferred_) {
+    Apply(change);
+    deferred_changes_.push_back(change);
+    return true;
+  }
+
+  // Write-ahead: if the change does not reach the journal, it is not
+  // applied either
+  if (!JournalBatch(changes)) {
+    return false;
+  }
+  Apply(change);
+  CommitBatch(changes);
+  return true;
+}
+
+bool Database::Apply(const Change& change) {
+  const TraceSpan trace_span{"database", "Database::Apply"};
+  ArenaScope arena_scope{arena_.get()};
+
+  if (change.type_ == Change::EType::ARCHIVE_INTERACTIONS) {
+    std::time_t cutoff_timestamp{};
+    if (!utilities::try_convert(change.first_, cutoff_timestamp)) {
+      return false;
+    }
+
+    // Archived interactions are still counted, they are just not at hand
+    for (auto& summary : activity_) {
+      summary.second.DropRecentBefore(cutoff_timestamp);
+    }
+
+    for (auto& customer_entry : customers_) {
+      apply_to_customer(change, customer_entry.second);
+    }
+
+    interaction_columns_.Rebuild(customers_);
+    appointments_.Rebuild(customers_);
+
+    // The segments were sealed with the sequence number of this very batch
+    archive_.Open(sequence_ + 1U, false);
+    return true;
+  }
+
+  if (change.type_ == Change::EType::ADD_CUSTOMER) {
+    const auto added = customers_.emplace(change.id_, Customer{});
+    if (!added.second) {
+      return false;
+    }
+    apply_to_customer(change, added.first->second);
+
+    AddToIndex(name_index_, change.first_, change.id_);
+    AddToIndex(surname_index_, change.second_, change.id_);
+    name_view_.Insert(GetNameKey(added.first->second), change.id_);
+    name_column_.Set(added.first->second);
+    activity_view_.Insert(0, change.id_);
+    last_customer_id_ = std::max(last_customer_id_, change.id_);
+    return true;
+  }
+
+  auto customer = customers_.find(change.id_);
+  if (customer == customers_.end()) {
+    return false;
+  }
+
+  switch (change.type_) {
+    case Change::EType::UPDATE_CUSTOMER:
+      RemoveFromIndex(name_index_, customer->second.name_.GetString(),
+                      change.id_);
+      RemoveFromIndex(surname_index_, customer->second.surname_.GetString(),
+                      change.id_);
+      name_view_.Erase(GetNameKey(customer->second), change.id_);
+      apply_to_customer(change, customer->second);
+      AddToIndex(name_index_, change.first_, change.id_);
+      AddToIndex(surname_index_, change.second_, change.id_);
+      name_view_.Insert(GetNameKey(customer->second), change.id_);
+      name_column_.Set(customer->second);
+      break;
+    case Change::EType::REMOVE_CUSTOMER:
+      RemoveFromIndex(name_index_, customer->second.name_.GetString(),
+                      change.id_);
+      RemoveFromIndex(surname_index_, customer->second.surname_.GetString(),
+                      change.id_);
+      name_view_.Erase(GetNameKey(customer->second), change.id_);
+      activity_view_.Erase(GetActivitySummary(change.id_).last_timestamp_,
+                           change.id_);
+      appointments_.RemoveCustomer(customer->second);
+      interaction_columns_.RemoveCustomer(customer->second);
+      customers_.erase(customer);
+      activity_.erase(change.id_);
+      name_column_.Remove(change.id_);
+      break;
+    case Change::EType::ADD_INTERACTION: {
+      apply_to_customer(change, customer->second);
+
+      ActivitySummary& summary = activity_[change.id_];
+      const std::time_t last_timestamp = summary.last_timestamp_;
+      summary.Add(customer->second.customer_interactions_.back());
+      interaction_columns_.Add(change.id_,
+                               *customer->second.customer_interactions_.back());
+      appointments_.Add(change.id_,
+                        customer->second.customer_interactions_.back());
+      if (summary.last_timestamp_ != last_timestamp) {
+        activity_view_.Erase(last_timestamp, change.id_);
+        activity_view_.Insert(summary.last_timestamp_, change.id_);
+      }
+      break;
+    }
+    default:
+      return false;
+  }
+
+  return true;
+}
+
+Transaction Database::BeginTransaction() const {
+  return Transaction{GetHighestCustomerID()};
+}
+
+bool Database::ValidateTransaction(const Transaction& transaction) const {
+  // New customers were numbered against the highest ID at the time the
+  // transaction began: if that changed meanwhile, their IDs would clash.
+  if (transaction.last_customer_id_ != transaction.base_customer_id_ &&
+      transaction.base_customer_id_ != GetHighestCustomerID()) {
+    return false;
+  }
+
+  return ValidateChanges(transaction.changes_);
+}
+
+bool Database::ValidateChanges(const std::vector<Change>& changes) const {
+  // Replay the existence of every customer touched by the changes, without
+  // modifying the actual data.
+  std::set<Customer::ID> added{};
+  std::set<Customer::ID> removed{};
+  const auto exists = [this, &added, &removed](const Customer::ID id) {
+    return (HasCustomer(id) || added.count(id) > 0) && removed.count(id) == 0;
+  };
+
+  for (const auto& change : changes) {
+    switch (change.type_) {
+      case Change::EType::ADD_CUSTOMER:
+        if (exists(change.id_)) {
+          return false;
+        }
+        added.insert(change.id_);
+        break;
+      case Change::EType::UPDATE_CUSTOMER:
+      case Change::EType::ADD_INTERACTION:
+        if (!exists(change.id_)) {
+          return false;
+        }
+        break;
+      case Change::EType::REMOVE_CUSTOMER:
+        if (!exists(change.id_)) {
+          return false;
+        }
+        removed.insert(change.id_);
+        break;
+      case Change::EType::ARCHIVE_INTERACTIONS: {
+        std::time_t cutoff_timestamp{};
+        if (!utilities::try_convert(change.first_, cutoff_timestamp)) {
+          return false;
+        }
+        break;
+      }
+      default:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+bool Database::CommitTransaction(Transaction& transaction) {
+  const TraceSpan trace_span{"database", "Database::CommitTransaction"};
+  if (transaction.IsEmpty()) {
+    return true;
+  }
+
+  if (read_only_ || !ValidateTransaction(transaction)) {
+    return false;
+  }
+
+  // Write-ahead, with a single write for the whole batch: if it does not
+  // reach the journal, nothing is applied and the transaction can be retried
+  const bool deferred = persistence_deferred_;
+  if (!deferred && !JournalBatch(transaction.changes_)) {
+    return false;
+  }
+
+  // Validation guarantees that every change succeeds, so the batch is
+  // applied either completely or not at all.
+  for (const auto& change : transaction.changes_) {
+    Apply(change);
+  }
+
+  if (deferred) {
+    deferred_changes_.insert(deferred_changes_.end(),
+                             transaction.changes_.cbegin(),
+                             transaction.changes_.cend());
+  } else {
+    CommitBatch(transaction.changes_);
+  }
+
+  transaction.Clear();
+  transaction.base_customer_id_ = GetHighestCustomerID();
+  transaction.last_customer_id_ = transaction.base_customer_id_;
+
+  return true;
+}
+
+void Database::RollbackTransaction(Transaction& transaction) const {
+  transaction.Clear();
+}
+
+void Database::GetCustomerInteractionsInRange(
+    const Customer::ID id, const std::time_t from_timestamp,
+    const std::time_t to_timestamp,
+    std::vector<std::shared_ptr<Interaction>>& interactions) const {
+  const TraceSpan trace_span{"database", "Database::GetCustomerInteractionsInRange"};
+  if (!HasCustomer(id)) {
+    return;
+  }
+
+  auto customer = customers_.find(id);
+
+  // Older interactions first
+  archive_.Collect(id, from_timestamp, to_timestamp, interactions);
+
+  for (const auto& interaction : customer->second.customer_interactions_) {
+    if (interaction->InRange(from_timestamp, to_timestamp)) {
+      interactions.emplace_back(interaction);
+    }
+  }
+}
+
+bool Database::ReadCustomerInteractions(
+    const std::string& database_path, const EStorageEngine storage_engine,
+    const Customer::ID id, const std::time_t from_timestamp,
+    const std::time_t to_timestamp,
+    std::vector<std::shared_ptr<Interaction>>& interactions) {
+  const TraceSpan trace_span{"database", "Database::ReadCustomerInteractions"};
+  bool exists{};
+  if (storage_engine == EStorageEngine::LSM &&
+      LookUpCustomerInteractions(database_path, id, from_timestamp,
+                                 to_timestamp, interactions, exists)) {
+    return exists;
+  }
+
+  const Database database{database_path, true, storage_engine};
+  if (!database.HasCustomer(id)) {
+    return false;
+  }
+  database.GetCustomerInteractionsInRange(id, from_timestamp, to_timestamp,
+                                          interactions);
+  return true;
+}
+
+bool Database::LookUpCustomerInteractions(
+    const std::string& database_path, const Customer::ID id,
+    const std::time_t from_timestamp, const std::time_t to_timestamp,
+    std::vector<std::shared_ptr<Interaction>>& interactions, bool& exists) {
+  LsmStorageEngine storage{database_path, true};
+  Customer customer{};
+  exists = storage.Open() && storage.Get(id, customer);
+  std::uint64_t sequence = storage.GetDurableSequence();
+
+  // Same as ReplayJournal(), for this customer only
+  bool in_sequence = true;
+  const Journal journal{database_path + DATABASE_JOURNAL_SUFFIX};
+  std::uint64_t journal_offset{};
+  const bool readable = journal.ReadBatches(
+      journal_offset,
+      [id, &customer, &exists, &sequence, &in_sequence](
+          const std::uint64_t batch_sequence,
+          const std::vector<Change>& changes) {
+        if (batch_sequence <= sequence) {
+          return true;
+        }
+
+        if (batch_sequence != sequence + 1U) {
+          in_sequence = false;
+          return false;
+        }
+
+        for (const auto& change : changes) {
+          if (change.type_ == Change::EType::ARCHIVE_INTERACTIONS) {
+            apply_to_customer(change, customer);
+          } else if (change.id_ == id) {
+            exists = apply_to_customer(change, customer);
+          }
+        }
+        sequence = batch_sequence;
+        return true;
+      });
+
+  // The journal was reset after the segments were read: the batches in
+  // between would be missed
+  if (!readable || !in_sequence) {
+    return false;
+  }
+
+  if (!exists) {
+    return true;
+  }
+
+  // Older interactions first
+  InteractionArchive archive{database_path + DATABASE_ARCHIVE_SUFFIX};
+  archive.Open(sequence, false);
+  archive.Collect(id, from_timestamp, to_timestamp, interactions);
+
+  for (const auto& interaction : customer.customer_interactions_) {
+    if (interaction->InRange(from_timestamp, to_timestamp)) {
+      interactions.emplace_back(interaction);
+    }
+  }
+  return true;
+}
+
+InteractionRange Database::GetCustomerInteractions(
+    const Customer::ID id, const std::time_t from_timestamp,
+    const std::time_t to_timestamp) const {
+  const auto customer = customers_.find(id);
+  return InteractionRange{customer != customers_.cend()
+                              ? &customer->second.customer_interactions_
+                              : nullptr,
+                          from_timestamp, to_timestamp};
+}
+
+const ActivitySummary& Database::GetActivitySummary(
+    const Customer::ID id) const {
+  static const ActivitySummary no_activity{};
+
+  const auto summary = activity_.find(id);
+  return summary != activity_.cend() ? summary->second : no_activity;
+}
+
+const CustomerMap& Database::GetCustomers() const {
+  return customers_;
+}
+
+const std::vector<Customer::ID>& Database::GetCustomersByName(
+    const std::string_view name) const {
+  return LookupIndex(name_index_, name);
+}
+
+const std::vector<Customer::ID>& Database::GetCustomersBySurname(
+    const std::string_view surname) const {
+  return LookupIndex(surname_index_, surname);
+}
+
+CustomerRange Database::FindCustomers(const std::string_view name,
+                                      const std::string_view surname) const {
+  const std::vector<Customer::ID>* candidates{nullptr};
+  if (!name.empty()) {
+    candidates = &GetCustomersByName(name);
+  }
+  if (!surname.empty()) {
+    const auto& same_surname = GetCustomersBySurname(surname);
+    if (candidates == nullptr || same_surname.size() < candidates->size()) {
+      candidates = &same_surname;
+    }
+  }
+
+  return CustomerRange{customers_, candidates, name, surname};
+}
+
+bool Database::GetCustomerPage(const ECustomerOrder order,
+                               const Customer::ID after,
+                               const std::size_t count,
+                               std::vector<Customer::ID>& page) const {
+  const TraceSpan trace_span{"database", "Database::GetCustomerPage"};
+  const auto customer = customers_.find(after);
+  if (after != INVALID_CUSTOMER_ID && customer == customers_.cend()) {
+    return false;
+  }
+
+  std::size_t listed{};
+  switch (order) {
+    case ECustomerOrder::ID:
+      for (auto entry = customers_.upper_bound(after);
+           entry != customers_.cend() && listed < count; ++entry, listed++) {
+        page.push_back(entry->first);
+      }
+      return true;
+    case ECustomerOrder::NAME: {
+      if (after == INVALID_CUSTOMER_ID) {
+        name_view_.Page(nullptr, count, page);
+        return true;
+      }
+      const NameView::Entry entry{GetNameKey(customer->second), after};
+      name_view_.Page(&entry, count, page);
+      return true;
+    }
+    case ECustomerOrder::LAST_ACTIVITY: {
+      if (after == INVALID_CUSTOMER_ID) {
+        activity_view_.Page(nullptr, count, page);
+        return true;
+      }
+      const ActivityView::Entry entry{
+          GetActivitySummary(after).last_timestamp_, after};
+      activity_view_.Page(&entry, count, page);
+      return true;
+    }
+    case ECustomerOrder::SCORE:
+      return scores_.Page(after, count, customers_, page);
+    default:
+      return false;
+  }
+}
+
+void Database::GetCustomersByInteractionKind(
+    const EInteractionKind kind, const std::time_t from_timestamp,
+    const std::time_t to_timestamp, std::vector<Customer::ID>& ids) const {
+  const TraceSpan trace_span{"database",
+                             "Database::GetCustomersByInteractionKind"};
+  interaction_columns_.GetCustomers(kind, from_timestamp, to_timestamp, ids);
+}
+
+void Database::GetCustomersByNamePart(const std::string_view text,
+                                      std::vector<Customer::ID>& ids) const {
+  name_column_.Find(text, ids);
+}
+
+std::size_t Database::GetInteractionCount(const EInteractionKind kind) const {
+  return interaction_columns_.GetCount(kind);
+}
+
+bool Database::ImportScores(const std::string& path,
+                            ScoreColumn::ImportSummary& result) {
+  const TraceSpan trace_span{"database", "Database::ImportScores"};
+  if (read_only_) {
+    return false;
+  }
+  return scores_.Import(path, customers_, result);
+}
+
+bool Database::GetScore(const Customer::ID id, float& score) const {
+  return scores_.GetScore(id, score);
+}
+
+void Database::GetCustomersByLastActivity(
+    const std::time_t from_timestamp, const std::time_t to_timestamp,
+    std::vector<Customer::ID>& ids) const {
+  // The view starts from the most recent
+  activity_view_.Range(to_timestamp, from_timestamp, ids);
+}
+
+void Database::AddToIndex(Index& index, const std::string& key,
+                          const Customer::ID id) {
+  auto& ids = index[key];
+  // IDs are handed out in increasing order, so this is usually an append
+  ids.insert(std::lower_bound(ids.begin(), ids.end(), id), id);
+}
+
+void Database::RemoveFromIndex(Index& index, const std::string& key,
+                               const Customer::ID id) {
+  auto entry = index.find(key);
+  if (entry == index.end()) {
+    return;
+  }
+
+  auto& ids = entry->second;
+  auto position = std::lower_bound(ids.begin(), ids.end(), id);
+  if (position != ids.end() && *position == id) {
+    ids.erase(position);
+  }
+
+  if (ids.empty()) {
+    index.erase(entry);
+  }
+}
+
+const std::vector<Customer::ID>& Database::LookupIndex(
+    const Index& index, const std::string_view key) {
+  static const std::vector<Customer::ID> no_customers{};
+
+  const auto entry = index.find(key);
+  return entry != index.cend() ? entry->second : no_customers;
+}
+
+void Database::RebuildIndexes() {
+  const TraceSpan trace_span{"database", "Database::RebuildIndexes"};
+  name_index_.clear();
+  surname_index_.clear();
+
+  // Customers are visited in ID order, so every index entry stays sorted
+  for (const auto& customer_entry : customers_) {
+    const Customer& customer = customer_entry.second;
+    name_index_[customer.name_.GetString()].push_back(customer.id_);
+    surname_index_[customer.surname_.GetString()].push_back(customer.id_);
+  }
+}
+
+void Database::RebuildActivity() {
+  const TraceSpan trace_span{"database", "Database::RebuildActivity"};
+  activity_.clear();
+
+  archive_.ForEachSummary([this](const Customer::ID id, const std::size_t count,
+                                 const std::time_t first_timestamp,
+                                 const std::time_t last_timestamp) {
+    // Archived interactions of removed customers are never deleted
+    if (HasCustomer(id)) {
+      activity_[id].AddRange(count, first_timestamp, last_timestamp);
+    }
+  });
+
+  for (const auto& customer_entry : customers_) {
+    for (const auto& interaction :
+         customer_entry.second.customer_interactions_) {
+      activity_[customer_entry.first].Add(interaction);
+    }
+  }
+}
+
+void Database::RebuildViews() {
+  const TraceSpan trace_span{"database", "Database::RebuildViews"};
+  std::vector<NameView::Entry> name_entries{};
+  std::vector<ActivityView::Entry> activity_entries{};
+  name_entries.reserve(customers_.size());
+  activity_entries.reserve(customers_.size());
+
+  for (const auto& customer_entry : customers_) {
+    const Customer& customer = customer_entry.second;
+    name_entries.emplace_back(GetNameKey(customer), customer.id_);
+    activity_entries.emplace_back(
+        GetActivitySummary(customer.id_).last_timestamp_, customer.id_);
+  }
+
+  name_view_.Assign(name_entries);
+  activity_view_.Assign(activity_entries);
+}
+
+bool Database::IsReadOnly() const { return read_only_; }
+
+std::uint64_t Database::GetSequence() const { return sequence_; }
+
+Customer::ID Database::GetLastCustomerID() const { return last_customer_id_; }
+
+ChangeFeed& Database::GetChangeFeed() { return change_feed_; }
+
+AppointmentScheduler& Database::GetAppointmentScheduler() {
+  return appointments_;
+}
+
+const AppointmentScheduler& Database::GetAppointmentScheduler() const {
+  return appointments_;
+}
+
+void Database::DeferPersistence() { persistence_deferred_ = true; }
+
+bool Database::FlushDeferredChanges() {
+  const TraceSpan trace_span{"database", "Database::FlushDeferredChanges"};
+  if (!deferred_changes_.empty() && !Persist(deferred_changes_)) {
+    // Already applied in memory, so they stay pending and go first in the
+    // next flush: changes persisted meanwhile would overtake them
+    return false;
+  }
+
+  deferred_changes_.clear();
+  persistence_deferred_ = false;
+  return true;
+}
+
+bool Database::ArchiveInteractions(const std::uint32_t hot_months) {
+  const TraceSpan trace_span{"database", "Database::ArchiveInteractions"};
+  // The archival must be a batch of its own, as the segments are tagged
+  // with its sequence number
+  if (read_only_ || persistence_deferred_) {
+    return false;
+  }
+
+  const std::time_t cutoff_timestamp =
+      InteractionArchive::GetMonthStart(std::time(nullptr), hot_months);
+
+  std::vector<InteractionArchive::Entry> entries{};
+  for (const auto& customer_entry : customers_) {
+    for (const auto& interaction :
+         customer_entry.second.customer_interactions_) {
+      std::time_t timestamp{};
+      if (interaction->GetTimestamp(timestamp) &&
+          timestamp < cutoff_timestamp) {
+        entries.emplace_back(customer_entry.first, interaction);
+      }
+    }
+  }
+
+  if (entries.empty()) {
+    return true;
+  }
+
+  // Segments first: if the batch never makes it to the journal, they are
+  // discarded on the next load and the interactions are still in memory
+  if (!archive_.Seal(sequence_ + 1U, entries)) {
+    return false;
+  }
+
+  return ApplyAndPersist(Change{Change::EType::ARCHIVE_INTERACTIONS,
+                                INVALID_CUSTOMER_ID,
+                                std::to_string(cutoff_timestamp)});
+}
+
+std::size_t Database::GetArchivedSegmentCount() const {
+  return archive_.GetSegmentCount();
+}
+
+std::uint64_t Database::GetMemoryUsage() const {
+  const Arena::Stats arena_stats = arena_->GetStats();
+  return arena_stats.reserved_bytes_ + arena_stats.bypassed_bytes_;
+}
+
+void Database::GetMemoryReport(MemoryReport& report) const {
+  const TraceSpan trace_span{"database", "Database::GetMemoryReport"};
+  report = MemoryReport{};
+  report.customers_ = customers_.size();
+
+  // Interactions live in the same block as their reference counts and the
+  // copy of the allocator that frees the block
+  const std::uint64_t interaction_size =
+      allocated_size(2U * sizeof(void*) + sizeof(ArenaAllocator<Interaction>) +
+                     sizeof(Interaction));
+  std::uint64_t interaction_buffers{};
+  std::uint64_t interaction_strings{};
+  for (const auto& customer : customers_) {
+    const auto& interactions = customer.second.customer_interactions_;
+    report.interactions_ += interactions.size();
+    interaction_buffers += vector_buffer_size(interactions);
+    for (const auto& interaction : interactions) {
+      interaction_strings += string_buffer_size(interaction->when_) +
+                             string_buffer_size(interaction->what_);
+    }
+  }
+  report.Add(EMemoryCategory::CUSTOMERS,
+             customers_.size() * tree_node_size<CustomerMap::value_type>(),
+             interaction_buffers);
+  report.Add(EMemoryCategory::INTERACTIONS, 0U,
+             report.interactions_ * interaction_size + interaction_strings);
+
+  report.Add(EMemoryCategory::STRINGS,
+             StringPool::GetStats().reserved_bytes_);
+
+  std::uint64_t index_bytes{};
+  for (const Index* index : {&name_index_, &surname_index_}) {
+    index_bytes += index->size() * tree_node_size<Index::value_type>();
+    for (const auto& entry : *index) {
+      index_bytes +=
+          string_buffer_size(entry.first) + vector_buffer_size(entry.second);
+    }
+  }
+  report.Add(EMemoryCategory::INDEXES,
+             index_bytes + name_view_.GetMemoryUsage() +
+                 activity_view_.GetMemoryUsage());
+
+  report.Add(EMemoryCategory::CACHES,
+             activity_.size() * tree_node_size<ActivityMap::value_type>() +
+                 name_column_.GetMemoryUsage() + scores_.GetMemoryUsage(),
+             interaction_columns_.GetMemoryUsage() +
+                 appointments_.GetMemoryUsage());
+
+  // Blocks are counted at the size requested, so rounding is included.
+  // Large blocks bypass the chunks and have no overhead of the arena.
+  const Arena::Stats arena_stats = arena_->GetStats();
+  report.Add(EMemoryCategory::ALLOCATOR,
+             arena_stats.reserved_bytes_ - arena_stats.pooled_bytes_);
+}
@@ -1,108 +1,595 @@
-#ifndef __DATABASE_H__
-#define __DATABASE_H__
-
-#include <cstdint>
-#include <fstream>
-#include <map>
-#include <memory>
-#include <string>
-
-#include "customers.h"
-
-/// @brief Manages all input and output with the actual data store
-class Database {
- public:
-  // No default, move and copy constructors/operators
-  Database() = delete;
-  Database(const Database &) = delete;
-  Database &operator=(const Database &) = delete;
-  Database(Database &&) = delete;
-  Database &operator=(Database &&) = delete;
-
-  explicit Database(const std::string &database_path);
-  ~Database();
-
-  /// @brief Adds a new customer to the database
-  /// @param name Name
-  /// @param surname Surname
-  /// @return ID assigned to the newly added customer
-  Customer::ID AddCustomer(const std::string &name, const std::string &surname);
-
-  /// @brief Checks if a customer already exists with the given name and
-  /// surname. Both values are required.
-  /// @param name Name to search for
-  /// @param surname Surname to search for
-  /// @return True if found, false otherwise.
-  bool HasCustomer(const std::string &name, const std::string &surname) const;
-
-  /// @brief Checks if a Customer with the specified ID exists
-  /// @param customer_id Customer ID
-  /// @return True if found, false otherwise.
-  bool HasCustomer(Customer::ID customer_id) const;
-
-  /// @brief Returns a read-only reference to a Customer object. Must be called
-  /// after checking if the Customer exists! Attempting to retrieve a
-  /// non-existed Customer will lead to a segmentation fault.
-  /// Use HasCustomer() to check if the entry exists.
-  /// @param customer_id ID of customer to fetch
-  /// @return Reference to customer object
-  const Customer &GetCustomer(const Customer::ID customer_id) const;
-
-  /// @brief Updates the information of a customer
-  /// @param id Customer ID
-  /// @param name New name
-  /// @param surname New surname
-  /// @return False if customer was does not exist, true otherwise.
-  bool UpdateClientInfo(const Customer::ID id, const std::string &name,
-                        const std::string &surname);
-
-  /// @brief Removes a customer from the database
-  /// @param id Customer ID to remove
-  /// @return True on success, false if not found.
-  bool RemoveCustomer(const Customer::ID id);
-
-  /// @brief Adds a new interaction to the specified customer
-  /// @param id Customer ID
-  /// @param when String containing a valid date
-  /// @param what Description of the interaction
-  /// @return True on success, false if customer not found.
-  bool AddInteraction(const Customer::ID id, const std::string &when,
-                      const std::string &what);
-
-  /// @brief Collections all interactions of a customer that happened within a
-  /// specified time interval.
-  /// @param id Customer ID
-  /// @param from_timestamp Start date as a UNIX Timestamp
-  /// @param to_timestamp End date as a UNIX Timestamp
-  /// @param interactions Vector where all found interactions shall be pushed
-  /// into
-  void GetCustomerInteractionsInRange(
-      const Customer::ID id, const std::time_t from_timestamp,
-      const std::time_t to_timestamp,
-      std::vector<std::shared_ptr<Interaction>> &interactions) const;
-
-  /// @brief Allows direct read-only access to all customers
-  /// @return Reference to customers
-  const std::map<Customer::ID, Customer> &GetCustomers() const;
-
- private:
-  /// @brief Loads an existing database file into memory
-  /// @return True if file could be opened, false otherwise.
-  bool LoadFromFile();
-
-  /// @brief Writes all customers to the database file.
-  void SaveDatabase() const;
-
-  /// @brief Finds the currently highest assigned ID among existing Customers.
-  /// Used in conjunction with AddCustomer to assign an ID to new customers.
-  /// @return Current highest ID, or 1 by default
-  Customer::ID GetHighestCustomerID() const;
-
-  /// @brief Path where database is loaded from/saved to
-  std::string database_path_;
-
-  /// @brief Keeps all customers in memory
-  std::map<Customer::ID, Customer> customers_;
-};
-
-#endif  // __DATABASE_H__
+#ifndef __DATABASE_H__
+#define __DATABASE_H__
+
+#include <cstdint>
+#include <ctime>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "activity.h"
+#include "appointment_scheduler.h"
+#include "arena.h"
+#include "change_feed.h"
+#include "changes.h"
+#include "customer_range.h"
+#include "customers.h"
+#include "index_file.h"
+#include "interaction_archive.h"
+#include "interaction_columns.h"
+#include "journal.h"
+#include "memory_report.h"
+#include "name_column.h"
+#include "score_column.h"
+#include "sorted_view.h"
+#include "storage_engine.h"
+#include "transaction.h"
+
+/// @brief Suffix appended to the path of the database for its journal
+#define DATABASE_JOURNAL_SUFFIX ".log"
+
+/// @brief Suffix appended to the path of the database for the directory of
+/// its archive
+#define DATABASE_ARCHIVE_SUFFIX ".archive"
+
+/// @brief Suffix appended to the path of the database for its index file
+#define DATABASE_INDEX_SUFFIX ".idx"
+
+/// @brief Suffix appended to the path of the database for its scores
+#define DATABASE_SCORES_SUFFIX ".scores"
+
+/// @brief Orders in which all customers can be listed
+enum class ECustomerOrder : std::uint32_t {
+  /// By ascending ID, i.e. by date of insertion
+  ID = 1,
+  /// By surname, then by name
+  NAME,
+  /// By date of the latest interaction, most recent first. Customers without
+  /// interactions come last.
+  LAST_ACTIVITY,
+  /// By imported score, highest first. Only customers with a score are
+  /// listed.
+  SCORE,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Manages all input and output with the actual data store
+class Database {
+ public:
+  // No default, move and copy constructors/operators
+  Database() = delete;
+  Database(const Database &) = delete;
+  Database &operator=(const Database &) = delete;
+  Database(Database &&) = delete;
+  Database &operator=(Database &&) = delete;
+
+  /// @brief A file kept next to the database file
+  struct File {
+    /// @brief Appended to the path of the database file
+    const char* suffix_;
+    /// @brief Whether it is a directory of files
+    bool directory_;
+  };
+
+  /// @brief Lists every file a database may open besides the database file,
+  /// whatever its storage engine, e.g. to copy or remove a whole database
+  /// @return Files, which may not exist
+  static const std::vector<File>& GetFiles();
+
+  /// @brief Opens the database stored at the given path
+  /// @param database_path Path of the database file
+  /// @param read_only When true, the database is never written and all
+  /// changes are refused. Used by replicas, which only follow the changes
+  /// persisted by the primary through CatchUp().
+  /// @param storage_engine How customers are stored on disk
+  explicit Database(const std::string &database_path,
+                    const bool read_only = false,
+                    const EStorageEngine storage_engine = EStorageEngine::TSV);
+
+  /// @brief Makes every change durable in the storage engine, unless
+  /// read-only, including the ones still deferred
+  ~Database();
+
+  /// @brief Adds a new customer to the database
+  /// @param name Name
+  /// @param surname Surname
+  /// @return ID assigned to the newly added customer
+  Customer::ID AddCustomer(const std::string &name, const std::string &surname);
+
+  /// @brief Checks if a customer already exists with the given name and
+  /// surname. Both values are required.
+  /// @param name Name to search for
+  /// @param surname Surname to search for
+  /// @return True if found, false otherwise.
+  bool HasCustomer(const std::string &name, const std::string &surname) const;
+
+  /// @brief Checks if a Customer with the specified ID exists
+  /// @param customer_id Customer ID
+  /// @return True if found, false otherwise.
+  bool HasCustomer(Customer::ID customer_id) const;
+
+  /// @brief Returns a read-only reference to a Customer object. Must be called
+  /// after checking if the Customer exists! Attempting to retrieve a
+  /// non-existed Customer will lead to a segmentation fault.
+  /// Use HasCustomer() to check if the entry exists.
+  /// @param customer_id ID of customer to fetch
+  /// @return Reference to customer object
+  const Customer &GetCustomer(const Customer::ID customer_id) const;
+
+  /// @brief Updates the information of a customer
+  /// @param id Customer ID
+  /// @param name New name
+  /// @param surname New surname
+  /// @return False if customer was does not exist, true otherwise.
+  bool UpdateClientInfo(const Customer::ID id, const std::string &name,
+                        const std::string &surname);
+
+  /// @brief Removes a customer from the database
+  /// @param id Customer ID to remove
+  /// @return True on success, false if not found.
+  bool RemoveCustomer(const Customer::ID id);
+
+  /// @brief Adds a new interaction to the specified customer
+  /// @param id Customer ID
+  /// @param when String containing a valid date
+  /// @param what Description of the interaction
+  /// @return True on success, false if customer not found.
+  bool AddInteraction(const Customer::ID id, const std::string &when,
+                      const std::string &what);
+
+  /// @brief Reads the interactions of a single customer within a time
+  /// interval straight from the files of a database, without loading it.
+  /// With the LSM storage engine only the segments that may hold the
+  /// customer are read, then the journal batches not in them yet; other
+  /// engines have no point lookup, and the whole database is loaded, as it
+  /// is when the journal no longer follows the segments.
+  /// @param database_path Path of the database file
+  /// @param storage_engine How customers are stored on disk
+  /// @param id Customer ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param interactions Vector where all found interactions shall be pushed
+  /// into
+  /// @return False if the customer does not exist
+  static bool ReadCustomerInteractions(
+      const std::string &database_path, const EStorageEngine storage_engine,
+      const Customer::ID id, const std::time_t from_timestamp,
+      const std::time_t to_timestamp,
+      std::vector<std::shared_ptr<Interaction>> &interactions);
+
+  /// @brief Collections all interactions of a customer that happened within a
+  /// specified time interval. Archived interactions are included, reading
+  /// only the archive segments that overlap the interval.
+  /// @param id Customer ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param interactions Vector where all found interactions shall be pushed
+  /// into
+  void GetCustomerInteractionsInRange(
+      const Customer::ID id, const std::time_t from_timestamp,
+      const std::time_t to_timestamp,
+      std::vector<std::shared_ptr<Interaction>> &interactions) const;
+
+  /// @brief Visits the interactions of a customer that happened within a
+  /// time interval, without collecting them. Only the interactions in memory
+  /// are visited, see InteractionRange.
+  /// @param id Customer ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @return Lazy range of the interactions, empty if the customer does not
+  /// exist
+  InteractionRange GetCustomerInteractions(
+      const Customer::ID id, const std::time_t from_timestamp,
+      const std::time_t to_timestamp) const;
+
+  /// @brief Summary of the interactions of a customer, maintained as they
+  /// are added
+  /// @param id Customer ID
+  /// @return Summary, empty if the customer has no interactions or does not
+  /// exist
+  const ActivitySummary &GetActivitySummary(const Customer::ID id) const;
+
+  /// @brief Allows direct read-only access to all customers
+  /// @return Reference to customers
+  const CustomerMap &GetCustomers() const;
+
+  /// @brief Looks up the customers with the given name through the name index
+  /// @param name Exact name to look for
+  /// @return IDs of the matching customers, sorted in ascending order
+  const std::vector<Customer::ID> &GetCustomersByName(
+      const std::string_view name) const;
+
+  /// @brief Looks up the customers with the given surname through the surname
+  /// index
+  /// @param surname Exact surname to look for
+  /// @return IDs of the matching customers, sorted in ascending order
+  const std::vector<Customer::ID> &GetCustomersBySurname(
+      const std::string_view surname) const;
+
+  /// @brief Visits the customers with the given name and surname, without
+  /// collecting them. Only the shorter of the two index entries is walked,
+  /// the other field is checked on each of its customers.
+  /// @param name Exact name, empty to match any
+  /// @param surname Exact surname, empty to match any
+  /// @return Lazy range of the customers, in ID order. Every customer when
+  /// both are empty.
+  CustomerRange FindCustomers(const std::string_view name,
+                              const std::string_view surname) const;
+
+  /// @brief Lists a page of customers in the given order. Every order is
+  /// maintained as customers change, so no page ever requires sorting.
+  /// @param order Order of the listing
+  /// @param after ID of the last customer of the previous page,
+  /// INVALID_CUSTOMER_ID for the first page
+  /// @param count Maximum number of customers in the page
+  /// @param page Where to append the IDs of the customers
+  /// @return False if the customer the page starts after does not exist
+  /// anymore
+  bool GetCustomerPage(const ECustomerOrder order, const Customer::ID after,
+                       const std::size_t count,
+                       std::vector<Customer::ID> &page) const;
+
+  /// @brief Lists the customers with an interaction of a kind within a time
+  /// interval, scanning the columns of that kind. Archived interactions are
+  /// not considered.
+  /// @param kind Kind of the interactions
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param ids Where to store the IDs of the customers, ascending
+  void GetCustomersByInteractionKind(const EInteractionKind kind,
+                                     const std::time_t from_timestamp,
+                                     const std::time_t to_timestamp,
+                                     std::vector<Customer::ID> &ids) const;
+
+  /// @brief Lists the customers whose name or surname contains a text,
+  /// ignoring case, scanning the packed column of the names
+  /// @param text Text to look for
+  /// @param ids Where to store the IDs of the customers, ascending
+  void GetCustomersByNamePart(const std::string_view text,
+                              std::vector<Customer::ID> &ids) const;
+
+  /// @brief Number of interactions of a kind held in memory
+  /// @param kind Kind of the interactions
+  /// @return Count
+  std::size_t GetInteractionCount(const EInteractionKind kind) const;
+
+  /// @brief Replaces the scores of all customers with the ones of a score
+  /// file, see ScoreColumn. The scores are saved to their own file, which
+  /// read-only databases pick up on CatchUp().
+  /// @param path Score file, sorted by customer ID
+  /// @param result Where to store the outcome
+  /// @return False if the database is read-only, the file is malformed or
+  /// the scores cannot be saved; the previous scores are kept in that case
+  bool ImportScores(const std::string &path,
+                    ScoreColumn::ImportSummary &result);
+
+  /// @brief Looks up the imported score of a customer
+  /// @param id Customer ID
+  /// @param score Where to store the score
+  /// @return False if the customer has no score
+  bool GetScore(const Customer::ID id, float &score) const;
+
+  /// @brief Lists the customers whose latest interaction happened within a
+  /// time interval, most recent first
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param ids Where to append the IDs of the customers
+  void GetCustomersByLastActivity(const std::time_t from_timestamp,
+                                  const std::time_t to_timestamp,
+                                  std::vector<Customer::ID> &ids) const;
+
+  /// @brief Opens a new transaction. Changes staged into it are not visible
+  /// until CommitTransaction() is called.
+  /// @return Empty transaction bound to the current state of the database
+  Transaction BeginTransaction() const;
+
+  /// @brief Applies all changes staged in a transaction and persists them with
+  /// a single durable write. If any of the changes cannot be applied (e.g. the
+  /// customer does not exist anymore), none of them is applied. The batch
+  /// reaches the journal before it is applied, so if the write fails nothing
+  /// is applied either and the transaction is left as it was.
+  /// On success the transaction is emptied and can be reused.
+  /// @param transaction Transaction to commit
+  /// @return True if all changes were applied and persisted, false otherwise.
+  bool CommitTransaction(Transaction &transaction);
+
+  /// @brief Discards all changes staged in a transaction
+  /// @param transaction Transaction to roll back
+  void RollbackTransaction(Transaction &transaction) const;
+
+  /// @brief Starts collecting changes instead of persisting each of them
+  /// right away. Changes are still applied in memory immediately, and are
+  /// persisted as a single batch by FlushDeferredChanges(), which amortizes
+  /// the cost of writing over many independent changes (group commit).
+  void DeferPersistence();
+
+  /// @brief Persists all changes collected since DeferPersistence() as a
+  /// single batch, then goes back to persisting every change immediately.
+  /// If the batch cannot be written, the changes stay applied and collected,
+  /// persistence stays deferred and the next call, or closing the database,
+  /// tries them again.
+  /// @return True if the changes reached the disk, false otherwise.
+  bool FlushDeferredChanges();
+
+  /// @brief Checks whether the database refuses all changes
+  /// @return True if opened in read-only mode
+  bool IsReadOnly() const;
+
+  /// @brief Sequence number of the last batch of changes applied
+  /// @return Sequence number, 0 if no change was ever persisted
+  std::uint64_t GetSequence() const;
+
+  /// @brief Highest customer ID ever assigned, including removed customers
+  /// @return Customer ID, 0 if none was ever assigned
+  Customer::ID GetLastCustomerID() const;
+
+  /// @brief Applies the changes persisted by another process since the last
+  /// call, by tailing its journal, and the scores imported since. If the
+  /// journal cannot be followed anymore (e.g. it was reset after a snapshot),
+  /// the snapshot is reloaded. Only meaningful for read-only databases.
+  /// @return True if the database is up to date, false if it could not be
+  /// loaded.
+  bool CatchUp();
+
+  /// @brief Moves the interactions older than the given number of months out
+  /// of memory and of the snapshot, sealing them into the archive one month
+  /// per segment. They remain available to GetCustomerInteractionsInRange().
+  /// @param hot_months Number of months kept in memory, counting back from
+  /// the beginning of the current month
+  /// @return False if the database is read-only, persistence is deferred or
+  /// the archive could not be written
+  bool ArchiveInteractions(const std::uint32_t hot_months);
+
+  /// @brief Number of sealed archive segments
+  /// @return Segment count
+  std::size_t GetArchivedSegmentCount() const;
+
+  /// @brief Memory reserved for the customers, their interactions and the
+  /// activity summaries
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+  /// @brief Estimates the memory held by the database, by category. Walks
+  /// all customers and indexes, so it is meant for reports rather than for
+  /// every request.
+  /// @param report Where to store the estimate
+  void GetMemoryReport(MemoryReport &report) const;
+
+  /// @brief Feed publishing every change once it has been persisted (or, on a
+  /// read-only database, once it has been caught up with). Subscribe to it to
+  /// process changes incrementally.
+  /// @return Reference to the change feed
+  ChangeFeed &GetChangeFeed();
+
+  /// @brief Upcoming appointments of all customers, kept up to date with
+  /// every change applied
+  /// @return Appointment scheduler
+  AppointmentScheduler &GetAppointmentScheduler();
+
+  /// @brief Upcoming appointments of all customers, read-only
+  /// @return Appointment scheduler
+  const AppointmentScheduler &GetAppointmentScheduler() const;
+
+ private:
+  /// @brief Loads all customers from the storage engine into memory, then
+  /// replays the journal batches that are not durable in it yet
+  /// @return True if anything could be loaded, false otherwise.
+  bool LoadFromFile();
+
+  /// @brief Applies all journal batches newer than the current sequence
+  /// number, starting at journal_offset_
+  /// @return False if the journal cannot be followed from journal_offset_
+  bool ReplayJournal();
+
+  /// @brief Looks up the archive segments sealed up to the current sequence
+  /// number
+  void OpenArchive();
+
+  /// @brief Point lookup behind ReadCustomerInteractions() for the LSM
+  /// storage engine: reads the segments that may hold the customer, then
+  /// the journal batches not in them yet
+  /// @param database_path Path of the database file
+  /// @param id Customer ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param interactions Vector where all found interactions shall be pushed
+  /// into
+  /// @param exists Set to whether the customer exists
+  /// @return False if batches are missing from the journal, e.g. because it
+  /// was reset meanwhile: nothing is collected and the database has to be
+  /// loaded instead
+  static bool LookUpCustomerInteractions(
+      const std::string &database_path, const Customer::ID id,
+      const std::time_t from_timestamp, const std::time_t to_timestamp,
+      std::vector<std::shared_ptr<Interaction>> &interactions, bool &exists);
+
+  /// @brief Persists a batch of changes that has already been applied in
+  /// memory: the batch is appended to the journal first, then handed to the
+  /// storage engine.
+  /// @param changes Applied changes
+  /// @return True if the changes reached the journal, false otherwise.
+  bool Persist(const std::vector<Change> &changes);
+
+  /// @brief Appends a batch of changes to the journal as the next batch,
+  /// before it is applied in memory. Nothing changes if it fails.
+  /// @param changes Changes to journal
+  /// @return True if the changes reached the journal, false otherwise.
+  bool JournalBatch(const std::vector<Change> &changes);
+
+  /// @brief Completes a batch that is in the journal and has been applied in
+  /// memory: assigns its sequence number, publishes it to the change feed
+  /// and hands it to the storage engine
+  /// @param changes Journaled and applied changes
+  void CommitBatch(const std::vector<Change> &changes);
+
+  /// @brief Makes every applied change durable in the storage engine, then
+  /// saves the indexes for the next start. Failing to save the indexes is
+  /// only logged, as they can be rebuilt.
+  /// @return True if the data reached the disk, false otherwise.
+  bool SaveDatabase();
+
+  /// @brief Checks if a transaction can be applied as a whole against the
+  /// current content of the database
+  /// @param transaction Transaction to validate
+  /// @return True if every staged change would succeed, false otherwise.
+  bool ValidateTransaction(const Transaction &transaction) const;
+
+  /// @brief Checks if a batch of changes can be applied as a whole against
+  /// the current content of the database
+  /// @param changes Changes to validate, in order
+  /// @return True if every change would succeed, false otherwise.
+  bool ValidateChanges(const std::vector<Change> &changes) const;
+
+  /// @brief Applies a single change to the in-memory data, without
+  /// persisting it
+  /// @param change Change to apply
+  /// @return False if the change refers to a non-existent customer
+  bool Apply(const Change &change);
+
+  /// @brief Persists a single change right away, then applies it. If it
+  /// cannot be persisted it is not applied either. While persistence is
+  /// deferred, it is applied and collected for the next flush instead.
+  /// @param change Change to apply
+  /// @return False if the database is read-only, the change refers to a
+  /// non-existent customer or it could not be persisted
+  bool ApplyAndPersist(const Change &change);
+
+  /// @brief Finds the highest ID ever assigned to a Customer, including
+  /// removed ones. Used in conjunction with AddCustomer to assign an ID to new
+  /// customers.
+  /// @return Highest assigned ID, or 1 by default
+  Customer::ID GetHighestCustomerID() const;
+
+  /// @brief Secondary index type, maps a value to the sorted IDs of the
+  /// customers holding it
+  using Index = IndexFile::Index;
+
+  /// @brief Adds a customer to a secondary index
+  /// @param index Index to update
+  /// @param key Value held by the customer
+  /// @param id Customer ID
+  static void AddToIndex(Index &index, const std::string &key,
+                         const Customer::ID id);
+
+  /// @brief Removes a customer from a secondary index
+  /// @param index Index to update
+  /// @param key Value held by the customer
+  /// @param id Customer ID
+  static void RemoveFromIndex(Index &index, const std::string &key,
+                              const Customer::ID id);
+
+  /// @brief Looks up a key in a secondary index
+  /// @param index Index to search
+  /// @param key Value to look for
+  /// @return Sorted IDs of the customers holding the value, empty if none
+  static const std::vector<Customer::ID> &LookupIndex(
+      const Index &index, const std::string_view key);
+
+  /// @brief Rebuilds all secondary indexes from scratch
+  void RebuildIndexes();
+
+  /// @brief Rebuilds all activity summaries from scratch, from the
+  /// interactions in memory and the summaries of the archive
+  void RebuildActivity();
+
+  /// @brief Customers sorted by surname and name
+  using NameView = SortedView<std::pair<InternedString, InternedString>>;
+
+  /// @brief Key of a customer in the view sorted by surname and name
+  /// @param customer Customer
+  /// @return Surname and name
+  static std::pair<InternedString, InternedString> GetNameKey(
+      const Customer &customer) {
+    return std::make_pair(customer.surname_, customer.name_);
+  }
+
+  /// @brief Customers sorted by date of the latest interaction, most recent
+  /// first
+  using ActivityView = SortedView<std::time_t, std::greater<std::time_t>>;
+
+  /// @brief Rebuilds all sorted views from scratch, from the customers and
+  /// the activity summaries
+  void RebuildViews();
+
+  /// @brief Path where database is loaded from/saved to
+  std::string database_path_;
+
+  /// @brief Whether changes are refused
+  bool read_only_;
+
+  /// @brief Keeps the customers on disk
+  std::unique_ptr<StorageEngine> storage_;
+
+  /// @brief Sequence number of the last batch of changes applied
+  std::uint64_t sequence_;
+
+  /// @brief Log of all persisted batches of changes
+  Journal journal_;
+
+  /// @brief Position in the journal right after the last batch applied
+  std::uint64_t journal_offset_;
+
+  /// @brief Sealed segments of old interactions
+  InteractionArchive archive_;
+
+  /// @brief Indexes and activity summaries saved along with the snapshot
+  IndexFile index_file_;
+
+  /// @brief Sequence number of the snapshot described by index_file_, 0 if
+  /// unknown
+  std::uint64_t index_generation_;
+
+  /// @brief Publishes applied batches to subscribers
+  ChangeFeed change_feed_;
+
+  /// @brief Whether applied changes are collected instead of persisted
+  bool persistence_deferred_;
+
+  /// @brief Changes applied but not persisted yet
+  std::vector<Change> deferred_changes_;
+
+  /// @brief Highest customer ID ever assigned
+  Customer::ID last_customer_id_;
+
+  /// @brief Holds the customers, their interactions and the summaries, so
+  /// that the many small allocations they need are served from a few chunks
+  Arena::Handle arena_;
+
+  /// @brief Keeps all customers in memory
+  CustomerMap customers_;
+
+  /// @brief Customer IDs by name
+  Index name_index_;
+
+  /// @brief Customer IDs by surname
+  Index surname_index_;
+
+  /// @brief Activity summary of every customer with interactions
+  ActivityMap activity_;
+
+  /// @brief All customers by surname and name
+  NameView name_view_;
+
+  /// @brief All customers by date of the latest interaction
+  ActivityView activity_view_;
+
+  /// @brief Imported scores, kept outside the customers
+  ScoreColumn scores_;
+
+  /// @brief Typed fields of the interactions in memory, by kind
+  InteractionColumns interaction_columns_;
+
+  /// @brief Case-folded names and surnames, packed for substring scans
+  NameColumn name_column_;
+
+  /// @brief Upcoming appointments by date, with their reminders. Shares the
+  /// interactions of customers_, whose blocks go back to arena_ when freed.
+  AppointmentScheduler appointments_;
+};
+
+#endif  // __DATABASE_H__
@@ -0,0 +1,59 @@
+#include "executor.h"
+
+#include <algorithm>
+
+Executor::Executor(const std::size_t thread_count)
+    : mutex_{}, task_available_{}, tasks_{}, stopping_{false}, threads_{} {
+  const std::size_t count =
+      thread_count > 0U
+          ? thread_count
+          : std::max<std::size_t>(1U, std::thread::hardware_concurrency());
+
+  threads_.reserve(count);
+  for (std::size_t i = 0U; i < count; i++) {
+    threads_.emplace_back(&Executor::Work, this);
+  }
+}
+
+Executor::~Executor() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  task_available_.notify_all();
+
+  for (auto& thread : threads_) {
+    thread.join();
+  }
+}
+
+void Executor::Submit(Task task) {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    tasks_.push_back(std::move(task));
+  }
+  task_available_.notify_one();
+}
+
+std::size_t Executor::GetThreadCount() const { return threads_.size(); }
+
+void Executor::Work() {
+  while (true) {
+    Task task{};
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      task_available_.wait(lock,
+                           [this]() { return stopping_ || !tasks_.empty(); });
+
+      if (tasks_.empty()) {
+        // Stopping and nothing left to do
+        return;
+      }
+
+      task = std::move(tasks_.front());
+      tasks_.pop_front();
+    }
+
+    task();
+  }
+}
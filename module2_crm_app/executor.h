@@ -0,0 +1,54 @@
+#ifndef __EXECUTOR_H__
+#define __EXECUTOR_H__
+
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/// @brief Fixed-size pool of worker threads running submitted tasks in FIFO
+/// order
+class Executor {
+ public:
+  /// @brief Unit of work run by the pool
+  using Task = std::function<void()>;
+
+  // No default, move and copy constructors/operators
+  Executor() = delete;
+  Executor(const Executor&) = delete;
+  Executor& operator=(const Executor&) = delete;
+  Executor(Executor&&) = delete;
+  Executor& operator=(Executor&&) = delete;
+
+  /// @brief Starts the worker threads
+  /// @param thread_count Number of threads, 0 to use one per hardware thread
+  explicit Executor(const std::size_t thread_count);
+
+  /// @brief Runs all queued tasks, including the ones they submit, then stops
+  /// the worker threads
+  ~Executor();
+
+  /// @brief Queues a task. Can be called from any thread, including from
+  /// within a running task.
+  /// @param task Task to run
+  void Submit(Task task);
+
+  /// @brief Number of worker threads
+  /// @return Thread count
+  std::size_t GetThreadCount() const;
+
+ private:
+  /// @brief Body of every worker thread
+  void Work();
+
+  std::mutex mutex_;
+  std::condition_variable task_available_;
+  std::deque<Task> tasks_;
+  bool stopping_;
+  std::vector<std::thread> threads_;
+};
+
+#endif  // __EXECUTOR_H__
@@ -0,0 +1,149 @@
+#include "export_command.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <limits>
+
+#include "database.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Format of the dates accepted by --from and --to
+constexpr char FILTER_DATE_FORMAT[]{"%d/%m/%Y"};
+
+/// @brief Seconds from the start of a day to its last second, so that --to
+/// includes the whole day
+constexpr std::time_t LAST_SECOND_OF_DAY{24 * 60 * 60 - 1};
+
+/// @brief Reads a list of customer IDs, one per line
+/// @param path Path of the list
+/// @param ids Where to append the IDs
+/// @return False if the file cannot be read or a line is not an ID
+bool read_customer_ids(const std::string& path,
+                       std::vector<Customer::ID>& ids) {
+  std::ifstream file_stream{path};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string line{};
+  while (std::getline(file_stream, line)) {
+    if (!line.empty() && line.back() == '\r') {
+      line.pop_back();
+    }
+    if (line.empty()) {
+      continue;
+    }
+    Customer::ID id{};
+    if (!utilities::try_convert(line, id)) {
+      return false;
+    }
+    ids.push_back(id);
+  }
+  return !file_stream.bad();
+}
+
+}  // namespace
+
+ExportCommand::ExportCommand(const Config& config) : config_{config} {}
+
+std::int32_t ExportCommand::Run() {
+  ReportExporter::Options options{};
+  if (!ParseOptions(options)) {
+    std::cerr << "Indica il tipo di report (customers o interactions) e il "
+                 "file da scrivere, con filtri e formato (tsv, csv o fixed) "
+                 "corretti."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  const Database database{config_.database_path_, true,
+                          config_.storage_engine_};
+  const ReportExporter exporter{database};
+
+  const auto start = std::chrono::steady_clock::now();
+  ReportExporter::Summary summary{};
+  if (!exporter.Export(options, config_.command_arguments_[1], summary)) {
+    std::cerr << "Impossibile scrivere il report." << std::endl;
+    return EXIT_FAILURE;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  std::cout << "Clienti esportati: " << summary.customers_ << std::endl
+            << "Righe scritte: " << summary.rows_ << std::endl
+            << "Dimensione: " << summary.bytes_ / 1024U << " KiB" << std::endl
+            << "Tempo impiegato: " << elapsed.count() << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
+
+bool ExportCommand::ParseOptions(ReportExporter::Options& options) const {
+  if (config_.command_arguments_.size() != 2U) {
+    return false;
+  }
+
+  const std::string& report = config_.command_arguments_[0];
+  if (report == "customers") {
+    options.type_ = EReportType::CUSTOMERS;
+  } else if (report == "interactions") {
+    options.type_ = EReportType::INTERACTIONS;
+  } else {
+    return false;
+  }
+
+  if (config_.output_format_ == EOutputFormat::JSON) {
+    return false;
+  }
+  options.format_ = config_.output_format_;
+  options.thread_count_ = config_.export_threads_;
+
+  if (!config_.filter_id_.empty() || !config_.filter_ids_path_.empty()) {
+    Customer::ID id{};
+    if (!config_.filter_id_.empty()) {
+      if (!utilities::try_convert(config_.filter_id_, id)) {
+        return false;
+      }
+      options.customer_ids_.push_back(id);
+    }
+    if (!config_.filter_ids_path_.empty() &&
+        !read_customer_ids(config_.filter_ids_path_, options.customer_ids_)) {
+      return false;
+    }
+
+    auto& ids = options.customer_ids_;
+    std::sort(ids.begin(), ids.end());
+    ids.erase(std::unique(ids.begin(), ids.end()), ids.end());
+    options.has_customer_list_ = true;
+  }
+
+  if (!config_.filter_kind_.empty()) {
+    if (!from_kind_name(config_.filter_kind_, options.kind_)) {
+      return false;
+    }
+    options.has_kind_ = true;
+  }
+
+  if (config_.filter_from_.empty() && config_.filter_to_.empty()) {
+    return true;
+  }
+
+  options.has_interaction_range_ = true;
+  options.from_timestamp_ = std::numeric_limits<std::time_t>::min();
+  options.to_timestamp_ = std::numeric_limits<std::time_t>::max();
+  if (!config_.filter_from_.empty() &&
+      !utilities::to_timestamp(config_.filter_from_, FILTER_DATE_FORMAT,
+                               options.from_timestamp_)) {
+    return false;
+  }
+  if (!config_.filter_to_.empty()) {
+    if (!utilities::to_timestamp(config_.filter_to_, FILTER_DATE_FORMAT,
+                                 options.to_timestamp_)) {
+      return false;
+    }
+    options.to_timestamp_ += LAST_SECOND_OF_DAY;
+  }
+  return true;
+}
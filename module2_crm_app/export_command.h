@@ -0,0 +1,39 @@
+#ifndef __EXPORT_COMMAND_H__
+#define __EXPORT_COMMAND_H__
+
+#include <cstdint>
+
+#include "config.h"
+#include "report_exporter.h"
+
+/// @brief Exports a report of the customers ("customers") or of their
+/// interactions ("interactions") to a file, as TSV, CSV or fixed-width
+/// records, optionally limited to an interval, a kind of interactions or a
+/// list of customers. The database is opened read-only.
+class ExportCommand {
+ public:
+  // No default, move and copy constructors/operators
+  ExportCommand() = delete;
+  ExportCommand(const ExportCommand&) = delete;
+  ExportCommand& operator=(const ExportCommand&) = delete;
+  ExportCommand(ExportCommand&&) = delete;
+  ExportCommand& operator=(ExportCommand&&) = delete;
+
+  /// @brief Prepares the export
+  /// @param config Report, file, format, filters and database to export
+  explicit ExportCommand(const Config& config);
+
+  /// @brief Loads the database, writes the report and prints a summary
+  /// @return Exit status code, failure if the report was not written
+  std::int32_t Run();
+
+ private:
+  /// @brief Builds the options of the export out of the command line
+  /// @param options Where to store the options
+  /// @return False if an argument or filter is malformed
+  bool ParseOptions(ReportExporter::Options& options) const;
+
+  Config config_;
+};
+
+#endif  // __EXPORT_COMMAND_H__
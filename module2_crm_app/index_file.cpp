@@ -0,0 +1,309 @@
+#include "index_file.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iterator>
+#include <sstream>
+#include <type_traits>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Marks the header line of the file
+constexpr char HEADER_MARKER{'#'};
+
+/// @brief Marks the lines of the name index
+constexpr char NAME_INDEX_MARKER{'N'};
+
+/// @brief Marks the lines of the surname index
+constexpr char SURNAME_INDEX_MARKER{'S'};
+
+/// @brief Marks the lines of the activity summaries
+constexpr char ACTIVITY_MARKER{'A'};
+
+/// @brief Marks the lines of the activity summaries without dated
+/// interactions, which have no dates to store
+constexpr char UNDATED_ACTIVITY_MARKER{'U'};
+
+/// @brief Reads the fields of a single line in place, without copying the
+/// line first
+class FieldReader {
+ public:
+  /// @param begin First character of the line
+  /// @param end One past the last character of the line
+  FieldReader(const char* begin, const char* end)
+      : position_{begin}, end_{end} {}
+
+  /// @brief Checks if every field has been read
+  bool AtEnd() const { return position_ >= end_; }
+
+  /// @brief Reads a text field
+  /// @param text Where to store the field
+  /// @return False if there are no fields left
+  bool ReadText(std::string& text) {
+    if (AtEnd()) {
+      return false;
+    }
+
+    const char* field_end = position_;
+    while (field_end < end_ && *field_end != SERIALIZATION_DELIMITER) {
+      field_end++;
+    }
+    text.assign(position_, field_end);
+    Skip(field_end);
+    return true;
+  }
+
+  /// @brief Reads a numeric field
+  /// @tparam T Integer type
+  /// @param value Where to store the field
+  /// @return False if there are no fields left or the field is not a number
+  template <typename T>
+  bool ReadNumber(T& value) {
+    if (AtEnd()) {
+      return false;
+    }
+
+    // Lines end with a newline, which stops the conversion
+    char* field_end = nullptr;
+    value = std::is_signed<T>::value
+                ? static_cast<T>(std::strtoll(position_, &field_end, 10))
+                : static_cast<T>(std::strtoull(position_, &field_end, 10));
+    if (field_end == position_ ||
+        (field_end < end_ && *field_end != SERIALIZATION_DELIMITER)) {
+      return false;
+    }
+    Skip(field_end);
+    return true;
+  }
+
+ private:
+  /// @brief Moves past a field and its delimiter
+  void Skip(const char* field_end) {
+    position_ = field_end < end_ ? field_end + 1 : end_;
+  }
+
+  const char* position_;
+  const char* end_;
+};
+
+/// @brief Parses the lines of an index
+/// @param reader Line, past the marker
+/// @param index Index to add the entry to
+/// @return False if the line is malformed
+bool read_index_entry(FieldReader& reader, IndexFile::Index& index) {
+  std::string key{};
+  if (!reader.ReadText(key)) {
+    return false;
+  }
+
+  // Entries were written in key order
+  auto& ids = index.emplace_hint(index.end(), key, std::vector<Customer::ID>{})
+                  ->second;
+  while (!reader.AtEnd()) {
+    Customer::ID id{};
+    if (!reader.ReadNumber(id)) {
+      return false;
+    }
+    ids.push_back(id);
+  }
+  return !ids.empty();
+}
+
+/// @brief Parses a line of the activity summaries
+/// @param reader Line, past the marker
+/// @param customers Customers the recent interactions belong to
+/// @param dated Whether the line holds the dates of the summary
+/// @param activity Summaries to add the entry to
+/// @return False if the line is malformed or does not match the customers
+bool read_activity_entry(FieldReader& reader, const CustomerMap& customers,
+                         const bool dated, ActivityMap& activity) {
+  Customer::ID id{};
+  ActivitySummary summary{};
+  if (!reader.ReadNumber(id) ||
+      !reader.ReadNumber(summary.interaction_count_)) {
+    return false;
+  }
+  summary.dated_ = dated;
+  if (dated && (!reader.ReadNumber(summary.first_timestamp_) ||
+                !reader.ReadNumber(summary.last_timestamp_))) {
+    return false;
+  }
+
+  const auto customer = customers.find(id);
+  if (customer == customers.cend()) {
+    return false;
+  }
+
+  const auto& interactions = customer->second.customer_interactions_;
+  while (!reader.AtEnd()) {
+    std::size_t position{};
+    std::time_t timestamp{};
+    if (summary.recent_count_ >= ACTIVITY_RECENT_INTERACTIONS ||
+        !reader.ReadNumber(position) || !reader.ReadNumber(timestamp) ||
+        position >= interactions.size()) {
+      return false;
+    }
+
+    summary.recent_[summary.recent_count_] = interactions[position];
+    summary.recent_timestamps_[summary.recent_count_] = timestamp;
+    summary.recent_count_++;
+  }
+
+  activity.emplace_hint(activity.end(), id, std::move(summary));
+  return true;
+}
+
+/// @brief Writes the entries of an index
+/// @param os Output stream
+/// @param marker Marker of the index
+/// @param index Index to write
+void write_index(std::ostream& os, const char marker,
+                 const IndexFile::Index& index) {
+  for (const auto& entry : index) {
+    os << marker << SERIALIZATION_DELIMITER << entry.first;
+    for (const Customer::ID id : entry.second) {
+      os << SERIALIZATION_DELIMITER << id;
+    }
+    os << '\n';
+  }
+}
+
+}  // namespace
+
+IndexFile::IndexFile(const std::string& path) : path_{path} {}
+
+bool IndexFile::Load(const std::uint64_t generation,
+                     const CustomerMap& customers, Index& name_index,
+                     Index& surname_index, ActivityMap& activity) const {
+  const TraceSpan trace_span{"index", "IndexFile::Load"};
+  name_index.clear();
+  surname_index.clear();
+  activity.clear();
+
+  // Snapshots of databases that predate sequence numbers cannot be told
+  // apart from each other
+  if (generation == 0U) {
+    return false;
+  }
+
+  std::ifstream file_stream{path_, std::ios::binary};
+  if (!file_stream.good()) {
+    return false;
+  }
+  const std::string content{std::istreambuf_iterator<char>{file_stream},
+                            std::istreambuf_iterator<char>{}};
+
+  const auto header_end = content.find('\n');
+  if (content.empty() || content[0] != HEADER_MARKER ||
+      header_end == std::string::npos) {
+    return false;
+  }
+
+  std::uint64_t file_generation{};
+  std::size_t customer_count{};
+  std::uint64_t checksum{};
+  FieldReader header{content.data() + 1, content.data() + header_end};
+  if (!header.ReadNumber(file_generation) ||
+      !header.ReadNumber(customer_count) || !header.ReadNumber(checksum) ||
+      file_generation != generation || customer_count != customers.size()) {
+    return false;
+  }
+
+  const char* const body = content.data() + header_end + 1U;
+  const char* const body_end = content.data() + content.size();
+  if (utilities::checksum(body, static_cast<std::size_t>(body_end - body)) !=
+      checksum) {
+    return false;
+  }
+
+  bool valid = true;
+  for (const char* line = body; valid && line < body_end;) {
+    const char* line_end = line;
+    while (line_end < body_end && *line_end != '\n') {
+      line_end++;
+    }
+
+    FieldReader reader{line + 2, line_end};
+    if (line_end - line < 2 || line[1] != SERIALIZATION_DELIMITER) {
+      valid = false;
+    } else if (line[0] == NAME_INDEX_MARKER) {
+      valid = read_index_entry(reader, name_index);
+    } else if (line[0] == SURNAME_INDEX_MARKER) {
+      valid = read_index_entry(reader, surname_index);
+    } else if (line[0] == ACTIVITY_MARKER) {
+      valid = read_activity_entry(reader, customers, true, activity);
+    } else if (line[0] == UNDATED_ACTIVITY_MARKER) {
+      valid = read_activity_entry(reader, customers, false, activity);
+    } else {
+      valid = false;
+    }
+
+    line = line_end + 1;
+  }
+
+  if (!valid) {
+    name_index.clear();
+    surname_index.clear();
+    activity.clear();
+  }
+  return valid;
+}
+
+bool IndexFile::Save(const std::uint64_t generation,
+                     const CustomerMap& customers, const Index& name_index,
+                     const Index& surname_index,
+                     const ActivityMap& activity) const {
+  const TraceSpan trace_span{"index", "IndexFile::Save"};
+  std::ostringstream body{};
+  write_index(body, NAME_INDEX_MARKER, name_index);
+  write_index(body, SURNAME_INDEX_MARKER, surname_index);
+
+  for (const auto& entry : activity) {
+    const ActivitySummary& summary = entry.second;
+    const auto customer = customers.find(entry.first);
+    if (customer == customers.cend()) {
+      continue;
+    }
+
+    if (!summary.IsDated()) {
+      // Only dated interactions are among the recent ones
+      body << UNDATED_ACTIVITY_MARKER << SERIALIZATION_DELIMITER
+           << entry.first << SERIALIZATION_DELIMITER
+           << summary.interaction_count_ << '\n';
+      continue;
+    }
+
+    body << ACTIVITY_MARKER << SERIALIZATION_DELIMITER << entry.first
+         << SERIALIZATION_DELIMITER << summary.interaction_count_
+         << SERIALIZATION_DELIMITER << summary.first_timestamp_
+         << SERIALIZATION_DELIMITER << summary.last_timestamp_;
+
+    // Recent interactions are usually the last ones added
+    const auto& interactions = customer->second.customer_interactions_;
+    for (std::size_t i = 0U; i < summary.recent_count_; i++) {
+      const auto interaction = std::find(interactions.crbegin(),
+                                         interactions.crend(),
+                                         summary.recent_[i]);
+      if (interaction == interactions.crend()) {
+        break;
+      }
+
+      body << SERIALIZATION_DELIMITER
+           << std::distance(interaction, interactions.crend()) - 1
+           << SERIALIZATION_DELIMITER << summary.recent_timestamps_[i];
+    }
+    body << '\n';
+  }
+
+  const std::string content{body.str()};
+  std::ostringstream file{};
+  file << HEADER_MARKER << generation << SERIALIZATION_DELIMITER
+       << customers.size() << SERIALIZATION_DELIMITER
+       << utilities::checksum(content.data(), content.size()) << '\n'
+       << content;
+  return utilities::write_file(path_, file.str());
+}
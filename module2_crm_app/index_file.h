@@ -0,0 +1,78 @@
+#ifndef __INDEX_FILE_H__
+#define __INDEX_FILE_H__
+
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "activity.h"
+#include "customers.h"
+
+/// @brief Persists the secondary indexes and the activity summaries of the
+/// Database, so that they do not have to be rebuilt from every customer and
+/// interaction at startup. The file starts with the header line
+///
+///   #<generation>\t<customers>\t<checksum>
+///
+/// where the generation is the sequence number of the snapshot the indexes
+/// describe and the checksum covers the rest of the file, made of lines:
+///
+///   N\t<name>\t<id>\t<id>...          name index entry
+///   S\t<surname>\t<id>\t<id>...       surname index entry
+///   A\t<id>\t<count>\t<first>\t<last>[\t<position>\t<timestamp>]...
+///   U\t<id>\t<count>                  activity without dated interactions
+///
+/// Activity lines refer to the recent interactions of a summary by their
+/// position among the interactions of the customer.
+///
+/// The file is only used when it matches the snapshot loaded by the storage
+/// engine; otherwise the Database rebuilds everything and writes a fresh file
+/// the next time it saves.
+class IndexFile {
+ public:
+  /// @brief Secondary index, maps a value to the sorted IDs of the customers
+  /// holding it. Looked up by std::string_view without building a string.
+  using Index =
+      std::map<std::string, std::vector<Customer::ID>, std::less<>>;
+
+  // No default, move and copy constructors/operators
+  IndexFile() = delete;
+  IndexFile(const IndexFile&) = delete;
+  IndexFile& operator=(const IndexFile&) = delete;
+  IndexFile(IndexFile&&) = delete;
+  IndexFile& operator=(IndexFile&&) = delete;
+
+  /// @brief Binds to a file. Nothing is read until Load().
+  /// @param path Path of the index file
+  explicit IndexFile(const std::string& path);
+
+  /// @brief Reads the indexes, if they match the loaded snapshot
+  /// @param generation Sequence number of the snapshot loaded
+  /// @param customers Customers of the snapshot
+  /// @param name_index Where to store the name index
+  /// @param surname_index Where to store the surname index
+  /// @param activity Where to store the activity summaries
+  /// @return False if the file is missing, corrupted or stale; the outputs
+  /// are left empty
+  bool Load(const std::uint64_t generation, const CustomerMap& customers,
+            Index& name_index, Index& surname_index,
+            ActivityMap& activity) const;
+
+  /// @brief Writes the indexes, replacing the file atomically
+  /// @param generation Sequence number of the snapshot they describe, which
+  /// must be durable in the storage engine
+  /// @param customers Customers of the snapshot
+  /// @param name_index Name index
+  /// @param surname_index Surname index
+  /// @param activity Activity summaries
+  /// @return True if the file reached the disk, false otherwise
+  bool Save(const std::uint64_t generation, const CustomerMap& customers,
+            const Index& name_index, const Index& surname_index,
+            const ActivityMap& activity) const;
+
+ private:
+  std::string path_;
+};
+
+#endif  // __INDEX_FILE_H__
@@ -0,0 +1,314 @@
+#include "interaction_archive.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <limits>
+#include <map>
+#include <sstream>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Extension of the segment files
+constexpr char SEGMENT_EXTENSION[]{".seg"};
+
+/// @brief Extension of the summary files
+constexpr char SUMMARY_EXTENSION[]{".sum"};
+
+/// @brief Separates the month from the sequence number in segment names
+constexpr char SEGMENT_NAME_SEPARATOR{'-'};
+
+/// @brief Builds the name of a segment file
+/// @param month_start First second of the month covered by the segment
+/// @param sequence Sequence number of the batch sealing it
+/// @param extension SEGMENT_EXTENSION or SUMMARY_EXTENSION
+/// @return File name, e.g. "202301-42.seg"
+std::string segment_name(const std::time_t month_start,
+                         const std::uint64_t sequence, const char* extension) {
+  std::tm date_time{};
+  localtime_r(&month_start, &date_time);
+
+  char month[8]{};
+  std::strftime(month, sizeof(month), "%Y%m", &date_time);
+
+  return std::string{month} + SEGMENT_NAME_SEPARATOR +
+         std::to_string(sequence) + extension;
+}
+
+/// @brief Extracts month and sequence number from the name of a segment file
+/// @param name File name
+/// @param month_start Where to store the first second of the month covered
+/// @param sequence Where to store the sequence number
+/// @return False if the name does not belong to a segment
+bool parse_segment_name(const std::string& name, std::time_t& month_start,
+                        std::uint64_t& sequence) {
+  const std::string extension{SEGMENT_EXTENSION};
+  const auto separator = name.find(SEGMENT_NAME_SEPARATOR);
+  if (name.size() <= extension.size() ||
+      name.compare(name.size() - extension.size(), extension.size(),
+                   extension) != 0 ||
+      separator != 6U) {
+    return false;
+  }
+
+  std::uint32_t month{};
+  if (!utilities::try_convert(name.substr(0U, separator), month) ||
+      !utilities::try_convert(
+          name.substr(separator + 1U,
+                      name.size() - extension.size() - separator - 1U),
+          sequence) ||
+      month % 100U < 1U || month % 100U > 12U) {
+    return false;
+  }
+
+  std::tm date_time{};
+  date_time.tm_year = static_cast<int>(month / 100U) - 1900;
+  date_time.tm_mon = static_cast<int>(month % 100U) - 1;
+  date_time.tm_mday = 1;
+  month_start = std::mktime(&date_time);
+  return true;
+}
+
+}  // namespace
+
+InteractionArchive::InteractionArchive(const std::string& directory_path)
+    : directory_path_{directory_path}, segments_{} {}
+
+void InteractionArchive::Open(const std::uint64_t sequence,
+                              const bool discard_unfinished) {
+  const TraceSpan trace_span{"archive", "InteractionArchive::Open"};
+  segments_.clear();
+
+  std::vector<std::string> file_names{};
+  if (!utilities::list_directory(directory_path_, file_names)) {
+    // Nothing archived yet
+    return;
+  }
+
+  for (const auto& file_name : file_names) {
+    Segment segment{};
+    if (!parse_segment_name(file_name, segment.from_timestamp_,
+                            segment.sequence_)) {
+      continue;
+    }
+
+    segment.path_ = directory_path_ + "/" + file_name;
+    segment.summary_path_ =
+        directory_path_ + "/" +
+        segment_name(segment.from_timestamp_, segment.sequence_,
+                     SUMMARY_EXTENSION);
+    if (segment.sequence_ > sequence) {
+      if (discard_unfinished) {
+        std::remove(segment.path_.c_str());
+        std::remove(segment.summary_path_.c_str());
+      }
+      continue;
+    }
+
+    // One second before the next month begins
+    segment.to_timestamp_ =
+        GetMonthStart(segment.from_timestamp_ + 32 * 24 * 60 * 60) - 1;
+    segments_.push_back(std::move(segment));
+  }
+
+  std::sort(segments_.begin(), segments_.end(),
+            [](const Segment& lhs, const Segment& rhs) {
+              return lhs.from_timestamp_ != rhs.from_timestamp_
+                         ? lhs.from_timestamp_ < rhs.from_timestamp_
+                         : lhs.sequence_ < rhs.sequence_;
+            });
+}
+
+bool InteractionArchive::Seal(const std::uint64_t sequence,
+                              const std::vector<Entry>& entries) {
+  const TraceSpan trace_span{"archive", "InteractionArchive::Seal"};
+  if (entries.empty()) {
+    return true;
+  }
+
+  if (!utilities::create_directory(directory_path_)) {
+    return false;
+  }
+
+  std::map<std::time_t, std::vector<Entry>> months{};
+  for (const auto& entry : entries) {
+    std::time_t timestamp{};
+    entry.second->GetTimestamp(timestamp);
+    months[GetMonthStart(timestamp)].push_back(entry);
+  }
+
+  for (auto& month : months) {
+    auto& month_entries = month.second;
+    // Sorted by customer so lookups can stop early, keeping the order of the
+    // interactions of each customer
+    std::stable_sort(month_entries.begin(), month_entries.end(),
+                     [](const Entry& lhs, const Entry& rhs) {
+                       return lhs.first < rhs.first;
+                     });
+
+    std::ostringstream segment{};
+    std::ostringstream summary{};
+    for (auto entry = month_entries.cbegin(); entry != month_entries.cend();) {
+      std::size_t count{};
+      std::time_t first_timestamp{std::numeric_limits<std::time_t>::max()};
+      std::time_t last_timestamp{std::numeric_limits<std::time_t>::min()};
+
+      const Customer::ID id = entry->first;
+      for (; entry != month_entries.cend() && entry->first == id; ++entry) {
+        segment << id << SERIALIZATION_DELIMITER << *entry->second << '\n';
+
+        std::time_t timestamp{};
+        entry->second->GetTimestamp(timestamp);
+        first_timestamp = std::min(first_timestamp, timestamp);
+        last_timestamp = std::max(last_timestamp, timestamp);
+        count++;
+      }
+
+      summary << id << SERIALIZATION_DELIMITER << count
+              << SERIALIZATION_DELIMITER << first_timestamp
+              << SERIALIZATION_DELIMITER << last_timestamp << '\n';
+    }
+
+    // Summary first: a segment is only found through its own name
+    if (!utilities::write_file(directory_path_ + "/" +
+                        segment_name(month.first, sequence, SUMMARY_EXTENSION),
+                    summary.str()) ||
+        !utilities::write_file(directory_path_ + "/" +
+                        segment_name(month.first, sequence, SEGMENT_EXTENSION),
+                    segment.str())) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+void InteractionArchive::Collect(
+    const Customer::ID id, const std::time_t from_timestamp,
+    const std::time_t to_timestamp,
+    std::vector<std::shared_ptr<Interaction>>& interactions) const {
+  const TraceSpan trace_span{"archive", "InteractionArchive::Collect"};
+  for (const auto& segment : segments_) {
+    if (segment.to_timestamp_ < from_timestamp ||
+        segment.from_timestamp_ > to_timestamp) {
+      continue;
+    }
+
+    std::fstream file_stream{segment.path_, std::ios::in};
+    std::string line{};
+    while (std::getline(file_stream, line)) {
+      std::stringstream ss{line};
+      std::string entry_id{};
+      Customer::ID customer_id{};
+      if (!std::getline(ss, entry_id, SERIALIZATION_DELIMITER) ||
+          !utilities::try_convert(entry_id, customer_id)) {
+        continue;
+      }
+
+      if (customer_id > id) {
+        break;
+      }
+      if (customer_id < id) {
+        continue;
+      }
+
+      std::shared_ptr<Interaction> interaction{std::make_shared<Interaction>()};
+      std::getline(ss, interaction->when_, SERIALIZATION_DELIMITER);
+      std::getline(ss, interaction->what_);
+      interaction->Decode();
+
+      if (interaction->InRange(from_timestamp, to_timestamp)) {
+        interactions.push_back(std::move(interaction));
+      }
+    }
+  }
+}
+
+void InteractionArchive::ForEachSummary(const SummaryCallback& callback) const {
+  for (const auto& segment : segments_) {
+    std::fstream file_stream{segment.summary_path_, std::ios::in};
+    if (!file_stream.good()) {
+      // Sealed before summaries were written
+      SummarizeSegment(segment, callback);
+      continue;
+    }
+
+    std::string line{};
+    while (std::getline(file_stream, line)) {
+      std::stringstream ss{line};
+      Customer::ID id{};
+      std::size_t count{};
+      std::time_t first_timestamp{};
+      std::time_t last_timestamp{};
+      if (ss >> id >> count >> first_timestamp >> last_timestamp) {
+        callback(id, count, first_timestamp, last_timestamp);
+      }
+    }
+  }
+}
+
+void InteractionArchive::SummarizeSegment(const Segment& segment,
+                                          const SummaryCallback& callback) {
+  std::fstream file_stream{segment.path_, std::ios::in};
+  std::string line{};
+  Customer::ID current_id{INVALID_CUSTOMER_ID};
+  std::size_t count{};
+  std::time_t first_timestamp{};
+  std::time_t last_timestamp{};
+
+  while (std::getline(file_stream, line)) {
+    std::stringstream ss{line};
+    std::string entry_id{};
+    Customer::ID id{};
+    Interaction interaction{};
+    if (!std::getline(ss, entry_id, SERIALIZATION_DELIMITER) ||
+        !std::getline(ss, interaction.when_, SERIALIZATION_DELIMITER) ||
+        !utilities::try_convert(entry_id, id)) {
+      continue;
+    }
+
+    interaction.Decode();
+    std::time_t timestamp{};
+    interaction.GetTimestamp(timestamp);
+
+    // Lines are sorted by customer
+    if (id != current_id) {
+      if (count > 0U) {
+        callback(current_id, count, first_timestamp, last_timestamp);
+      }
+      current_id = id;
+      count = 0U;
+      first_timestamp = timestamp;
+      last_timestamp = timestamp;
+    }
+
+    first_timestamp = std::min(first_timestamp, timestamp);
+    last_timestamp = std::max(last_timestamp, timestamp);
+    count++;
+  }
+
+  if (count > 0U) {
+    callback(current_id, count, first_timestamp, last_timestamp);
+  }
+}
+
+std::size_t InteractionArchive::GetSegmentCount() const {
+  return segments_.size();
+}
+
+std::time_t InteractionArchive::GetMonthStart(
+    const std::time_t timestamp, const std::uint32_t months_back) {
+  std::tm date_time{};
+  localtime_r(&timestamp, &date_time);
+
+  // Same conventions as utilities::to_timestamp(), so the result compares
+  // consistently with the timestamps of the interactions
+  std::tm month_start{};
+  month_start.tm_year = date_time.tm_year;
+  month_start.tm_mon = date_time.tm_mon - static_cast<int>(months_back);
+  month_start.tm_mday = 1;
+  return std::mktime(&month_start);
+}
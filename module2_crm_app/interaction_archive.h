@@ -0,0 +1,123 @@
+#ifndef __INTERACTION_ARCHIVE_H__
+#define __INTERACTION_ARCHIVE_H__
+
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "customers.h"
+
+/// @brief Cold storage for old interactions. Interactions are partitioned by
+/// the month they happened in, and every partition is sealed into a
+/// read-only segment file:
+///
+///   <directory>/<YYYYMM>-<sequence>.seg
+///
+/// holding one "<customer id>\t<when>\t<what>" line per interaction, sorted
+/// by customer. The sequence number is the one of the journal batch that
+/// moved the interactions out of memory: segments newer than the database
+/// belong to a seal that never completed and are ignored.
+///
+/// Next to every segment, a <YYYYMM>-<sequence>.sum file holds one
+/// "<customer id>\t<count>\t<first>\t<last>" line per customer, with the
+/// number of interactions and the timestamps of the oldest and latest one.
+///
+/// Segments are only opened by Collect() when the requested time interval
+/// overlaps the month they cover.
+class InteractionArchive {
+ public:
+  /// @brief Interaction to archive, with the customer it belongs to
+  using Entry = std::pair<Customer::ID, std::shared_ptr<Interaction>>;
+
+  /// @brief Receives the archived interactions of a customer in a segment:
+  /// how many they are and the dates of the oldest and latest one
+  using SummaryCallback = std::function<void(
+      const Customer::ID id, const std::size_t count,
+      const std::time_t first_timestamp, const std::time_t last_timestamp)>;
+
+  // No default, move and copy constructors/operators
+  InteractionArchive() = delete;
+  InteractionArchive(const InteractionArchive&) = delete;
+  InteractionArchive& operator=(const InteractionArchive&) = delete;
+  InteractionArchive(InteractionArchive&&) = delete;
+  InteractionArchive& operator=(InteractionArchive&&) = delete;
+
+  /// @brief Binds the archive to a directory. Nothing is read until Open().
+  /// @param directory_path Directory holding the segment files
+  explicit InteractionArchive(const std::string& directory_path);
+
+  /// @brief Looks up the segments sealed up to a given batch
+  /// @param sequence Sequence number of the last batch applied
+  /// @param discard_unfinished Deletes the segments of newer batches, left
+  /// behind by a seal that was interrupted. Only the writing process may do
+  /// so.
+  void Open(const std::uint64_t sequence, const bool discard_unfinished);
+
+  /// @brief Writes the given interactions into new segments, one per month.
+  /// The segments are only taken into account once Open() is called with a
+  /// sequence number at least as high as the given one.
+  /// @param sequence Sequence number of the batch that will drop the
+  /// interactions from memory
+  /// @param entries Interactions to archive
+  /// @return True if all segments reached the disk, false otherwise
+  bool Seal(const std::uint64_t sequence, const std::vector<Entry>& entries);
+
+  /// @brief Collects the archived interactions of a customer within a time
+  /// interval. Only the segments overlapping the interval are read.
+  /// @param id Customer ID
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param interactions Where to push the interactions found
+  void Collect(const Customer::ID id, const std::time_t from_timestamp,
+               const std::time_t to_timestamp,
+               std::vector<std::shared_ptr<Interaction>>& interactions) const;
+
+  /// @brief Reads the summaries of all segments in use, without opening the
+  /// segments themselves
+  /// @param callback Invoked for every customer of every segment
+  void ForEachSummary(const SummaryCallback& callback) const;
+
+  /// @brief Number of segments currently in use
+  /// @return Segment count
+  std::size_t GetSegmentCount() const;
+
+  /// @brief Start of the month a timestamp falls into, in local time
+  /// @param timestamp UNIX Timestamp
+  /// @param months_back Number of months to go back from there
+  /// @return UNIX Timestamp of the first second of the month
+  static std::time_t GetMonthStart(const std::time_t timestamp,
+                                   const std::uint32_t months_back = 0U);
+
+ private:
+  /// @brief A sealed segment
+  struct Segment {
+    /// @brief Path of the segment file
+    std::string path_;
+    /// @brief Path of the summary file
+    std::string summary_path_;
+    /// @brief Sequence number of the batch that sealed it
+    std::uint64_t sequence_;
+    /// @brief First second of the month covered
+    std::time_t from_timestamp_;
+    /// @brief Last second of the month covered
+    std::time_t to_timestamp_;
+  };
+
+  /// @brief Summarizes a segment by reading it entirely
+  /// @param segment Segment to read
+  /// @param callback Invoked for every customer of the segment
+  static void SummarizeSegment(const Segment& segment,
+                               const SummaryCallback& callback);
+
+  /// @brief Directory holding the segment files
+  std::string directory_path_;
+
+  /// @brief Segments in use, oldest month first
+  std::vector<Segment> segments_;
+};
+
+#endif  // __INTERACTION_ARCHIVE_H__
@@ -0,0 +1,179 @@
+#include "interaction_columns.h"
+
+#include <algorithm>
+
+#include "memory_report.h"
+#include "tracer.h"
+
+namespace {
+
+/// @brief Moves a row of a column to a lower position
+/// @param values Column
+/// @param from Position of the row
+/// @param to Position it is moved to
+template <typename T>
+void move_row(std::vector<T>& values, const std::size_t from,
+              const std::size_t to) {
+  if (from < values.size()) {
+    values[to] = values[from];
+  }
+}
+
+}  // namespace
+
+InteractionColumns::InteractionColumns() : columns_{}, removed_ids_{} {}
+
+void InteractionColumns::Add(const Customer::ID id,
+                             const Interaction& interaction) {
+  Column* const column = GetColumn(interaction.details_.kind_);
+  if (column == nullptr) {
+    return;
+  }
+
+  column->timestamps_.push_back(interaction.timestamp_);
+  column->customer_ids_.push_back(id);
+  if (interaction.details_.kind_ == EInteractionKind::CONTRACT) {
+    column->policies_.push_back(interaction.details_.policy_);
+    column->premium_cents_.push_back(interaction.details_.premium_cents_);
+    column->duration_months_.push_back(interaction.details_.duration_months_);
+  }
+}
+
+void InteractionColumns::RemoveCustomer(const Customer& customer) {
+  // The rows themselves are not looked for: they are counted out of the
+  // interactions of the customer, which are the ones in the columns
+  bool has_rows{false};
+  for (const auto& interaction : customer.customer_interactions_) {
+    Column* const column = GetColumn(interaction->details_.kind_);
+    if (column != nullptr) {
+      column->removed_rows_++;
+      has_rows = true;
+    }
+  }
+  if (!has_rows) {
+    return;
+  }
+  removed_ids_.insert(
+      std::lower_bound(removed_ids_.begin(), removed_ids_.end(), customer.id_),
+      customer.id_);
+
+  std::size_t rows{};
+  std::size_t removed_rows{};
+  for (const auto& column : columns_) {
+    rows += column.timestamps_.size();
+    removed_rows += column.removed_rows_;
+  }
+  if (removed_rows * 2U >= rows) {
+    Compact();
+  }
+}
+
+void InteractionColumns::Rebuild(const CustomerMap& customers) {
+  const TraceSpan trace_span{"database", "InteractionColumns::Rebuild"};
+  for (auto& column : columns_) {
+    column = Column{};
+  }
+  removed_ids_.clear();
+
+  for (const auto& customer_entry : customers) {
+    for (const auto& interaction :
+         customer_entry.second.customer_interactions_) {
+      Add(customer_entry.first, *interaction);
+    }
+  }
+}
+
+std::size_t InteractionColumns::GetCount(const EInteractionKind kind) const {
+  const Column* const column = GetColumn(kind);
+  return column != nullptr
+             ? column->timestamps_.size() - column->removed_rows_
+             : 0U;
+}
+
+std::uint64_t InteractionColumns::GetMemoryUsage() const {
+  std::uint64_t bytes{};
+  for (const auto& column : columns_) {
+    bytes += vector_buffer_size(column.timestamps_) +
+             vector_buffer_size(column.customer_ids_) +
+             vector_buffer_size(column.policies_) +
+             vector_buffer_size(column.premium_cents_) +
+             vector_buffer_size(column.duration_months_);
+  }
+  return bytes + vector_buffer_size(removed_ids_);
+}
+
+void InteractionColumns::GetCustomers(const EInteractionKind kind,
+                                      const std::time_t from_timestamp,
+                                      const std::time_t to_timestamp,
+                                      std::vector<Customer::ID>& ids) const {
+  const Column* const column = GetColumn(kind);
+  if (column == nullptr) {
+    return;
+  }
+
+  const std::size_t first = ids.size();
+  const std::vector<std::time_t>& timestamps = column->timestamps_;
+  for (std::size_t row = 0U; row < timestamps.size(); row++) {
+    if (timestamps[row] >= from_timestamp && timestamps[row] <= to_timestamp) {
+      ids.push_back(column->customer_ids_[row]);
+    }
+  }
+
+  std::sort(ids.begin() + first, ids.end());
+  ids.erase(std::unique(ids.begin() + first, ids.end()), ids.end());
+  if (!removed_ids_.empty()) {
+    ids.erase(std::remove_if(ids.begin() + first, ids.end(),
+                             [this](const Customer::ID id) {
+                               return IsRemoved(id);
+                             }),
+              ids.end());
+  }
+}
+
+InteractionColumns::Column* InteractionColumns::GetColumn(
+    const EInteractionKind kind) {
+  const auto index = static_cast<std::uint32_t>(kind) - 1U;
+  return index < columns_.size() ? &columns_[index] : nullptr;
+}
+
+const InteractionColumns::Column* InteractionColumns::GetColumn(
+    const EInteractionKind kind) const {
+  const auto index = static_cast<std::uint32_t>(kind) - 1U;
+  return index < columns_.size() ? &columns_[index] : nullptr;
+}
+
+bool InteractionColumns::IsRemoved(const Customer::ID id) const {
+  return std::binary_search(removed_ids_.cbegin(), removed_ids_.cend(), id);
+}
+
+void InteractionColumns::Compact() {
+  const TraceSpan trace_span{"database", "InteractionColumns::Compact"};
+  for (auto& column : columns_) {
+    if (column.removed_rows_ == 0U) {
+      continue;
+    }
+
+    std::size_t kept{};
+    for (std::size_t row = 0U; row < column.customer_ids_.size(); row++) {
+      if (IsRemoved(column.customer_ids_[row])) {
+        continue;
+      }
+      move_row(column.timestamps_, row, kept);
+      move_row(column.customer_ids_, row, kept);
+      move_row(column.policies_, row, kept);
+      move_row(column.premium_cents_, row, kept);
+      move_row(column.duration_months_, row, kept);
+      kept++;
+    }
+
+    column.timestamps_.resize(kept);
+    column.customer_ids_.resize(kept);
+    if (!column.policies_.empty()) {
+      column.policies_.resize(kept);
+      column.premium_cents_.resize(kept);
+      column.duration_months_.resize(kept);
+    }
+    column.removed_rows_ = 0U;
+  }
+  removed_ids_.clear();
+}
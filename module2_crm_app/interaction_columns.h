@@ -0,0 +1,99 @@
+#ifndef __INTERACTION_COLUMNS_H__
+#define __INTERACTION_COLUMNS_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <vector>
+
+#include "customers.h"
+
+/// @brief The typed fields of the interactions in memory, one set of
+/// fixed-width columns per kind, so that a query such as "contracts signed
+/// in the third quarter" scans an array of timestamps instead of parsing the
+/// dates and descriptions of every interaction.
+///
+/// Rows are appended as interactions are added and are not sorted. Archived
+/// interactions are not included. The rows of a removed customer stay in
+/// place, skipped by the queries, until they make up half of the rows: then
+/// all of them are dropped in a single pass. Customer IDs are never reused,
+/// so a removed customer never gets rows again.
+class InteractionColumns {
+ public:
+  InteractionColumns();
+
+  // No move and copy constructors/operators
+  InteractionColumns(const InteractionColumns&) = delete;
+  InteractionColumns& operator=(const InteractionColumns&) = delete;
+  InteractionColumns(InteractionColumns&&) = delete;
+  InteractionColumns& operator=(InteractionColumns&&) = delete;
+
+  /// @brief Adds an interaction to the columns of its kind
+  /// @param id Customer the interaction belongs to
+  /// @param interaction Interaction to add
+  void Add(const Customer::ID id, const Interaction& interaction);
+
+  /// @brief Removes all interactions of a customer
+  /// @param customer Customer about to be removed
+  void RemoveCustomer(const Customer& customer);
+
+  /// @brief Rebuilds all columns from the interactions in memory
+  /// @param customers All customers
+  void Rebuild(const CustomerMap& customers);
+
+  /// @brief Number of interactions of a kind
+  /// @param kind Kind of the interactions
+  /// @return Count
+  std::size_t GetCount(const EInteractionKind kind) const;
+
+  /// @brief Memory taken by the columns of all kinds
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+  /// @brief Lists the customers with an interaction of a kind within a time
+  /// interval
+  /// @param kind Kind of the interactions
+  /// @param from_timestamp Start date as a UNIX Timestamp
+  /// @param to_timestamp End date as a UNIX Timestamp
+  /// @param ids Where to store the IDs of the customers, ascending and
+  /// without repetitions
+  void GetCustomers(const EInteractionKind kind,
+                    const std::time_t from_timestamp,
+                    const std::time_t to_timestamp,
+                    std::vector<Customer::ID>& ids) const;
+
+ private:
+  /// @brief Interactions of a single kind, one row per interaction
+  struct Column {
+    std::vector<std::time_t> timestamps_;
+    std::vector<Customer::ID> customer_ids_;
+    /// @brief Policy fields, only filled for contracts
+    std::vector<EPolicyType> policies_;
+    std::vector<std::uint32_t> premium_cents_;
+    std::vector<std::uint32_t> duration_months_;
+    /// @brief Rows of removed customers, still in the vectors above
+    std::size_t removed_rows_;
+  };
+
+  /// @brief Columns of a kind
+  /// @param kind Kind of the interactions
+  /// @return Columns, nullptr if the kind is not valid
+  Column* GetColumn(const EInteractionKind kind);
+  const Column* GetColumn(const EInteractionKind kind) const;
+
+  /// @brief Checks if a customer has been removed
+  /// @param id Customer ID
+  /// @return True if the rows of the customer are to be skipped
+  bool IsRemoved(const Customer::ID id) const;
+
+  /// @brief Drops the rows of the removed customers from all columns
+  void Compact();
+
+  /// @brief Columns of the kinds, in the order of EInteractionKind
+  std::array<Column, 3U> columns_;
+  /// @brief Customers removed since the last compaction, ascending
+  std::vector<Customer::ID> removed_ids_;
+};
+
+#endif  // __INTERACTION_COLUMNS_H__
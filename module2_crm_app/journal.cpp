@@ -0,0 +1,142 @@
+#include "journal.h"
+
+#include <fstream>
+#include <sstream>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Marks the header line of a batch
+constexpr char BATCH_MARKER{'#'};
+
+/// @brief Reads a line that is terminated by a newline
+/// @param is Input stream
+/// @param line Where to store the line
+/// @return False if no complete line is available
+bool read_complete_line(std::istream& is, std::string& line) {
+  if (!std::getline(is, line)) {
+    return false;
+  }
+
+  // Hitting EOF means the last line has not been terminated yet, i.e. the
+  // writer is still in the middle of it
+  return !is.eof();
+}
+
+}  // namespace
+
+Journal::Journal(const std::string& journal_path)
+    : journal_path_{journal_path} {}
+
+bool Journal::Append(const std::uint64_t sequence,
+                     const std::vector<Change>& changes) {
+  const TraceSpan trace_span{"journal", "Journal::Append"};
+  std::ostringstream batch{};
+  batch << BATCH_MARKER << sequence << SERIALIZATION_DELIMITER
+        << changes.size() << std::endl;
+  for (const auto& change : changes) {
+    batch << change;
+  }
+
+  std::fstream file_stream{journal_path_, std::ios::out | std::ios::app};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  // Single write, so readers never see a batch header without its changes
+  // for longer than needed
+  const std::uint64_t previous_size = GetSize();
+  file_stream << batch.str();
+  file_stream.close();
+  if (!file_stream.fail() && utilities::sync_file(journal_path_)) {
+    return true;
+  }
+
+  // The caller gives the batch up: a partial one would hide every batch
+  // appended after it from the readers
+  utilities::truncate_file(journal_path_, previous_size);
+  return false;
+}
+
+bool Journal::Reset() {
+  const TraceSpan trace_span{"journal", "Journal::Reset"};
+  const std::string temporary_path{journal_path_ + ".tmp"};
+  std::fstream file_stream{temporary_path, std::ios::out | std::ios::trunc};
+  if (!file_stream.good()) {
+    return false;
+  }
+  file_stream.close();
+
+  return utilities::replace_file(temporary_path, journal_path_);
+}
+
+std::uint64_t Journal::GetSize() const {
+  std::ifstream file_stream{journal_path_, std::ios::binary | std::ios::ate};
+  if (!file_stream.good()) {
+    return 0U;
+  }
+
+  return static_cast<std::uint64_t>(file_stream.tellg());
+}
+
+bool Journal::ReadBatches(std::uint64_t& offset,
+                          const BatchCallback& callback) const {
+  const TraceSpan trace_span{"journal", "Journal::ReadBatches"};
+  std::ifstream file_stream{journal_path_, std::ios::binary};
+  if (!file_stream.good()) {
+    // A missing journal is an empty journal
+    return offset == 0U;
+  }
+
+  file_stream.seekg(0, std::ios::end);
+  if (static_cast<std::uint64_t>(file_stream.tellg()) < offset) {
+    return false;
+  }
+  file_stream.seekg(static_cast<std::streamoff>(offset));
+
+  std::string line{};
+  while (read_complete_line(file_stream, line)) {
+    std::uint64_t sequence{};
+    std::size_t change_count{};
+    std::stringstream header{line};
+    std::string sequence_field{};
+    std::string count_field{};
+
+    if (line.empty() || line[0] != BATCH_MARKER ||
+        !std::getline(header.ignore(1), sequence_field,
+                      SERIALIZATION_DELIMITER) ||
+        !std::getline(header, count_field) ||
+        !utilities::try_convert(sequence_field, sequence) ||
+        !utilities::try_convert(count_field, change_count)) {
+      return false;
+    }
+
+    std::vector<Change> changes{};
+    changes.reserve(change_count);
+    while (changes.size() < change_count &&
+           read_complete_line(file_stream, line)) {
+      std::stringstream ss{line};
+      Change change{};
+      ss >> change;
+
+      if (change.type_ == Change::EType::INVALID) {
+        return false;
+      }
+      changes.push_back(std::move(change));
+    }
+
+    if (changes.size() < change_count) {
+      // Batch not complete yet
+      break;
+    }
+
+    offset = static_cast<std::uint64_t>(file_stream.tellg());
+    if (!callback(sequence, changes)) {
+      break;
+    }
+  }
+
+  return true;
+}
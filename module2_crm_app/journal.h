@@ -0,0 +1,68 @@
+#ifndef __JOURNAL_H__
+#define __JOURNAL_H__
+
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+#include "changes.h"
+
+/// @brief Append-only log of all changes persisted by the Database.
+/// Changes are grouped in batches (one per commit), each one tagged with an
+/// increasing sequence number:
+///
+///   #<sequence>\t<number of changes>
+///   <change>
+///   ...
+///
+/// The journal is written before the snapshot, so it can be replayed to
+/// recover the last commits after a crash, and it is what replicas tail to
+/// follow the primary.
+class Journal {
+ public:
+  /// @brief Called for every complete batch read from the journal
+  /// @return False to stop reading
+  using BatchCallback = std::function<bool(const std::uint64_t sequence,
+                                           const std::vector<Change>& changes)>;
+
+  // No default, move and copy constructors/operators
+  Journal() = delete;
+  Journal(const Journal&) = delete;
+  Journal& operator=(const Journal&) = delete;
+  Journal(Journal&&) = delete;
+  Journal& operator=(Journal&&) = delete;
+
+  explicit Journal(const std::string& journal_path);
+
+  /// @brief Appends a batch of changes and flushes it to disk. On failure
+  /// the journal is cut back to where it was, so the batch can be retried.
+  /// @param sequence Sequence number of the batch
+  /// @param changes Changes of the batch
+  /// @return True if the batch reached the disk, false otherwise
+  bool Append(const std::uint64_t sequence, const std::vector<Change>& changes);
+
+  /// @brief Empties the journal. Only to be called once every change in it is
+  /// part of a snapshot.
+  /// @return True on success, false otherwise
+  bool Reset();
+
+  /// @brief Current size of the journal file
+  /// @return Size in bytes, 0 if the journal does not exist
+  std::uint64_t GetSize() const;
+
+  /// @brief Reads all complete batches starting from a given position.
+  /// A batch that is still being written is left for the next call.
+  /// @param offset Position to start reading from, updated to the position
+  /// right after the last batch that was read
+  /// @param callback Invoked for every batch
+  /// @return False if the journal is shorter than offset or malformed at that
+  /// position (e.g. it has been reset meanwhile), true otherwise
+  bool ReadBatches(std::uint64_t& offset, const BatchCallback& callback) const;
+
+ private:
+  /// @brief Path of the journal file
+  std::string journal_path_;
+};
+
+#endif  // __JOURNAL_H__
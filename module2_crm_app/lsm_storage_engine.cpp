@@ -0,0 +1,879 @@
+#include "lsm_storage_engine.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <set>
+#include <sstream>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Size in bytes after which the memtable is written into a segment
+constexpr std::size_t MEMTABLE_FLUSH_SIZE{1024U * 1024U};
+
+/// @brief Number of segments that triggers a compaction
+constexpr std::size_t COMPACTION_TRIGGER{4U};
+
+/// @brief A record out of every SPARSE_INDEX_INTERVAL is indexed
+constexpr std::size_t SPARSE_INDEX_INTERVAL{16U};
+
+/// @brief Bits of bloom filter per record, for about 1% false positives
+constexpr std::size_t BLOOM_BITS_PER_ID{10U};
+
+/// @brief Bits set per record in the bloom filter
+constexpr std::uint32_t BLOOM_HASH_COUNT{7U};
+
+/// @brief Name of the file listing the segments in use
+constexpr char MANIFEST_NAME[]{"MANIFEST"};
+
+/// @brief Marks the header line of the manifest
+constexpr char MANIFEST_HEADER_MARKER{'#'};
+
+/// @brief Prefix of a segment line holding a customer
+constexpr char PUT_MARKER{'P'};
+
+/// @brief Prefix of a segment line holding a removed customer
+constexpr char DELETE_MARKER{'D'};
+
+/// @brief Prefix of a manifest line listing a segment replaced by a
+/// compaction, not deleted yet
+constexpr char RETIRED_MARKER{'R'};
+
+/// @brief Last field of the meta file header when every record of the
+/// segment ends with its CRC32C
+constexpr char CHECKSUM_FORMAT[]{"crc32c"};
+
+/// @brief Splits a segment line into its parts
+/// @param line Segment line, without the newline
+/// @param id Where to store the customer ID
+/// @param removed Where to store whether it is a tombstone
+/// @return False if the line is malformed
+bool parse_segment_line(const std::string& line, Customer::ID& id,
+                        bool& removed) {
+  if (line.size() < 3U || (line[0] != PUT_MARKER && line[0] != DELETE_MARKER)) {
+    return false;
+  }
+
+  removed = line[0] == DELETE_MARKER;
+  return utilities::try_convert(
+      line.substr(2U, line.find(SERIALIZATION_DELIMITER, 2U) - 2U), id);
+}
+
+/// @brief Reads a customer out of a segment line holding one
+/// @param line Segment line
+/// @param customer Where to store the customer
+void parse_customer(const std::string& line, Customer& customer) {
+  std::stringstream ss{line.substr(2U)};
+  ss >> customer;
+}
+
+/// @brief Reads a segment file sequentially, one record at a time. Records
+/// whose checksum does not match are counted, and still returned, flagged as
+/// corrupted, if their ID can be read: they must hide the older versions of
+/// the customer all the same.
+class SegmentCursor {
+ public:
+  SegmentCursor(const std::string& path, const bool checksummed)
+      : file_stream_{path, std::ios::in},
+        checksummed_{checksummed},
+        line_{},
+        id_{},
+        removed_{},
+        corrupted_record_{},
+        corrupted_{},
+        unidentified_{} {}
+
+  /// @brief Whether the file could be opened
+  bool IsOpen() const { return file_stream_.is_open(); }
+
+  /// @brief Moves to the next record
+  /// @return False at the end of the segment
+  bool Next() {
+    while (std::getline(file_stream_, line_)) {
+      corrupted_record_ = checksummed_ && !utilities::strip_crc32c(line_);
+      if (corrupted_record_) {
+        corrupted_++;
+      }
+
+      if (parse_segment_line(line_, id_, removed_)) {
+        return true;
+      }
+
+      if (corrupted_record_) {
+        unidentified_++;
+      }
+    }
+    return false;
+  }
+
+  std::fstream file_stream_;
+  bool checksummed_;
+  std::string line_;
+  Customer::ID id_;
+  bool removed_;
+  /// @brief Whether the current record failed its checksum
+  bool corrupted_record_;
+  /// @brief Records that failed their checksum so far
+  std::size_t corrupted_;
+  /// @brief Corrupted records whose ID could not be read either
+  std::size_t unidentified_;
+};
+
+/// @brief Merges segments into a single sequence sorted by ID, holding only
+/// the newest version of every customer
+class SegmentMerger {
+ public:
+  /// @param cursors Cursors of the segments, newest first
+  explicit SegmentMerger(std::vector<SegmentCursor>& cursors)
+      : cursors_{cursors}, has_record_(cursors.size()), newest_{} {
+    for (std::size_t i = 0U; i < cursors_.size(); i++) {
+      has_record_[i] = cursors_[i].Next();
+    }
+    newest_ = cursors_.size();
+  }
+
+  /// @brief Moves to the next customer
+  /// @return False once every segment is exhausted
+  bool Next() {
+    // The versions of the current customer are only skipped now, so that
+    // the newest one could be read meanwhile
+    if (newest_ < cursors_.size()) {
+      const Customer::ID id = cursors_[newest_].id_;
+      for (std::size_t i = 0U; i < cursors_.size(); i++) {
+        if (has_record_[i] && cursors_[i].id_ == id) {
+          has_record_[i] = cursors_[i].Next();
+        }
+      }
+    }
+
+    // The first cursor holding the lowest ID has its latest version
+    newest_ = cursors_.size();
+    for (std::size_t i = 0U; i < cursors_.size(); i++) {
+      if (has_record_[i] && (newest_ == cursors_.size() ||
+                             cursors_[i].id_ < cursors_[newest_].id_)) {
+        newest_ = i;
+      }
+    }
+    return newest_ < cursors_.size();
+  }
+
+  /// @brief Cursor positioned on the newest version of the current customer
+  const SegmentCursor& GetNewest() const { return cursors_[newest_]; }
+
+ private:
+  std::vector<SegmentCursor>& cursors_;
+  std::vector<bool> has_record_;
+  std::size_t newest_;
+};
+
+/// @brief Mixes the bits of an ID, so that close IDs hash far apart
+std::uint64_t mix(std::uint64_t value) {
+  // splitmix64 finalizer
+  value += 0x9E3779B97F4A7C15ULL;
+  value = (value ^ (value >> 30)) * 0xBF58476D1CE4E5B9ULL;
+  value = (value ^ (value >> 27)) * 0x94D049BB133111EBULL;
+  return value ^ (value >> 31);
+}
+
+}  // namespace
+
+BloomFilter::BloomFilter(const std::size_t expected_ids)
+    : hash_count_{BLOOM_HASH_COUNT},
+      bits_((std::max<std::size_t>(expected_ids, 1U) * BLOOM_BITS_PER_ID +
+             63U) /
+                64U,
+            0U) {}
+
+template <typename Callback>
+void BloomFilter::ForEachBit(const Customer::ID id, Callback callback) const {
+  // Double hashing: the n-th bit is h1 + n * h2
+  const std::uint64_t hash = mix(id);
+  const std::uint64_t first = hash & 0xFFFFFFFFU;
+  const std::uint64_t second = (hash >> 32) | 1U;
+  const std::uint64_t bit_count = bits_.size() * 64U;
+
+  for (std::uint32_t i = 0U; i < hash_count_; i++) {
+    callback((first + i * second) % bit_count);
+  }
+}
+
+void BloomFilter::Add(const Customer::ID id) {
+  ForEachBit(id, [this](const std::uint64_t bit) {
+    bits_[bit / 64U] |= 1ULL << (bit % 64U);
+  });
+}
+
+bool BloomFilter::MayContain(const Customer::ID id) const {
+  if (bits_.empty()) {
+    return true;
+  }
+
+  bool contained = true;
+  ForEachBit(id, [this, &contained](const std::uint64_t bit) {
+    contained = contained && (bits_[bit / 64U] & (1ULL << (bit % 64U))) != 0U;
+  });
+  return contained;
+}
+
+std::ostream& operator<<(std::ostream& os, const BloomFilter& filter) {
+  os << filter.hash_count_ << SERIALIZATION_DELIMITER << filter.bits_.size();
+  os << std::hex;
+  for (const auto word : filter.bits_) {
+    os << SERIALIZATION_DELIMITER << word;
+  }
+  os << std::dec;
+  return os;
+}
+
+std::istream& operator>>(std::istream& is, BloomFilter& filter) {
+  std::size_t word_count{};
+  is >> filter.hash_count_ >> word_count >> std::hex;
+  filter.bits_.assign(word_count, 0U);
+  for (auto& word : filter.bits_) {
+    is >> word;
+  }
+  is >> std::dec;
+  return is;
+}
+
+LsmStorageEngine::LsmStorageEngine(const std::string& database_path,
+                                   const bool read_only)
+    : directory_path_{database_path + LSM_DIRECTORY_SUFFIX},
+      read_only_{read_only},
+      memtable_{},
+      memtable_size_{},
+      mutex_{},
+      segments_{},
+      retired_segments_{},
+      durable_sequence_{},
+      last_customer_id_{},
+      next_segment_number_{1U},
+      compaction_requested_{},
+      stopping_{false},
+      compaction_thread_{} {
+  if (!read_only_) {
+    compaction_thread_ = std::thread{&LsmStorageEngine::RunCompaction, this};
+  }
+}
+
+LsmStorageEngine::~LsmStorageEngine() {
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    stopping_ = true;
+  }
+  compaction_requested_.notify_all();
+
+  if (compaction_thread_.joinable()) {
+    compaction_thread_.join();
+  }
+}
+
+bool LsmStorageEngine::Load(Customers& customers, std::uint64_t& sequence,
+                            Customer::ID& last_customer_id) {
+  const TraceSpan trace_span{"storage", "LsmStorageEngine::Load"};
+  std::uint64_t durable_sequence{};
+  Customer::ID highest_customer_id{};
+  std::uint64_t next_segment_number{};
+  SegmentList segments{};
+  RetiredSegmentList retired_segments{};
+  if (!ReadManifest(durable_sequence, highest_customer_id, next_segment_number,
+                    segments, &retired_segments)) {
+    return false;
+  }
+
+  std::vector<SegmentCursor> cursors{};
+  cursors.reserve(segments.size());
+  for (const auto& segment : segments) {
+    cursors.emplace_back(GetSegmentPath(segment->number_),
+                         segment->checksummed_);
+    if (!cursors.back().IsOpen()) {
+      // Dropped after a compaction meanwhile
+      return false;
+    }
+  }
+
+  // Only the newest version of every customer is parsed, in ID order
+  SegmentMerger merger{cursors};
+  while (merger.Next()) {
+    const SegmentCursor& newest = merger.GetNewest();
+    if (newest.corrupted_record_) {
+      // Left out rather than brought back to an older version
+      std::cerr << "Customer " << newest.id_ << " is corrupted" << std::endl;
+      continue;
+    }
+    if (newest.removed_) {
+      continue;
+    }
+
+    Customer customer{};
+    parse_customer(newest.line_, customer);
+    customers.emplace_hint(customers.cend(), newest.id_, std::move(customer));
+  }
+
+  bool identified = true;
+  for (std::size_t i = 0U; i < segments.size(); i++) {
+    if (cursors[i].corrupted_ > 0U) {
+      std::cerr << "Found " << cursors[i].corrupted_
+                << " corrupted entries in segment " << segments[i]->number_
+                << std::endl;
+    }
+    identified = identified && cursors[i].unidentified_ == 0U;
+  }
+
+  // Some customer could silently be back to an older version
+  if (!identified) {
+    std::cerr << "Corrupted entries of unknown customers, not loading"
+              << std::endl;
+    customers.clear();
+    return false;
+  }
+
+  std::set<std::string> in_use{MANIFEST_NAME};
+  for (const auto& segment : segments) {
+    in_use.insert(std::to_string(segment->number_) + ".sst");
+    in_use.insert(std::to_string(segment->number_) + ".meta");
+  }
+  for (const auto& retired : retired_segments) {
+    in_use.insert(std::to_string(retired.first) + ".sst");
+    in_use.insert(std::to_string(retired.first) + ".meta");
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    segments_ = std::move(segments);
+    retired_segments_ = std::move(retired_segments);
+    durable_sequence_ = durable_sequence;
+    last_customer_id_ = highest_customer_id;
+    next_segment_number_ = std::max<std::uint64_t>(next_segment_number, 1U);
+  }
+
+  if (!read_only_) {
+    // Remove what an interrupted flush or compaction left behind
+
+    std::vector<std::string> file_names{};
+    utilities::list_directory(directory_path_, file_names);
+    for (const auto& file_name : file_names) {
+      if (in_use.count(file_name) == 0U) {
+        std::remove(GetPath(file_name).c_str());
+      }
+    }
+
+    compaction_requested_.notify_one();
+  }
+
+  sequence = durable_sequence;
+  last_customer_id = highest_customer_id;
+  return true;
+}
+
+void LsmStorageEngine::Stage(const std::vector<Change>& changes,
+                             const Customers& customers) {
+  if (read_only_) {
+    return;
+  }
+
+  std::set<Customer::ID> changed{};
+  for (const auto& change : changes) {
+    if (change.type_ == Change::EType::ARCHIVE_INTERACTIONS) {
+      // Touches the interactions of every customer
+      for (const auto& customer : customers) {
+        changed.insert(customer.first);
+      }
+    } else {
+      changed.insert(change.id_);
+    }
+  }
+
+  for (const auto id : changed) {
+    Record record{true, {}};
+
+    const auto customer = customers.find(id);
+    if (customer != customers.cend()) {
+      std::ostringstream line{};
+      line << customer->second;
+      record.removed_ = false;
+      record.line_ = line.str();
+    }
+
+    auto entry = memtable_.find(id);
+    if (entry == memtable_.end()) {
+      memtable_size_ += sizeof(Record);
+      entry = memtable_.emplace(id, Record{true, {}}).first;
+    }
+
+    memtable_size_ -= entry->second.line_.size();
+    memtable_size_ += record.line_.size();
+    entry->second = std::move(record);
+  }
+}
+
+bool LsmStorageEngine::Checkpoint(const std::uint64_t sequence,
+                                  const Customer::ID last_customer_id,
+                                  const Customers&, const bool force) {
+  const TraceSpan trace_span{"storage", "LsmStorageEngine::Checkpoint"};
+  if (read_only_) {
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    last_customer_id_ = last_customer_id;
+  }
+
+  if (!force && memtable_size_ < MEMTABLE_FLUSH_SIZE) {
+    // Still in the journal
+    return true;
+  }
+
+  if (!memtable_.empty()) {
+    return FlushMemtable(sequence);
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  durable_sequence_ = sequence;
+  return WriteManifest();
+}
+
+std::uint64_t LsmStorageEngine::GetDurableSequence() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return durable_sequence_;
+}
+
+bool LsmStorageEngine::Verify(Verification& verification) const {
+  std::uint64_t durable_sequence{};
+  Customer::ID highest_customer_id{};
+  std::uint64_t next_segment_number{};
+  SegmentList segments{};
+  if (!ReadManifest(durable_sequence, highest_customer_id, next_segment_number,
+                    segments)) {
+    return false;
+  }
+
+  for (const auto& segment : segments) {
+    const std::string path{GetSegmentPath(segment->number_)};
+    std::fstream file_stream{path, std::ios::in};
+    if (!file_stream.good()) {
+      return false;
+    }
+
+    std::string line{};
+    std::size_t line_number{};
+    while (std::getline(file_stream, line)) {
+      line_number++;
+      if (!segment->checksummed_) {
+        verification.unchecked_++;
+      } else if (utilities::strip_crc32c(line)) {
+        verification.verified_++;
+      } else {
+        verification.corrupted_.push_back(path + ":" +
+                                          std::to_string(line_number));
+      }
+    }
+  }
+  return true;
+}
+
+bool LsmStorageEngine::Open() {
+  std::uint64_t durable_sequence{};
+  Customer::ID highest_customer_id{};
+  std::uint64_t next_segment_number{};
+  SegmentList segments{};
+  if (!ReadManifest(durable_sequence, highest_customer_id, next_segment_number,
+                    segments)) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock{mutex_};
+  segments_ = std::move(segments);
+  durable_sequence_ = durable_sequence;
+  last_customer_id_ = highest_customer_id;
+  next_segment_number_ = std::max<std::uint64_t>(next_segment_number, 1U);
+  return true;
+}
+
+bool LsmStorageEngine::Get(const Customer::ID id, Customer& customer) const {
+  const auto staged = memtable_.find(id);
+  if (staged != memtable_.cend()) {
+    if (staged->second.removed_) {
+      return false;
+    }
+
+    std::stringstream ss{staged->second.line_};
+    ss >> customer;
+    return true;
+  }
+
+  SegmentList segments{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    segments = segments_;
+  }
+
+  // The newest version wins
+  for (const auto& segment : segments) {
+    if (!segment->filter_.MayContain(id)) {
+      continue;
+    }
+
+    // Last indexed record not past the ID
+    const auto indexed = std::upper_bound(
+        segment->sparse_index_.cbegin(), segment->sparse_index_.cend(), id,
+        [](const Customer::ID lhs,
+           const std::pair<Customer::ID, std::uint64_t>& rhs) {
+          return lhs < rhs.first;
+        });
+    if (indexed == segment->sparse_index_.cbegin()) {
+      continue;
+    }
+
+    SegmentCursor cursor{GetSegmentPath(segment->number_),
+                         segment->checksummed_};
+    cursor.file_stream_.seekg(
+        static_cast<std::streamoff>(std::prev(indexed)->second));
+
+    while (cursor.Next() && cursor.id_ <= id) {
+      if (cursor.id_ == id) {
+        if (cursor.removed_ || cursor.corrupted_record_) {
+          return false;
+        }
+
+        parse_customer(cursor.line_, customer);
+        return true;
+      }
+    }
+  }
+
+  return false;
+}
+
+std::size_t LsmStorageEngine::GetSegmentCount() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return segments_.size();
+}
+
+std::string LsmStorageEngine::GetPath(const std::string& name) const {
+  return directory_path_ + "/" + name;
+}
+
+std::string LsmStorageEngine::GetSegmentPath(const std::uint64_t number) const {
+  return GetPath(std::to_string(number) + ".sst");
+}
+
+std::string LsmStorageEngine::GetSegmentMetaPath(
+    const std::uint64_t number) const {
+  return GetPath(std::to_string(number) + ".meta");
+}
+
+bool LsmStorageEngine::ReadManifest(
+    std::uint64_t& durable_sequence, Customer::ID& last_customer_id,
+    std::uint64_t& next_segment_number, SegmentList& segments,
+    RetiredSegmentList* retired_segments) const {
+  std::fstream file_stream{GetPath(MANIFEST_NAME), std::ios::in};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string line{};
+  if (!std::getline(file_stream, line) || line.empty() ||
+      line[0] != MANIFEST_HEADER_MARKER) {
+    return false;
+  }
+
+  std::stringstream header{line.substr(1)};
+  header >> durable_sequence >> last_customer_id >> next_segment_number;
+
+  while (std::getline(file_stream, line)) {
+    std::uint64_t number{};
+    if (!line.empty() && line[0] == RETIRED_MARKER) {
+      if (retired_segments != nullptr &&
+          utilities::try_convert(line.substr(1U), number)) {
+        retired_segments->emplace_back(
+            number, std::weak_ptr<const Segment>{});
+      }
+      continue;
+    }
+    if (!utilities::try_convert(line, number)) {
+      continue;
+    }
+
+    auto segment = OpenSegment(number);
+    if (!segment) {
+      return false;
+    }
+    segments.push_back(std::move(segment));
+  }
+  return true;
+}
+
+std::shared_ptr<const LsmStorageEngine::Segment> LsmStorageEngine::OpenSegment(
+    const std::uint64_t number) const {
+  std::fstream file_stream{GetSegmentMetaPath(number), std::ios::in};
+  if (!file_stream.good()) {
+    return nullptr;
+  }
+
+  auto segment = std::make_shared<Segment>();
+  segment->number_ = number;
+
+  std::string line{};
+  if (!std::getline(file_stream, line)) {
+    return nullptr;
+  }
+
+  std::stringstream header{line};
+  header >> segment->record_count_ >> segment->filter_;
+  if (header.fail()) {
+    return nullptr;
+  }
+
+  // Missing from segments written before records had checksums
+  std::string format{};
+  header >> format;
+  segment->checksummed_ = format == CHECKSUM_FORMAT;
+
+  while (std::getline(file_stream, line)) {
+    std::stringstream entry{line};
+    std::pair<Customer::ID, std::uint64_t> indexed{};
+    if (entry >> indexed.first >> indexed.second) {
+      segment->sparse_index_.push_back(indexed);
+    }
+  }
+
+  return segment;
+}
+
+bool LsmStorageEngine::WriteSegment(
+    const std::uint64_t number, const std::size_t expected_records,
+    const std::function<bool(Customer::ID&, Record&)>& next_record,
+    std::shared_ptr<const Segment>& written_segment) const {
+  auto segment = std::make_shared<Segment>();
+  segment->number_ = number;
+  segment->record_count_ = 0U;
+  segment->filter_ = BloomFilter{expected_records};
+  segment->checksummed_ = true;
+
+  std::ostringstream data{};
+  std::string line{};
+  Customer::ID id{};
+  Record record{};
+  while (next_record(id, record)) {
+    if (segment->record_count_ % SPARSE_INDEX_INTERVAL == 0U) {
+      segment->sparse_index_.emplace_back(
+          id, static_cast<std::uint64_t>(data.tellp()));
+    }
+
+    if (record.removed_) {
+      line = std::string{DELETE_MARKER} + SERIALIZATION_DELIMITER +
+             std::to_string(id);
+    } else {
+      // Serialized customers end with a newline
+      line = std::string{PUT_MARKER} + SERIALIZATION_DELIMITER;
+      line.append(record.line_, 0U, record.line_.size() - 1U);
+    }
+    utilities::append_crc32c(line);
+    data << line << '\n';
+
+    segment->filter_.Add(id);
+    segment->record_count_++;
+  }
+
+  std::ostringstream meta{};
+  meta << segment->record_count_ << SERIALIZATION_DELIMITER << segment->filter_
+       << SERIALIZATION_DELIMITER << CHECKSUM_FORMAT << '\n';
+  for (const auto& indexed : segment->sparse_index_) {
+    meta << indexed.first << SERIALIZATION_DELIMITER << indexed.second << '\n';
+  }
+
+  if (!utilities::create_directory(directory_path_) ||
+      !utilities::write_file(GetSegmentPath(number), data.str()) ||
+      !utilities::write_file(GetSegmentMetaPath(number), meta.str())) {
+    return false;
+  }
+
+  written_segment = std::move(segment);
+  return true;
+}
+
+bool LsmStorageEngine::FlushMemtable(const std::uint64_t sequence) {
+  const TraceSpan trace_span{"storage", "LsmStorageEngine::FlushMemtable"};
+  std::uint64_t number{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    number = next_segment_number_++;
+  }
+
+  auto staged = memtable_.cbegin();
+  std::shared_ptr<const Segment> segment{};
+  if (!WriteSegment(number, memtable_.size(),
+                    [this, &staged](Customer::ID& id, Record& record) {
+                      if (staged == memtable_.cend()) {
+                        return false;
+                      }
+                      id = staged->first;
+                      record = staged->second;
+                      ++staged;
+                      return true;
+                    },
+                    segment)) {
+    return false;
+  }
+
+  bool compaction_needed = false;
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    segments_.insert(segments_.begin(), segment);
+    const std::uint64_t previous_sequence = durable_sequence_;
+    durable_sequence_ = sequence;
+
+    if (!WriteManifest()) {
+      segments_.erase(segments_.begin());
+      durable_sequence_ = previous_sequence;
+      return false;
+    }
+
+    compaction_needed = segments_.size() >= COMPACTION_TRIGGER;
+  }
+
+  memtable_.clear();
+  memtable_size_ = 0U;
+
+  if (compaction_needed) {
+    compaction_requested_.notify_one();
+  }
+  return true;
+}
+
+bool LsmStorageEngine::WriteManifest() const {
+  std::ostringstream manifest{};
+  manifest << MANIFEST_HEADER_MARKER << durable_sequence_
+           << SERIALIZATION_DELIMITER << last_customer_id_
+           << SERIALIZATION_DELIMITER << next_segment_number_ << '\n';
+  for (const auto& segment : segments_) {
+    manifest << segment->number_ << '\n';
+  }
+  for (const auto& retired : retired_segments_) {
+    manifest << RETIRED_MARKER << retired.first << '\n';
+  }
+
+  return utilities::create_directory(directory_path_) &&
+         utilities::write_file(GetPath(MANIFEST_NAME), manifest.str());
+}
+
+void LsmStorageEngine::RunCompaction() {
+  bool compaction_failed = false;
+
+  while (true) {
+    {
+      std::unique_lock<std::mutex> lock{mutex_};
+      compaction_requested_.wait(lock, [this, compaction_failed]() {
+        return stopping_ ||
+               (!compaction_failed && segments_.size() >= COMPACTION_TRIGGER);
+      });
+
+      if (stopping_) {
+        return;
+      }
+    }
+
+    // Retried on the next request only
+    compaction_failed = !Compact();
+  }
+}
+
+bool LsmStorageEngine::Compact() {
+  const TraceSpan trace_span{"storage", "LsmStorageEngine::Compact"};
+  SegmentList inputs{};
+  std::uint64_t number{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    inputs = segments_;
+    number = next_segment_number_++;
+  }
+
+  std::vector<SegmentCursor> cursors{};
+  std::size_t expected_records{};
+  cursors.reserve(inputs.size());
+  for (const auto& input : inputs) {
+    cursors.emplace_back(GetSegmentPath(input->number_), input->checksummed_);
+    if (!cursors.back().IsOpen()) {
+      return false;
+    }
+    expected_records += input->record_count_;
+  }
+
+  // Every segment is merged, so tombstones have nothing left to hide and are
+  // dropped
+  SegmentMerger merger{cursors};
+  const auto next_record = [&merger](Customer::ID& id, Record& record) {
+    while (merger.Next()) {
+      const SegmentCursor& newest = merger.GetNewest();
+      // Corrupted records make the compaction fail below anyway
+      if (!newest.removed_ && !newest.corrupted_record_) {
+        id = newest.id_;
+        record.removed_ = false;
+        record.line_ = newest.line_.substr(2U) + '\n';
+        return true;
+      }
+    }
+    return false;
+  };
+
+  std::shared_ptr<const Segment> merged{};
+  if (!WriteSegment(number, expected_records, next_record, merged)) {
+    return false;
+  }
+
+  // Dropping a corrupted record would bring back an older version of the
+  // customer: keep the inputs as they are
+  for (const auto& cursor : cursors) {
+    if (cursor.corrupted_ > 0U) {
+      std::remove(GetSegmentPath(number).c_str());
+      std::remove(GetSegmentMetaPath(number).c_str());
+      return false;
+    }
+  }
+
+  RetiredSegmentList dropped{};
+  {
+    std::lock_guard<std::mutex> lock{mutex_};
+    const SegmentList previous_segments{segments_};
+    const RetiredSegmentList previous_retired{retired_segments_};
+
+    // Segments flushed while merging stay on top of the merged one
+    segments_.resize(segments_.size() - inputs.size());
+    segments_.push_back(merged);
+
+    // The inputs stay on disk until the next compaction, so that readers
+    // that listed them before this one, here or in another process, can
+    // still open them. Those retired by the previous one go, unless a
+    // reader here still holds them.
+    RetiredSegmentList retired{};
+    for (const auto& previous : retired_segments_) {
+      (previous.second.expired() ? dropped : retired).push_back(previous);
+    }
+    for (const auto& input : inputs) {
+      retired.emplace_back(input->number_, input);
+    }
+    retired_segments_ = std::move(retired);
+
+    if (!WriteManifest()) {
+      segments_ = previous_segments;
+      retired_segments_ = previous_retired;
+      std::remove(GetSegmentPath(number).c_str());
+      std::remove(GetSegmentMetaPath(number).c_str());
+      return false;
+    }
+  }
+
+  for (const auto& retired : dropped) {
+    std::remove(GetSegmentPath(retired.first).c_str());
+    std::remove(GetSegmentMetaPath(retired.first).c_str());
+  }
+  return true;
+}
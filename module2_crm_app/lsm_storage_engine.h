@@ -0,0 +1,261 @@
+#ifndef __LSM_STORAGE_ENGINE_H__
+#define __LSM_STORAGE_ENGINE_H__
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "storage_engine.h"
+
+/// @brief Suffix appended to the path of the database for the directory of
+/// the segments
+#define LSM_DIRECTORY_SUFFIX ".lsm"
+
+/// @brief Probabilistic set of customer IDs: a negative answer is always
+/// right, a positive one may be wrong with a small probability (about 1% with
+/// the default sizing)
+class BloomFilter {
+ public:
+  BloomFilter() : hash_count_{}, bits_{} {}
+
+  /// @brief Creates an empty filter
+  /// @param expected_ids Number of IDs the filter is sized for
+  explicit BloomFilter(const std::size_t expected_ids);
+
+  /// @brief Adds an ID to the set
+  /// @param id Customer ID
+  void Add(const Customer::ID id);
+
+  /// @brief Checks if an ID may be part of the set
+  /// @param id Customer ID
+  /// @return False if the ID is surely not part of the set
+  bool MayContain(const Customer::ID id) const;
+
+  /// @brief Serializes the filter into a single line, without terminating it
+  friend std::ostream& operator<<(std::ostream& os, const BloomFilter& filter);
+
+  /// @brief Deserializes a filter written by operator<<
+  friend std::istream& operator>>(std::istream& is, BloomFilter& filter);
+
+ private:
+  /// @brief Calls the callback with the position of every bit of an ID
+  template <typename Callback>
+  void ForEachBit(const Customer::ID id, Callback callback) const;
+
+  /// @brief Number of bits set for every ID
+  std::uint32_t hash_count_;
+
+  /// @brief Bit array
+  std::vector<std::uint64_t> bits_;
+};
+
+/// @brief Log-structured merge-tree storage engine. Only the customers
+/// touched by a batch are written, which keeps the cost of a commit
+/// independent of the size of the database:
+///
+/// - changed customers are collected in memory (memtable); the journal of
+///   the Database makes them durable meanwhile
+/// - once the memtable is large enough, it is written as an immutable
+///   segment file sorted by customer ID, holding the whole record of every
+///   customer in it, or a tombstone for removed ones
+/// - every segment comes with a bloom filter and a sparse index, so a point
+///   lookup only reads the segments that may hold the customer, from the
+///   right position
+/// - when segments pile up, a background thread merges them into a single
+///   one, dropping overwritten records and tombstones. The merged segments
+///   are only deleted by the next compaction, once no reader in the process
+///   holds them, so that readers in other processes can finish with them.
+/// - every record ends with its CRC32C: a customer whose newest record is
+///   corrupted is left out when loading, instead of falling back to an older
+///   version, and segments holding corrupted records are not compacted.
+///   Loading fails if the ID of a corrupted record cannot be read.
+///
+/// All files live in the <database>.lsm directory. The MANIFEST file lists
+/// the segments in use, newest first, and is atomically replaced on every
+/// change.
+class LsmStorageEngine : public StorageEngine {
+ public:
+  // No default, move and copy constructors/operators
+  LsmStorageEngine() = delete;
+  LsmStorageEngine(const LsmStorageEngine&) = delete;
+  LsmStorageEngine& operator=(const LsmStorageEngine&) = delete;
+  LsmStorageEngine(LsmStorageEngine&&) = delete;
+  LsmStorageEngine& operator=(LsmStorageEngine&&) = delete;
+
+  /// @brief Binds the engine to its directory and, unless read-only, starts
+  /// the compaction thread
+  /// @param database_path Path of the database, files are stored in
+  /// <database_path>.lsm
+  /// @param read_only When true, nothing is ever written
+  explicit LsmStorageEngine(const std::string& database_path,
+                            const bool read_only);
+
+  /// @brief Waits for a running compaction, then stops the compaction thread.
+  /// The memtable is not written: call Checkpoint() with force beforehand.
+  ~LsmStorageEngine() override;
+
+  bool Load(Customers& customers, std::uint64_t& sequence,
+            Customer::ID& last_customer_id) override;
+
+  void Stage(const std::vector<Change>& changes,
+             const Customers& customers) override;
+
+  bool Checkpoint(const std::uint64_t sequence,
+                  const Customer::ID last_customer_id,
+                  const Customers& customers, const bool force) override;
+
+  std::uint64_t GetDurableSequence() const override;
+
+  bool Verify(Verification& verification) const override;
+
+  /// @brief Reads the MANIFEST only, so that Get() can look customers up
+  /// without Load()
+  /// @return False if nothing has been persisted yet or it cannot be read
+  bool Open();
+
+  /// @brief Reads a single customer, without loading the whole database.
+  /// Requires Load() or Open().
+  /// @param id Customer ID
+  /// @param customer Where to store the customer
+  /// @return False if the customer does not exist
+  bool Get(const Customer::ID id, Customer& customer) const;
+
+  /// @brief Number of segments in use
+  /// @return Segment count
+  std::size_t GetSegmentCount() const;
+
+ private:
+  /// @brief Latest version of a customer
+  struct Record {
+    /// @brief Whether the customer was removed
+    bool removed_;
+    /// @brief Serialized customer, empty if removed
+    std::string line_;
+  };
+
+  /// @brief An immutable segment file, with its lookup structures
+  struct Segment {
+    /// @brief Number of the segment, increasing with every new one
+    std::uint64_t number_;
+    /// @brief Number of records
+    std::size_t record_count_;
+    /// @brief IDs of all records
+    BloomFilter filter_;
+    /// @brief Byte offset of every n-th record, by ID
+    std::vector<std::pair<Customer::ID, std::uint64_t>> sparse_index_;
+    /// @brief Whether every record ends with its CRC32C
+    bool checksummed_;
+  };
+
+  using SegmentList = std::vector<std::shared_ptr<const Segment>>;
+
+  /// @brief Numbers of the segments replaced by a compaction, with the
+  /// segment while readers in the process may still use it
+  using RetiredSegmentList =
+      std::vector<std::pair<std::uint64_t, std::weak_ptr<const Segment>>>;
+
+  /// @brief Path of a file of the engine
+  /// @param name File name
+  std::string GetPath(const std::string& name) const;
+
+  /// @brief Path of the data file of a segment
+  std::string GetSegmentPath(const std::uint64_t number) const;
+
+  /// @brief Path of the filter and index file of a segment
+  std::string GetSegmentMetaPath(const std::uint64_t number) const;
+
+  /// @brief Reads the MANIFEST and the meta file of every segment listed
+  /// @param durable_sequence Where to store the durable sequence number
+  /// @param last_customer_id Where to store the highest customer ID
+  /// @param next_segment_number Where to store the number of the next segment
+  /// @param segments Where to store the segments, newest first
+  /// @param retired_segments Where to store the retired segments, if needed
+  /// @return False if the MANIFEST or a meta file cannot be read
+  bool ReadManifest(std::uint64_t& durable_sequence,
+                    Customer::ID& last_customer_id,
+                    std::uint64_t& next_segment_number,
+                    SegmentList& segments,
+                    RetiredSegmentList* retired_segments = nullptr) const;
+
+  /// @brief Reads the filter and the sparse index of a segment
+  /// @param number Segment number
+  /// @return The segment, nullptr if it cannot be read
+  std::shared_ptr<const Segment> OpenSegment(const std::uint64_t number) const;
+
+  /// @brief Writes a new segment
+  /// @param number Segment number
+  /// @param expected_records Number of records the bloom filter is sized for
+  /// @param next_record Provides the records in ascending ID order, returns
+  /// false once there are no more
+  /// @param written_segment Where to store the segment
+  /// @return False if the segment could not be written
+  bool WriteSegment(
+      const std::uint64_t number, const std::size_t expected_records,
+      const std::function<bool(Customer::ID&, Record&)>& next_record,
+      std::shared_ptr<const Segment>& written_segment) const;
+
+  /// @brief Writes the memtable into a new segment and clears it
+  /// @param sequence Sequence number of the last batch in the memtable
+  /// @return False if writing failed, the memtable is kept in that case
+  bool FlushMemtable(const std::uint64_t sequence);
+
+  /// @brief Replaces the MANIFEST with the current state. mutex_ must be held.
+  /// @return False if writing failed
+  bool WriteManifest() const;
+
+  /// @brief Body of the compaction thread
+  void RunCompaction();
+
+  /// @brief Merges all segments in use into a single one
+  /// @return False if the merged segment could not be written
+  bool Compact();
+
+  /// @brief Directory holding all files
+  std::string directory_path_;
+
+  /// @brief Whether nothing is ever written
+  bool read_only_;
+
+  /// @brief Customers changed since the last flush, by ID
+  std::map<Customer::ID, Record> memtable_;
+
+  /// @brief Bytes held by the memtable
+  std::size_t memtable_size_;
+
+  /// @brief Protects all members below, shared with the compaction thread
+  mutable std::mutex mutex_;
+
+  /// @brief Segments in use, newest first
+  SegmentList segments_;
+
+  /// @brief Segments replaced by the last compactions, still on disk
+  RetiredSegmentList retired_segments_;
+
+  /// @brief Sequence number recorded in the MANIFEST
+  std::uint64_t durable_sequence_;
+
+  /// @brief Highest customer ID ever assigned, recorded in the MANIFEST
+  Customer::ID last_customer_id_;
+
+  /// @brief Number of the next segment created
+  std::uint64_t next_segment_number_;
+
+  /// @brief Signals the compaction thread
+  std::condition_variable compaction_requested_;
+
+  /// @brief Whether the compaction thread shall stop
+  bool stopping_;
+
+  /// @brief Merges segments in the background
+  std::thread compaction_thread_;
+};
+
+#endif  // __LSM_STORAGE_ENGINE_H__
@@ -1,6 +1,83 @@
-#include "app.h"
-
-int main() {
-  App app{};
-  return app.Run();
-}
+#include "app.h"
+#include "backup_command.h"
+#include "benchmark.h"
+#include "config.h"
+#include "export_command.h"
+#include "query_command.h"
+#include "score_importer.h"
+#include "session.h"
+#include "stats_command.h"
+#include "tracer.h"
+#include "verifier.h"
+
+namespace {
+
+/// @brief Runs the command selected on the command line, or the App
+/// @param config Runtime options
+/// @return Exit status code
+std::int32_t run(const Config& config) {
+  if (config.command_ == "replay") {
+    SessionReplayer replayer{config};
+    return replayer.Run();
+  }
+
+  if (config.command_ == "benchmark") {
+    LoadBenchmark benchmark{config};
+    return benchmark.Run();
+  }
+
+  if (config.command_ == "verify") {
+    Verifier verifier{config};
+    return verifier.Run();
+  }
+
+  if (config.command_ == "import-scores") {
+    ScoreImporter importer{config};
+    return importer.Run();
+  }
+
+  if (config.command_ == "export") {
+    ExportCommand export_command{config};
+    return export_command.Run();
+  }
+
+  if (config.command_ == "backup" || config.command_ == "restore") {
+    BackupCommand backup_command{config};
+    return backup_command.Run();
+  }
+
+  if (config.command_ == "stats") {
+    StatsCommand stats_command{config};
+    return stats_command.Run();
+  }
+
+  if (config.command_ == "find" || config.command_ == "interactions" ||
+      config.command_ == "count") {
+    QueryCommand query_command{config};
+    return query_command.Run();
+  }
+
+  App app{config};
+  return app.Run();
+}
+
+}  // namespace
+
+int main(int argc, char* argv[]) {
+  Config config{};
+  if (!Config::FromCommandLine(argc, argv, config)) {
+    Config::PrintUsage(argv[0]);
+    return EXIT_FAILURE;
+  }
+
+  if (!config.trace_path_.empty()) {
+    Tracer::SetOutputPath(config.trace_path_);
+    Tracer::SetEnabled(true);
+  }
+  Tracer::InstallToggleSignal();
+
+  // Everything has been torn down, and saved, by the time the trace closes
+  const std::int32_t status = run(config);
+  Tracer::Close();
+  return status;
+}
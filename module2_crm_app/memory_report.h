@@ -0,0 +1,181 @@
+#ifndef __MEMORY_REPORT_H__
+#define __MEMORY_REPORT_H__
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Parts of the Database memory is accounted to
+enum class EMemoryCategory : std::uint32_t {
+  /// Nodes of the customer map and the vectors of interaction pointers
+  CUSTOMERS = 1,
+  /// Interactions with their reference counts, and the buffers of their
+  /// dates and descriptions
+  INTERACTIONS,
+  /// Names and surnames in the StringPool, shared by all databases of the
+  /// process
+  STRINGS,
+  /// Name and surname indexes, and the views sorted by name and by activity
+  INDEXES,
+  /// Data derived from the customers to answer queries faster: activity
+  /// summaries, interaction and name columns, scores, upcoming appointments
+  CACHES,
+  /// Memory the Arena holds without handing it out: freed blocks waiting to
+  /// be reused and the unused end of the current chunk
+  ALLOCATOR,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Number of valid memory categories
+#define MEMORY_CATEGORY_COUNT 6U
+
+/// @brief Size of a block as handed out: the Arena and the system allocator
+/// both round requests up to 16 bytes
+/// @param size Requested size in bytes
+/// @return Bytes
+inline std::uint64_t allocated_size(const std::size_t size) {
+  return (static_cast<std::uint64_t>(size) + 15U) & ~std::uint64_t{15U};
+}
+
+/// @brief Size of a node of a std::map or std::set: the value follows the
+/// color and the three links of the tree
+/// @tparam Value Type of the values of the container
+/// @return Bytes
+template <typename Value>
+std::uint64_t tree_node_size() {
+  return allocated_size(4U * sizeof(void*) + sizeof(Value));
+}
+
+/// @brief Size of the buffer a string allocated for its characters, 0 if
+/// they fit in the string itself
+/// @tparam String Type of the string
+/// @param str String
+/// @return Bytes
+template <typename String>
+std::uint64_t string_buffer_size(const String& str) {
+  static const std::size_t local_capacity{String{}.capacity()};
+  return str.capacity() > local_capacity ? allocated_size(str.capacity() + 1U)
+                                         : 0U;
+}
+
+/// @brief Size of the buffer of a vector, 0 if it has none
+/// @tparam Vector Type of the vector
+/// @param vector Vector
+/// @return Bytes
+template <typename Vector>
+std::uint64_t vector_buffer_size(const Vector& vector) {
+  return vector.capacity() > 0U
+             ? allocated_size(vector.capacity() *
+                              sizeof(typename Vector::value_type))
+             : 0U;
+}
+
+/// @brief Estimate of the memory held by a Database, by category.
+///
+/// Every category is split into the bytes that grow with the number of
+/// customers and the bytes that grow with the number of interactions, so
+/// that the footprint of a larger database can be projected from the
+/// current one. Sizes are computed from the capacity of the containers and
+/// the layout of the standard library nodes, rounded up the way allocators
+/// round blocks, so building a report costs a walk over the customers and
+/// nothing at all while the Database runs.
+struct MemoryReport {
+  /// @brief Customers accounted
+  std::size_t customers_;
+  /// @brief Interactions in memory accounted
+  std::size_t interactions_;
+  /// @brief Bytes growing with the customers, by category
+  std::array<std::uint64_t, MEMORY_CATEGORY_COUNT> customer_bytes_;
+  /// @brief Bytes growing with the interactions, by category
+  std::array<std::uint64_t, MEMORY_CATEGORY_COUNT> interaction_bytes_;
+
+  MemoryReport()
+      : customers_{},
+        interactions_{},
+        customer_bytes_{},
+        interaction_bytes_{} {}
+
+  /// @brief Accounts memory to a category
+  /// @param category Category of the memory
+  /// @param customer_bytes Bytes growing with the customers
+  /// @param interaction_bytes Bytes growing with the interactions
+  void Add(const EMemoryCategory category, const std::uint64_t customer_bytes,
+           const std::uint64_t interaction_bytes = 0U) {
+    const auto index = GetIndex(category);
+    customer_bytes_[index] += customer_bytes;
+    interaction_bytes_[index] += interaction_bytes;
+  }
+
+  /// @brief Memory accounted to a category
+  /// @param category Category of the memory
+  /// @return Bytes
+  std::uint64_t GetBytes(const EMemoryCategory category) const {
+    const auto index = GetIndex(category);
+    return customer_bytes_[index] + interaction_bytes_[index];
+  }
+
+  /// @brief Memory accounted to all categories
+  /// @return Bytes
+  std::uint64_t GetTotalBytes() const {
+    std::uint64_t total{};
+    for (std::size_t i = 0U; i < MEMORY_CATEGORY_COUNT; i++) {
+      total += customer_bytes_[i] + interaction_bytes_[i];
+    }
+    return total;
+  }
+
+  /// @brief Projects the memory of a database holding a different number of
+  /// customers and interactions, assuming they look like the current ones.
+  /// Strings are scaled with the customers, which overestimates them as
+  /// names repeat; the memory held by the allocator keeps its share of the
+  /// total.
+  /// @param customers Number of customers
+  /// @param interactions Number of interactions in memory
+  /// @return Projected report
+  MemoryReport Project(const std::size_t customers,
+                       const std::size_t interactions) const {
+    const auto scale = [](const std::uint64_t bytes, const std::size_t from,
+                          const std::size_t to) {
+      return from == 0U ? 0U
+                        : static_cast<std::uint64_t>(
+                              static_cast<double>(bytes) * to / from);
+    };
+
+    MemoryReport projection{};
+    projection.customers_ = customers;
+    projection.interactions_ = interactions;
+    std::uint64_t current{};
+    std::uint64_t projected{};
+    for (std::size_t i = 0U; i < MEMORY_CATEGORY_COUNT; i++) {
+      if (i == GetIndex(EMemoryCategory::ALLOCATOR)) {
+        continue;
+      }
+      projection.customer_bytes_[i] =
+          scale(customer_bytes_[i], customers_, customers);
+      projection.interaction_bytes_[i] =
+          scale(interaction_bytes_[i], interactions_, interactions);
+      current += customer_bytes_[i] + interaction_bytes_[i];
+      projected +=
+          projection.customer_bytes_[i] + projection.interaction_bytes_[i];
+    }
+
+    const auto allocator = GetIndex(EMemoryCategory::ALLOCATOR);
+    projection.customer_bytes_[allocator] = static_cast<std::uint64_t>(
+        current == 0U ? 0.0
+                      : static_cast<double>(GetBytes(
+                            EMemoryCategory::ALLOCATOR)) *
+                            static_cast<double>(projected) / current);
+    return projection;
+  }
+
+ private:
+  /// @brief Position of a category in the arrays
+  /// @param category Category, must be valid
+  /// @return Index
+  static std::size_t GetIndex(const EMemoryCategory category) {
+    return static_cast<std::size_t>(category) - 1U;
+  }
+};
+
+#endif  // __MEMORY_REPORT_H__
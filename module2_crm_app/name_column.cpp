@@ -0,0 +1,339 @@
+#include "name_column.h"
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+
+#include "memory_report.h"
+#include "tracer.h"
+
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+/// @brief Marks customers without a row
+constexpr std::uint32_t NO_ROW{UINT32_MAX};
+
+/// @brief Bytes of the column below which a scan runs on the calling thread,
+/// as starting the workers would take longer than the scan itself
+constexpr std::size_t PARALLEL_SCAN_BYTES{4U * 1024U * 1024U};
+
+/// @brief Dead bytes tolerated before compacting, whatever their share
+constexpr std::size_t MIN_COMPACTION_BYTES{64U * 1024U};
+
+/// @brief Finds the first occurrence of a text in a buffer
+using FindFunction = const char* (*)(const char*, const char*,
+                                     std::string_view);
+
+/// @brief Finds a text one position at a time
+/// @param begin Start of the buffer
+/// @param end End of the buffer
+/// @param text Text to look for, not empty
+/// @return Start of the first occurrence, end if there is none
+const char* find_scalar(const char* begin, const char* end,
+                        const std::string_view text) {
+  const std::string_view buffer{begin, static_cast<std::size_t>(end - begin)};
+  const std::size_t position = buffer.find(text);
+  return position != std::string_view::npos ? begin + position : end;
+}
+
+#if defined(__x86_64__)
+
+/// @brief Checks the candidates of a block, whose first and last characters
+/// both match
+/// @param block Start of the block
+/// @param mask One bit per candidate position
+/// @param text Text to look for
+/// @return Start of the first occurrence, nullptr if there is none
+inline const char* check_candidates(const char* block, std::uint32_t mask,
+                                    const std::string_view text) {
+  while (mask != 0U) {
+    const char* const candidate = block + __builtin_ctz(mask);
+    if (text.size() <= 2U ||
+        std::memcmp(candidate + 1, text.data() + 1, text.size() - 2U) == 0) {
+      return candidate;
+    }
+    mask &= mask - 1U;
+  }
+  return nullptr;
+}
+
+/// @brief Finds a text 32 positions at a time, through the AVX2
+/// instructions. Only called after checking that the CPU supports them.
+__attribute__((target("avx2"))) const char* find_avx2(
+    const char* begin, const char* end, const std::string_view text) {
+  const __m256i first = _mm256_set1_epi8(text.front());
+  const __m256i last = _mm256_set1_epi8(text.back());
+  const std::size_t last_offset = text.size() - 1U;
+
+  const char* block = begin;
+  for (; static_cast<std::size_t>(end - block) >= last_offset + 32U;
+       block += 32) {
+    const __m256i block_first =
+        _mm256_loadu_si256(reinterpret_cast<const __m256i*>(block));
+    const __m256i block_last = _mm256_loadu_si256(
+        reinterpret_cast<const __m256i*>(block + last_offset));
+    const auto mask = static_cast<std::uint32_t>(
+        _mm256_movemask_epi8(_mm256_and_si256(
+            _mm256_cmpeq_epi8(block_first, first),
+            _mm256_cmpeq_epi8(block_last, last))));
+
+    const char* const found = check_candidates(block, mask, text);
+    if (found != nullptr) {
+      return found;
+    }
+  }
+  return find_scalar(block, end, text);
+}
+
+/// @brief Finds a text 16 positions at a time, through the SSE2
+/// instructions every x86-64 CPU has
+const char* find_sse2(const char* begin, const char* end,
+                      const std::string_view text) {
+  const __m128i first = _mm_set1_epi8(text.front());
+  const __m128i last = _mm_set1_epi8(text.back());
+  const std::size_t last_offset = text.size() - 1U;
+
+  const char* block = begin;
+  for (; static_cast<std::size_t>(end - block) >= last_offset + 16U;
+       block += 16) {
+    const __m128i block_first =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block));
+    const __m128i block_last =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(block + last_offset));
+    const auto mask = static_cast<std::uint32_t>(_mm_movemask_epi8(
+        _mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                      _mm_cmpeq_epi8(block_last, last))));
+
+    const char* const found = check_candidates(block, mask, text);
+    if (found != nullptr) {
+      return found;
+    }
+  }
+  return find_scalar(block, end, text);
+}
+
+/// @brief Fastest way to find a text supported by the CPU
+FindFunction get_find_function() {
+  static const FindFunction function =
+      __builtin_cpu_supports("avx2") ? find_avx2 : find_sse2;
+  return function;
+}
+
+#else
+
+/// @brief No vector instructions on this target
+FindFunction get_find_function() { return find_scalar; }
+
+#endif
+
+}  // namespace
+
+NameColumn::NameColumn()
+    : text_{},
+      offsets_{},
+      ids_{},
+      rows_{},
+      dead_bytes_{},
+      executor_started_{},
+      executor_{} {}
+
+void NameColumn::Set(const Customer& customer) {
+  Remove(customer.id_);
+  Append(customer);
+}
+
+void NameColumn::Remove(const Customer::ID id) {
+  if (id >= rows_.size() || rows_[id] == NO_ROW) {
+    return;
+  }
+
+  const std::size_t row = rows_[id];
+  const std::size_t row_end =
+      row + 1U < offsets_.size() ? offsets_[row + 1U] : text_.size();
+  ids_[row] = INVALID_CUSTOMER_ID;
+  rows_[id] = NO_ROW;
+  dead_bytes_ += row_end - offsets_[row];
+
+  if (dead_bytes_ >= MIN_COMPACTION_BYTES && dead_bytes_ * 2U > text_.size()) {
+    Compact();
+  }
+}
+
+void NameColumn::Rebuild(const CustomerMap& customers) {
+  const TraceSpan trace_span{"database", "NameColumn::Rebuild"};
+  text_.clear();
+  offsets_.clear();
+  ids_.clear();
+  rows_.clear();
+  dead_bytes_ = 0U;
+
+  offsets_.reserve(customers.size());
+  ids_.reserve(customers.size());
+  if (!customers.empty()) {
+    rows_.resize(customers.crbegin()->first + 1U, NO_ROW);
+  }
+  for (const auto& customer : customers) {
+    Append(customer.second);
+  }
+}
+
+void NameColumn::Find(const std::string_view text,
+                      std::vector<Customer::ID>& ids) const {
+  const TraceSpan trace_span{"database", "NameColumn::Find"};
+  ids.clear();
+
+  std::string folded{};
+  Fold(text, folded);
+  if (folded.empty() || offsets_.empty()) {
+    return;
+  }
+
+  const std::size_t rows = offsets_.size();
+  const std::size_t max_parts = text_.size() / PARALLEL_SCAN_BYTES;
+  if (max_parts <= 1U) {
+    Scan(0U, rows, folded, ids);
+  } else {
+    Executor& executor = GetExecutor();
+    const std::size_t parts = std::min(executor.GetThreadCount(), max_parts);
+    std::vector<std::vector<Customer::ID>> found(parts);
+
+    // The pool outlives the search, so its parts are counted down instead
+    std::mutex mutex{};
+    std::condition_variable part_scanned{};
+    std::size_t pending_parts{parts};
+    for (std::size_t part = 0U; part < parts; part++) {
+      executor.Submit([this, &found, &folded, &mutex, &part_scanned,
+                       &pending_parts, rows, parts, part]() {
+        Scan(rows * part / parts, rows * (part + 1U) / parts, folded,
+             found[part]);
+        std::lock_guard<std::mutex> lock{mutex};
+        if (--pending_parts == 0U) {
+          part_scanned.notify_one();
+        }
+      });
+    }
+    {
+      std::unique_lock<std::mutex> lock{mutex};
+      part_scanned.wait(lock, [&pending_parts]() {
+        return pending_parts == 0U;
+      });
+    }
+
+    for (const auto& part_ids : found) {
+      ids.insert(ids.end(), part_ids.cbegin(), part_ids.cend());
+    }
+  }
+
+  // Customers changed since the last rebuild have their row at the end
+  std::sort(ids.begin(), ids.end());
+}
+
+std::uint64_t NameColumn::GetMemoryUsage() const {
+  return string_buffer_size(text_) + vector_buffer_size(offsets_) +
+         vector_buffer_size(ids_) + vector_buffer_size(rows_);
+}
+
+void NameColumn::Fold(const std::string_view text, std::string& folded) {
+  folded.reserve(folded.size() + text.size());
+  for (std::size_t i = 0U; i < text.size(); i++) {
+    const auto character = static_cast<unsigned char>(text[i]);
+    if (character >= 'A' && character <= 'Z') {
+      folded += static_cast<char>(character + ('a' - 'A'));
+      continue;
+    }
+
+    folded += static_cast<char>(character);
+    // Two-byte UTF-8 sequences of the uppercase letters from U+00C0 to
+    // U+00DE, except the multiplication sign, are 0x20 below the lowercase
+    if (character == 0xC3U && i + 1U < text.size()) {
+      const auto next = static_cast<unsigned char>(text[++i]);
+      folded += static_cast<char>(
+          next >= 0x80U && next <= 0x9EU && next != 0x97U ? next + 0x20U
+                                                          : next);
+    }
+  }
+}
+
+bool NameColumn::Contains(const std::string_view field,
+                          const std::string_view folded_text) {
+  std::string folded{};
+  Fold(field, folded);
+  return folded.find(folded_text) != std::string::npos;
+}
+
+void NameColumn::Scan(const std::size_t first_row, const std::size_t end_row,
+                      const std::string_view text,
+                      std::vector<Customer::ID>& ids) const {
+  const FindFunction find = get_find_function();
+  const char* const base = text_.data();
+  const auto row_start = [this, base](const std::size_t row) {
+    return base + (row < offsets_.size() ? offsets_[row] : text_.size());
+  };
+
+  // Texts never hold a NUL, so an occurrence never spans two fields
+  const char* const end = row_start(end_row);
+  const char* position = row_start(first_row);
+  std::size_t row = first_row;
+  while ((position = find(position, end, text)) != end) {
+    // Occurrences come in order, the row is always ahead
+    const auto next_row = std::upper_bound(
+        offsets_.cbegin() + static_cast<std::ptrdiff_t>(row),
+        offsets_.cbegin() + static_cast<std::ptrdiff_t>(end_row),
+        static_cast<std::uint32_t>(position - base));
+    row = static_cast<std::size_t>(next_row - offsets_.cbegin()) - 1U;
+
+    if (ids_[row] != INVALID_CUSTOMER_ID) {
+      ids.push_back(ids_[row]);
+    }
+    position = row_start(row + 1U);
+  }
+}
+
+Executor& NameColumn::GetExecutor() const {
+  std::call_once(executor_started_,
+                 [this]() { executor_ = std::make_unique<Executor>(0U); });
+  return *executor_;
+}
+
+void NameColumn::Append(const Customer& customer) {
+  if (customer.id_ >= rows_.size()) {
+    rows_.resize(customer.id_ + 1U, NO_ROW);
+  }
+  rows_[customer.id_] = static_cast<std::uint32_t>(offsets_.size());
+  offsets_.push_back(static_cast<std::uint32_t>(text_.size()));
+  ids_.push_back(customer.id_);
+
+  Fold(customer.name_.GetString(), text_);
+  text_ += '\0';
+  Fold(customer.surname_.GetString(), text_);
+  text_ += '\0';
+}
+
+void NameColumn::Compact() {
+  const TraceSpan trace_span{"database", "NameColumn::Compact"};
+  std::string text{};
+  std::vector<std::uint32_t> offsets{};
+  std::vector<Customer::ID> ids{};
+  text.reserve(text_.size() - dead_bytes_);
+
+  for (std::size_t row = 0U; row < offsets_.size(); row++) {
+    const Customer::ID id = ids_[row];
+    if (id == INVALID_CUSTOMER_ID) {
+      continue;
+    }
+    const std::size_t row_end =
+        row + 1U < offsets_.size() ? offsets_[row + 1U] : text_.size();
+    rows_[id] = static_cast<std::uint32_t>(offsets.size());
+    offsets.push_back(static_cast<std::uint32_t>(text.size()));
+    ids.push_back(id);
+    text.append(text_, offsets_[row], row_end - offsets_[row]);
+  }
+
+  text_.swap(text);
+  offsets_.swap(offsets);
+  ids_.swap(ids);
+  dead_bytes_ = 0U;
+}
@@ -0,0 +1,112 @@
+#ifndef __NAME_COLUMN_H__
+#define __NAME_COLUMN_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "customers.h"
+#include "executor.h"
+
+/// @brief Names and surnames of all customers packed in a single buffer,
+/// case-folded, so that searches for a part of a name, which no index can
+/// answer, scan contiguous memory instead of visiting every customer.
+///
+/// Each row holds the name and the surname of a customer, each followed by a
+/// NUL byte, and starts at the position listed in the offsets. Changed
+/// customers get a new row at the end and their old one is marked dead; the
+/// buffer is compacted once dead rows take half of it.
+///
+/// The scan compares 32 (AVX2) or 16 (SSE2) positions at a time against the
+/// first and last character of the text, and only checks the rest of the
+/// text where both match. Large columns are split across worker threads,
+/// started by the first large search and kept for the following ones.
+class NameColumn {
+ public:
+  NameColumn();
+
+  // No move and copy constructors/operators
+  NameColumn(const NameColumn&) = delete;
+  NameColumn& operator=(const NameColumn&) = delete;
+  NameColumn(NameColumn&&) = delete;
+  NameColumn& operator=(NameColumn&&) = delete;
+
+  /// @brief Adds a customer, or replaces its name and surname
+  /// @param customer Customer to add
+  void Set(const Customer& customer);
+
+  /// @brief Removes a customer
+  /// @param id Customer ID
+  void Remove(const Customer::ID id);
+
+  /// @brief Rebuilds the column from scratch
+  /// @param customers All customers
+  void Rebuild(const CustomerMap& customers);
+
+  /// @brief Lists the customers whose name or surname contains a text,
+  /// ignoring case
+  /// @param text Text to look for, not empty
+  /// @param ids Where to store the IDs of the customers, ascending
+  void Find(const std::string_view text, std::vector<Customer::ID>& ids) const;
+
+  /// @brief Memory taken by the column
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+  /// @brief Lowercases a text the way the column is: ASCII letters and the
+  /// accented letters of the Latin-1 range, e.g. "È" becomes "è"
+  /// @param text Text to fold
+  /// @param folded Where to append the folded text
+  static void Fold(const std::string_view text, std::string& folded);
+
+  /// @brief Checks if a name or surname contains a text, ignoring case,
+  /// without going through the column
+  /// @param field Name or surname
+  /// @param folded_text Text to look for, already folded
+  /// @return True if the text appears in the field
+  static bool Contains(const std::string_view field,
+                       const std::string_view folded_text);
+
+ private:
+  /// @brief Looks for a text in the rows of a range
+  /// @param first_row First row to scan
+  /// @param end_row Row following the last one to scan
+  /// @param text Folded text to look for
+  /// @param ids Where to append the IDs of the matching customers
+  void Scan(const std::size_t first_row, const std::size_t end_row,
+            const std::string_view text, std::vector<Customer::ID>& ids) const;
+
+  /// @brief Appends the row of a customer
+  /// @param customer Customer
+  void Append(const Customer& customer);
+
+  /// @brief Drops the dead rows
+  void Compact();
+
+  /// @brief Pool scanning large columns, started on first use
+  /// @return Pool with one thread per hardware thread
+  Executor& GetExecutor() const;
+
+  /// @brief Folded names and surnames, NUL-terminated
+  std::string text_;
+  /// @brief Start of each row in text_
+  std::vector<std::uint32_t> offsets_;
+  /// @brief Customer of each row, INVALID_CUSTOMER_ID for dead rows
+  std::vector<Customer::ID> ids_;
+  /// @brief Row of each customer, indexed by ID
+  std::vector<std::uint32_t> rows_;
+  /// @brief Bytes of text_ taken by dead rows
+  std::size_t dead_bytes_;
+
+  mutable std::once_flag executor_started_;
+  /// @brief Only started by searches that split the scan, so small columns
+  /// and read-only tools never spawn the threads. Its tasks read the members
+  /// above, so it is destroyed before them.
+  mutable std::unique_ptr<Executor> executor_;
+};
+
+#endif  // __NAME_COLUMN_H__
@@ -0,0 +1,320 @@
+#include "query.h"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+
+#include "name_column.h"
+#include "tracer.h"
+
+namespace {
+
+/// @brief Above this size ratio, intersections probe the larger list with
+/// binary searches instead of walking both lists side by side
+constexpr std::size_t GALLOPING_RATIO{16U};
+
+/// @brief Intersects two sorted ID lists
+/// @param left First sorted list
+/// @param right Second sorted list
+/// @param output Where to store the IDs found in both lists, sorted
+void intersect_sorted(const std::vector<Customer::ID>& left,
+                      const std::vector<Customer::ID>& right,
+                      std::vector<Customer::ID>& output) {
+  const auto& smaller = left.size() <= right.size() ? left : right;
+  const auto& larger = left.size() <= right.size() ? right : left;
+
+  if (smaller.empty()) {
+    return;
+  }
+
+  if (larger.size() / smaller.size() < GALLOPING_RATIO) {
+    std::set_intersection(smaller.cbegin(), smaller.cend(), larger.cbegin(),
+                          larger.cend(), std::back_inserter(output));
+    return;
+  }
+
+  auto position = larger.cbegin();
+  for (const auto id : smaller) {
+    position = std::lower_bound(position, larger.cend(), id);
+    if (position == larger.cend()) {
+      break;
+    }
+    if (*position == id) {
+      output.push_back(id);
+    }
+  }
+}
+
+/// @brief Checks if a customer had any interaction of the query kind in the
+/// query interval, each being optional
+bool has_matching_interaction(const Customer& customer,
+                              const CustomerQuery& query) {
+  return std::any_of(
+      customer.customer_interactions_.cbegin(),
+      customer.customer_interactions_.cend(),
+      [&query](const auto& interaction) {
+        return (!query.has_kind_ ||
+                interaction->details_.kind_ == query.kind_) &&
+               (!query.has_interaction_range_ ||
+                interaction->InRange(query.from_timestamp_,
+                                     query.to_timestamp_));
+      });
+}
+
+/// @brief Checks if the query text appears in any field of the customer
+bool contains_text(const Customer& customer, const CustomerQuery& query) {
+  const auto contains = [&query](const auto& field) {
+    return field.find(query.text_.data(), 0U, query.text_.size()) !=
+           std::string::npos;
+  };
+
+  return contains(customer.name_.GetString()) ||
+         contains(customer.surname_.GetString()) ||
+         std::any_of(customer.customer_interactions_.cbegin(),
+                     customer.customer_interactions_.cend(),
+                     [&contains](const auto& interaction) {
+                       return contains(interaction->what_);
+                     });
+}
+
+const char* to_string(const QueryPlan::EAccessPath access_path) {
+  switch (access_path) {
+    case QueryPlan::EAccessPath::ID_LOOKUP:
+      return "ID lookup";
+    case QueryPlan::EAccessPath::NAME_INDEX:
+      return "name index";
+    case QueryPlan::EAccessPath::SURNAME_INDEX:
+      return "surname index";
+    case QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION:
+      return "name index + surname index intersection";
+    case QueryPlan::EAccessPath::INTERACTION_KIND_SCAN:
+      return "interaction kind column scan";
+    case QueryPlan::EAccessPath::NAME_COLUMN_SCAN:
+      return "name column scan";
+    case QueryPlan::EAccessPath::FULL_SCAN:
+    default:
+      return "full scan";
+  }
+}
+
+}  // namespace
+
+const char* QueryPlan::GetAccessPathName() const {
+  return to_string(access_path_);
+}
+
+std::ostream& operator<<(std::ostream& os, const QueryPlan& plan) {
+  os << "access path: " << plan.GetAccessPathName()
+     << " (~" << plan.estimated_candidates_ << " candidates)";
+
+  if (!plan.residual_filters_.empty()) {
+    os << ", residual filter:";
+    for (const auto& filter : plan.residual_filters_) {
+      os << " " << filter;
+    }
+  }
+
+  return os;
+}
+
+QueryPlanner::QueryPlanner(const Database& database) : database_{database} {}
+
+QueryPlan QueryPlanner::Plan(const CustomerQuery& query) const {
+  QueryPlan plan{};
+
+  const bool has_name = !query.name_.empty();
+  const bool has_surname = !query.surname_.empty();
+  const std::size_t name_matches =
+      has_name ? database_.GetCustomersByName(query.name_).size() : 0U;
+  const std::size_t surname_matches =
+      has_surname ? database_.GetCustomersBySurname(query.surname_).size()
+                  : 0U;
+
+  if (query.has_id_) {
+    plan.access_path_ = QueryPlan::EAccessPath::ID_LOOKUP;
+    plan.estimated_candidates_ = database_.HasCustomer(query.id_) ? 1U : 0U;
+  } else if (has_name && has_surname) {
+    // Intersecting only pays off when both lists are selective, otherwise
+    // walk the shorter one and check the other field on each candidate.
+    const std::size_t smaller = std::min(name_matches, surname_matches);
+    const std::size_t larger = std::max(name_matches, surname_matches);
+    if (smaller > 0U && larger / smaller < GALLOPING_RATIO) {
+      plan.access_path_ = QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION;
+    } else if (name_matches <= surname_matches) {
+      plan.access_path_ = QueryPlan::EAccessPath::NAME_INDEX;
+    } else {
+      plan.access_path_ = QueryPlan::EAccessPath::SURNAME_INDEX;
+    }
+    plan.estimated_candidates_ = smaller;
+  } else if (has_name) {
+    plan.access_path_ = QueryPlan::EAccessPath::NAME_INDEX;
+    plan.estimated_candidates_ = name_matches;
+  } else if (has_surname) {
+    plan.access_path_ = QueryPlan::EAccessPath::SURNAME_INDEX;
+    plan.estimated_candidates_ = surname_matches;
+  } else if (!query.name_part_.empty()) {
+    // Scanning the packed names only visits the customers that match
+    plan.access_path_ = QueryPlan::EAccessPath::NAME_COLUMN_SCAN;
+    plan.estimated_candidates_ = database_.GetCustomers().size();
+  } else {
+    plan.access_path_ = QueryPlan::EAccessPath::FULL_SCAN;
+    plan.estimated_candidates_ = database_.GetCustomers().size();
+  }
+
+  // The columns of a kind hold one row per interaction: worth scanning when
+  // there are fewer of them than candidates
+  if (query.has_kind_ && !query.has_id_) {
+    const std::size_t kind_rows = database_.GetInteractionCount(query.kind_);
+    if (kind_rows < plan.estimated_candidates_) {
+      plan.access_path_ = QueryPlan::EAccessPath::INTERACTION_KIND_SCAN;
+      plan.estimated_candidates_ = kind_rows;
+    }
+  }
+
+  const auto path = plan.access_path_;
+  if (has_name && path != QueryPlan::EAccessPath::NAME_INDEX &&
+      path != QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION) {
+    plan.residual_filters_.emplace_back("name");
+  }
+  if (has_surname && path != QueryPlan::EAccessPath::SURNAME_INDEX &&
+      path != QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION) {
+    plan.residual_filters_.emplace_back("surname");
+  }
+  if (query.has_interactions_) {
+    plan.residual_filters_.emplace_back("has-interactions");
+  }
+  // The scan of a kind resolves the interval too
+  if (path != QueryPlan::EAccessPath::INTERACTION_KIND_SCAN) {
+    if (query.has_kind_) {
+      plan.residual_filters_.emplace_back("interaction-kind");
+    }
+    if (query.has_interaction_range_) {
+      plan.residual_filters_.emplace_back("interaction-range");
+    }
+  }
+  if (!query.name_part_.empty() &&
+      path != QueryPlan::EAccessPath::NAME_COLUMN_SCAN) {
+    plan.residual_filters_.emplace_back("name-part");
+  }
+  if (!query.text_.empty()) {
+    plan.residual_filters_.emplace_back("text");
+  }
+
+  return plan;
+}
+
+QueryPlan QueryPlanner::Execute(
+    const CustomerQuery& query,
+    std::vector<Customer::ID>& found_customers) const {
+  const TraceSpan trace_span{"query", "QueryPlanner::Execute"};
+  const QueryPlan plan = Plan(query);
+
+  const auto collect = [this, &plan, &query,
+                        &found_customers](const Customer::ID id) {
+    if (database_.HasCustomer(id) &&
+        MatchesResidual(plan, query, database_.GetCustomer(id))) {
+      found_customers.push_back(id);
+    }
+  };
+
+  switch (plan.access_path_) {
+    case QueryPlan::EAccessPath::ID_LOOKUP:
+      collect(query.id_);
+      break;
+    case QueryPlan::EAccessPath::NAME_INDEX:
+      for (const auto id : database_.GetCustomersByName(query.name_)) {
+        collect(id);
+      }
+      break;
+    case QueryPlan::EAccessPath::SURNAME_INDEX:
+      for (const auto id : database_.GetCustomersBySurname(query.surname_)) {
+        collect(id);
+      }
+      break;
+    case QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION: {
+      std::vector<Customer::ID> candidates{};
+      intersect_sorted(database_.GetCustomersByName(query.name_),
+                       database_.GetCustomersBySurname(query.surname_),
+                       candidates);
+      for (const auto id : candidates) {
+        collect(id);
+      }
+      break;
+    }
+    case QueryPlan::EAccessPath::INTERACTION_KIND_SCAN: {
+      std::vector<Customer::ID> candidates{};
+      database_.GetCustomersByInteractionKind(
+          query.kind_,
+          query.has_interaction_range_
+              ? query.from_timestamp_
+              : std::numeric_limits<std::time_t>::min(),
+          query.has_interaction_range_
+              ? query.to_timestamp_
+              : std::numeric_limits<std::time_t>::max(),
+          candidates);
+      for (const auto id : candidates) {
+        collect(id);
+      }
+      break;
+    }
+    case QueryPlan::EAccessPath::NAME_COLUMN_SCAN: {
+      std::vector<Customer::ID> candidates{};
+      database_.GetCustomersByNamePart(query.name_part_, candidates);
+      for (const auto id : candidates) {
+        collect(id);
+      }
+      break;
+    }
+    case QueryPlan::EAccessPath::FULL_SCAN:
+    default:
+      for (const auto& customer_entry : database_.GetCustomers()) {
+        if (MatchesResidual(plan, query, customer_entry.second)) {
+          found_customers.push_back(customer_entry.first);
+        }
+      }
+      break;
+  }
+
+  return plan;
+}
+
+bool QueryPlanner::MatchesResidual(const QueryPlan& plan,
+                                   const CustomerQuery& query,
+                                   const Customer& customer) const {
+  const auto path = plan.access_path_;
+
+  if (!query.name_.empty() && path != QueryPlan::EAccessPath::NAME_INDEX &&
+      path != QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION &&
+      customer.name_ != query.name_) {
+    return false;
+  }
+
+  if (!query.surname_.empty() &&
+      path != QueryPlan::EAccessPath::SURNAME_INDEX &&
+      path != QueryPlan::EAccessPath::NAME_SURNAME_INTERSECTION &&
+      customer.surname_ != query.surname_) {
+    return false;
+  }
+
+  if (query.has_interactions_ && !customer.HasInteractions()) {
+    return false;
+  }
+
+  if ((query.has_kind_ || query.has_interaction_range_) &&
+      path != QueryPlan::EAccessPath::INTERACTION_KIND_SCAN &&
+      !has_matching_interaction(customer, query)) {
+    return false;
+  }
+
+  if (!query.name_part_.empty() &&
+      path != QueryPlan::EAccessPath::NAME_COLUMN_SCAN) {
+    std::string name_part{};
+    NameColumn::Fold(query.name_part_, name_part);
+    if (!NameColumn::Contains(customer.name_.GetString(), name_part) &&
+        !NameColumn::Contains(customer.surname_.GetString(), name_part)) {
+      return false;
+    }
+  }
+
+  return query.text_.empty() || contains_text(customer, query);
+}
@@ -0,0 +1,141 @@
+#ifndef __QUERY_H__
+#define __QUERY_H__
+
+#include <cstdint>
+#include <ctime>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include "customers.h"
+#include "database.h"
+
+/// @brief Combination of search criterias for customers. Every criteria is
+/// optional and all the enabled ones must match.
+struct CustomerQuery {
+  /// @brief Whether to look for a specific customer ID
+  bool has_id_;
+  /// @brief Customer ID to look for
+  Customer::ID id_;
+  /// @brief Exact name, ignored if empty
+  std::string name_;
+  /// @brief Exact surname, ignored if empty
+  std::string surname_;
+  /// @brief Whether the customer must have had at least one interaction
+  bool has_interactions_;
+  /// @brief Whether the customer must have had an interaction in the interval
+  /// between from_timestamp_ and to_timestamp_
+  bool has_interaction_range_;
+  /// @brief Start of the interaction interval as a UNIX Timestamp
+  std::time_t from_timestamp_;
+  /// @brief End of the interaction interval as a UNIX Timestamp
+  std::time_t to_timestamp_;
+  /// @brief Whether the customer must have had an interaction of kind kind_,
+  /// within the interaction interval if one is set
+  bool has_kind_;
+  /// @brief Kind of interaction to look for
+  EInteractionKind kind_;
+  /// @brief Text that must appear in the name, surname or in the description
+  /// of an interaction, ignored if empty
+  std::string text_;
+  /// @brief Text that must appear in the name or surname, ignoring case,
+  /// ignored if empty
+  std::string name_part_;
+
+  CustomerQuery()
+      : has_id_{false},
+        id_{INVALID_CUSTOMER_ID},
+        name_{},
+        surname_{},
+        has_interactions_{false},
+        has_interaction_range_{false},
+        from_timestamp_{},
+        to_timestamp_{},
+        has_kind_{false},
+        kind_{EInteractionKind::INVALID},
+        text_{},
+        name_part_{} {}
+
+  /// @brief Checks if no criteria has been set
+  /// @return True if the query would match every customer
+  bool IsEmpty() const {
+    return !has_id_ && name_.empty() && surname_.empty() &&
+           !has_interactions_ && !has_interaction_range_ && !has_kind_ &&
+           text_.empty() && name_part_.empty();
+  }
+};
+
+/// @brief Describes how a CustomerQuery is going to be executed
+struct QueryPlan {
+  /// @brief Strategy used to collect the candidate customers
+  enum class EAccessPath : std::uint32_t {
+    ID_LOOKUP = 1,
+    NAME_INDEX,
+    SURNAME_INDEX,
+    NAME_SURNAME_INTERSECTION,
+    INTERACTION_KIND_SCAN,
+    NAME_COLUMN_SCAN,
+    FULL_SCAN,
+  };
+
+  /// @brief Strategy used to collect the candidate customers
+  EAccessPath access_path_;
+  /// @brief Number of candidates the access path produces
+  std::size_t estimated_candidates_;
+  /// @brief Criterias checked on every candidate after the access path
+  std::vector<std::string> residual_filters_;
+
+  QueryPlan()
+      : access_path_{EAccessPath::FULL_SCAN},
+        estimated_candidates_{},
+        residual_filters_{} {}
+
+  /// @brief Name of the access path
+  /// @return Name, e.g. "name index"
+  const char* GetAccessPathName() const;
+
+  /// @brief Stream overload to print a human-readable explanation of the plan
+  /// @param os Output stream
+  /// @param plan Plan to explain
+  /// @return Reference to the output stream
+  friend std::ostream& operator<<(std::ostream& os, const QueryPlan& plan);
+};
+
+/// @brief Picks the cheapest way to answer a CustomerQuery using the indexes
+/// available in the Database, then runs it.
+class QueryPlanner {
+ public:
+  QueryPlanner() = delete;
+  QueryPlanner(const QueryPlanner&) = delete;
+  QueryPlanner& operator=(const QueryPlanner&) = delete;
+  QueryPlanner(QueryPlanner&&) = delete;
+  QueryPlanner& operator=(QueryPlanner&&) = delete;
+
+  explicit QueryPlanner(const Database& database);
+
+  /// @brief Chooses the most selective access path for the query
+  /// @param query Search criterias
+  /// @return Plan describing how the query will be executed
+  QueryPlan Plan(const CustomerQuery& query) const;
+
+  /// @brief Plans and executes a query
+  /// @param query Search criterias
+  /// @param found_customers Where to store the IDs of all matching customers,
+  /// in ascending order
+  /// @return Plan that has been executed
+  QueryPlan Execute(const CustomerQuery& query,
+                    std::vector<Customer::ID>& found_customers) const;
+
+ private:
+  /// @brief Checks the criterias that were not resolved by the access path
+  /// @param plan Executed plan
+  /// @param query Search criterias
+  /// @param customer Candidate customer
+  /// @return True if the customer matches all remaining criterias
+  bool MatchesResidual(const QueryPlan& plan, const CustomerQuery& query,
+                       const Customer& customer) const;
+
+  const Database& database_;
+};
+
+#endif  // __QUERY_H__
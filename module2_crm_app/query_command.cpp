@@ -0,0 +1,303 @@
+#include "query_command.h"
+
+#include <algorithm>
+#include <iostream>
+#include <iterator>
+#include <limits>
+
+#include "database.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Format of the dates accepted by --from and --to
+constexpr char FILTER_DATE_FORMAT[]{"%d/%m/%Y"};
+
+/// @brief Seconds from the start of a day to its last second, so that --to
+/// includes the whole day
+constexpr std::time_t LAST_SECOND_OF_DAY{24 * 60 * 60 - 1};
+
+/// @brief Size the output may reach before it is written out
+constexpr std::size_t OUTPUT_CHUNK_SIZE{64U * 1024U};
+
+}  // namespace
+
+QueryCommand::QueryCommand(const Config& config) : config_{config} {}
+
+std::int32_t QueryCommand::Run() {
+  if (config_.output_format_ != EOutputFormat::TSV &&
+      config_.output_format_ != EOutputFormat::JSON) {
+    std::cerr << "I risultati possono essere stampati solo in formato tsv o "
+                 "json."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  CustomerQuery query{};
+  if (!ParseFilters(query)) {
+    std::cerr << "I filtri indicati non sono nel formato corretto."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (config_.command_ == "find" && query.IsEmpty()) {
+    std::cerr << "Indica almeno un filtro." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (config_.command_ == "interactions" && config_.explain_) {
+    std::cerr << "--explain vale solo per find e count." << std::endl;
+    return EXIT_FAILURE;
+  }
+  if (config_.command_ == "interactions" && !query.has_id_) {
+    std::cerr << "Indica il cliente con --id." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  if (config_.command_ == "interactions") {
+    // Point lookup: only what holds this customer is read
+    std::vector<std::shared_ptr<Interaction>> interactions{};
+    if (!Database::ReadCustomerInteractions(
+            config_.database_path_, config_.storage_engine_, query.id_,
+            query.has_interaction_range_
+                ? query.from_timestamp_
+                : std::numeric_limits<std::time_t>::min(),
+            query.has_interaction_range_
+                ? query.to_timestamp_
+                : std::numeric_limits<std::time_t>::max(),
+            interactions)) {
+      std::cerr << "Nessun cliente con ID " << query.id_ << "." << std::endl;
+      return EXIT_FAILURE;
+    }
+
+    if (query.has_kind_) {
+      interactions.erase(
+          std::remove_if(interactions.begin(), interactions.end(),
+                         [&query](const auto& interaction) {
+                           return interaction->details_.kind_ != query.kind_;
+                         }),
+          interactions.end());
+    }
+    PrintInteractions(interactions);
+    return EXIT_SUCCESS;
+  }
+
+  // Read-only: nothing is archived, checkpointed or saved on exit, and the
+  // indexes saved along with the snapshot are loaded instead of rebuilt
+  const CRM customer_manager{config_.database_path_, true,
+                             std::chrono::milliseconds{},
+                             config_.storage_engine_};
+
+  if (config_.explain_) {
+    PrintPlan(customer_manager.ExplainQuery(query));
+    return EXIT_SUCCESS;
+  }
+
+  if (config_.command_ == "count" && query.IsEmpty()) {
+    PrintCount(customer_manager.GetCustomerCount());
+    return EXIT_SUCCESS;
+  }
+
+  // Exact names are answered while walking the index, the customers are
+  // printed as they are found instead of being collected first
+  if (!query.has_id_ && query.text_.empty() && query.name_part_.empty() &&
+      !query.has_interaction_range_ && !query.has_kind_) {
+    const CustomerRange customers =
+        customer_manager.FindCustomers(query.name_, query.surname_);
+    if (config_.command_ == "count") {
+      PrintCount(static_cast<std::size_t>(
+          std::distance(customers.begin(), customers.end())));
+    } else {
+      PrintCustomers(customer_manager, customers);
+    }
+    return EXIT_SUCCESS;
+  }
+
+  std::vector<Customer::ID> customer_ids{};
+  customer_manager.FindCustomers(query, customer_ids);
+  if (config_.command_ == "count") {
+    PrintCount(customer_ids.size());
+  } else {
+    std::string output{};
+    BeginCustomers(output);
+    for (std::size_t i = 0U; i < customer_ids.size(); i++) {
+      AppendCustomer(customer_manager,
+                     customer_manager.GetCustomer(customer_ids[i]), i == 0U,
+                     output);
+    }
+    EndCustomers(output);
+  }
+  return EXIT_SUCCESS;
+}
+
+bool QueryCommand::ParseFilters(CustomerQuery& query) const {
+  if (!config_.filter_id_.empty()) {
+    if (!utilities::try_convert(config_.filter_id_, query.id_)) {
+      return false;
+    }
+    query.has_id_ = true;
+  }
+
+  query.name_ = config_.filter_name_;
+  query.surname_ = config_.filter_surname_;
+  query.text_ = config_.filter_text_;
+  query.name_part_ = config_.filter_name_part_;
+
+  if (!config_.filter_kind_.empty()) {
+    if (!from_kind_name(config_.filter_kind_, query.kind_)) {
+      return false;
+    }
+    query.has_kind_ = true;
+  }
+
+  if (config_.filter_from_.empty() && config_.filter_to_.empty()) {
+    return true;
+  }
+
+  query.has_interaction_range_ = true;
+  query.from_timestamp_ = std::numeric_limits<std::time_t>::min();
+  query.to_timestamp_ = std::numeric_limits<std::time_t>::max();
+  if (!config_.filter_from_.empty() &&
+      !utilities::to_timestamp(config_.filter_from_, FILTER_DATE_FORMAT,
+                               query.from_timestamp_)) {
+    return false;
+  }
+  if (!config_.filter_to_.empty()) {
+    if (!utilities::to_timestamp(config_.filter_to_, FILTER_DATE_FORMAT,
+                                 query.to_timestamp_)) {
+      return false;
+    }
+    query.to_timestamp_ += LAST_SECOND_OF_DAY;
+  }
+  return true;
+}
+
+void QueryCommand::PrintCustomers(const CRM& customer_manager,
+                                  const CustomerRange& customers) const {
+  std::string output{};
+  BeginCustomers(output);
+  bool first{true};
+  for (const Customer& customer : customers) {
+    AppendCustomer(customer_manager, customer, first, output);
+    first = false;
+
+    if (output.size() >= OUTPUT_CHUNK_SIZE) {
+      std::cout << output;
+      output.clear();
+    }
+  }
+  EndCustomers(output);
+}
+
+void QueryCommand::BeginCustomers(std::string& output) const {
+  output += config_.output_format_ == EOutputFormat::JSON
+                ? "["
+                : "id\tname\tsurname\tinteractions\tlast_interaction\n";
+}
+
+void QueryCommand::AppendCustomer(const CRM& customer_manager,
+                                  const Customer& customer, const bool first,
+                                  std::string& output) const {
+  const ActivitySummary& summary =
+      customer_manager.GetActivitySummary(customer.id_);
+  const std::string last_interaction =
+      summary.IsDated()
+          ? utilities::to_date(summary.last_timestamp_, DATE_FORMAT)
+          : std::string{};
+
+  if (config_.output_format_ == EOutputFormat::JSON) {
+    output += first ? "\n " : ",\n ";
+    output += "{\"id\": " + std::to_string(customer.id_) +
+              ", \"name\": " +
+              utilities::to_json_string(customer.name_.GetString()) +
+              ", \"surname\": " +
+              utilities::to_json_string(customer.surname_.GetString()) +
+              ", \"interactions\": " +
+              std::to_string(summary.interaction_count_) +
+              ", \"last_interaction\": " +
+              (summary.IsDated()
+                   ? utilities::to_json_string(last_interaction)
+                   : std::string{"null"}) +
+              "}";
+  } else {
+    output += std::to_string(customer.id_) + '\t' +
+              customer.name_.GetString() + '\t' +
+              customer.surname_.GetString() + '\t' +
+              std::to_string(summary.interaction_count_) + '\t' +
+              last_interaction + '\n';
+  }
+}
+
+void QueryCommand::EndCustomers(std::string& output) const {
+  output += config_.output_format_ == EOutputFormat::JSON ? "\n]\n" : "";
+  std::cout << output;
+}
+
+void QueryCommand::PrintInteractions(
+    const std::vector<std::shared_ptr<Interaction>>& interactions) const {
+  const bool json = config_.output_format_ == EOutputFormat::JSON;
+
+  std::string output{};
+  output += json ? "[" : "when\twhat\tkind\n";
+  for (std::size_t i = 0U; i < interactions.size(); i++) {
+    const Interaction& interaction = *interactions[i];
+    const std::string when{interaction.GetDate()};
+    const std::string what{interaction.what_.data(),
+                           interaction.what_.size()};
+    const InteractionDetails& details = interaction.details_;
+    const char* const kind = to_kind_name(details.kind_);
+    if (json) {
+      output += i > 0U ? ",\n " : "\n ";
+      output += "{\"when\": " + utilities::to_json_string(when) +
+                ", \"what\": " + utilities::to_json_string(what) +
+                ", \"kind\": \"" + kind + "\"";
+      if (details.kind_ == EInteractionKind::CONTRACT &&
+          details.policy_ != EPolicyType::INVALID) {
+        output += ", \"policy\": " +
+                  std::to_string(static_cast<std::uint32_t>(details.policy_)) +
+                  ", \"premium_cents\": " +
+                  std::to_string(details.premium_cents_) +
+                  ", \"duration_months\": " +
+                  std::to_string(details.duration_months_);
+      }
+      output += "}";
+    } else {
+      output += when + '\t' + what + '\t' + kind + '\n';
+    }
+  }
+  output += json ? "\n]\n" : "";
+
+  std::cout << output;
+}
+
+void QueryCommand::PrintPlan(const QueryPlan& plan) const {
+  std::string output{};
+  if (config_.output_format_ == EOutputFormat::JSON) {
+    output += "{\"access_path\": " +
+              utilities::to_json_string(plan.GetAccessPathName()) +
+              ", \"estimated_candidates\": " +
+              std::to_string(plan.estimated_candidates_) +
+              ", \"residual_filters\": [";
+    for (std::size_t i = 0U; i < plan.residual_filters_.size(); i++) {
+      output += (i > 0U ? ", " : "") +
+                utilities::to_json_string(plan.residual_filters_[i]);
+    }
+    output += "]}\n";
+  } else {
+    output += "access_path\testimated_candidates\tresidual_filters\n";
+    output += std::string{plan.GetAccessPathName()} + '\t' +
+              std::to_string(plan.estimated_candidates_) + '\t';
+    for (std::size_t i = 0U; i < plan.residual_filters_.size(); i++) {
+      output += (i > 0U ? "," : "") + plan.residual_filters_[i];
+    }
+    output += '\n';
+  }
+  std::cout << output;
+}
+
+void QueryCommand::PrintCount(const std::size_t count) const {
+  if (config_.output_format_ == EOutputFormat::JSON) {
+    std::cout << "{\"count\": " << count << "}" << std::endl;
+  } else {
+    std::cout << "count" << std::endl << count << std::endl;
+  }
+}
@@ -0,0 +1,80 @@
+#ifndef __QUERY_COMMAND_H__
+#define __QUERY_COMMAND_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "crm.h"
+
+/// @brief Runs a single query for scripts, without the interactive menu:
+/// "find" lists the customers matching the filters, "interactions" the
+/// interactions of a customer and "count" the number of matching customers.
+/// The database is opened read-only, so it is never rewritten, and results
+/// are printed as TSV or JSON to standard output. With --explain, find and
+/// count print the plan of the query instead: its access path, the expected
+/// number of candidates and the filters checked on each of them.
+class QueryCommand {
+ public:
+  // No default, move and copy constructors/operators
+  QueryCommand() = delete;
+  QueryCommand(const QueryCommand&) = delete;
+  QueryCommand& operator=(const QueryCommand&) = delete;
+  QueryCommand(QueryCommand&&) = delete;
+  QueryCommand& operator=(QueryCommand&&) = delete;
+
+  /// @brief Prepares the query
+  /// @param config Command, filters, output format and database to query
+  explicit QueryCommand(const Config& config);
+
+  /// @brief Opens the database and runs the query
+  /// @return Exit status code, failure if the filters are malformed
+  std::int32_t Run();
+
+ private:
+  /// @brief Builds the query out of the filters of the command line
+  /// @param query Where to store the query
+  /// @return False if a filter is malformed
+  bool ParseFilters(CustomerQuery& query) const;
+
+  /// @brief Prints the customers as they are found, a chunk of output at a
+  /// time
+  /// @param customer_manager CRM holding the customers
+  /// @param customers Customers to print
+  void PrintCustomers(const CRM& customer_manager,
+                      const CustomerRange& customers) const;
+
+  /// @brief Starts the list of customers
+  /// @param output Where to append the output
+  void BeginCustomers(std::string& output) const;
+
+  /// @brief Formats a customer found
+  /// @param customer_manager CRM holding the customers
+  /// @param customer Customer to print
+  /// @param first Whether it is the first customer of the list
+  /// @param output Where to append the output
+  void AppendCustomer(const CRM& customer_manager, const Customer& customer,
+                      const bool first, std::string& output) const;
+
+  /// @brief Completes the list of customers and prints what is left of it
+  /// @param output Output not printed yet
+  void EndCustomers(std::string& output) const;
+
+  /// @brief Prints the interactions of a customer
+  /// @param interactions Interactions to print
+  void PrintInteractions(
+      const std::vector<std::shared_ptr<Interaction>>& interactions) const;
+
+  /// @brief Prints how a query is executed
+  /// @param plan Plan chosen for the query
+  void PrintPlan(const QueryPlan& plan) const;
+
+  /// @brief Prints the number of customers found
+  /// @param count Number of customers
+  void PrintCount(const std::size_t count) const;
+
+  Config config_;
+};
+
+#endif  // __QUERY_COMMAND_H__
@@ -0,0 +1,442 @@
+#include "report_exporter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <charconv>
+#include <condition_variable>
+#include <cstdio>
+#include <fstream>
+#include <mutex>
+#include <string_view>
+
+#include "executor.h"
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Range of customer IDs formatted together
+constexpr std::uint64_t CHUNK_CUSTOMER_IDS{4096U};
+
+/// @brief Chunks in flight for each worker thread: formatted, being
+/// formatted or waiting to be written
+constexpr std::size_t CHUNKS_PER_THREAD{4U};
+
+/// @brief Widths of the fields of the fixed-width customer report
+constexpr std::size_t CUSTOMER_FIELD_WIDTHS[]{10U, 30U, 30U, 8U, 16U, 16U};
+
+/// @brief Widths of the fields of the fixed-width interaction report
+constexpr std::size_t INTERACTION_FIELD_WIDTHS[]{10U, 30U, 30U, 16U, 12U,
+                                                 6U,  12U, 4U,  80U};
+
+/// @brief Header line of the customer report
+constexpr const char* CUSTOMER_FIELD_NAMES[]{
+    "id", "name", "surname", "interactions", "last_interaction", "score"};
+
+/// @brief Header line of the interaction report
+constexpr const char* INTERACTION_FIELD_NAMES[]{
+    "customer_id", "name",    "surname",         "date",       "kind",
+    "policy",      "premium", "duration_months", "description"};
+
+/// @brief Appends the fields of a row of a report to a buffer, without any
+/// intermediate allocation
+class RowWriter {
+ public:
+  /// @brief Starts a row
+  /// @param format TSV, CSV or FIXED_WIDTH
+  /// @param widths Width of each field, for FIXED_WIDTH
+  /// @param buffer Where to append the row
+  RowWriter(const EOutputFormat format, const std::size_t* widths,
+            std::string& buffer)
+      : format_{format}, widths_{widths}, buffer_{buffer}, field_{0U} {}
+
+  /// @brief Appends a text field
+  /// @param value Text
+  void AddText(const std::string_view value) { AddField(value, false); }
+
+  /// @brief Appends a number
+  /// @param value Number
+  void AddNumber(const std::uint64_t value) {
+    char digits[24];
+    const auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    AddField(std::string_view{digits, static_cast<std::size_t>(end - digits)},
+             true);
+  }
+
+  /// @brief Appends an amount of money, as units and two decimals
+  /// @param cents Amount in cents
+  void AddCents(const std::uint32_t cents) {
+    char digits[24];
+    char* end =
+        std::to_chars(digits, digits + sizeof(digits), cents / 100U).ptr;
+    *end++ = '.';
+    *end++ = static_cast<char>('0' + cents % 100U / 10U);
+    *end++ = static_cast<char>('0' + cents % 10U);
+    AddField(std::string_view{digits, static_cast<std::size_t>(end - digits)},
+             true);
+  }
+
+  /// @brief Appends a score, in its shortest exact form
+  /// @param value Score
+  void AddScore(const float value) {
+    char digits[32];
+    const auto end = std::to_chars(digits, digits + sizeof(digits), value).ptr;
+    AddField(std::string_view{digits, static_cast<std::size_t>(end - digits)},
+             true);
+  }
+
+  /// @brief Appends a date and time in DATE_FORMAT, in local time
+  /// @param timestamp UNIX Timestamp
+  void AddDate(const std::time_t timestamp) {
+    std::tm date_time{};
+    localtime_r(&timestamp, &date_time);
+
+    char date[16];
+    const auto two_digits = [](char* destination, const int value) {
+      destination[0] = static_cast<char>('0' + value / 10);
+      destination[1] = static_cast<char>('0' + value % 10);
+    };
+    two_digits(date, date_time.tm_mday);
+    date[2] = '/';
+    two_digits(date + 3, date_time.tm_mon + 1);
+    date[5] = '/';
+    const int year = date_time.tm_year + 1900;
+    two_digits(date + 6, year / 100);
+    two_digits(date + 8, year % 100);
+    date[10] = ' ';
+    two_digits(date + 11, date_time.tm_hour);
+    date[13] = ':';
+    two_digits(date + 14, date_time.tm_min);
+    AddField(std::string_view{date, sizeof(date)}, false);
+  }
+
+  /// @brief Appends an empty field
+  void AddEmpty() { AddField(std::string_view{}, false); }
+
+  /// @brief Completes the row
+  void EndRow() { buffer_ += '\n'; }
+
+ private:
+  /// @brief Appends a field, with its separator, quoting or padding
+  /// @param value Field
+  /// @param right_aligned Whether padding goes before the value
+  void AddField(std::string_view value, const bool right_aligned) {
+    const std::size_t field = field_++;
+    switch (format_) {
+      case EOutputFormat::CSV:
+        if (field > 0U) {
+          buffer_ += ',';
+        }
+        AddQuoted(value);
+        return;
+      case EOutputFormat::FIXED_WIDTH: {
+        const std::size_t width = widths_[field];
+        if (value.size() > width) {
+          // Never cut a UTF-8 sequence in half
+          std::size_t size = width;
+          while (size > 0U && (static_cast<unsigned char>(value[size]) &
+                               0xC0U) == 0x80U) {
+            size--;
+          }
+          value = value.substr(0U, size);
+        }
+        const std::size_t padding = width - value.size();
+        if (right_aligned) {
+          buffer_.append(padding, ' ');
+        }
+        buffer_.append(value.data(), value.size());
+        if (!right_aligned) {
+          buffer_.append(padding, ' ');
+        }
+        return;
+      }
+      case EOutputFormat::TSV:
+      default:
+        if (field > 0U) {
+          buffer_ += '\t';
+        }
+        buffer_.append(value.data(), value.size());
+        return;
+    }
+  }
+
+  /// @brief Appends a CSV field, quoted if it holds separators or quotes
+  /// @param value Field
+  void AddQuoted(const std::string_view value) {
+    if (value.find_first_of(",\"\r\n") == std::string_view::npos) {
+      buffer_.append(value.data(), value.size());
+      return;
+    }
+
+    buffer_ += '"';
+    for (const char character : value) {
+      if (character == '"') {
+        buffer_ += '"';
+      }
+      buffer_ += character;
+    }
+    buffer_ += '"';
+  }
+
+  EOutputFormat format_;
+  const std::size_t* widths_;
+  std::string& buffer_;
+  std::size_t field_;
+};
+
+/// @brief Appends the header line of a report, if the format has one
+/// @param options What is exported and how
+/// @param buffer Where to append the header
+void append_header(const ReportExporter::Options& options,
+                   std::string& buffer) {
+  if (options.format_ == EOutputFormat::FIXED_WIDTH) {
+    return;
+  }
+
+  RowWriter row{options.format_, nullptr, buffer};
+  if (options.type_ == EReportType::CUSTOMERS) {
+    for (const char* name : CUSTOMER_FIELD_NAMES) {
+      row.AddText(name);
+    }
+  } else {
+    for (const char* name : INTERACTION_FIELD_NAMES) {
+      row.AddText(name);
+    }
+  }
+  row.EndRow();
+}
+
+/// @brief Checks an interaction against the filters of an export
+/// @param options What is exported
+/// @param interaction Interaction to check
+/// @return True if the interaction is exported
+bool is_exported(const ReportExporter::Options& options,
+                 const Interaction& interaction) {
+  return (!options.has_kind_ || interaction.details_.kind_ == options.kind_) &&
+         (!options.has_interaction_range_ ||
+          interaction.InRange(options.from_timestamp_, options.to_timestamp_));
+}
+
+}  // namespace
+
+struct ReportExporter::Chunk {
+  /// @brief First customer ID of the chunk
+  std::uint64_t first_id_;
+  /// @brief Customer ID following the chunk
+  std::uint64_t end_id_;
+  /// @brief Formatted rows, kept from one chunk to the next to reuse the
+  /// memory
+  std::string buffer_;
+  std::size_t customers_;
+  std::size_t rows_;
+  /// @brief Whether the buffer is ready to be written. Guarded by the mutex
+  /// of the export.
+  bool formatted_;
+};
+
+ReportExporter::ReportExporter(const Database& database)
+    : database_{database} {}
+
+bool ReportExporter::Export(const Options& options, const std::string& path,
+                            Summary& result) const {
+  const TraceSpan trace_span{"export", "ReportExporter::Export"};
+  result = Summary{};
+  if ((options.format_ != EOutputFormat::TSV &&
+       options.format_ != EOutputFormat::CSV &&
+       options.format_ != EOutputFormat::FIXED_WIDTH) ||
+      (options.type_ != EReportType::CUSTOMERS &&
+       options.type_ != EReportType::INTERACTIONS)) {
+    return false;
+  }
+
+  const std::string temporary_path{path + ".tmp"};
+  std::ofstream file_stream{temporary_path,
+                            std::ios::out | std::ios::trunc | std::ios::binary};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string header{};
+  append_header(options, header);
+  file_stream.write(header.data(), static_cast<std::streamsize>(header.size()));
+  result.bytes_ += header.size();
+
+  const CustomerMap& customers = database_.GetCustomers();
+  std::uint64_t highest_id{INVALID_CUSTOMER_ID};
+  if (options.has_customer_list_) {
+    highest_id = options.customer_ids_.empty() ? INVALID_CUSTOMER_ID
+                                               : options.customer_ids_.back();
+  } else if (!customers.empty()) {
+    highest_id = customers.crbegin()->first;
+  }
+  const std::uint64_t chunk_count = highest_id / CHUNK_CUSTOMER_IDS + 1U;
+
+  std::mutex mutex{};
+  std::condition_variable chunk_formatted{};
+  std::atomic<bool> failed{false};
+  std::vector<Chunk> chunks{};
+  {
+    // The tasks fill chunks and signal through mutex: leaving this block
+    // waits for the ones still queued after a failed write, before those go
+    Executor executor{options.thread_count_};
+    chunks.resize(static_cast<std::size_t>(
+        std::min<std::uint64_t>(executor.GetThreadCount() * CHUNKS_PER_THREAD,
+                                chunk_count)));
+
+    const auto submit = [&](const std::uint64_t index) {
+      Chunk& chunk = chunks[index % chunks.size()];
+      chunk.first_id_ = index * CHUNK_CUSTOMER_IDS;
+      chunk.end_id_ = chunk.first_id_ + CHUNK_CUSTOMER_IDS;
+      chunk.buffer_.clear();
+      chunk.customers_ = 0U;
+      chunk.rows_ = 0U;
+      chunk.formatted_ = false;
+
+      executor.Submit([this, &options, &chunk, &mutex, &chunk_formatted,
+                       &failed]() {
+        if (!failed.load(std::memory_order_relaxed)) {
+          FormatChunk(options, chunk);
+        }
+        std::lock_guard<std::mutex> lock{mutex};
+        chunk.formatted_ = true;
+        chunk_formatted.notify_all();
+      });
+    };
+
+    for (std::uint64_t index = 0U; index < chunks.size(); index++) {
+      submit(index);
+    }
+
+    // Written in order as soon as they are ready, then reused for the chunk
+    // that comes chunks.size() later
+    for (std::uint64_t index = 0U; index < chunk_count; index++) {
+      Chunk& chunk = chunks[index % chunks.size()];
+      {
+        std::unique_lock<std::mutex> lock{mutex};
+        chunk_formatted.wait(lock, [&chunk]() { return chunk.formatted_; });
+      }
+
+      file_stream.write(chunk.buffer_.data(),
+                        static_cast<std::streamsize>(chunk.buffer_.size()));
+      if (!file_stream.good()) {
+        failed.store(true, std::memory_order_relaxed);
+        break;
+      }
+      result.customers_ += chunk.customers_;
+      result.rows_ += chunk.rows_;
+      result.bytes_ += chunk.buffer_.size();
+
+      if (index + chunks.size() < chunk_count) {
+        submit(index + chunks.size());
+      }
+    }
+  }
+
+  file_stream.close();
+  // Flushed before the rename, so that a crash cannot leave an empty report
+  // in place of the previous one
+  if (failed.load(std::memory_order_relaxed) || file_stream.fail() ||
+      !utilities::sync_file(temporary_path)) {
+    std::remove(temporary_path.c_str());
+    return false;
+  }
+  return utilities::replace_file(temporary_path, path);
+}
+
+void ReportExporter::FormatChunk(const Options& options, Chunk& chunk) const {
+  const TraceSpan trace_span{"export", "ReportExporter::FormatChunk"};
+  const CustomerMap& customers = database_.GetCustomers();
+
+  if (!options.has_customer_list_) {
+    for (auto customer = customers.lower_bound(
+             static_cast<Customer::ID>(chunk.first_id_));
+         customer != customers.cend() && customer->first < chunk.end_id_;
+         ++customer) {
+      FormatCustomer(options, customer->second, chunk);
+    }
+    return;
+  }
+
+  const auto& ids = options.customer_ids_;
+  for (auto id = std::lower_bound(ids.cbegin(), ids.cend(), chunk.first_id_);
+       id != ids.cend() && *id < chunk.end_id_; ++id) {
+    const auto customer = customers.find(*id);
+    if (customer != customers.cend()) {
+      FormatCustomer(options, customer->second, chunk);
+    }
+  }
+}
+
+void ReportExporter::FormatCustomer(const Options& options,
+                                    const Customer& customer,
+                                    Chunk& chunk) const {
+  const bool filtered = options.has_interaction_range_ || options.has_kind_;
+  const auto& interactions = customer.customer_interactions_;
+
+  if (options.type_ == EReportType::CUSTOMERS) {
+    if (filtered &&
+        std::none_of(interactions.cbegin(), interactions.cend(),
+                     [&options](const auto& interaction) {
+                       return is_exported(options, *interaction);
+                     })) {
+      return;
+    }
+
+    const ActivitySummary& summary = database_.GetActivitySummary(customer.id_);
+    float score{};
+    RowWriter row{options.format_, CUSTOMER_FIELD_WIDTHS, chunk.buffer_};
+    row.AddNumber(customer.id_);
+    row.AddText(customer.name_.GetString());
+    row.AddText(customer.surname_.GetString());
+    row.AddNumber(summary.interaction_count_);
+    if (summary.IsDated()) {
+      row.AddDate(summary.last_timestamp_);
+    } else {
+      row.AddEmpty();
+    }
+    if (database_.GetScore(customer.id_, score)) {
+      row.AddScore(score);
+    } else {
+      row.AddEmpty();
+    }
+    row.EndRow();
+    chunk.customers_++;
+    chunk.rows_++;
+    return;
+  }
+
+  bool exported{false};
+  for (const auto& interaction : interactions) {
+    if (filtered && !is_exported(options, *interaction)) {
+      continue;
+    }
+
+    const InteractionDetails& details = interaction->details_;
+    RowWriter row{options.format_, INTERACTION_FIELD_WIDTHS, chunk.buffer_};
+    row.AddNumber(customer.id_);
+    row.AddText(customer.name_.GetString());
+    row.AddText(customer.surname_.GetString());
+    row.AddText(interaction->GetDate());
+    row.AddText(to_kind_name(details.kind_));
+    // Contracts saved before interactions had a kind have no details
+    if (details.kind_ == EInteractionKind::CONTRACT &&
+        details.policy_ != EPolicyType::INVALID) {
+      row.AddText(to_policy_name(details.policy_));
+      row.AddCents(details.premium_cents_);
+      row.AddNumber(details.duration_months_);
+    } else {
+      row.AddEmpty();
+      row.AddEmpty();
+      row.AddEmpty();
+    }
+    row.AddText(std::string_view{interaction->what_.data(),
+                                 interaction->what_.size()});
+    row.EndRow();
+    chunk.rows_++;
+    exported = true;
+  }
+
+  if (exported) {
+    chunk.customers_++;
+  }
+}
@@ -0,0 +1,129 @@
+#ifndef __REPORT_EXPORTER_H__
+#define __REPORT_EXPORTER_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "customers.h"
+#include "database.h"
+
+/// @brief Content of a report
+enum class EReportType : std::uint32_t {
+  /// One row per customer: ID, name, surname, number of interactions, date
+  /// of the latest one and score
+  CUSTOMERS = 1,
+  /// One row per interaction: customer ID, name and surname, date, kind,
+  /// contract fields and description
+  INTERACTIONS,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Writes reports of the customers or of their interactions to a
+/// file, e.g. CSV for accounting or fixed-width records for the mainframe.
+///
+/// The customers are split in chunks of consecutive IDs, formatted by a pool
+/// of worker threads and written in order by the calling thread. Rows are
+/// formatted straight into the buffer of their chunk, without streams or
+/// temporary strings, and the buffers are reused: only a few chunks per
+/// worker are in flight at any time, so memory stays bounded whatever the
+/// size of the report.
+///
+/// Only the interactions in memory are exported, archived ones are left
+/// out. The Database must not change while exporting.
+class ReportExporter {
+ public:
+  /// @brief What to export and how
+  struct Options {
+    EReportType type_;
+    /// @brief TSV, CSV or FIXED_WIDTH
+    EOutputFormat format_;
+    /// @brief Whether to only export the interactions, and the customers
+    /// having any, between from_timestamp_ and to_timestamp_
+    bool has_interaction_range_;
+    /// @brief Start of the interaction interval as a UNIX Timestamp
+    std::time_t from_timestamp_;
+    /// @brief End of the interaction interval as a UNIX Timestamp
+    std::time_t to_timestamp_;
+    /// @brief Whether to only export the interactions, and the customers
+    /// having any, of kind kind_
+    bool has_kind_;
+    /// @brief Kind of interactions to export
+    EInteractionKind kind_;
+    /// @brief Whether to only export the customers of customer_ids_
+    bool has_customer_list_;
+    /// @brief Customers to export, sorted and without duplicates. IDs of
+    /// missing customers are skipped.
+    std::vector<Customer::ID> customer_ids_;
+    /// @brief Threads formatting the report, 0 to use one per hardware
+    /// thread
+    std::size_t thread_count_;
+
+    Options()
+        : type_{EReportType::CUSTOMERS},
+          format_{EOutputFormat::TSV},
+          has_interaction_range_{false},
+          from_timestamp_{},
+          to_timestamp_{},
+          has_kind_{false},
+          kind_{EInteractionKind::INVALID},
+          has_customer_list_{false},
+          customer_ids_{},
+          thread_count_{0U} {}
+  };
+
+  /// @brief Outcome of an export
+  struct Summary {
+    /// @brief Customers exported, or whose interactions were exported
+    std::size_t customers_;
+    /// @brief Rows written, without the header
+    std::size_t rows_;
+    /// @brief Size of the file
+    std::uint64_t bytes_;
+  };
+
+  // No default, move and copy constructors/operators
+  ReportExporter() = delete;
+  ReportExporter(const ReportExporter&) = delete;
+  ReportExporter& operator=(const ReportExporter&) = delete;
+  ReportExporter(ReportExporter&&) = delete;
+  ReportExporter& operator=(ReportExporter&&) = delete;
+
+  /// @brief Binds to the database to export
+  /// @param database Loaded database
+  explicit ReportExporter(const Database& database);
+
+  /// @brief Writes a report. The file is written aside and moved in place
+  /// once complete, so a failed export leaves any previous report intact.
+  /// @param options What to export and how
+  /// @param path Path of the report
+  /// @param result Where to store the outcome
+  /// @return False if the format is not supported by reports or the file
+  /// cannot be written
+  bool Export(const Options& options, const std::string& path,
+              Summary& result) const;
+
+ private:
+  /// @brief Consecutive customers formatted together
+  struct Chunk;
+
+  /// @brief Formats the rows of a chunk into its buffer
+  /// @param options What to export and how
+  /// @param chunk Chunk to format
+  void FormatChunk(const Options& options, Chunk& chunk) const;
+
+  /// @brief Formats the rows of a customer, if it passes the filters
+  /// @param options What to export and how
+  /// @param customer Customer to format
+  /// @param chunk Chunk whose buffer the rows are appended to
+  void FormatCustomer(const Options& options, const Customer& customer,
+                      Chunk& chunk) const;
+
+  const Database& database_;
+};
+
+#endif  // __REPORT_EXPORTER_H__
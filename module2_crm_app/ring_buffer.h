@@ -0,0 +1,97 @@
+#ifndef __RING_BUFFER_H__
+#define __RING_BUFFER_H__
+
+#include <atomic>
+#include <cstddef>
+#include <vector>
+
+/// @brief Bounded lock-free queue for exactly one producer thread and one
+/// consumer thread. Neither side ever blocks: pushing into a full buffer and
+/// popping from an empty one simply fail.
+/// @tparam T Type of the stored elements, must be default constructible and
+/// movable
+template <typename T>
+class RingBuffer {
+ public:
+  // No default, move and copy constructors/operators
+  RingBuffer() = delete;
+  RingBuffer(const RingBuffer&) = delete;
+  RingBuffer& operator=(const RingBuffer&) = delete;
+  RingBuffer(RingBuffer&&) = delete;
+  RingBuffer& operator=(RingBuffer&&) = delete;
+
+  /// @brief Creates the buffer
+  /// @param capacity Minimum number of elements the buffer can hold. Rounded
+  /// up to the next power of two.
+  explicit RingBuffer(const std::size_t capacity)
+      : slots_(round_up_capacity(capacity)),
+        mask_{slots_.size() - 1U},
+        head_{0U},
+        tail_{0U} {}
+
+  /// @brief Appends an element. Producer side only.
+  /// @param value Element to append
+  /// @return False if the buffer is full, true otherwise
+  bool TryPush(T&& value) {
+    const std::size_t tail = tail_.load(std::memory_order_relaxed);
+    if (tail - head_.load(std::memory_order_acquire) == slots_.size()) {
+      return false;
+    }
+
+    slots_[tail & mask_] = std::move(value);
+    tail_.store(tail + 1U, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Takes the oldest element out of the buffer. Consumer side only.
+  /// @param value Where to move the element into
+  /// @return False if the buffer is empty, true otherwise
+  bool TryPop(T& value) {
+    const std::size_t head = head_.load(std::memory_order_relaxed);
+    if (head == tail_.load(std::memory_order_acquire)) {
+      return false;
+    }
+
+    value = std::move(slots_[head & mask_]);
+    head_.store(head + 1U, std::memory_order_release);
+    return true;
+  }
+
+  /// @brief Number of elements currently stored. Only a hint while the other
+  /// side is running.
+  /// @return Number of elements
+  std::size_t GetSize() const {
+    return tail_.load(std::memory_order_acquire) -
+           head_.load(std::memory_order_acquire);
+  }
+
+  /// @brief Maximum number of elements the buffer can hold
+  /// @return Capacity
+  std::size_t GetCapacity() const { return slots_.size(); }
+
+ private:
+  /// @brief Size of a cache line, used to keep producer and consumer counters
+  /// from sharing one
+  static constexpr std::size_t CACHE_LINE_SIZE{64U};
+
+  static std::size_t round_up_capacity(const std::size_t capacity) {
+    std::size_t rounded{1U};
+    while (rounded < capacity) {
+      rounded <<= 1U;
+    }
+    return rounded;
+  }
+
+  std::vector<T> slots_;
+  const std::size_t mask_;
+
+  /// @brief Index of the next element to pop, written by the consumer
+  char head_padding_[CACHE_LINE_SIZE];
+  std::atomic<std::size_t> head_;
+
+  /// @brief Index of the next free slot, written by the producer
+  char tail_padding_[CACHE_LINE_SIZE];
+  std::atomic<std::size_t> tail_;
+};
+
+#endif  // __RING_BUFFER_H__
@@ -0,0 +1,362 @@
+#include "score_column.h"
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <numeric>
+
+#include "memory_report.h"
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Start of the file the scores are saved to
+constexpr char SCORE_FILE_MAGIC[]{"CRMSCORE"};
+
+/// @brief Size of the header of the saved file: magic, count and checksum
+constexpr std::size_t SCORE_FILE_HEADER_SIZE{sizeof(SCORE_FILE_MAGIC) - 1U +
+                                             2U * sizeof(std::uint64_t)};
+
+/// @brief Bytes of a score file read at a time
+constexpr std::size_t IMPORT_CHUNK_SIZE{1024U * 1024U};
+
+/// @brief Size of a record of a binary score file
+constexpr std::size_t BINARY_RECORD_SIZE{sizeof(std::uint32_t) +
+                                         sizeof(float)};
+
+/// @brief Extension of the CSV score files
+constexpr char CSV_EXTENSION[]{".csv"};
+
+/// @brief Joins the scores of a file with the customers as they are read.
+/// Both are sorted by ID, so each side is walked only once.
+class ScoreJoin {
+ public:
+  ScoreJoin(const CustomerMap& customers, std::vector<Customer::ID>& ids,
+            std::vector<float>& scores, ScoreColumn::ImportSummary& summary)
+      : customer_{customers.cbegin()},
+        end_{customers.cend()},
+        ids_{ids},
+        scores_{scores},
+        summary_{summary},
+        last_id_{INVALID_CUSTOMER_ID} {}
+
+  /// @brief Joins the next score of the file
+  /// @param id Customer ID
+  /// @param score Score of the customer
+  /// @return False if the file is not sorted by ID or the score is not a
+  /// number
+  bool Add(const Customer::ID id, const float score) {
+    if (id <= last_id_ || !std::isfinite(score)) {
+      return false;
+    }
+    last_id_ = id;
+
+    while (customer_ != end_ && customer_->first < id) {
+      ++customer_;
+    }
+    if (customer_ == end_ || customer_->first != id) {
+      summary_.unknown_++;
+      return true;
+    }
+
+    ids_.push_back(id);
+    scores_.push_back(score);
+    summary_.imported_++;
+    return true;
+  }
+
+ private:
+  CustomerMap::const_iterator customer_;
+  CustomerMap::const_iterator end_;
+  std::vector<Customer::ID>& ids_;
+  std::vector<float>& scores_;
+  ScoreColumn::ImportSummary& summary_;
+  Customer::ID last_id_;
+};
+
+/// @brief Joins the complete records of a chunk of a binary score file
+/// @param data Start of the chunk
+/// @param size Size of the chunk
+/// @param join Join to feed
+/// @param consumed Where to store the size of the records joined
+/// @return False if a record is invalid
+bool join_binary(const char* data, const std::size_t size, ScoreJoin& join,
+                 std::size_t& consumed) {
+  for (consumed = 0U; size - consumed >= BINARY_RECORD_SIZE;
+       consumed += BINARY_RECORD_SIZE) {
+    std::uint32_t id{};
+    float score{};
+    std::memcpy(&id, data + consumed, sizeof(id));
+    std::memcpy(&score, data + consumed + sizeof(id), sizeof(score));
+    if (!join.Add(id, score)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief Joins the complete lines of a chunk of a CSV score file
+/// @param data Start of the chunk
+/// @param size Size of the chunk
+/// @param at_end Whether the chunk ends the file, so that its last line is
+/// complete even without a newline
+/// @param first_line Whether the chunk starts with the first line of the
+/// file, which may be a header. Cleared once it has been read.
+/// @param join Join to feed
+/// @param consumed Where to store the size of the lines joined
+/// @return False if a line is malformed
+bool join_csv(const char* data, const std::size_t size, const bool at_end,
+              bool& first_line, ScoreJoin& join, std::size_t& consumed) {
+  consumed = 0U;
+  while (consumed < size) {
+    const char* const line = data + consumed;
+    const char* line_end = static_cast<const char*>(
+        std::memchr(line, '\n', size - consumed));
+    if (line_end == nullptr && !at_end) {
+      break;
+    }
+    if (line_end == nullptr) {
+      line_end = data + size;
+    }
+    consumed = static_cast<std::size_t>(line_end - data) +
+               (line_end < data + size ? 1U : 0U);
+
+    const char* field_end = line_end;
+    if (field_end > line && field_end[-1] == '\r') {
+      field_end--;
+    }
+    if (field_end == line) {
+      continue;
+    }
+
+    std::uint32_t id{};
+    float score{};
+    const auto id_end = std::from_chars(line, field_end, id);
+    bool valid = id_end.ec == std::errc{} && id_end.ptr < field_end &&
+                 *id_end.ptr == ',';
+    if (valid) {
+      const auto score_end = std::from_chars(id_end.ptr + 1, field_end, score);
+      valid = score_end.ec == std::errc{} && score_end.ptr == field_end;
+    }
+
+    const bool header = first_line && !valid;
+    first_line = false;
+    if (header) {
+      continue;
+    }
+    if (!valid || !join.Add(id, score)) {
+      return false;
+    }
+  }
+  return true;
+}
+
+/// @brief Appends the bytes of a value to a buffer
+/// @param buffer Buffer to append to
+/// @param value Value to append
+template <typename T>
+void append_bytes(std::string& buffer, const T& value) {
+  buffer.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+}  // namespace
+
+ScoreColumn::ScoreColumn(const std::string& path)
+    : path_{path}, version_{}, ids_{}, scores_{}, ranking_{} {}
+
+bool ScoreColumn::Load() {
+  const TraceSpan trace_span{"scores", "ScoreColumn::Load"};
+  ids_.clear();
+  scores_.clear();
+  ranking_.clear();
+
+  // Read first: if the file is replaced meanwhile, Refresh() loads it again
+  version_ = utilities::get_file_version(path_);
+  std::ifstream file_stream{path_, std::ios::binary};
+  if (!file_stream.good()) {
+    return false;
+  }
+  const std::string content{std::istreambuf_iterator<char>{file_stream},
+                            std::istreambuf_iterator<char>{}};
+
+  const std::size_t magic_size{sizeof(SCORE_FILE_MAGIC) - 1U};
+  if (content.size() < SCORE_FILE_HEADER_SIZE ||
+      content.compare(0U, magic_size, SCORE_FILE_MAGIC) != 0) {
+    return false;
+  }
+
+  std::uint64_t count{};
+  std::uint64_t checksum{};
+  std::memcpy(&count, content.data() + magic_size, sizeof(count));
+  std::memcpy(&checksum, content.data() + magic_size + sizeof(count),
+              sizeof(checksum));
+
+  const char* const body = content.data() + SCORE_FILE_HEADER_SIZE;
+  const std::size_t body_size = content.size() - SCORE_FILE_HEADER_SIZE;
+  if (body_size != count * (sizeof(Customer::ID) + sizeof(float)) ||
+      utilities::checksum(body, body_size) != checksum) {
+    return false;
+  }
+
+  ids_.resize(count);
+  scores_.resize(count);
+  std::memcpy(ids_.data(), body, count * sizeof(Customer::ID));
+  std::memcpy(scores_.data(), body + count * sizeof(Customer::ID),
+              count * sizeof(float));
+  RebuildRanking();
+  return true;
+}
+
+bool ScoreColumn::Refresh() {
+  if (utilities::get_file_version(path_) == version_) {
+    return true;
+  }
+  return Load();
+}
+
+bool ScoreColumn::Import(const std::string& source_path,
+                         const CustomerMap& customers,
+                         ImportSummary& result) {
+  const TraceSpan trace_span{"scores", "ScoreColumn::Import"};
+  result = ImportSummary{};
+
+  std::ifstream file_stream{source_path, std::ios::binary};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  const std::size_t extension_size{sizeof(CSV_EXTENSION) - 1U};
+  const bool csv =
+      source_path.size() >= extension_size &&
+      source_path.compare(source_path.size() - extension_size, extension_size,
+                          CSV_EXTENSION) == 0;
+
+  // Built aside, so that the current scores survive a failed import
+  std::vector<Customer::ID> ids{};
+  std::vector<float> scores{};
+  ScoreJoin join{customers, ids, scores, result};
+
+  std::vector<char> buffer(IMPORT_CHUNK_SIZE);
+  std::size_t pending{};
+  bool first_line{true};
+  bool at_end{false};
+  while (!at_end) {
+    file_stream.read(buffer.data() + pending,
+                     static_cast<std::streamsize>(buffer.size() - pending));
+    const std::size_t size =
+        pending + static_cast<std::size_t>(file_stream.gcount());
+    at_end = file_stream.eof();
+    if (!at_end && !file_stream.good()) {
+      return false;
+    }
+
+    std::size_t consumed{};
+    const bool joined =
+        csv ? join_csv(buffer.data(), size, at_end, first_line, join,
+                       consumed)
+            : join_binary(buffer.data(), size, join, consumed);
+    pending = size - consumed;
+
+    // A line longer than a chunk, or a truncated record
+    if (!joined || pending == buffer.size() || (at_end && pending > 0U)) {
+      return false;
+    }
+    std::memmove(buffer.data(), buffer.data() + consumed, pending);
+  }
+
+  std::swap(ids_, ids);
+  std::swap(scores_, scores);
+  RebuildRanking();
+  if (!Save()) {
+    std::swap(ids_, ids);
+    std::swap(scores_, scores);
+    RebuildRanking();
+    return false;
+  }
+  version_ = utilities::get_file_version(path_);
+  return true;
+}
+
+bool ScoreColumn::GetScore(const Customer::ID id, float& score) const {
+  std::size_t position{};
+  if (!Find(id, position)) {
+    return false;
+  }
+  score = scores_[position];
+  return true;
+}
+
+bool ScoreColumn::Page(const Customer::ID after, const std::size_t count,
+                       const CustomerMap& customers,
+                       std::vector<Customer::ID>& ids) const {
+  auto rank = ranking_.cbegin();
+  if (after != INVALID_CUSTOMER_ID) {
+    std::size_t position{};
+    if (!Find(after, position)) {
+      return false;
+    }
+    const float score = scores_[position];
+    rank = std::upper_bound(
+        ranking_.cbegin(), ranking_.cend(), position,
+        [this, score, after](const std::size_t, const std::uint32_t other) {
+          return score > scores_[other] ||
+                 (score == scores_[other] && after < ids_[other]);
+        });
+  }
+
+  for (std::size_t listed = 0U; rank != ranking_.cend() && listed < count;
+       ++rank) {
+    const Customer::ID id = ids_[*rank];
+    if (customers.find(id) != customers.cend()) {
+      ids.push_back(id);
+      listed++;
+    }
+  }
+  return true;
+}
+
+std::uint64_t ScoreColumn::GetMemoryUsage() const {
+  return vector_buffer_size(ids_) + vector_buffer_size(scores_) +
+         vector_buffer_size(ranking_);
+}
+
+bool ScoreColumn::Save() const {
+  const TraceSpan trace_span{"scores", "ScoreColumn::Save"};
+  std::string body{};
+  body.reserve(ids_.size() * (sizeof(Customer::ID) + sizeof(float)));
+  body.append(reinterpret_cast<const char*>(ids_.data()),
+              ids_.size() * sizeof(Customer::ID));
+  body.append(reinterpret_cast<const char*>(scores_.data()),
+              scores_.size() * sizeof(float));
+
+  std::string file{SCORE_FILE_MAGIC};
+  file.reserve(SCORE_FILE_HEADER_SIZE + body.size());
+  append_bytes(file, static_cast<std::uint64_t>(ids_.size()));
+  append_bytes(file, utilities::checksum(body.data(), body.size()));
+  file += body;
+  return utilities::write_file(path_, file);
+}
+
+void ScoreColumn::RebuildRanking() {
+  ranking_.resize(ids_.size());
+  std::iota(ranking_.begin(), ranking_.end(), 0U);
+
+  // Positions follow the IDs, so a stable sort keeps equal scores by ID
+  std::stable_sort(ranking_.begin(), ranking_.end(),
+                   [this](const std::uint32_t left, const std::uint32_t right) {
+                     return scores_[left] > scores_[right];
+                   });
+}
+
+bool ScoreColumn::Find(const Customer::ID id, std::size_t& position) const {
+  const auto entry = std::lower_bound(ids_.cbegin(), ids_.cend(), id);
+  if (entry == ids_.cend() || *entry != id) {
+    return false;
+  }
+  position = static_cast<std::size_t>(std::distance(ids_.cbegin(), entry));
+  return true;
+}
@@ -0,0 +1,124 @@
+#ifndef __SCORE_COLUMN_H__
+#define __SCORE_COLUMN_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "customers.h"
+
+/// @brief Scores computed outside the CRM, e.g. the propensity to buy of the
+/// cross-selling model, at most one per customer.
+///
+/// Scores are kept apart from the customers, as two parallel arrays sorted by
+/// customer ID, plus the positions of the scores from the highest to the
+/// lowest, so that the best customers are listed without sorting anything.
+/// They are replaced as a whole by Import(), which merge-joins a score file
+/// sorted by customer ID with the customers in a single pass, reading the
+/// file a chunk at a time. Two formats are accepted:
+///
+///   - CSV (files ending in ".csv"): lines "<id>,<score>", optionally after a
+///     header line
+///   - binary (any other file): records of a 32-bit customer ID followed by
+///     a 32-bit float score, both in the byte order of the machine
+///
+/// The imported scores are saved to their own file, loaded along with the
+/// database. Other processes holding the database pick up a new import
+/// through Refresh().
+class ScoreColumn {
+ public:
+  /// @brief Outcome of an import
+  struct ImportSummary {
+    /// @brief Scores stored
+    std::size_t imported_;
+    /// @brief Scores of customers that do not exist, skipped
+    std::size_t unknown_;
+  };
+
+  // No default, move and copy constructors/operators
+  ScoreColumn() = delete;
+  ScoreColumn(const ScoreColumn&) = delete;
+  ScoreColumn& operator=(const ScoreColumn&) = delete;
+  ScoreColumn(ScoreColumn&&) = delete;
+  ScoreColumn& operator=(ScoreColumn&&) = delete;
+
+  /// @brief Binds to the file the scores are saved to. Nothing is read until
+  /// Load().
+  /// @param path Path of the score file
+  explicit ScoreColumn(const std::string& path);
+
+  /// @brief Reads the scores saved by the last import
+  /// @return False if the file is missing or corrupted, no customer has a
+  /// score in that case
+  bool Load();
+
+  /// @brief Reads the scores again if their file has been replaced since the
+  /// last Load() or Import(), e.g. by an import run by another process
+  /// @return False if the file was replaced by a missing or corrupted one
+  bool Refresh();
+
+  /// @brief Replaces all scores with the ones of a score file and saves them.
+  /// Customers missing from the file are left without a score.
+  /// @param source_path Score file, sorted by ascending customer ID
+  /// @param customers Customers the scores are joined with
+  /// @param result Where to store the outcome
+  /// @return False if the file cannot be read, is malformed or not sorted, or
+  /// the scores cannot be saved; the previous scores are kept in that case
+  bool Import(const std::string& source_path, const CustomerMap& customers,
+              ImportSummary& result);
+
+  /// @brief Looks up the score of a customer
+  /// @param id Customer ID
+  /// @param score Where to store the score
+  /// @return False if the customer has no score
+  bool GetScore(const Customer::ID id, float& score) const;
+
+  /// @brief Number of customers with a score
+  /// @return Count
+  std::size_t GetSize() const { return ids_.size(); }
+
+  /// @brief Memory taken by the scores and their ranking
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+  /// @brief Lists the customers that follow a customer by descending score.
+  /// Customers with the same score are listed by ID.
+  /// @param after Customer to start after, INVALID_CUSTOMER_ID to start from
+  /// the highest score
+  /// @param count Maximum number of customers to list
+  /// @param customers Existing customers, the ones removed since the import
+  /// are skipped
+  /// @param ids Where to append the IDs of the customers
+  /// @return False if the customer to start after has no score
+  bool Page(const Customer::ID after, const std::size_t count,
+            const CustomerMap& customers,
+            std::vector<Customer::ID>& ids) const;
+
+ private:
+  /// @brief Writes the scores, replacing the file atomically
+  /// @return True if the file reached the disk, false otherwise
+  bool Save() const;
+
+  /// @brief Sorts the positions of the scores from the highest
+  void RebuildRanking();
+
+  /// @brief Position of the score of a customer in the column
+  /// @param id Customer ID
+  /// @param position Where to store the position
+  /// @return False if the customer has no score
+  bool Find(const Customer::ID id, std::size_t& position) const;
+
+  std::string path_;
+  /// @brief Version of the file the scores were last read from or saved to,
+  /// see utilities::get_file_version()
+  std::uint64_t version_;
+  /// @brief Customers with a score, ascending
+  std::vector<Customer::ID> ids_;
+  /// @brief Score of each customer of ids_
+  std::vector<float> scores_;
+  /// @brief Positions in the column from the highest score to the lowest
+  std::vector<std::uint32_t> ranking_;
+};
+
+#endif  // __SCORE_COLUMN_H__
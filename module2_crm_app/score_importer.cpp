@@ -0,0 +1,36 @@
+#include "score_importer.h"
+
+#include <chrono>
+#include <iostream>
+
+#include "database.h"
+
+ScoreImporter::ScoreImporter(const Config& config) : config_{config} {}
+
+std::int32_t ScoreImporter::Run() {
+  if (config_.command_arguments_.empty()) {
+    std::cerr << "Indica il file dei punteggi." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  Database database{config_.database_path_, false, config_.storage_engine_};
+
+  const auto start = std::chrono::steady_clock::now();
+  ScoreColumn::ImportSummary summary{};
+  if (!database.ImportScores(config_.command_arguments_[0], summary)) {
+    std::cerr << "Impossibile importare i punteggi: il file non è leggibile, "
+                 "non è ordinato per ID cliente o contiene righe non valide."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  std::cout << "Punteggi importati: " << summary.imported_ << std::endl;
+  if (summary.unknown_ > 0U) {
+    std::cout << "Punteggi di clienti inesistenti, ignorati: "
+              << summary.unknown_ << std::endl;
+  }
+  std::cout << "Tempo impiegato: " << elapsed.count() << " ms" << std::endl;
+  return EXIT_SUCCESS;
+}
@@ -0,0 +1,33 @@
+#ifndef __SCORE_IMPORTER_H__
+#define __SCORE_IMPORTER_H__
+
+#include <cstdint>
+
+#include "config.h"
+
+/// @brief Replaces the scores of the customers with the ones of a score
+/// file, e.g. the nightly output of the cross-selling model. The database is
+/// opened read-only: only the score file next to it is written, and the
+/// interactive menu reads it the next time it starts.
+class ScoreImporter {
+ public:
+  // No default, move and copy constructors/operators
+  ScoreImporter() = delete;
+  ScoreImporter(const ScoreImporter&) = delete;
+  ScoreImporter& operator=(const ScoreImporter&) = delete;
+  ScoreImporter(ScoreImporter&&) = delete;
+  ScoreImporter& operator=(ScoreImporter&&) = delete;
+
+  /// @brief Prepares the import
+  /// @param config Score file, database and storage engine
+  explicit ScoreImporter(const Config& config);
+
+  /// @brief Loads the database, imports the scores and prints a summary
+  /// @return Exit status code, failure if the scores were not imported
+  std::int32_t Run();
+
+ private:
+  Config config_;
+};
+
+#endif  // __SCORE_IMPORTER_H__
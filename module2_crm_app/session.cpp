@@ -0,0 +1,302 @@
+#include "session.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <iomanip>
+#include <map>
+#include <sstream>
+#include <streambuf>
+#include <thread>
+#include <utility>
+
+#include "app.h"
+#include "database.h"
+
+namespace {
+
+/// @brief Stream buffer discarding everything written into it, used to
+/// silence the App while replaying
+class NullBuffer : public std::streambuf {
+ protected:
+  int overflow(int c) override { return c; }
+  std::streamsize xsputn(const char*, std::streamsize count) override {
+    return count;
+  }
+};
+
+/// @brief Human-readable name of a command
+/// @param command App::ECommand value
+/// @param sub_command App::ESubCommand value
+/// @return Name of the command, with its subcommand if any
+std::string command_name(const std::uint32_t command,
+                         const std::uint32_t sub_command) {
+  static const std::map<App::ECommand, const char*> command_names{
+      {App::ECommand::ADD_CUSTOMER, "ADD_CUSTOMER"},
+      {App::ECommand::SHOW_CUSTOMERS, "SHOW_CUSTOMERS"},
+      {App::ECommand::EDIT_CUSTOMER, "EDIT_CUSTOMER"},
+      {App::ECommand::REMOVE_CUSTOMER, "REMOVE_CUSTOMER"},
+      {App::ECommand::SEARCH_CUSTOMER, "SEARCH_CUSTOMER"},
+      {App::ECommand::MANAGE_CUSTOMER_INTERACTIONS,
+       "MANAGE_CUSTOMER_INTERACTIONS"},
+      {App::ECommand::SWITCH_TENANT, "SWITCH_TENANT"},
+      {App::ECommand::SHOW_APPOINTMENTS, "SHOW_APPOINTMENTS"},
+  };
+  static const std::map<App::ESubCommand, const char*> sub_command_names{
+      {App::ESubCommand::CLIENT_INTERACTIONS_ADD, "ADD"},
+      {App::ESubCommand::CLIENT_INTERACTIONS_SHOW, "SHOW"},
+      {App::ESubCommand::CLIENT_INTERACTIONS_SEARCH, "SEARCH"},
+      {App::ESubCommand::CLIENT_INTERACTIONS_RESELECT_CLIENT, "RESELECT"},
+  };
+
+  const auto command_entry =
+      command_names.find(static_cast<App::ECommand>(command));
+  std::string name{command_entry != command_names.cend()
+                       ? command_entry->second
+                       : std::to_string(command)};
+
+  const auto sub_command_entry =
+      sub_command_names.find(static_cast<App::ESubCommand>(sub_command));
+  if (sub_command_entry != sub_command_names.cend()) {
+    name += "/";
+    name += sub_command_entry->second;
+  }
+
+  return name;
+}
+
+/// @brief Copies the files of a directory, if it exists
+/// @param source_path Directory to copy
+/// @param destination_path Where to copy it
+void copy_directory(const std::string& source_path,
+                    const std::string& destination_path) {
+  std::vector<std::string> file_names{};
+  if (!utilities::list_directory(source_path, file_names) ||
+      !utilities::create_directory(destination_path)) {
+    return;
+  }
+
+  for (const auto& file_name : file_names) {
+    utilities::copy_file(source_path + "/" + file_name,
+              destination_path + "/" + file_name);
+  }
+}
+
+/// @brief Removes a directory and the files in it
+/// @param path Directory to remove
+void remove_directory(const std::string& path) {
+  std::vector<std::string> file_names{};
+  utilities::list_directory(path, file_names);
+  for (const auto& file_name : file_names) {
+    std::remove((path + "/" + file_name).c_str());
+  }
+  std::remove(path.c_str());
+}
+
+/// @brief Duration as fractional microseconds
+double to_microseconds(const std::chrono::nanoseconds duration) {
+  return static_cast<double>(duration.count()) / 1000.0;
+}
+
+}  // namespace
+
+SessionRecorder::SessionRecorder(const std::string& trace_path)
+    : file_stream_{trace_path, std::ios::out | std::ios::trunc},
+      start_{std::chrono::steady_clock::now()} {}
+
+void SessionRecorder::Record(const std::uint32_t command,
+                             const std::uint32_t sub_command, const bool choice,
+                             const std::string& input) {
+  SessionEvent event{};
+  event.offset_ms_ = static_cast<std::uint64_t>(
+      std::chrono::duration_cast<std::chrono::milliseconds>(
+          std::chrono::steady_clock::now() - start_)
+          .count());
+  event.command_ = command;
+  event.sub_command_ = sub_command;
+  event.choice_ = choice;
+  event.input_ = input;
+
+  // Flushed right away, so the trace survives a crash of the session
+  file_stream_ << event;
+}
+
+SessionReplayer::SessionReplayer(const Config& config)
+    : config_{config}, events_{} {}
+
+std::int32_t SessionReplayer::Run() {
+  if (config_.command_arguments_.empty() || !LoadTrace()) {
+    std::cout << "Impossibile leggere la sessione registrata." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::vector<std::vector<Sample>> session_samples(config_.replay_concurrency_);
+  std::vector<std::thread> sessions{};
+
+  // The App writes straight to the terminal: silence it while replaying
+  NullBuffer null_buffer{};
+  std::streambuf* const terminal_buffer = std::cout.rdbuf(&null_buffer);
+
+  const auto start = std::chrono::steady_clock::now();
+  for (std::uint32_t i = 0U; i < config_.replay_concurrency_; i++) {
+    sessions.emplace_back(&SessionReplayer::ReplaySession, this, i,
+                          std::ref(session_samples[i]));
+  }
+  for (auto& session : sessions) {
+    session.join();
+  }
+  const auto elapsed = std::chrono::steady_clock::now() - start;
+
+  std::cout.rdbuf(terminal_buffer);
+
+  std::vector<Sample> samples{};
+  for (const auto& session : session_samples) {
+    samples.insert(samples.end(), session.cbegin(), session.cend());
+  }
+
+  PrintReport(samples, elapsed);
+  return EXIT_SUCCESS;
+}
+
+bool SessionReplayer::LoadTrace() {
+  std::fstream file_stream{config_.command_arguments_[0], std::ios::in};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string line{};
+  while (std::getline(file_stream, line)) {
+    std::stringstream ss{line};
+    SessionEvent event{};
+    if (ss >> event) {
+      events_.push_back(std::move(event));
+    }
+  }
+
+  return !events_.empty();
+}
+
+void SessionReplayer::ReplaySession(const std::uint32_t session_index,
+                                    std::vector<Sample>& samples) const {
+  // Every session works on its own copy of the database, so sessions do not
+  // overwrite each other's files and the original data stays untouched
+  Config session_config{config_};
+  session_config.database_path_ =
+      config_.database_path_ + ".replay" + std::to_string(session_index);
+  session_config.command_.clear();
+  session_config.record_path_.clear();
+  session_config.change_log_path_.clear();
+  session_config.archive_after_months_ = 0U;
+  session_config.replica_ = false;
+  // Sessions work on a copy of a single database
+  session_config.tenants_directory_.clear();
+  session_config.tenant_.clear();
+
+  // Along with the archive and the scores, so that the data is the same as
+  // in the recording
+  utilities::copy_file(config_.database_path_, session_config.database_path_);
+  for (const auto& file : Database::GetFiles()) {
+    if (file.directory_) {
+      copy_directory(config_.database_path_ + file.suffix_,
+                     session_config.database_path_ + file.suffix_);
+    } else {
+      utilities::copy_file(config_.database_path_ + file.suffix_,
+                           session_config.database_path_ + file.suffix_);
+    }
+  }
+
+  std::size_t next_event{};
+  std::uint64_t last_choice_offset_ms{};
+
+  const auto input_source = [this, &next_event, &last_choice_offset_ms](
+                                const bool, std::string& input) {
+    if (next_event >= events_.size()) {
+      return false;
+    }
+
+    const SessionEvent& event = events_[next_event++];
+    if (event.choice_ && config_.replay_speedup_ > 0U) {
+      const std::uint64_t think_time_ms =
+          event.offset_ms_ > last_choice_offset_ms
+              ? event.offset_ms_ - last_choice_offset_ms
+              : 0U;
+      std::this_thread::sleep_for(std::chrono::milliseconds{
+          think_time_ms / config_.replay_speedup_});
+    }
+    if (event.choice_) {
+      last_choice_offset_ms = event.offset_ms_;
+    }
+
+    input = event.input_;
+    return true;
+  };
+
+  const auto command_observer = [&samples](
+                                    const App::ECommand command,
+                                    const App::ESubCommand sub_command,
+                                    const std::chrono::nanoseconds duration) {
+    // The interactions menu is a loop of subcommands, which are timed on
+    // their own
+    if (command == App::ECommand::MANAGE_CUSTOMER_INTERACTIONS &&
+        sub_command == App::ESubCommand::INVALID) {
+      return;
+    }
+
+    samples.push_back(Sample{static_cast<std::uint32_t>(command),
+                             static_cast<std::uint32_t>(sub_command),
+                             duration});
+  };
+
+  {
+    App app{session_config, input_source, command_observer};
+    app.Run();
+  }
+
+  std::remove(session_config.database_path_.c_str());
+  for (const auto& file : Database::GetFiles()) {
+    const std::string path{session_config.database_path_ + file.suffix_};
+    if (file.directory_) {
+      remove_directory(path);
+    } else {
+      std::remove(path.c_str());
+    }
+  }
+}
+
+void SessionReplayer::PrintReport(std::vector<Sample>& samples,
+                                  const std::chrono::nanoseconds elapsed) const {
+  std::map<std::string, std::vector<std::chrono::nanoseconds>> latencies{};
+  for (const auto& sample : samples) {
+    latencies[command_name(sample.command_, sample.sub_command_)].push_back(
+        sample.duration_);
+  }
+
+  const auto percentile = [](const std::vector<std::chrono::nanoseconds>& sorted,
+                             const double rank) {
+    const auto index = static_cast<std::size_t>(
+        rank * static_cast<double>(sorted.size() - 1U) + 0.5);
+    return to_microseconds(sorted[index]);
+  };
+
+  std::cout << "Sessioni: " << config_.replay_concurrency_
+            << ", comandi eseguiti: " << samples.size() << ", durata: "
+            << std::fixed << std::setprecision(1)
+            << to_microseconds(elapsed) / 1000.0 << " ms" << std::endl
+            << std::endl;
+
+  std::cout << std::left << std::setw(40) << "Comando" << std::right
+            << std::setw(8) << "N" << std::setw(12) << "p50 (us)"
+            << std::setw(12) << "p90 (us)" << std::setw(12) << "p99 (us)"
+            << std::setw(12) << "max (us)" << std::endl;
+
+  for (auto& entry : latencies) {
+    auto& durations = entry.second;
+    std::sort(durations.begin(), durations.end());
+
+    std::cout << std::left << std::setw(40) << entry.first << std::right
+              << std::setw(8) << durations.size() << std::setw(12)
+              << percentile(durations, 0.50) << std::setw(12)
+              << percentile(durations, 0.90) << std::setw(12)
+              << percentile(durations, 0.99) << std::setw(12)
+              << to_microseconds(durations.back()) << std::endl;
+  }
+}
@@ -0,0 +1,153 @@
+#ifndef __SESSION_H__
+#define __SESSION_H__
+
+#include <chrono>
+#include <cstdint>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "customers.h"
+#include "utilities.h"
+
+/// @brief A single answer typed by the user during an App session
+struct SessionEvent {
+  /// @brief Milliseconds elapsed since the session started
+  std::uint64_t offset_ms_;
+  /// @brief App::ECommand being executed when the answer was given,
+  /// App::ECommand::INVALID while in the main menu
+  std::uint32_t command_;
+  /// @brief App::ESubCommand being executed when the answer was given,
+  /// App::ESubCommand::INVALID outside of submenus
+  std::uint32_t sub_command_;
+  /// @brief Whether the answer selects a menu entry. Think time is only
+  /// reproduced before these, so command latencies are not affected by it.
+  bool choice_;
+  /// @brief What the user typed
+  std::string input_;
+
+  SessionEvent()
+      : offset_ms_{}, command_{}, sub_command_{}, choice_{false}, input_{} {}
+
+  /// @brief Stream overload to serialize the event into a single line
+  /// @param os Output stream where to serialize the data into
+  /// @param event Event to serialize
+  /// @return Reference to the output stream
+  friend std::ostream& operator<<(std::ostream& os, const SessionEvent& event) {
+    os << event.offset_ms_ << SERIALIZATION_DELIMITER;
+    os << event.command_ << SERIALIZATION_DELIMITER;
+    os << event.sub_command_ << SERIALIZATION_DELIMITER;
+    os << (event.choice_ ? 'C' : 'I') << SERIALIZATION_DELIMITER;
+    os << event.input_ << std::endl;
+    return os;
+  }
+
+  /// @brief Stream overload to deserialize an event from a single line
+  /// @param is Input stream to read the data from
+  /// @param event Event to store the extracted data into
+  /// @return Reference to the input stream, failed on malformed input
+  friend std::istream& operator>>(std::istream& is, SessionEvent& event) {
+    std::string offset{};
+    std::string command{};
+    std::string sub_command{};
+    std::string kind{};
+
+    if (!std::getline(is, offset, SERIALIZATION_DELIMITER) ||
+        !std::getline(is, command, SERIALIZATION_DELIMITER) ||
+        !std::getline(is, sub_command, SERIALIZATION_DELIMITER) ||
+        !std::getline(is, kind, SERIALIZATION_DELIMITER) ||
+        !utilities::try_convert(offset, event.offset_ms_) ||
+        !utilities::try_convert(command, event.command_) ||
+        !utilities::try_convert(sub_command, event.sub_command_)) {
+      is.setstate(std::ios::failbit);
+      return is;
+    }
+
+    event.choice_ = kind == "C";
+    // An empty answer leaves nothing after the last delimiter
+    if (!std::getline(is, event.input_)) {
+      event.input_.clear();
+      is.clear();
+    }
+
+    return is;
+  }
+};
+
+/// @brief Appends every answer typed during an App session to a trace file
+class SessionRecorder {
+ public:
+  // No default, move and copy constructors/operators
+  SessionRecorder() = delete;
+  SessionRecorder(const SessionRecorder&) = delete;
+  SessionRecorder& operator=(const SessionRecorder&) = delete;
+  SessionRecorder(SessionRecorder&&) = delete;
+  SessionRecorder& operator=(SessionRecorder&&) = delete;
+
+  explicit SessionRecorder(const std::string& trace_path);
+
+  /// @brief Records an answer
+  /// @param command App::ECommand being executed
+  /// @param sub_command App::ESubCommand being executed
+  /// @param choice Whether the answer selects a menu entry
+  /// @param input What the user typed
+  void Record(const std::uint32_t command, const std::uint32_t sub_command,
+              const bool choice, const std::string& input);
+
+ private:
+  std::fstream file_stream_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+/// @brief Replays a recorded session trace against the CRM without a
+/// terminal, with several concurrent sessions, and reports how long every
+/// command took.
+class SessionReplayer {
+ public:
+  // No default, move and copy constructors/operators
+  SessionReplayer() = delete;
+  SessionReplayer(const SessionReplayer&) = delete;
+  SessionReplayer& operator=(const SessionReplayer&) = delete;
+  SessionReplayer(SessionReplayer&&) = delete;
+  SessionReplayer& operator=(SessionReplayer&&) = delete;
+
+  /// @brief Prepares the replay
+  /// @param config Options of the replay: database to start from, trace
+  /// file, concurrency and speed-up
+  explicit SessionReplayer(const Config& config);
+
+  /// @brief Replays the trace and prints the latency report
+  /// @return Exit status code
+  std::int32_t Run();
+
+ private:
+  /// @brief Latency of a single executed command
+  struct Sample {
+    std::uint32_t command_;
+    std::uint32_t sub_command_;
+    std::chrono::nanoseconds duration_;
+  };
+
+  /// @brief Loads the trace file
+  /// @return False if the trace cannot be read
+  bool LoadTrace();
+
+  /// @brief Replays the whole trace once, as a single session
+  /// @param session_index Index of the session, used to name its database
+  /// @param samples Where to store the latency of every executed command
+  void ReplaySession(const std::uint32_t session_index,
+                     std::vector<Sample>& samples) const;
+
+  /// @brief Prints latency percentiles grouped by command
+  /// @param samples Latencies collected by all sessions
+  /// @param elapsed Wall-clock duration of the replay
+  void PrintReport(std::vector<Sample>& samples,
+                   const std::chrono::nanoseconds elapsed) const;
+
+  Config config_;
+  std::vector<SessionEvent> events_;
+};
+
+#endif  // __SESSION_H__
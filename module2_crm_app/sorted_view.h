@@ -0,0 +1,126 @@
+#ifndef __SORTED_VIEW_H__
+#define __SORTED_VIEW_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "arena.h"
+#include "customers.h"
+#include "memory_report.h"
+
+/// @brief Customers kept sorted by a key derived from their data, so that
+/// they can be listed in that order, a page or a range at a time, without
+/// sorting anything. The owner keeps the view up to date on every change:
+/// a customer is erased with the key it had and inserted again with the new
+/// one. Entries with the same key are ordered by customer ID.
+/// @tparam Key Sort key
+/// @tparam Compare Order of the keys
+template <typename Key, typename Compare = std::less<Key>>
+class SortedView {
+ public:
+  /// @brief Position of a customer in the view
+  using Entry = std::pair<Key, Customer::ID>;
+
+  // No default, move and copy constructors/operators
+  SortedView() = delete;
+  SortedView(const SortedView&) = delete;
+  SortedView& operator=(const SortedView&) = delete;
+  SortedView(SortedView&&) = delete;
+  SortedView& operator=(SortedView&&) = delete;
+
+  /// @brief Creates an empty view
+  /// @param arena Arena the entries are allocated from
+  explicit SortedView(Arena* arena)
+      : entries_{EntryCompare{}, ArenaAllocator<Entry>{arena}} {}
+
+  /// @brief Adds a customer
+  /// @param key Current key of the customer
+  /// @param id Customer ID
+  void Insert(const Key& key, const Customer::ID id) {
+    entries_.emplace(key, id);
+  }
+
+  /// @brief Removes a customer
+  /// @param key Key the customer was inserted with
+  /// @param id Customer ID
+  void Erase(const Key& key, const Customer::ID id) {
+    entries_.erase(Entry{key, id});
+  }
+
+  /// @brief Replaces every entry of the view
+  /// @param entries New entries, in any order. Sorted in place.
+  void Assign(std::vector<Entry>& entries) {
+    std::sort(entries.begin(), entries.end(), EntryCompare{});
+
+    // Sorted input makes every insertion constant time
+    entries_.clear();
+    for (auto& entry : entries) {
+      entries_.emplace_hint(entries_.end(), std::move(entry));
+    }
+  }
+
+  /// @brief Number of customers in the view
+  /// @return Count
+  std::size_t GetSize() const { return entries_.size(); }
+
+  /// @brief Memory taken by the entries
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const {
+    return entries_.size() * tree_node_size<Entry>();
+  }
+
+  /// @brief Lists the customers that follow an entry of the view
+  /// @param after Entry to start after, nullptr to start from the first one
+  /// @param count Maximum number of customers to list
+  /// @param ids Where to append the IDs of the customers, in view order
+  void Page(const Entry* after, const std::size_t count,
+            std::vector<Customer::ID>& ids) const {
+    auto entry = after != nullptr ? entries_.upper_bound(*after)
+                                  : entries_.cbegin();
+    for (std::size_t listed = 0U; listed < count && entry != entries_.cend();
+         listed++, ++entry) {
+      ids.push_back(entry->second);
+    }
+  }
+
+  /// @brief Lists the customers whose key lies between two bounds
+  /// @param from Key of the first customers to list
+  /// @param to Key of the last customers to list, not before from in the
+  /// order of the view
+  /// @param ids Where to append the IDs of the customers, in view order
+  void Range(const Key& from, const Key& to,
+             std::vector<Customer::ID>& ids) const {
+    const Compare compare{};
+    for (auto entry = entries_.lower_bound(Entry{from, INVALID_CUSTOMER_ID});
+         entry != entries_.cend() && !compare(to, entry->first); ++entry) {
+      ids.push_back(entry->second);
+    }
+  }
+
+  /// @brief Removes every entry
+  void Clear() { entries_.clear(); }
+
+ private:
+  /// @brief Orders the entries by key, then by customer ID
+  struct EntryCompare {
+    bool operator()(const Entry& left, const Entry& right) const {
+      const Compare compare{};
+      if (compare(left.first, right.first)) {
+        return true;
+      }
+      if (compare(right.first, left.first)) {
+        return false;
+      }
+      return left.second < right.second;
+    }
+  };
+
+  std::set<Entry, EntryCompare, ArenaAllocator<Entry>> entries_;
+};
+
+#endif  // __SORTED_VIEW_H__
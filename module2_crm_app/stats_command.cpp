@@ -0,0 +1,94 @@
+#include "stats_command.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <utility>
+
+#include "database.h"
+
+namespace {
+
+/// @brief Categories in the order they are printed, with their labels
+constexpr std::pair<EMemoryCategory, const char*> CATEGORIES[]{
+    {EMemoryCategory::CUSTOMERS, "Clienti"},
+    {EMemoryCategory::INTERACTIONS, "Interazioni"},
+    {EMemoryCategory::STRINGS, "Stringhe"},
+    {EMemoryCategory::INDEXES, "Indici"},
+    {EMemoryCategory::CACHES, "Cache"},
+    {EMemoryCategory::ALLOCATOR, "Allocatore"},
+};
+
+/// @brief Bytes in a mebibyte
+constexpr double MIB{1024.0 * 1024.0};
+
+}  // namespace
+
+StatsCommand::StatsCommand(const Config& config) : config_{config} {}
+
+std::int32_t StatsCommand::Run() {
+  const auto start = std::chrono::steady_clock::now();
+  const Database database{config_.database_path_, true,
+                          config_.storage_engine_};
+  const auto elapsed = std::chrono::duration_cast<std::chrono::milliseconds>(
+      std::chrono::steady_clock::now() - start);
+
+  MemoryReport report{};
+  database.GetMemoryReport(report);
+  std::cout << "Caricamento: " << elapsed.count() << " ms" << std::endl;
+  PrintReport(report);
+
+  if (config_.projected_customers_ == 0U &&
+      config_.projected_interactions_ == 0U) {
+    return EXIT_SUCCESS;
+  }
+
+  if (report.customers_ == 0U) {
+    std::cerr << std::endl
+              << "Impossibile stimare la memoria: il database è vuoto."
+              << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  // A missing target keeps the current interactions per customer
+  std::uint64_t customers = config_.projected_customers_;
+  std::uint64_t interactions = config_.projected_interactions_;
+  if (customers == 0U) {
+    customers = report.interactions_ == 0U
+                    ? report.customers_
+                    : static_cast<std::uint64_t>(
+                          static_cast<double>(interactions) *
+                          report.customers_ / report.interactions_);
+  } else if (interactions == 0U) {
+    interactions = static_cast<std::uint64_t>(
+        static_cast<double>(customers) * report.interactions_ /
+        report.customers_);
+  }
+
+  std::cout << std::endl << "Stima" << std::endl;
+  PrintReport(report.Project(customers, interactions));
+  return EXIT_SUCCESS;
+}
+
+void StatsCommand::PrintReport(const MemoryReport& report) {
+  std::cout << "Clienti: " << report.customers_ << std::endl
+            << "Interazioni in memoria: " << report.interactions_ << std::endl;
+
+  const std::uint64_t total = report.GetTotalBytes();
+  for (const auto& category : CATEGORIES) {
+    const std::uint64_t bytes = report.GetBytes(category.first);
+    std::cout << "  " << std::left << std::setw(12) << category.second
+              << std::right << std::fixed << std::setprecision(1)
+              << std::setw(10) << bytes / MIB << " MiB" << std::setw(7)
+              << (total == 0U ? 0.0 : 100.0 * bytes / total) << "%"
+              << std::endl;
+  }
+  std::cout << "  " << std::left << std::setw(12) << "Totale" << std::right
+            << std::setw(10) << total / MIB << " MiB" << std::endl;
+
+  if (report.customers_ > 0U) {
+    std::cout << "Byte per cliente: " << total / report.customers_
+              << std::endl;
+  }
+}
@@ -0,0 +1,38 @@
+#ifndef __STATS_COMMAND_H__
+#define __STATS_COMMAND_H__
+
+#include <cstdint>
+
+#include "config.h"
+#include "memory_report.h"
+
+/// @brief Loads the database read-only and prints how long it took and how
+/// much memory it holds, by category ("stats"). Optionally projects the
+/// memory of a database with a given number of customers and interactions,
+/// to size the machines before the data grows.
+class StatsCommand {
+ public:
+  // No default, move and copy constructors/operators
+  StatsCommand() = delete;
+  StatsCommand(const StatsCommand&) = delete;
+  StatsCommand& operator=(const StatsCommand&) = delete;
+  StatsCommand(StatsCommand&&) = delete;
+  StatsCommand& operator=(StatsCommand&&) = delete;
+
+  /// @brief Prepares the report
+  /// @param config Database, storage engine and projection targets
+  explicit StatsCommand(const Config& config);
+
+  /// @brief Loads the database and prints the report
+  /// @return Exit status code
+  std::int32_t Run();
+
+ private:
+  /// @brief Prints the memory of every category
+  /// @param report Memory to print
+  static void PrintReport(const MemoryReport& report);
+
+  Config config_;
+};
+
+#endif  // __STATS_COMMAND_H__
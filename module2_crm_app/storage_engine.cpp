@@ -0,0 +1,19 @@
+#include "storage_engine.h"
+
+#include "lsm_storage_engine.h"
+#include "tsv_storage_engine.h"
+
+std::unique_ptr<StorageEngine> StorageEngine::Create(
+    const EStorageEngine type, const std::string& database_path,
+    const bool read_only) {
+  switch (type) {
+    case EStorageEngine::TSV:
+      return std::unique_ptr<StorageEngine>{
+          new TsvStorageEngine{database_path, read_only}};
+    case EStorageEngine::LSM:
+      return std::unique_ptr<StorageEngine>{
+          new LsmStorageEngine{database_path, read_only}};
+    default:
+      return nullptr;
+  }
+}
@@ -0,0 +1,96 @@
+#ifndef __STORAGE_ENGINE_H__
+#define __STORAGE_ENGINE_H__
+
+#include <cstdint>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "changes.h"
+#include "customers.h"
+
+/// @brief Available storage engines
+enum class EStorageEngine : std::uint32_t {
+  /// Single TSV file, rewritten as a whole on every commit
+  TSV = 1,
+  /// Log-structured merge-tree, only writing what changed
+  LSM,
+
+  INVALID = UINT32_MAX,
+};
+
+/// @brief Persists the customers held by the Database.
+///
+/// Every batch of changes is written to the journal by the Database before
+/// it reaches the storage engine, so an engine does not need to make each
+/// batch durable right away: GetDurableSequence() tells which batches it
+/// could lose, and the Database keeps them in the journal until the engine
+/// catches up. After a restart the Database replays those batches on top of
+/// what Load() returned.
+class StorageEngine {
+ public:
+  /// @brief All customers, by ID
+  using Customers = CustomerMap;
+
+  /// @brief Outcome of Verify()
+  struct Verification {
+    /// @brief Records whose checksum matched
+    std::size_t verified_;
+    /// @brief Records written before checksums were introduced
+    std::size_t unchecked_;
+    /// @brief Location of every record whose checksum is missing or wrong,
+    /// as "<file>:<line>"
+    std::vector<std::string> corrupted_;
+  };
+
+  virtual ~StorageEngine() = default;
+
+  /// @brief Creates a storage engine
+  /// @param type Kind of engine
+  /// @param database_path Path of the database, each engine derives the
+  /// name of its files from it
+  /// @param read_only When true, the engine never writes anything
+  /// @return The engine, nullptr if the type is unknown
+  static std::unique_ptr<StorageEngine> Create(const EStorageEngine type,
+                                               const std::string& database_path,
+                                               const bool read_only);
+
+  /// @brief Reads every persisted customer
+  /// @param customers Where to store the customers
+  /// @param sequence Where to store the sequence number of the last batch
+  /// included
+  /// @param last_customer_id Where to store the highest ID ever assigned
+  /// @return False if nothing has been persisted yet or it cannot be read
+  virtual bool Load(Customers& customers, std::uint64_t& sequence,
+                    Customer::ID& last_customer_id) = 0;
+
+  /// @brief Takes note of a batch of changes, already applied to the
+  /// customers
+  /// @param changes Changes of the batch
+  /// @param customers All customers, after the changes
+  virtual void Stage(const std::vector<Change>& changes,
+                     const Customers& customers) = 0;
+
+  /// @brief Gives the engine the chance to write the staged changes
+  /// @param sequence Sequence number of the last staged batch
+  /// @param last_customer_id Highest customer ID ever assigned
+  /// @param customers All customers
+  /// @param force Whether every staged change must be durable afterwards
+  /// @return False if writing failed
+  virtual bool Checkpoint(const std::uint64_t sequence,
+                          const Customer::ID last_customer_id,
+                          const Customers& customers, const bool force) = 0;
+
+  /// @brief Sequence number of the last batch that is durable in the engine
+  /// @return Sequence number
+  virtual std::uint64_t GetDurableSequence() const = 0;
+
+  /// @brief Checks the checksum of every persisted record, without loading
+  /// the customers
+  /// @param verification Where to store the outcome
+  /// @return False if nothing has been persisted yet or it cannot be read
+  virtual bool Verify(Verification& verification) const = 0;
+};
+
+#endif  // __STORAGE_ENGINE_H__
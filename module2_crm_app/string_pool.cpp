@@ -0,0 +1,168 @@
+#include "string_pool.h"
+
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <shared_mutex>
+#include <unordered_map>
+
+namespace {
+
+/// @brief The first chunk holds 2^FIRST_CHUNK_BITS strings, each following
+/// chunk twice as many as the previous one
+constexpr std::uint32_t FIRST_CHUNK_BITS{8U};
+
+/// @brief Enough chunks for every handle
+constexpr std::size_t MAX_CHUNKS{32U - FIRST_CHUNK_BITS};
+
+/// @brief Chunk holding a handle and the position of the string in it
+/// @param handle Handle of the string
+/// @param chunk Where to store the chunk
+/// @param offset Where to store the position in the chunk
+void locate(const StringPool::Handle handle, std::size_t& chunk,
+            std::size_t& offset) {
+  // Chunk k starts at handle 2^FIRST_CHUNK_BITS * (2^k - 1)
+  const std::uint64_t scaled =
+      (static_cast<std::uint64_t>(handle) >> FIRST_CHUNK_BITS) + 1U;
+  chunk = 0U;
+  while ((scaled >> (chunk + 1U)) != 0U) {
+    chunk++;
+  }
+  offset = handle - (((std::uint64_t{1U} << chunk) - 1U) << FIRST_CHUNK_BITS);
+}
+
+/// @brief Number of strings held by a chunk
+std::size_t get_chunk_size(const std::size_t chunk) {
+  return std::size_t{1U} << (FIRST_CHUNK_BITS + chunk);
+}
+
+/// @brief Content of the pool. The chunks are written under the exclusive
+/// lock and read without it: a string is complete before its handle is
+/// handed out, and never changes afterwards.
+struct PoolState {
+  std::shared_mutex mutex_;
+  /// @brief Keys point into the chunks
+  std::unordered_map<std::string_view, StringPool::Handle> handles_;
+  std::array<std::atomic<std::string*>, MAX_CHUNKS> chunks_;
+  /// @brief Strings stored, i.e. the next handle
+  std::size_t size_;
+  std::size_t characters_;
+
+  PoolState() : mutex_{}, handles_{}, chunks_{}, size_{}, characters_{} {
+    for (auto& chunk : chunks_) {
+      chunk.store(nullptr, std::memory_order_relaxed);
+    }
+    Add(std::string_view{});
+  }
+
+  ~PoolState() {
+    for (auto& chunk : chunks_) {
+      delete[] chunk.load(std::memory_order_relaxed);
+    }
+  }
+
+  /// @brief Stores a new string. The exclusive lock must be held.
+  /// @param value String not yet in the pool
+  /// @return Handle of the string
+  StringPool::Handle Add(const std::string_view value) {
+    const auto handle = static_cast<StringPool::Handle>(size_);
+    std::size_t chunk{};
+    std::size_t offset{};
+    locate(handle, chunk, offset);
+
+    std::string* strings = chunks_[chunk].load(std::memory_order_relaxed);
+    if (strings == nullptr) {
+      strings = new std::string[get_chunk_size(chunk)];
+      chunks_[chunk].store(strings, std::memory_order_release);
+    }
+
+    strings[offset].assign(value.data(), value.size());
+    handles_.emplace(std::string_view{strings[offset]}, handle);
+    size_++;
+    characters_ += value.size();
+    return handle;
+  }
+};
+
+PoolState& get_state() {
+  static PoolState state{};
+  return state;
+}
+
+}  // namespace
+
+constexpr StringPool::Handle StringPool::EMPTY_HANDLE;
+
+StringPool::Handle StringPool::Intern(const std::string_view value) {
+  if (value.empty()) {
+    return EMPTY_HANDLE;
+  }
+
+  Handle handle{};
+  if (Find(value, handle)) {
+    return handle;
+  }
+
+  PoolState& state = get_state();
+  std::unique_lock<std::shared_mutex> lock{state.mutex_};
+  // Another thread may have added it in the meantime
+  const auto entry = state.handles_.find(value);
+  if (entry != state.handles_.cend()) {
+    return entry->second;
+  }
+  return state.Add(value);
+}
+
+bool StringPool::Find(const std::string_view value, Handle& handle) {
+  if (value.empty()) {
+    handle = EMPTY_HANDLE;
+    return true;
+  }
+
+  PoolState& state = get_state();
+  std::shared_lock<std::shared_mutex> lock{state.mutex_};
+  const auto entry = state.handles_.find(value);
+  if (entry == state.handles_.cend()) {
+    return false;
+  }
+  handle = entry->second;
+  return true;
+}
+
+const std::string& StringPool::Resolve(const Handle handle) {
+  std::size_t chunk{};
+  std::size_t offset{};
+  locate(handle, chunk, offset);
+  return get_state().chunks_[chunk].load(std::memory_order_acquire)[offset];
+}
+
+StringPool::Stats StringPool::GetStats() {
+  PoolState& state = get_state();
+  std::shared_lock<std::shared_mutex> lock{state.mutex_};
+
+  Stats stats{state.size_, state.characters_, 0U};
+  std::size_t remaining{state.size_};
+  for (std::size_t chunk = 0U; chunk < MAX_CHUNKS && remaining > 0U;
+       chunk++) {
+    const std::string* strings =
+        state.chunks_[chunk].load(std::memory_order_relaxed);
+    const std::size_t chunk_size = get_chunk_size(chunk);
+    stats.reserved_bytes_ += chunk_size * sizeof(std::string);
+
+    // Strings too long for the small string buffer have their own allocation
+    for (std::size_t offset = 0U; offset < chunk_size && remaining > 0U;
+         offset++, remaining--) {
+      const std::string& value = strings[offset];
+      const char* const object = reinterpret_cast<const char*>(&value);
+      if (value.data() < object || value.data() >= object + sizeof(value)) {
+        stats.reserved_bytes_ += value.capacity() + 1U;
+      }
+    }
+  }
+
+  stats.reserved_bytes_ +=
+      state.handles_.bucket_count() * sizeof(void*) +
+      state.handles_.size() *
+          (sizeof(std::string_view) + sizeof(Handle) + 2U * sizeof(void*));
+  return stats;
+}
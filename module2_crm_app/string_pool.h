@@ -0,0 +1,133 @@
+#ifndef __STRING_POOL_H__
+#define __STRING_POOL_H__
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+
+/// @brief Process-wide table of distinct strings, each stored once and
+/// referred to by a small integer handle. Meant for values that repeat a lot
+/// across records, like the names and surnames of the customers: a few
+/// thousand distinct strings for millions of customers.
+///
+/// Strings are never removed and never move once added, so a handle stays
+/// valid for the whole life of the process and resolving it takes no lock.
+/// Adding and looking up strings are serialized by a reader-writer lock, as
+/// any thread may load customers.
+class StringPool {
+ public:
+  /// @brief Integer referring to a string of the pool
+  using Handle = std::uint32_t;
+
+  /// @brief Handle of the empty string, always in the pool
+  static constexpr Handle EMPTY_HANDLE{0U};
+
+  /// @brief Counters describing the content of the pool
+  struct Stats {
+    /// @brief Distinct strings stored, including the empty one
+    std::size_t strings_;
+    /// @brief Characters of all the strings
+    std::size_t characters_;
+    /// @brief Bytes taken by the strings and the lookup table
+    std::size_t reserved_bytes_;
+  };
+
+  // No default, move and copy constructors/operators
+  StringPool() = delete;
+  StringPool(const StringPool&) = delete;
+  StringPool& operator=(const StringPool&) = delete;
+  StringPool(StringPool&&) = delete;
+  StringPool& operator=(StringPool&&) = delete;
+
+  /// @brief Adds a string to the pool, unless already there
+  /// @param value String to add
+  /// @return Handle of the string
+  static Handle Intern(const std::string_view value);
+
+  /// @brief Looks up a string without adding it
+  /// @param value String to look up
+  /// @param handle Where to store the handle of the string
+  /// @return False if the string is not in the pool, in which case no record
+  /// holds it
+  static bool Find(const std::string_view value, Handle& handle);
+
+  /// @brief String referred to by a handle
+  /// @param handle Handle returned by Intern() or Find()
+  /// @return String, valid for the whole life of the process
+  static const std::string& Resolve(const Handle handle);
+
+  /// @brief Snapshot of the counters
+  /// @return Counters
+  static Stats GetStats();
+};
+
+/// @brief String field stored in the StringPool. Copying and comparing for
+/// equality only touch the handle; ordering compares the strings.
+class InternedString {
+ public:
+  InternedString() : handle_{StringPool::EMPTY_HANDLE} {}
+
+  explicit InternedString(const std::string_view value)
+      : handle_{StringPool::Intern(value)} {}
+
+  InternedString& operator=(const std::string_view value) {
+    handle_ = StringPool::Intern(value);
+    return *this;
+  }
+
+  /// @brief Looks up a string already in the pool, e.g. a search filter,
+  /// without growing the pool
+  /// @param value String to look up
+  /// @param result Where to store the interned string
+  /// @return False if no record holds the string
+  static bool Find(const std::string_view value, InternedString& result) {
+    return StringPool::Find(value, result.handle_);
+  }
+
+  /// @brief Text of the string
+  /// @return String stored in the pool
+  const std::string& GetString() const { return StringPool::Resolve(handle_); }
+
+  /// @brief Checks if the string is empty, without resolving it
+  /// @return True if empty
+  bool IsEmpty() const { return handle_ == StringPool::EMPTY_HANDLE; }
+
+  friend bool operator==(const InternedString& left,
+                         const InternedString& right) {
+    return left.handle_ == right.handle_;
+  }
+
+  friend bool operator!=(const InternedString& left,
+                         const InternedString& right) {
+    return left.handle_ != right.handle_;
+  }
+
+  friend bool operator==(const InternedString& left,
+                         const std::string_view right) {
+    return left.GetString() == right;
+  }
+
+  friend bool operator!=(const InternedString& left,
+                         const std::string_view right) {
+    return left.GetString() != right;
+  }
+
+  /// @brief Alphabetical order, for the views sorted by name
+  friend bool operator<(const InternedString& left,
+                        const InternedString& right) {
+    return left.handle_ != right.handle_ &&
+           left.GetString() < right.GetString();
+  }
+
+  friend std::ostream& operator<<(std::ostream& os,
+                                  const InternedString& value) {
+    return os << value.GetString();
+  }
+
+ private:
+  StringPool::Handle handle_;
+};
+
+#endif  // __STRING_POOL_H__
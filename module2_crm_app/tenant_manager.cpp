@@ -0,0 +1,224 @@
+#include "tenant_manager.h"
+
+#include <algorithm>
+#include <cctype>
+#include <iostream>
+
+#include "utilities.h"
+
+TenantManager::TenantManager(const Config& config)
+    : config_{config},
+      mutex_{},
+      tenants_{},
+      closing_{},
+      opening_{},
+      executor_{TENANT_WORKER_THREADS} {
+  if (IsMultiTenant()) {
+    utilities::create_directory(config_.tenants_directory_);
+  }
+}
+
+TenantManager::~TenantManager() {
+  std::lock_guard<std::mutex> lock{mutex_};
+  while (!tenants_.empty()) {
+    Close(tenants_.begin());
+  }
+}
+
+bool TenantManager::IsMultiTenant() const {
+  return !config_.tenants_directory_.empty();
+}
+
+bool TenantManager::IsValidName(const std::string& name) {
+  return !name.empty() &&
+         std::all_of(name.cbegin(), name.cend(), [](const char c) {
+           return std::isalnum(static_cast<unsigned char>(c)) != 0 ||
+                  c == '-' || c == '_';
+         });
+}
+
+std::vector<std::string> TenantManager::ListTenants() const {
+  std::vector<std::string> file_names{};
+  utilities::list_directory(config_.tenants_directory_, file_names);
+
+  const std::string extension{TENANT_DATABASE_EXTENSION};
+  std::vector<std::string> names{};
+  for (const auto& file_name : file_names) {
+    if (file_name.size() > extension.size() &&
+        file_name.compare(file_name.size() - extension.size(),
+                          extension.size(), extension) == 0) {
+      names.push_back(file_name.substr(0, file_name.size() - extension.size()));
+    }
+  }
+
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+std::shared_ptr<CRM> TenantManager::Acquire(const std::string& name) {
+  const std::string key{IsMultiTenant() ? name : std::string{}};
+
+  // Saving and opening a tenant take long: they are waited for without the
+  // lock, so that the other tenants can be used meanwhile
+  std::unique_lock<std::mutex> lock{mutex_};
+  while (true) {
+    const auto now = std::chrono::steady_clock::now();
+    const auto tenant = tenants_.find(key);
+    if (tenant != tenants_.end()) {
+      tenant->second.last_used_ = now;
+
+      // Held by the caller from now on, so it is not evicted
+      std::shared_ptr<CRM> crm{tenant->second.crm_};
+      Evict(now);
+      return crm;
+    }
+
+    // Being saved after it was closed: wait before opening the files again
+    const auto closing = closing_.find(key);
+    if (closing != closing_.end()) {
+      const std::shared_future<void> closed{closing->second};
+      lock.unlock();
+      closed.wait();
+      lock.lock();
+
+      const auto saved = closing_.find(key);
+      if (saved != closing_.end() && IsReady(saved->second)) {
+        closing_.erase(saved);
+      }
+      continue;
+    }
+
+    // Being opened by another caller
+    const auto opening = opening_.find(key);
+    if (opening != opening_.end()) {
+      const std::shared_future<void> opened{opening->second};
+      lock.unlock();
+      opened.wait();
+      lock.lock();
+      continue;
+    }
+
+    std::promise<void> opened{};
+    opening_[key] = opened.get_future().share();
+    lock.unlock();
+    std::shared_ptr<CRM> crm{Open(key)};
+    lock.lock();
+
+    tenants_.emplace(key, Tenant{std::move(crm), now});
+    opening_.erase(key);
+    opened.set_value();
+  }
+}
+
+std::size_t TenantManager::GetOpenTenantCount() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return tenants_.size();
+}
+
+std::uint64_t TenantManager::GetMemoryUsage() const {
+  std::lock_guard<std::mutex> lock{mutex_};
+  return GetMemoryUsageLocked();
+}
+
+std::string TenantManager::GetDatabasePath(const std::string& name) const {
+  if (!IsMultiTenant()) {
+    return config_.database_path_;
+  }
+  return config_.tenants_directory_ + "/" + name + TENANT_DATABASE_EXTENSION;
+}
+
+std::shared_ptr<CRM> TenantManager::Open(const std::string& name) const {
+  auto crm = std::make_shared<CRM>(
+      GetDatabasePath(name), config_.replica_,
+      std::chrono::milliseconds{config_.replica_max_lag_ms_},
+      config_.storage_engine_);
+
+  if (!crm->IsReplica() && config_.archive_after_months_ > 0U &&
+      !crm->ArchiveInteractions(config_.archive_after_months_)) {
+    std::cout << "Impossibile archiviare le interazioni meno recenti."
+              << std::endl;
+  }
+
+  if (!config_.change_log_path_.empty()) {
+    // Every tenant has a change log of its own
+    crm->EnableChangeLog(
+        IsMultiTenant() ? config_.change_log_path_ + "." + name
+                        : config_.change_log_path_,
+        static_cast<std::uint64_t>(config_.change_log_size_mb_) * 1024U * 1024U,
+        CHANGE_LOG_MAX_FILES);
+  }
+
+  return crm;
+}
+
+void TenantManager::Close(std::map<std::string, Tenant>::iterator tenant) {
+  auto closed = std::make_shared<std::promise<void>>();
+  closing_[tenant->first] = closed->get_future().share();
+
+  std::shared_ptr<CRM> crm{std::move(tenant->second.crm_)};
+  tenants_.erase(tenant);
+
+  // The database is saved by its destructor
+  executor_.Submit([crm, closed]() mutable {
+    crm.reset();
+    closed->set_value();
+  });
+}
+
+void TenantManager::Evict(const std::chrono::steady_clock::time_point now) {
+  const auto idle_timeout =
+      std::chrono::seconds{config_.tenant_idle_timeout_s_};
+  const auto is_unused = [](const Tenant& tenant) {
+    return tenant.crm_.use_count() == 1;
+  };
+
+  for (auto tenant = tenants_.begin(); tenant != tenants_.end();) {
+    const auto current = tenant++;
+    if (is_unused(current->second) &&
+        now - current->second.last_used_ >= idle_timeout) {
+      Close(current);
+    }
+  }
+
+  const std::uint64_t memory_budget =
+      static_cast<std::uint64_t>(config_.memory_budget_mb_) * 1024U * 1024U;
+  while (GetMemoryUsageLocked() > memory_budget) {
+    auto least_recently_used = tenants_.end();
+    for (auto tenant = tenants_.begin(); tenant != tenants_.end(); ++tenant) {
+      if (is_unused(tenant->second) &&
+          (least_recently_used == tenants_.end() ||
+           tenant->second.last_used_ <
+               least_recently_used->second.last_used_)) {
+        least_recently_used = tenant;
+      }
+    }
+
+    if (least_recently_used == tenants_.end()) {
+      // Everything left is in use
+      break;
+    }
+    Close(least_recently_used);
+  }
+
+  // Forget the tenants whose save completed meanwhile
+  for (auto closing = closing_.begin(); closing != closing_.end();) {
+    if (IsReady(closing->second)) {
+      closing = closing_.erase(closing);
+    } else {
+      ++closing;
+    }
+  }
+}
+
+bool TenantManager::IsReady(const std::shared_future<void>& future) {
+  return future.wait_for(std::chrono::seconds{0}) ==
+         std::future_status::ready;
+}
+
+std::uint64_t TenantManager::GetMemoryUsageLocked() const {
+  std::uint64_t memory_usage{};
+  for (const auto& tenant : tenants_) {
+    memory_usage += tenant.second.crm_->GetMemoryUsage();
+  }
+  return memory_usage;
+}
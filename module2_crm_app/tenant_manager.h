@@ -0,0 +1,129 @@
+#ifndef __TENANT_MANAGER_H__
+#define __TENANT_MANAGER_H__
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+#include "config.h"
+#include "crm.h"
+#include "executor.h"
+
+/// @brief Extension of the database files of the tenants
+#define TENANT_DATABASE_EXTENSION ".tsv"
+
+/// @brief Threads of the pool saving the tenants being closed
+#define TENANT_WORKER_THREADS 2U
+
+/// @brief Hosts the databases of many tenants (e.g. agencies) in a single
+/// process. With Config::tenants_directory_ set, every tenant has its own
+/// database <directory>/<name>.tsv; otherwise there is a single, unnamed
+/// tenant using Config::database_path_.
+///
+/// Tenants are opened on first use and closed again once they have been
+/// idle for longer than the configured timeout, or when the memory held by
+/// the open tenants exceeds the budget, least recently used first. Tenants
+/// still referenced by a caller are never closed. Closing a tenant saves it
+/// on a worker pool shared by all tenants, so the caller does not wait for
+/// it; reopening it waits for the save to complete. Saving and opening a
+/// tenant never block the callers using the other ones.
+class TenantManager {
+ public:
+  // No default, move and copy constructors/operators
+  TenantManager() = delete;
+  TenantManager(const TenantManager&) = delete;
+  TenantManager& operator=(const TenantManager&) = delete;
+  TenantManager(TenantManager&&) = delete;
+  TenantManager& operator=(TenantManager&&) = delete;
+
+  /// @brief Sets up the manager, no tenant is opened yet
+  /// @param config Runtime options, applied to every tenant
+  explicit TenantManager(const Config& config);
+
+  /// @brief Closes all tenants, waiting for them to be saved
+  ~TenantManager();
+
+  /// @brief Checks whether the databases of several tenants are hosted
+  /// @return True if a tenants directory is configured
+  bool IsMultiTenant() const;
+
+  /// @brief Checks if a string can be used as tenant name: letters, digits,
+  /// '-' and '_' only, so that it maps to a file name
+  /// @param name Tenant name
+  /// @return True if valid
+  static bool IsValidName(const std::string& name);
+
+  /// @brief Lists the tenants having a database in the tenants directory
+  /// @return Tenant names, sorted
+  std::vector<std::string> ListTenants() const;
+
+  /// @brief Gives access to the CRM of a tenant, opening it if needed. Idle
+  /// tenants are closed meanwhile.
+  /// @param name Tenant name, ignored unless IsMultiTenant()
+  /// @return CRM of the tenant, kept open as long as it is referenced
+  std::shared_ptr<CRM> Acquire(const std::string& name);
+
+  /// @brief Number of tenants currently open
+  /// @return Tenant count
+  std::size_t GetOpenTenantCount() const;
+
+  /// @brief Memory held by the open tenants
+  /// @return Bytes
+  std::uint64_t GetMemoryUsage() const;
+
+ private:
+  /// @brief An open tenant
+  struct Tenant {
+    std::shared_ptr<CRM> crm_;
+    std::chrono::steady_clock::time_point last_used_;
+  };
+
+  /// @brief Path of the database of a tenant
+  /// @param name Tenant name
+  std::string GetDatabasePath(const std::string& name) const;
+
+  /// @brief Opens the CRM of a tenant, archiving old interactions and
+  /// enabling the change log as configured
+  /// @param name Tenant name
+  std::shared_ptr<CRM> Open(const std::string& name) const;
+
+  /// @brief Hands a tenant over to the worker pool to be saved and closed.
+  /// mutex_ must be held.
+  /// @param tenant Tenant to close
+  void Close(std::map<std::string, Tenant>::iterator tenant);
+
+  /// @brief Closes the tenants that have been idle for too long, then the
+  /// least recently used ones while over the memory budget. mutex_ must be
+  /// held.
+  /// @param now Current time
+  void Evict(const std::chrono::steady_clock::time_point now);
+
+  /// @brief Memory held by the open tenants. mutex_ must be held.
+  std::uint64_t GetMemoryUsageLocked() const;
+
+  /// @brief Checks, without waiting, if a save or an open has completed
+  /// @param future Completion of the save or of the open
+  /// @return True if completed
+  static bool IsReady(const std::shared_future<void>& future);
+
+  Config config_;
+  mutable std::mutex mutex_;
+  std::map<std::string, Tenant> tenants_;
+
+  /// @brief Completion of the tenants being closed, by name
+  std::map<std::string, std::shared_future<void>> closing_;
+
+  /// @brief Completion of the tenants being opened, by name
+  std::map<std::string, std::shared_future<void>> opening_;
+
+  /// @brief Saves the tenants being closed. Its destructor waits for the
+  /// pending saves, so every tenant is on disk once the manager is gone.
+  Executor executor_;
+};
+
+#endif  // __TENANT_MANAGER_H__
@@ -0,0 +1,94 @@
+#include <ctime>
+#include <memory>
+#include <string>
+
+#include "activity.h"
+#include "check.h"
+#include "customers.h"
+#include "index_file.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Converts a date to a timestamp
+/// @param date Date in DATE_FORMAT
+/// @return UNIX Timestamp
+std::time_t get_timestamp(const char* date) {
+  std::time_t timestamp{};
+  CHECK(utilities::to_timestamp(date, DATE_FORMAT, timestamp));
+  return timestamp;
+}
+
+/// @brief An undated interaction is counted but sets no dates, which the
+/// first dated one does
+void test_undated_first() {
+  ActivitySummary summary{};
+  summary.Add(make_interaction("da definire", "Telefonata"));
+  CHECK(summary.HasInteractions());
+  CHECK(!summary.IsDated());
+  CHECK(summary.recent_count_ == 0U);
+
+  const std::time_t timestamp = get_timestamp("10/01/2024 09:00");
+  summary.Add(make_interaction("10/01/2024 09:00", "Incontro"));
+  CHECK(summary.IsDated());
+  CHECK(summary.interaction_count_ == 2U);
+  CHECK(summary.first_timestamp_ == timestamp);
+  CHECK(summary.last_timestamp_ == timestamp);
+  CHECK(summary.recent_count_ == 1U);
+}
+
+/// @brief Archived interactions set the dates even if undated ones were
+/// counted before
+void test_range_after_undated() {
+  ActivitySummary summary{};
+  summary.Add(make_interaction("da definire", "Telefonata"));
+
+  const std::time_t first = get_timestamp("01/02/2023 10:00");
+  const std::time_t last = get_timestamp("15/03/2023 10:00");
+  summary.AddRange(3U, first, last);
+  summary.Add(make_interaction("senza data", "Email"));
+  CHECK(summary.IsDated());
+  CHECK(summary.interaction_count_ == 5U);
+  CHECK(summary.first_timestamp_ == first);
+  CHECK(summary.last_timestamp_ == last);
+}
+
+/// @brief Whether a summary is dated survives the index file
+void test_index_file() {
+  const std::string path =
+      check::make_empty_directory("activity_summary_test_files") + "/index";
+  CustomerMap customers{};
+  customers.emplace(2U, Customer{2U, "Mario", "Rossi"});
+  customers.emplace(3U, Customer{3U, "Luigi", "Verdi"});
+  customers.at(2U).customer_interactions_.push_back(
+      make_interaction("da definire", "Telefonata"));
+  customers.at(3U).customer_interactions_.push_back(
+      make_interaction("10/01/2024 09:00", "Incontro"));
+
+  ActivityMap activity{};
+  for (const auto& entry : customers) {
+    activity[entry.first].Add(entry.second.customer_interactions_.front());
+  }
+
+  const IndexFile index_file{path};
+  IndexFile::Index name_index{};
+  IndexFile::Index surname_index{};
+  CHECK(index_file.Save(1U, customers, name_index, surname_index, activity));
+
+  ActivityMap loaded{};
+  CHECK(index_file.Load(1U, customers, name_index, surname_index, loaded));
+  CHECK(loaded.size() == 2U);
+  CHECK(loaded[2U].interaction_count_ == 1U && !loaded[2U].IsDated());
+  CHECK(loaded[3U].IsDated() &&
+        loaded[3U].first_timestamp_ == get_timestamp("10/01/2024 09:00"));
+  CHECK(loaded[3U].recent_count_ == 1U);
+}
+
+}  // namespace
+
+int main() {
+  test_undated_first();
+  test_range_after_undated();
+  test_index_file();
+  return check::exit_code();
+}
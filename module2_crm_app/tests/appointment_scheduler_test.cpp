@@ -0,0 +1,171 @@
+#include <ctime>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "appointment_scheduler.h"
+#include "check.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Seconds in an hour
+constexpr std::time_t HOUR{60 * 60};
+
+/// @brief Date the tests start from
+std::time_t get_start() {
+  std::time_t start{};
+  utilities::to_timestamp("15/06/2030 09:00", DATE_FORMAT, start);
+  return start;
+}
+
+/// @brief A scheduler driven by a simulated clock, recording the customers
+/// it reminds of. The reminders run without the background thread, so they
+/// are only sent when the test checks them.
+struct Fixture {
+  std::time_t now_;
+  std::vector<Customer::ID> reminded_;
+  AppointmentScheduler scheduler_;
+
+  Fixture()
+      : now_{get_start()}, reminded_{}, scheduler_{[this]() { return now_; }} {}
+
+  /// @brief Starts the reminders, recording them
+  /// @param lead_time Seconds before the appointment the reminder is sent
+  void Start(const std::time_t lead_time) {
+    scheduler_.StartReminders(
+        lead_time,
+        [this](const Appointment& due) {
+          reminded_.push_back(due.customer_id_);
+        },
+        false);
+  }
+
+  /// @brief Moves the clock and sends the reminders due
+  /// @param now New time
+  /// @param sent_count Reminders expected to be sent by this check
+  /// @return Customers reminded of so far, in order
+  std::vector<Customer::ID> CheckAt(const std::time_t now,
+                                    const std::size_t sent_count) {
+    now_ = now;
+    CHECK(scheduler_.CheckReminders() == sent_count);
+    return reminded_;
+  }
+};
+
+/// @brief Adds a customer with an appointment
+/// @param customers Where to add the customer
+/// @param id Customer ID
+/// @param when Date of the appointment
+/// @return The appointment
+std::shared_ptr<Interaction> add_appointment(CustomerMap& customers,
+                                             const Customer::ID id,
+                                             const std::time_t when) {
+  const InteractionDetails details{EInteractionKind::APPOINTMENT};
+  auto interaction = make_interaction(
+      Interaction::FormatWhen(utilities::to_date(when, DATE_FORMAT), details),
+      "Incontro");
+  auto customer = customers.find(id);
+  if (customer == customers.end()) {
+    customer = customers.emplace(id, Customer{id, "Nome", "Cognome"}).first;
+  }
+  customer->second.customer_interactions_.push_back(interaction);
+  return interaction;
+}
+
+/// @brief Reminders are sent lead_time before the appointment, earliest
+/// first, and only once
+void test_reminders_in_order() {
+  const std::time_t start = get_start();
+  CustomerMap customers{};
+  add_appointment(customers, 2U, start + 2 * HOUR);
+  add_appointment(customers, 3U, start + HOUR + HOUR / 2);
+  add_appointment(customers, 4U, start + 3 * HOUR);
+
+  Fixture fixture{};
+  fixture.scheduler_.Rebuild(customers);
+  fixture.Start(HOUR);
+
+  CHECK(fixture.CheckAt(start, 0U).empty());
+  CHECK(fixture.CheckAt(start + HOUR / 2 - 60, 0U).empty());
+  CHECK((fixture.CheckAt(start + HOUR / 2, 1U) ==
+         std::vector<Customer::ID>{3U}));
+  CHECK((fixture.CheckAt(start + 2 * HOUR, 2U) ==
+         std::vector<Customer::ID>{3U, 2U, 4U}));
+  CHECK(fixture.CheckAt(start + 3 * HOUR, 0U).size() == 3U);
+}
+
+/// @brief The reminders of a removed customer are dropped
+void test_removed_customer() {
+  const std::time_t start = get_start();
+  CustomerMap customers{};
+
+  Fixture fixture{};
+  fixture.Start(HOUR);
+  fixture.scheduler_.Add(2U, add_appointment(customers, 2U, start + 2 * HOUR));
+  fixture.scheduler_.Add(3U, add_appointment(customers, 3U, start + 2 * HOUR));
+  CHECK(fixture.scheduler_.GetSize() == 2U);
+
+  fixture.scheduler_.RemoveCustomer(customers.at(2U));
+  customers.erase(2U);
+  CHECK(fixture.scheduler_.GetSize() == 1U);
+  CHECK((fixture.CheckAt(start + HOUR, 1U) == std::vector<Customer::ID>{3U}));
+}
+
+/// @brief A rebuild does not send again the reminders sent already, but
+/// still sends the ones that became due since the last check
+void test_rebuild() {
+  const std::time_t start = get_start();
+  CustomerMap customers{};
+  add_appointment(customers, 2U, start + HOUR);
+  add_appointment(customers, 3U, start + 2 * HOUR);
+
+  Fixture fixture{};
+  fixture.scheduler_.Rebuild(customers);
+  fixture.Start(HOUR);
+  CHECK((fixture.CheckAt(start, 1U) == std::vector<Customer::ID>{2U}));
+
+  // Due, but not checked yet
+  fixture.now_ = start + HOUR;
+  fixture.scheduler_.Rebuild(customers);
+  CHECK((fixture.CheckAt(start + HOUR, 1U) ==
+         std::vector<Customer::ID>{2U, 3U}));
+
+  fixture.scheduler_.Rebuild(customers);
+  CHECK(fixture.CheckAt(start + HOUR + 60, 0U).size() == 2U);
+}
+
+/// @brief Appointments are kept for a day after they are held
+void test_past_appointments_dropped() {
+  const std::time_t start = get_start();
+  CustomerMap customers{};
+  add_appointment(customers, 2U, start);
+  add_appointment(customers, 3U, start + HOUR);
+
+  Fixture fixture{};
+  fixture.scheduler_.Rebuild(customers);
+  CHECK(fixture.scheduler_.GetSize() == 2U);
+
+  fixture.now_ = start + 24 * HOUR;
+  fixture.scheduler_.CheckReminders();
+  CHECK(fixture.scheduler_.GetSize() == 2U);
+
+  fixture.now_ = start + 24 * HOUR + 60;
+  fixture.scheduler_.CheckReminders();
+  CHECK(fixture.scheduler_.GetSize() == 1U);
+
+  std::vector<Appointment> appointments{};
+  fixture.scheduler_.GetAppointments(start - HOUR, start + 2 * HOUR, 10U,
+                                     appointments);
+  CHECK(appointments.size() == 1U && appointments[0].customer_id_ == 3U);
+}
+
+}  // namespace
+
+int main() {
+  test_reminders_in_order();
+  test_removed_customer();
+  test_rebuild();
+  test_past_appointments_dropped();
+  return check::exit_code();
+}
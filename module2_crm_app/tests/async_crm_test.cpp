@@ -0,0 +1,114 @@
+#include <filesystem>
+#include <future>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "async_crm.h"
+#include "check.h"
+#include "crm.h"
+#include "database.h"
+
+namespace {
+
+/// @brief Checks whether a future holds a given exception
+/// @tparam Exception Type of the exception expected
+/// @param future Future to check
+/// @return True if getting the result throws the exception
+template <typename Exception, typename Result>
+bool throws(std::future<Result>& future) {
+  try {
+    future.get();
+  } catch (const Exception&) {
+    return true;
+  } catch (...) {
+  }
+  return false;
+}
+
+/// @brief Writes queued without waiting are applied in order and persisted
+void test_pipelined_writes() {
+  const std::string path =
+      check::make_empty_directory("async_crm_test_files") + "/pipelined";
+  constexpr Customer::ID COUNT{20U};
+  {
+    AsyncCRM crm{path, 4U};
+    std::vector<std::future<bool>> added{};
+    for (Customer::ID i = 0U; i < COUNT; i++) {
+      added.push_back(crm.AddCustomer("Nome", "Cognome" + std::to_string(i)));
+    }
+    for (auto& result : added) {
+      CHECK(result.get());
+    }
+
+    // First ID is 2, assigned in submission order
+    auto interaction = crm.AddInteraction(COUNT + 1U, "10/01/2024 09:00",
+                                          "Ultimo cliente");
+    CHECK(interaction.get());
+    CHECK(crm.HasCustomer(2U).get());
+    CHECK(crm.HasCustomer(COUNT + 1U).get());
+    CHECK(!crm.HasCustomer(COUNT + 2U).get());
+  }
+
+  const CRM reopened{path};
+  CHECK(reopened.HasCustomer(COUNT + 1U));
+}
+
+/// @brief The writes of a batch that cannot be journaled stay applied, are
+/// reported as pending and are persisted with the next batch
+void test_failed_flush() {
+  const std::string path =
+      check::make_empty_directory("async_crm_test_files") + "/failed";
+  const std::string journal_path = path + DATABASE_JOURNAL_SUFFIX;
+  {
+    AsyncCRM crm{path, 2U};
+    auto first = crm.AddCustomer("Mario", "Rossi");
+    CHECK(first.get());
+
+    // The journal can no longer be opened for writing
+    std::filesystem::remove(journal_path);
+    std::filesystem::create_directory(journal_path);
+    auto pending = crm.AddCustomer("Luigi", "Verdi");
+    CHECK(throws<AsyncCRM::PendingWrite>(pending));
+    CHECK(crm.HasCustomer(3U).get());
+
+    std::filesystem::remove(journal_path);
+    auto next = crm.AddCustomer("Anna", "Bianchi");
+    CHECK(next.get());
+  }
+
+  const CRM reopened{path};
+  CHECK(reopened.HasCustomer(2U));
+  CHECK(reopened.HasCustomer(3U));
+  CHECK(reopened.HasCustomer(4U));
+}
+
+/// @brief An exception thrown by a read or a write reaches its caller and
+/// leaves the other requests alone
+void test_throwing_requests() {
+  const std::string path =
+      check::make_empty_directory("async_crm_test_files") + "/throwing";
+  AsyncCRM crm{path, 2U};
+
+  auto read = crm.Read([](const CRM&) -> bool {
+    throw std::runtime_error{"Lettura fallita"};
+  });
+  CHECK(throws<std::runtime_error>(read));
+
+  auto write = crm.Write([](CRM&) -> bool {
+    throw std::runtime_error{"Scrittura fallita"};
+  });
+  auto added = crm.AddCustomer("Mario", "Rossi");
+  CHECK(throws<std::runtime_error>(write));
+  CHECK(added.get());
+  CHECK(crm.HasCustomer(2U).get());
+}
+
+}  // namespace
+
+int main() {
+  test_pipelined_writes();
+  test_failed_flush();
+  test_throwing_requests();
+  return check::exit_code();
+}
@@ -0,0 +1,42 @@
+#ifndef __CHECK_H__
+#define __CHECK_H__
+
+#include <cstdlib>
+#include <filesystem>
+#include <iostream>
+#include <string>
+
+/// @brief Minimal support for the test executables: every failed check is
+/// reported on stderr and makes the test fail, without stopping it.
+namespace check {
+
+/// @brief Number of checks failed so far
+inline int failures{0};
+
+/// @brief Exit code of the test executable
+/// @return EXIT_SUCCESS if every check passed, EXIT_FAILURE otherwise
+inline int exit_code() { return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE; }
+
+/// @brief Creates an empty directory for the files of a test, in the
+/// working directory, dropping whatever a previous run left there
+/// @param name Name of the directory
+/// @return Path of the directory
+inline std::string make_empty_directory(const std::string& name) {
+  std::filesystem::remove_all(name);
+  std::filesystem::create_directory(name);
+  return name;
+}
+
+}  // namespace check
+
+/// @brief Checks a condition, reporting where it failed
+#define CHECK(condition)                                                \
+  do {                                                                  \
+    if (!(condition)) {                                                 \
+      check::failures++;                                                \
+      std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #condition \
+                << ") failed" << std::endl;                             \
+    }                                                                   \
+  } while (false)
+
+#endif  // __CHECK_H__
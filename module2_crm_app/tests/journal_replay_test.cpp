@@ -0,0 +1,143 @@
+#include <limits>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "changes.h"
+#include "check.h"
+#include "database.h"
+#include "journal.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief A removal carries no second field: reading it back must neither
+/// fail the stream nor lose the change
+void test_parse_removal() {
+  std::stringstream line{};
+  line << Change{Change::EType::REMOVE_CUSTOMER, 42U};
+
+  std::string serialized{};
+  std::getline(line, serialized);
+  std::stringstream ss{serialized};
+  Change change{};
+  CHECK(static_cast<bool>(ss >> change));
+  CHECK(change.type_ == Change::EType::REMOVE_CUSTOMER);
+  CHECK(change.id_ == 42U);
+  CHECK(change.first_.empty());
+  CHECK(change.second_.empty());
+}
+
+/// @brief Checks that the only interaction of a customer is dated
+/// @param database Database holding the customer
+/// @param id Customer ID
+/// @param date Expected date, in DATE_FORMAT
+/// @return True if the interaction has the timestamp of the date
+bool has_interaction_on(const Database& database, const Customer::ID id,
+                        const char* date) {
+  std::time_t expected{};
+  CHECK(utilities::to_timestamp(date, DATE_FORMAT, expected));
+  const auto& interactions = database.GetCustomer(id).customer_interactions_;
+  return interactions.size() == 1U && interactions[0]->dated_ &&
+         interactions[0]->timestamp_ == expected;
+}
+
+/// @brief A batch removing a customer is replayed by a replica following the
+/// journal, and on the next load
+void test_replay_removal_batch() {
+  const std::string path{
+      check::make_empty_directory("journal_replay_test_files") + "/crm.tsv"};
+
+  Database primary{path};
+  const Customer::ID kept = primary.AddCustomer("Anna", "Rossi");
+  const Customer::ID removed = primary.AddCustomer("Bruno", "Bianchi");
+  CHECK(primary.AddInteraction(removed, "10/01/2024 09:00", "telefonata"));
+
+  Database replica{path, true};
+  CHECK(replica.HasCustomer(removed));
+  CHECK(has_interaction_on(replica, removed, "10/01/2024 09:00"));
+
+  // Dated interactions are replayed with their timestamp
+  CHECK(primary.AddInteraction(kept, "12/01/2024 15:30", "incontro"));
+  CHECK(replica.CatchUp());
+  CHECK(has_interaction_on(replica, kept, "12/01/2024 15:30"));
+
+  // Removal and new customer in a single batch
+  Transaction transaction = primary.BeginTransaction();
+  transaction.RemoveCustomer(removed);
+  const Customer::ID added = transaction.AddCustomer("Carla", "Verdi");
+  CHECK(primary.CommitTransaction(transaction));
+  CHECK(!primary.HasCustomer(removed));
+
+  CHECK(replica.CatchUp());
+  CHECK(replica.GetSequence() == primary.GetSequence());
+  CHECK(replica.HasCustomer(kept));
+  CHECK(!replica.HasCustomer(removed));
+  CHECK(replica.HasCustomer(added));
+  CHECK(replica.GetCustomersBySurname("Bianchi").empty());
+
+  // A single removal, persisted on its own
+  CHECK(primary.RemoveCustomer(kept));
+  CHECK(!primary.RemoveCustomer(kept));
+  CHECK(replica.CatchUp());
+  CHECK(!replica.HasCustomer(kept));
+
+  Database reloaded{path, true};
+  CHECK(reloaded.GetSequence() == primary.GetSequence());
+  CHECK(!reloaded.HasCustomer(kept));
+  CHECK(!reloaded.HasCustomer(removed));
+  CHECK(reloaded.HasCustomer(added));
+}
+
+/// @brief Counts the interactions of a customer read without loading the
+/// database
+/// @param path Path of the database
+/// @param id Customer ID
+/// @return Number of interactions, 0 if the customer was not found
+std::size_t count_read_interactions(const std::string& path,
+                                    const Customer::ID id) {
+  std::vector<std::shared_ptr<Interaction>> interactions{};
+  CHECK(Database::ReadCustomerInteractions(
+      path, EStorageEngine::LSM, id, 0, std::numeric_limits<std::time_t>::max(),
+      interactions));
+  return interactions.size();
+}
+
+/// @brief Reading a single customer follows the journal batches only as
+/// long as they are in sequence, as loading the database does
+void test_read_customer_after_gap() {
+  const std::string path{
+      check::make_empty_directory("journal_replay_test_files") + "/crm"};
+
+  Customer::ID id{};
+  std::uint64_t sequence{};
+  {
+    Database primary{path, false, EStorageEngine::LSM};
+    id = primary.AddCustomer("Anna", "Rossi");
+    CHECK(primary.AddInteraction(id, "10/01/2024 09:00", "telefonata"));
+    sequence = primary.GetSequence();
+  }
+  CHECK(count_read_interactions(path, id) == 1U);
+
+  Journal journal{path + DATABASE_JOURNAL_SUFFIX};
+  CHECK(journal.Append(sequence + 1U, {Change{Change::EType::ADD_INTERACTION,
+                                              id, "11/01/2024 09:00",
+                                              "email"}}));
+  CHECK(count_read_interactions(path, id) == 2U);
+
+  // Batches are missing in between, e.g. the journal was reset meanwhile
+  CHECK(journal.Append(sequence + 3U, {Change{Change::EType::ADD_INTERACTION,
+                                              id, "12/01/2024 09:00",
+                                              "incontro"}}));
+  CHECK(count_read_interactions(path, id) == 2U);
+}
+
+}  // namespace
+
+int main() {
+  test_parse_removal();
+  test_replay_removal_batch();
+  test_read_customer_after_gap();
+  return check::exit_code();
+}
@@ -0,0 +1,157 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "changes.h"
+#include "check.h"
+#include "lsm_storage_engine.h"
+
+namespace {
+
+/// @brief Applies changes to the customers, then writes them into a segment
+/// of their own
+void flush(LsmStorageEngine& engine, CustomerMap& customers,
+           std::uint64_t& sequence, const std::vector<Change>& changes) {
+  Customer::ID last_customer_id{};
+  for (const auto& change : changes) {
+    if (change.type_ == Change::EType::REMOVE_CUSTOMER) {
+      customers.erase(change.id_);
+    } else {
+      customers.erase(change.id_);
+      customers.emplace(change.id_,
+                        Customer{change.id_, change.first_, change.second_});
+    }
+    last_customer_id = std::max(last_customer_id, change.id_);
+  }
+
+  engine.Stage(changes, customers);
+  CHECK(engine.Checkpoint(++sequence, last_customer_id, customers, true));
+}
+
+/// @brief Waits for the compaction thread to merge every segment
+bool wait_for_compaction(const LsmStorageEngine& engine) {
+  for (int i = 0; i < 1000 && engine.GetSegmentCount() > 1U; i++) {
+    std::this_thread::sleep_for(std::chrono::milliseconds{10});
+  }
+  return engine.GetSegmentCount() == 1U;
+}
+
+/// @brief Segments replaced by a compaction stay on disk until the next one,
+/// and loading only keeps the newest version of every customer
+void test_compaction_keeps_inputs() {
+  const std::string path{
+      check::make_empty_directory("lsm_storage_engine_test_files") +
+      "/crm.tsv"};
+  const std::string directory{path + ".lsm/"};
+
+  CustomerMap customers{};
+  std::uint64_t sequence{};
+  {
+    LsmStorageEngine engine{path, false};
+    for (Customer::ID id = 1U; id <= 4U; id++) {
+      flush(engine, customers, sequence,
+            {Change{Change::EType::ADD_CUSTOMER, id,
+                    "Nome" + std::to_string(id), "Cognome"},
+             Change{Change::EType::UPDATE_CUSTOMER, 1U,
+                    "Anna" + std::to_string(id), "Rossi"}});
+    }
+    CHECK(wait_for_compaction(engine));
+    CHECK(std::filesystem::exists(directory + "1.sst"));
+    CHECK(std::filesystem::exists(directory + "4.sst"));
+
+    flush(engine, customers, sequence,
+          {Change{Change::EType::REMOVE_CUSTOMER, 2U}});
+    for (Customer::ID id = 5U; id <= 6U; id++) {
+      flush(engine, customers, sequence,
+            {Change{Change::EType::ADD_CUSTOMER, id,
+                    "Nome" + std::to_string(id), "Cognome"}});
+    }
+    CHECK(wait_for_compaction(engine));
+    CHECK(!std::filesystem::exists(directory + "1.sst"));
+    CHECK(!std::filesystem::exists(directory + "4.meta"));
+    CHECK(std::filesystem::exists(directory + "5.sst"));
+
+    Customer customer{};
+    CHECK(engine.Get(1U, customer));
+    CHECK(customer.name_.GetString() == "Anna4");
+    CHECK(!engine.Get(2U, customer));
+  }
+
+  LsmStorageEngine reader{path, true};
+  CustomerMap loaded{};
+  std::uint64_t loaded_sequence{};
+  Customer::ID last_customer_id{};
+  CHECK(reader.Load(loaded, loaded_sequence, last_customer_id));
+  CHECK(loaded_sequence == sequence);
+  CHECK(last_customer_id == 6U);
+  CHECK(loaded.size() == customers.size());
+  CHECK(loaded.count(2U) == 0U);
+  CHECK(loaded.count(1U) == 1U &&
+        loaded.at(1U).name_.GetString() == "Anna4");
+}
+
+/// @brief Replaces the first occurrence of a text in a file
+void corrupt_file(const std::string& path, const std::string& text,
+                  const std::string& replacement) {
+  std::stringstream content{};
+  content << std::ifstream{path}.rdbuf();
+  std::string data{content.str()};
+  const std::size_t position = data.find(text);
+  CHECK(position != std::string::npos);
+  data.replace(position, text.size(), replacement);
+  std::ofstream{path, std::ios::trunc} << data;
+}
+
+/// @brief A corrupted record hides the older versions of its customer, and
+/// one that cannot be attributed to a customer fails the load
+void test_corrupted_records() {
+  const std::string path{
+      check::make_empty_directory("lsm_storage_engine_test_files") +
+      "/crm.tsv"};
+  const std::string directory{path + ".lsm/"};
+
+  CustomerMap customers{};
+  std::uint64_t sequence{};
+  {
+    LsmStorageEngine engine{path, false};
+    flush(engine, customers, sequence,
+          {Change{Change::EType::ADD_CUSTOMER, 1U, "Anna", "Rossi"},
+           Change{Change::EType::ADD_CUSTOMER, 2U, "Bruno", "Bianchi"}});
+    flush(engine, customers, sequence,
+          {Change{Change::EType::UPDATE_CUSTOMER, 1U, "Anna", "Verdi"},
+           Change{Change::EType::UPDATE_CUSTOMER, 2U, "Bruno", "Neri"}});
+  }
+  corrupt_file(directory + "2.sst", "Verdi", "Vxrdi");
+
+  {
+    LsmStorageEngine reader{path, true};
+    CustomerMap loaded{};
+    Customer::ID last_customer_id{};
+    CHECK(reader.Load(loaded, sequence, last_customer_id));
+    CHECK(loaded.count(1U) == 0U);
+    CHECK(loaded.count(2U) == 1U &&
+          loaded.at(2U).surname_.GetString() == "Neri");
+
+    Customer customer{};
+    CHECK(!reader.Get(1U, customer));
+  }
+
+  corrupt_file(directory + "2.sst", "P\t2\t", "P\tx\t");
+  LsmStorageEngine reader{path, true};
+  CustomerMap loaded{};
+  Customer::ID last_customer_id{};
+  CHECK(!reader.Load(loaded, sequence, last_customer_id));
+  CHECK(loaded.empty());
+}
+
+}  // namespace
+
+int main() {
+  test_compaction_keeps_inputs();
+  test_corrupted_records();
+  return check::exit_code();
+}
@@ -0,0 +1,71 @@
+#include <iostream>
+#include <sstream>
+#include <string>
+
+#include "check.h"
+#include "database.h"
+#include "query_command.h"
+
+namespace {
+
+/// @brief Runs a query command, capturing what it prints
+/// @param config Command and filters
+/// @param output Where to store what is printed to standard output
+/// @return Exit status code of the command
+std::int32_t run(const Config& config, std::string& output) {
+  std::ostringstream captured{};
+  std::streambuf* const previous = std::cout.rdbuf(captured.rdbuf());
+  QueryCommand command{config};
+  const std::int32_t status = command.Run();
+  std::cout.rdbuf(previous);
+  output = captured.str();
+  return status;
+}
+
+/// @brief --explain prints the access path chosen, the candidates expected
+/// and the filters left, in both formats
+void test_explain() {
+  const std::string path{
+      check::make_empty_directory("query_command_test_files") + "/crm.tsv"};
+  {
+    Database database{path, false, EStorageEngine::TSV};
+    database.AddCustomer("Anna", "Rossi");
+    database.AddCustomer("Anna", "Bianchi");
+    database.AddCustomer("Marco", "Rossi");
+  }
+
+  Config config{};
+  config.command_ = "find";
+  config.database_path_ = path;
+  config.explain_ = true;
+  config.filter_name_ = "Anna";
+  config.filter_text_ = "polizza";
+
+  std::string output{};
+  CHECK(run(config, output) == EXIT_SUCCESS);
+  CHECK(output ==
+        "access_path\testimated_candidates\tresidual_filters\n"
+        "name index\t2\ttext\n");
+
+  config.command_ = "count";
+  config.filter_surname_ = "Rossi";
+  config.filter_text_.clear();
+  config.output_format_ = EOutputFormat::JSON;
+  CHECK(run(config, output) == EXIT_SUCCESS);
+  CHECK(output ==
+        "{\"access_path\": \"name index + surname index intersection\", "
+        "\"estimated_candidates\": 2, \"residual_filters\": []}\n");
+
+  // Nothing to plan for a point lookup of interactions
+  config.command_ = "interactions";
+  config.filter_id_ = "2";
+  CHECK(run(config, output) == EXIT_FAILURE);
+  CHECK(output.empty());
+}
+
+}  // namespace
+
+int main() {
+  test_explain();
+  return check::exit_code();
+}
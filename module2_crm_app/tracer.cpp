@@ -0,0 +1,258 @@
+#include "tracer.h"
+
+#include <atomic>
+#include <csignal>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <pthread.h>
+
+#include "ring_buffer.h"
+
+namespace {
+
+/// @brief A completed span
+struct TraceEvent {
+  const char* category_;
+  const char* name_;
+  /// @brief Nanoseconds since the trace epoch
+  std::int64_t start_ns_;
+  std::int64_t duration_ns_;
+};
+
+/// @brief Spans recorded by a single thread, waiting to be written out
+struct ThreadBuffer {
+  /// @brief Number identifying the thread in the trace
+  std::uint32_t thread_id_;
+  /// @brief Written by the thread, read by whoever flushes
+  RingBuffer<TraceEvent> events_;
+  /// @brief Spans lost because the buffer was full
+  std::atomic<std::uint64_t> dropped_;
+
+  explicit ThreadBuffer(const std::uint32_t thread_id)
+      : thread_id_{thread_id}, events_{TRACE_BUFFER_EVENTS}, dropped_{0U} {}
+};
+
+/// @brief Everything shared by the threads, guarded by mutex_ except for the
+/// contents of the buffers
+struct TraceState {
+  std::mutex mutex_;
+  std::vector<std::shared_ptr<ThreadBuffer>> buffers_;
+  std::uint32_t next_thread_id_;
+  std::string path_;
+  std::ofstream file_;
+  /// @brief Whether an event has been written since the file was created
+  bool has_events_;
+  /// @brief Origin of the timestamps of the trace
+  std::chrono::steady_clock::time_point epoch_;
+  /// @brief Serves SIGUSR1, not guarded by mutex_: it is only started and
+  /// stopped by the main thread
+  std::thread signal_thread_;
+  /// @brief Set to ask the signal thread to stop
+  std::atomic<bool> signal_stopping_;
+
+  TraceState()
+      : mutex_{},
+        buffers_{},
+        next_thread_id_{1U},
+        path_{DEFAULT_TRACE_PATH},
+        file_{},
+        has_events_{false},
+        epoch_{std::chrono::steady_clock::now()},
+        signal_thread_{},
+        signal_stopping_{false} {}
+
+  ~TraceState();
+};
+
+/// @brief Whether spans are recorded
+std::atomic<bool> tracing_enabled{false};
+
+TraceState& get_state() {
+  static TraceState state{};
+  return state;
+}
+
+/// @brief Buffer of the calling thread, registered on first use
+ThreadBuffer& get_thread_buffer() {
+  thread_local std::shared_ptr<ThreadBuffer> buffer{};
+  if (!buffer) {
+    TraceState& state = get_state();
+    std::lock_guard<std::mutex> lock{state.mutex_};
+    buffer = std::make_shared<ThreadBuffer>(state.next_thread_id_++);
+    state.buffers_.push_back(buffer);
+  }
+  return *buffer;
+}
+
+#ifdef SIGUSR1
+/// @brief Body of the signal thread: every SIGUSR1 turns tracing on or off
+/// and writes out the spans buffered so far, so that they can be read
+/// without waiting for the next command
+/// @param signals Set holding SIGUSR1, blocked in every thread
+void serve_toggle_signal(const sigset_t signals) {
+  TraceState& state = get_state();
+  int signal_number{0};
+  while (sigwait(&signals, &signal_number) == 0 &&
+         !state.signal_stopping_.load()) {
+    tracing_enabled.store(!tracing_enabled.load(std::memory_order_relaxed),
+                          std::memory_order_relaxed);
+    Tracer::Flush();
+  }
+}
+#endif
+
+/// @brief Stops the signal thread, if running
+/// @param state Shared state
+void stop_signal_thread(TraceState& state) {
+  if (!state.signal_thread_.joinable()) {
+    return;
+  }
+  state.signal_stopping_.store(true);
+#ifdef SIGUSR1
+  pthread_kill(state.signal_thread_.native_handle(), SIGUSR1);
+#endif
+  state.signal_thread_.join();
+}
+
+TraceState::~TraceState() { stop_signal_thread(*this); }
+
+/// @brief Writes an event to the trace file, creating it if needed. The
+/// mutex of the state must be held.
+/// @param state Shared state
+/// @param event Event as a JSON object
+void write_event(TraceState& state, const char* event) {
+  if (!state.file_.is_open()) {
+    state.file_.open(state.path_, std::ios::out | std::ios::trunc);
+    state.file_ << '[';
+    state.has_events_ = false;
+  }
+
+  state.file_ << (state.has_events_ ? ",\n" : "\n") << event;
+  state.has_events_ = true;
+}
+
+}  // namespace
+
+void Tracer::SetOutputPath(const std::string& path) {
+  TraceState& state = get_state();
+  std::lock_guard<std::mutex> lock{state.mutex_};
+  state.path_ = path;
+}
+
+void Tracer::SetEnabled(const bool enabled_value) {
+  tracing_enabled.store(enabled_value, std::memory_order_relaxed);
+}
+
+bool Tracer::IsEnabled() {
+  return tracing_enabled.load(std::memory_order_relaxed);
+}
+
+void Tracer::InstallToggleSignal() {
+#ifdef SIGUSR1
+  // A handler could not write the trace file, so the signal is blocked
+  // here, and in every thread started from now on, and waited for by a
+  // thread of its own
+  sigset_t signals{};
+  sigemptyset(&signals);
+  sigaddset(&signals, SIGUSR1);
+  if (pthread_sigmask(SIG_BLOCK, &signals, nullptr) != 0) {
+    return;
+  }
+
+  TraceState& state = get_state();
+  if (!state.signal_thread_.joinable()) {
+    state.signal_stopping_.store(false);
+    state.signal_thread_ = std::thread{serve_toggle_signal, signals};
+  }
+#endif
+}
+
+void Tracer::Record(const char* category, const char* name,
+                    const std::chrono::steady_clock::time_point start,
+                    const std::chrono::steady_clock::time_point end) {
+  static const std::chrono::steady_clock::time_point epoch{get_state().epoch_};
+
+  TraceEvent event{
+      category, name,
+      std::chrono::duration_cast<std::chrono::nanoseconds>(start - epoch)
+          .count(),
+      std::chrono::duration_cast<std::chrono::nanoseconds>(end - start)
+          .count()};
+
+  ThreadBuffer& buffer = get_thread_buffer();
+  if (!buffer.events_.TryPush(std::move(event))) {
+    buffer.dropped_.fetch_add(1U, std::memory_order_relaxed);
+  }
+}
+
+bool Tracer::Flush() {
+  TraceState& state = get_state();
+  std::lock_guard<std::mutex> lock{state.mutex_};
+
+  char line[256];
+  TraceEvent event{};
+  for (auto buffer = state.buffers_.begin(); buffer != state.buffers_.end();) {
+    while ((*buffer)->events_.TryPop(event)) {
+      // Chrome expects microseconds, fractions keep the nanoseconds
+      std::snprintf(line, sizeof(line),
+                    "{\"cat\": \"%s\", \"name\": \"%s\", \"ph\": \"X\", "
+                    "\"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                    event.category_, event.name_, (*buffer)->thread_id_,
+                    static_cast<double>(event.start_ns_) / 1000.0,
+                    static_cast<double>(event.duration_ns_) / 1000.0);
+      write_event(state, line);
+    }
+
+    const std::uint64_t dropped =
+        (*buffer)->dropped_.exchange(0U, std::memory_order_relaxed);
+    if (dropped > 0U) {
+      std::snprintf(line, sizeof(line),
+                    "{\"name\": \"Spans dropped\", \"ph\": \"i\", \"s\": "
+                    "\"t\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, "
+                    "\"args\": {\"count\": %llu}}",
+                    (*buffer)->thread_id_,
+                    static_cast<double>(
+                        std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now() - state.epoch_)
+                            .count()) /
+                        1000.0,
+                    static_cast<unsigned long long>(dropped));
+      write_event(state, line);
+    }
+
+    // The thread has exited and everything it recorded has been written
+    if (buffer->use_count() == 1 && (*buffer)->events_.GetSize() == 0U) {
+      buffer = state.buffers_.erase(buffer);
+    } else {
+      ++buffer;
+    }
+  }
+
+  if (!state.file_.is_open()) {
+    return true;
+  }
+  state.file_.flush();
+  return !state.file_.fail();
+}
+
+bool Tracer::Close() {
+  TraceState& state = get_state();
+  stop_signal_thread(state);
+  if (!Flush()) {
+    return false;
+  }
+
+  std::lock_guard<std::mutex> lock{state.mutex_};
+  if (!state.file_.is_open()) {
+    return true;
+  }
+
+  state.file_ << "\n]\n";
+  state.file_.close();
+  return !state.file_.fail();
+}
@@ -0,0 +1,110 @@
+#ifndef __TRACER_H__
+#define __TRACER_H__
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/// @brief Default file the trace is written to when tracing is turned on
+/// while running
+#define DEFAULT_TRACE_PATH "./crm.trace.json"
+
+/// @brief Number of spans each thread can hold before they are written out,
+/// further ones are dropped
+#define TRACE_BUFFER_EVENTS 16384U
+
+/// @brief Records timed spans of the work done by every thread and writes
+/// them out in the Chrome trace event format, which chrome://tracing and
+/// Perfetto can open.
+///
+/// Each thread records into its own lock-free ring buffer, so recording
+/// never contends with other threads; Flush() moves the buffered spans to
+/// the trace file. While tracing is off a span costs a single relaxed atomic
+/// load. Tracing can be turned on and off while running, also by sending
+/// SIGUSR1 to the process (see InstallToggleSignal()).
+class Tracer {
+ public:
+  // No default, move and copy constructors/operators
+  Tracer() = delete;
+  Tracer(const Tracer&) = delete;
+  Tracer& operator=(const Tracer&) = delete;
+  Tracer(Tracer&&) = delete;
+  Tracer& operator=(Tracer&&) = delete;
+
+  /// @brief Sets the file the trace is written to. It is created, replacing
+  /// any previous content, the first time there is something to write.
+  /// @param path Path of the trace file
+  static void SetOutputPath(const std::string& path);
+
+  /// @brief Turns tracing on or off. Spans already open are recorded only if
+  /// tracing was on when they began.
+  /// @param enabled Whether to record spans
+  static void SetEnabled(const bool enabled);
+
+  /// @brief Checks whether spans are being recorded
+  /// @return True if tracing is on
+  static bool IsEnabled();
+
+  /// @brief Makes SIGUSR1 turn tracing on and off and write out the spans
+  /// buffered so far. Must be called by the main thread before any other
+  /// thread is started, since they all have to block the signal.
+  static void InstallToggleSignal();
+
+  /// @brief Records a completed span on the buffer of the calling thread
+  /// @param category Category of the span, must be a string literal
+  /// @param name Name of the span, must be a string literal
+  /// @param start When the span began
+  /// @param end When the span ended
+  static void Record(const char* category, const char* name,
+                     const std::chrono::steady_clock::time_point start,
+                     const std::chrono::steady_clock::time_point end);
+
+  /// @brief Writes the spans buffered by all threads to the trace file. Safe
+  /// to call from any thread, it does not block recording.
+  /// @return False if the trace file could not be written
+  static bool Flush();
+
+  /// @brief Stops serving SIGUSR1, writes the remaining spans and completes
+  /// the trace file
+  /// @return False if the trace file could not be written
+  static bool Close();
+};
+
+/// @brief Records the lifetime of the scope as a span, if tracing is on when
+/// the scope begins
+class TraceSpan {
+ public:
+  // No default, move and copy constructors/operators
+  TraceSpan() = delete;
+  TraceSpan(const TraceSpan&) = delete;
+  TraceSpan& operator=(const TraceSpan&) = delete;
+  TraceSpan(TraceSpan&&) = delete;
+  TraceSpan& operator=(TraceSpan&&) = delete;
+
+  /// @brief Begins the span
+  /// @param category Category of the span, must be a string literal
+  /// @param name Name of the span, must be a string literal
+  TraceSpan(const char* category, const char* name)
+      : category_{category}, name_{name}, enabled_{Tracer::IsEnabled()} {
+    if (enabled_) {
+      start_ = std::chrono::steady_clock::now();
+    }
+  }
+
+  /// @brief Ends the span and records it
+  ~TraceSpan() {
+    if (enabled_) {
+      Tracer::Record(category_, name_, start_,
+                     std::chrono::steady_clock::now());
+    }
+  }
+
+ private:
+  const char* category_;
+  const char* name_;
+  bool enabled_;
+  std::chrono::steady_clock::time_point start_;
+};
+
+#endif  // __TRACER_H__
@@ -0,0 +1,84 @@
+#ifndef __TRANSACTION_H__
+#define __TRANSACTION_H__
+
+#include <string>
+#include <vector>
+
+#include "changes.h"
+#include "customers.h"
+
+/// @brief Collects a batch of changes that shall be applied to the Database
+/// all together. Nothing is applied until the transaction is committed through
+/// Database::CommitTransaction(), which either applies every staged change and
+/// persists them with a single write, or applies none of them.
+class Transaction {
+ public:
+  /// @brief Stages the creation of a new customer
+  /// @param name Name
+  /// @param surname Surname
+  /// @return ID the customer will be assigned once committed
+  Customer::ID AddCustomer(const std::string& name,
+                           const std::string& surname) {
+    const Customer::ID customer_id{++last_customer_id_};
+    changes_.emplace_back(Change::EType::ADD_CUSTOMER, customer_id, name,
+                          surname);
+    return customer_id;
+  }
+
+  /// @brief Stages an update of the information of a customer
+  /// @param id Customer ID
+  /// @param name New name
+  /// @param surname New surname
+  void UpdateClientInfo(const Customer::ID id, const std::string& name,
+                        const std::string& surname) {
+    changes_.emplace_back(Change::EType::UPDATE_CUSTOMER, id, name, surname);
+  }
+
+  /// @brief Stages the removal of a customer
+  /// @param id Customer ID
+  void RemoveCustomer(const Customer::ID id) {
+    changes_.emplace_back(Change::EType::REMOVE_CUSTOMER, id);
+  }
+
+  /// @brief Stages a new interaction for a customer
+  /// @param id Customer ID
+  /// @param when String containing a valid date
+  /// @param what Description of the interaction
+  void AddInteraction(const Customer::ID id, const std::string& when,
+                      const std::string& what) {
+    changes_.emplace_back(Change::EType::ADD_INTERACTION, id, when, what);
+  }
+
+  /// @brief Checks if any change has been staged yet
+  /// @return True if nothing is staged, false otherwise
+  bool IsEmpty() const { return changes_.empty(); }
+
+  /// @brief Read-only access to the staged changes, in staging order
+  /// @return Reference to the staged changes
+  const std::vector<Change>& GetChanges() const { return changes_; }
+
+ private:
+  // Only the Database can open, commit and roll back transactions
+  friend class Database;
+
+  explicit Transaction(const Customer::ID highest_customer_id)
+      : base_customer_id_{highest_customer_id},
+        last_customer_id_{highest_customer_id},
+        changes_{} {}
+
+  /// @brief Drops every staged change
+  void Clear() {
+    last_customer_id_ = base_customer_id_;
+    changes_.clear();
+  }
+
+  /// @brief Highest customer ID in the Database when the transaction began.
+  /// Used to detect conflicting additions at commit time.
+  Customer::ID base_customer_id_;
+  /// @brief Last ID handed out to a staged customer
+  Customer::ID last_customer_id_;
+  /// @brief Staged changes, in staging order
+  std::vector<Change> changes_;
+};
+
+#endif  // __TRANSACTION_H__
@@ -0,0 +1,178 @@
+#include "tsv_storage_engine.h"
+
+#include <fstream>
+#include <iostream>
+#include <sstream>
+
+#include "tracer.h"
+#include "utilities.h"
+
+namespace {
+
+/// @brief Marks the header line of the snapshot, holding the sequence number
+/// of the last batch of changes it contains and the highest customer ID ever
+/// assigned
+constexpr char SNAPSHOT_HEADER_MARKER{'#'};
+
+/// @brief Last field of the header when every customer line ends with its
+/// CRC32C
+constexpr char CHECKSUM_FORMAT[]{"crc32c"};
+
+/// @brief Suffix of the copy kept of a snapshot with corrupted lines, which
+/// the next checkpoint would otherwise drop for good
+constexpr char CORRUPTED_SUFFIX[]{".corrupted"};
+
+/// @brief Parses the header line of the snapshot
+/// @param line Header line, marker included
+/// @param sequence Where to store the sequence number
+/// @param last_customer_id Where to store the highest customer ID
+/// @return Whether the customer lines carry a checksum
+bool parse_header(const std::string& line, std::uint64_t& sequence,
+                  Customer::ID& last_customer_id) {
+  std::stringstream header{line.substr(1)};
+  std::string sequence_field{};
+  std::string last_customer_id_field{};
+  std::string format_field{};
+  std::getline(header, sequence_field, SERIALIZATION_DELIMITER);
+  std::getline(header, last_customer_id_field, SERIALIZATION_DELIMITER);
+  std::getline(header, format_field);
+  utilities::try_convert(sequence_field, sequence);
+  utilities::try_convert(last_customer_id_field, last_customer_id);
+  return format_field == CHECKSUM_FORMAT;
+}
+
+}  // namespace
+
+TsvStorageEngine::TsvStorageEngine(const std::string& database_path,
+                                   const bool read_only)
+    : database_path_{database_path},
+      read_only_{read_only},
+      durable_sequence_{} {}
+
+bool TsvStorageEngine::Load(Customers& customers, std::uint64_t& sequence,
+                            Customer::ID& last_customer_id) {
+  const TraceSpan trace_span{"storage", "TsvStorageEngine::Load"};
+  std::fstream file_stream{database_path_, std::ios::in};
+
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string line;
+  std::size_t line_number{};
+  bool checksummed = false;
+  bool corrupted = false;
+  while (std::getline(file_stream, line)) {
+    line_number++;
+    if (!line.empty() && line[0] == SNAPSHOT_HEADER_MARKER) {
+      checksummed = parse_header(line, sequence, last_customer_id);
+      continue;
+    }
+
+    if (checksummed && !utilities::strip_crc32c(line)) {
+      std::cerr << "Found corrupted entry at line " << line_number
+                << std::endl;
+      corrupted = true;
+      continue;
+    }
+
+    std::stringstream ss{line};
+
+    Customer customer{};
+    ss >> customer;
+
+    if (!customer.IsValid()) {
+      // Same details as Customer::PrintInfo(), which writes to stdout
+      std::cerr << "Found invalid entry: " << customer.id_ << ") "
+                << customer.name_ << " " << customer.surname_ << std::endl;
+      continue;
+    }
+
+    customers[customer.id_] = std::move(customer);
+  }
+
+  if (corrupted && !read_only_) {
+    utilities::copy_file(database_path_, database_path_ + CORRUPTED_SUFFIX);
+  }
+
+  durable_sequence_ = sequence;
+  return true;
+}
+
+void TsvStorageEngine::Stage(const std::vector<Change>&, const Customers&) {
+  // Nothing to keep track of, every checkpoint writes all customers
+}
+
+// Quite inefficient implementation since the file is rewritten everytime..
+// but simplest approach. Use transactions to batch multiple changes into a
+// single write.
+bool TsvStorageEngine::Checkpoint(const std::uint64_t sequence,
+                                  const Customer::ID last_customer_id,
+                                  const Customers& customers, const bool) {
+  const TraceSpan trace_span{"storage", "TsvStorageEngine::Checkpoint"};
+  if (read_only_) {
+    return false;
+  }
+
+  const std::string temporary_path{database_path_ + ".tmp"};
+  std::fstream file_stream{temporary_path, std::ios::out | std::ios::trunc};
+
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  file_stream << SNAPSHOT_HEADER_MARKER << sequence << SERIALIZATION_DELIMITER
+              << last_customer_id << SERIALIZATION_DELIMITER
+              << CHECKSUM_FORMAT << '\n';
+
+  std::ostringstream record{};
+  std::string line{};
+  for (const auto& customer : customers) {
+    record.str(std::string{});
+    record << customer.second;
+    line = record.str();
+    line.pop_back();
+    utilities::append_crc32c(line);
+    file_stream << line << '\n';
+  }
+
+  file_stream.close();
+  if (file_stream.fail() || !utilities::sync_file(temporary_path) ||
+      !utilities::replace_file(temporary_path, database_path_)) {
+    return false;
+  }
+
+  durable_sequence_ = sequence;
+  return true;
+}
+
+std::uint64_t TsvStorageEngine::GetDurableSequence() const {
+  return durable_sequence_;
+}
+
+bool TsvStorageEngine::Verify(Verification& verification) const {
+  std::fstream file_stream{database_path_, std::ios::in};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  std::string line;
+  std::size_t line_number{};
+  bool checksummed = false;
+  while (std::getline(file_stream, line)) {
+    line_number++;
+    if (!line.empty() && line[0] == SNAPSHOT_HEADER_MARKER) {
+      std::uint64_t sequence{};
+      Customer::ID last_customer_id{};
+      checksummed = parse_header(line, sequence, last_customer_id);
+    } else if (!checksummed) {
+      verification.unchecked_++;
+    } else if (utilities::strip_crc32c(line)) {
+      verification.verified_++;
+    } else {
+      verification.corrupted_.push_back(database_path_ + ":" +
+                                        std::to_string(line_number));
+    }
+  }
+  return true;
+}
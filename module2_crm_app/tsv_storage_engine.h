@@ -0,0 +1,57 @@
+#ifndef __TSV_STORAGE_ENGINE_H__
+#define __TSV_STORAGE_ENGINE_H__
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "storage_engine.h"
+
+/// @brief Keeps all customers in a single TSV file, one customer per line,
+/// preceded by a header holding the sequence number of the last batch it
+/// contains. The file is rewritten as a whole on every checkpoint.
+///
+/// Every customer line ends with the CRC32C of the rest of the line. Lines
+/// that do not match are reported and skipped when loading; a copy of the
+/// file is kept aside, as the next checkpoint leaves them out.
+class TsvStorageEngine : public StorageEngine {
+ public:
+  // No default, move and copy constructors/operators
+  TsvStorageEngine() = delete;
+  TsvStorageEngine(const TsvStorageEngine&) = delete;
+  TsvStorageEngine& operator=(const TsvStorageEngine&) = delete;
+  TsvStorageEngine(TsvStorageEngine&&) = delete;
+  TsvStorageEngine& operator=(TsvStorageEngine&&) = delete;
+
+  /// @brief Binds the engine to a file
+  /// @param database_path Path of the TSV file
+  /// @param read_only When true, the file is never written
+  explicit TsvStorageEngine(const std::string& database_path,
+                            const bool read_only);
+
+  bool Load(Customers& customers, std::uint64_t& sequence,
+            Customer::ID& last_customer_id) override;
+
+  void Stage(const std::vector<Change>& changes,
+             const Customers& customers) override;
+
+  bool Checkpoint(const std::uint64_t sequence,
+                  const Customer::ID last_customer_id,
+                  const Customers& customers, const bool force) override;
+
+  std::uint64_t GetDurableSequence() const override;
+
+  bool Verify(Verification& verification) const override;
+
+ private:
+  /// @brief Path of the TSV file
+  std::string database_path_;
+
+  /// @brief Whether the file is never written
+  bool read_only_;
+
+  /// @brief Sequence number written in the file
+  std::uint64_t durable_sequence_;
+};
+
+#endif  // __TSV_STORAGE_ENGINE_H__
@@ -1,40 +1,420 @@
-#include "utilities.h"
-
-#include <iomanip>
-#include <iostream>
-#include <sstream>
-
-namespace utilities {
-
-// Source: https://www.geeksforgeeks.org/how-to-convert-string-to-date-in-cpp/
-bool to_timestamp(const std::string& date, const char* format,
-                  std::time_t& output) {
-  std::stringstream strstream{date};
-
-  std::tm date_time{};
-  strstream >> std::get_time(&date_time, format);
-
-  if (strstream.fail()) {
-    return false;
-  }
-
-  output = std::mktime(&date_time);
-  return true;
-}
-
-bool is_valid_date(const std::string& date, const char* format) {
-  std::time_t timestamp{};
-  return to_timestamp(date, format, timestamp);
-}
-
-void remove_chars_from_str(std::string& str, const std::string& pattern,
-                           const char replace) {
-  const auto cb = [pattern](const char c) {
-    return std::any_of(pattern.begin(), pattern.end(),
-                       [c](const char p) { return p == c; });
-  };
-
-  std::replace_if(str.begin(), str.end(), cb, replace);
-}
-
-}  // namespace utilities
\ No newline at end of file
+#include "utilities.h"
+
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <array>
+#include <cctype>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+#if defined(__x86_64__)
+#include <nmmintrin.h>
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+#include <arm_acle.h>
+#endif
+
+namespace {
+
+/// @brief Reversed Castagnoli polynomial
+constexpr std::uint32_t CRC32C_POLYNOMIAL{0x82F63B78U};
+
+/// @brief Digits of the CRC32C field of a line
+constexpr std::size_t CRC32C_DIGITS{8U};
+
+/// @brief CRC32C one byte at a time, through a lookup table
+std::uint32_t crc32c_software(std::uint32_t crc, const unsigned char* data,
+                              std::size_t size) {
+  static const std::array<std::uint32_t, 256U> table = []() {
+    std::array<std::uint32_t, 256U> entries{};
+    for (std::uint32_t i = 0U; i < entries.size(); i++) {
+      std::uint32_t entry = i;
+      for (int bit = 0; bit < 8; bit++) {
+        entry = (entry >> 1U) ^ ((entry & 1U) != 0U ? CRC32C_POLYNOMIAL : 0U);
+      }
+      entries[i] = entry;
+    }
+    return entries;
+  }();
+
+  while (size-- > 0U) {
+    crc = table[(crc ^ *data++) & 0xFFU] ^ (crc >> 8U);
+  }
+  return crc;
+}
+
+#if defined(__x86_64__)
+
+/// @brief CRC32C eight bytes at a time, through the SSE 4.2 instructions.
+/// Only called after checking that the CPU supports them.
+__attribute__((target("sse4.2"))) std::uint32_t crc32c_hardware(
+    std::uint32_t crc, const unsigned char* data, std::size_t size) {
+  std::uint64_t crc64 = crc;
+  for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t)) {
+    std::uint64_t word{};
+    std::memcpy(&word, data, sizeof(word));
+    crc64 = _mm_crc32_u64(crc64, word);
+    data += sizeof(word);
+  }
+
+  crc = static_cast<std::uint32_t>(crc64);
+  while (size-- > 0U) {
+    crc = _mm_crc32_u8(crc, *data++);
+  }
+  return crc;
+}
+
+/// @brief Whether crc32c_hardware() can be used
+bool has_crc32c_hardware() {
+  static const bool supported = __builtin_cpu_supports("sse4.2");
+  return supported;
+}
+
+#elif defined(__aarch64__) && defined(__ARM_FEATURE_CRC32)
+
+/// @brief CRC32C eight bytes at a time, through the ARMv8 CRC instructions
+std::uint32_t crc32c_hardware(std::uint32_t crc, const unsigned char* data,
+                              std::size_t size) {
+  for (; size >= sizeof(std::uint64_t); size -= sizeof(std::uint64_t)) {
+    std::uint64_t word{};
+    std::memcpy(&word, data, sizeof(word));
+    crc = __crc32cd(crc, word);
+    data += sizeof(word);
+  }
+
+  while (size-- > 0U) {
+    crc = __crc32cb(crc, *data++);
+  }
+  return crc;
+}
+
+/// @brief Whether crc32c_hardware() can be used, always when compiled in
+bool has_crc32c_hardware() { return true; }
+
+#else
+
+/// @brief No CRC instructions on this target
+std::uint32_t crc32c_hardware(std::uint32_t crc, const unsigned char* data,
+                              std::size_t size) {
+  return crc32c_software(crc, data, size);
+}
+
+/// @brief Whether crc32c_hardware() can be used
+bool has_crc32c_hardware() { return false; }
+
+#endif
+
+}  // namespace
+
+namespace utilities {
+
+// Source: https://www.geeksforgeeks.org/how-to-convert-string-to-date-in-cpp/
+bool to_timestamp(const std::string_view date, const char* format,
+                  std::time_t& output) {
+  // Parsed by hand for the conversions the App uses, which is much faster
+  // than std::get_time and does not allocate. Same rules: numbers may have
+  // fewer digits than their maximum, whitespace in the format matches any
+  // amount of it and whatever follows the format is ignored. A date ending
+  // right before a separator is taken as is, the missing fields being 0.
+  std::tm date_time{};
+  std::size_t position{};
+  for (const char* directive = format; *directive != '\0'; directive++) {
+    if (*directive != '%' && position >= date.size()) {
+      break;
+    }
+
+    if (std::isspace(static_cast<unsigned char>(*directive))) {
+      while (position < date.size() &&
+             std::isspace(static_cast<unsigned char>(date[position]))) {
+        position++;
+      }
+      continue;
+    }
+
+    if (*directive != '%') {
+      if (date[position] != *directive) {
+        return false;
+      }
+      position++;
+      continue;
+    }
+
+    int* field{};
+    int max_digits{2};
+    int min_value{};
+    int max_value{};
+    int offset{};
+    switch (*++directive) {
+      case 'd':
+        field = &date_time.tm_mday;
+        min_value = 1;
+        max_value = 31;
+        break;
+      case 'm':
+        field = &date_time.tm_mon;
+        min_value = 1;
+        max_value = 12;
+        offset = 1;
+        break;
+      case 'Y':
+        field = &date_time.tm_year;
+        max_digits = 4;
+        max_value = 9999;
+        offset = 1900;
+        break;
+      case 'H':
+        field = &date_time.tm_hour;
+        max_value = 23;
+        break;
+      case 'M':
+        field = &date_time.tm_min;
+        max_value = 59;
+        break;
+      case 'S':
+        field = &date_time.tm_sec;
+        max_value = 60;
+        break;
+      default: {
+        // Any other conversion goes through the standard library
+        std::stringstream strstream{std::string{date}};
+        date_time = std::tm{};
+        strstream >> std::get_time(&date_time, format);
+        if (strstream.fail()) {
+          return false;
+        }
+        output = std::mktime(&date_time);
+        return true;
+      }
+    }
+
+    // Only days may be padded with spaces
+    while (*directive == 'd' && position < date.size() &&
+           std::isspace(static_cast<unsigned char>(date[position]))) {
+      position++;
+    }
+    int value{};
+    int digits{};
+    while (digits < max_digits && position < date.size() &&
+           std::isdigit(static_cast<unsigned char>(date[position]))) {
+      value = value * 10 + (date[position] - '0');
+      position++;
+      digits++;
+    }
+    if (digits == 0 || value < min_value || value > max_value) {
+      return false;
+    }
+    *field = value - offset;
+  }
+
+  output = std::mktime(&date_time);
+  return true;
+}
+
+std::string to_date(const std::time_t timestamp, const char* format) {
+  std::tm date_time{};
+  localtime_r(&timestamp, &date_time);
+
+  std::stringstream strstream{};
+  strstream << std::put_time(&date_time, format);
+  return strstream.str();
+}
+
+bool is_valid_date(const std::string_view date, const char* format) {
+  std::time_t timestamp{};
+  return to_timestamp(date, format, timestamp);
+}
+
+void remove_chars_from_str(std::string& str, const std::string& pattern,
+                           const char replace) {
+  const auto cb = [pattern](const char c) {
+    return std::any_of(pattern.begin(), pattern.end(),
+                       [c](const char p) { return p == c; });
+  };
+
+  std::replace_if(str.begin(), str.end(), cb, replace);
+}
+
+bool sync_file(const std::string& path) {
+  const int fd = ::open(path.c_str(), O_RDONLY);
+  if (fd < 0) {
+    return false;
+  }
+
+  const bool synced = ::fsync(fd) == 0;
+  ::close(fd);
+  return synced;
+}
+
+bool replace_file(const std::string& source_path,
+                  const std::string& destination_path) {
+  return std::rename(source_path.c_str(), destination_path.c_str()) == 0;
+}
+
+bool truncate_file(const std::string& path, const std::uint64_t size) {
+  return ::truncate(path.c_str(), static_cast<off_t>(size)) == 0;
+}
+
+std::uint64_t get_file_version(const std::string& path) {
+  struct stat status {};
+  if (::stat(path.c_str(), &status) != 0) {
+    return 0U;
+  }
+
+  // An atomic replace gets a new inode, an update in place a new time
+  const std::uint64_t modified_ns =
+      static_cast<std::uint64_t>(status.st_mtim.tv_sec) * 1000000000U +
+      static_cast<std::uint64_t>(status.st_mtim.tv_nsec);
+  return (static_cast<std::uint64_t>(status.st_ino) << 32U) ^ modified_ns ^
+         static_cast<std::uint64_t>(status.st_size);
+}
+
+bool write_file(const std::string& path, const std::string& content) {
+  const std::string temporary_path{path + ".tmp"};
+  std::fstream file_stream{temporary_path, std::ios::out | std::ios::trunc};
+  if (!file_stream.good()) {
+    return false;
+  }
+
+  file_stream << content;
+  file_stream.close();
+  return !file_stream.fail() && sync_file(temporary_path) &&
+         replace_file(temporary_path, path);
+}
+
+bool create_directory(const std::string& path) {
+  return ::mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+bool list_directory(const std::string& path,
+                    std::vector<std::string>& file_names) {
+  DIR* const directory = ::opendir(path.c_str());
+  if (directory == nullptr) {
+    return false;
+  }
+
+  while (const struct dirent* entry = ::readdir(directory)) {
+    if (entry->d_type == DT_REG) {
+      file_names.emplace_back(entry->d_name);
+    }
+  }
+
+  ::closedir(directory);
+  return true;
+}
+
+std::uint64_t checksum(const char* data, const std::size_t size) {
+  std::uint64_t hash{14695981039346656037ULL};
+  for (std::size_t i = 0U; i < size; i++) {
+    hash ^= static_cast<unsigned char>(data[i]);
+    hash *= 1099511628211ULL;
+  }
+  return hash;
+}
+
+std::uint32_t crc32c(const char* data, const std::size_t size) {
+  const auto bytes = reinterpret_cast<const unsigned char*>(data);
+  const std::uint32_t crc = has_crc32c_hardware()
+                                ? crc32c_hardware(~0U, bytes, size)
+                                : crc32c_software(~0U, bytes, size);
+  return ~crc;
+}
+
+void append_crc32c(std::string& line) {
+  static const char digits[]{"0123456789abcdef"};
+
+  const std::uint32_t crc = crc32c(line.data(), line.size());
+  char field[CRC32C_DIGITS + 1U]{'\t'};
+  for (std::size_t i = 0U; i < CRC32C_DIGITS; i++) {
+    field[CRC32C_DIGITS - i] = digits[(crc >> (4U * i)) & 0xFU];
+  }
+  line.append(field, sizeof(field));
+}
+
+bool strip_crc32c(std::string& line) {
+  if (line.size() <= CRC32C_DIGITS ||
+      line[line.size() - CRC32C_DIGITS - 1U] != '\t') {
+    return false;
+  }
+
+  const std::size_t content_size = line.size() - CRC32C_DIGITS - 1U;
+  std::uint32_t expected{};
+  for (std::size_t i = content_size + 1U; i < line.size(); i++) {
+    const char digit = line[i];
+    std::uint32_t value{};
+    if (digit >= '0' && digit <= '9') {
+      value = static_cast<std::uint32_t>(digit - '0');
+    } else if (digit >= 'a' && digit <= 'f') {
+      value = static_cast<std::uint32_t>(digit - 'a' + 10);
+    } else {
+      return false;
+    }
+    expected = (expected << 4U) | value;
+  }
+
+  if (crc32c(line.data(), content_size) != expected) {
+    return false;
+  }
+  line.resize(content_size);
+  return true;
+}
+
+bool copy_file(const std::string& source_path,
+               const std::string& destination_path) {
+  std::ifstream source{source_path, std::ios::binary};
+  if (!source.good()) {
+    return false;
+  }
+
+  std::ofstream destination{destination_path,
+                            std::ios::binary | std::ios::trunc};
+  destination << source.rdbuf();
+  destination.close();
+  return !destination.fail();
+}
+
+std::string to_json_string(const std::string& str) {
+  static const char hex_digits[]{"0123456789abcdef"};
+
+  std::string json{"\""};
+  json.reserve(str.size() + 2U);
+  for (const char c : str) {
+    switch (c) {
+      case '"':
+        json += "\\\"";
+        break;
+      case '\\':
+        json += "\\\\";
+        break;
+      case '\n':
+        json += "\\n";
+        break;
+      case '\r':
+        json += "\\r";
+        break;
+      case '\t':
+        json += "\\t";
+        break;
+      default:
+        if (static_cast<unsigned char>(c) < 0x20U) {
+          // Other control characters, UTF-8 sequences are kept as they are
+          json += "\\u00";
+          json += hex_digits[static_cast<unsigned char>(c) >> 4U];
+          json += hex_digits[static_cast<unsigned char>(c) & 0x0FU];
+        } else {
+          json += c;
+        }
+        break;
+    }
+  }
+  json += '"';
+  return json;
+}
+
+}  // namespace utilities
@@ -1,62 +1,153 @@
-#ifndef __UTILITIES_H__
-#define __UTILITIES_H__
-
-#include <algorithm>
-#include <ctime>
-#include <string>
-#include <vector>
-
-namespace utilities {
-
-/// @brief Safely convert a string to an integer
-/// @tparam ToType Output type
-/// @param input String to attempt to convert
-/// @param output Where to store the converted result
-/// @return True if conversion succeeds, false otherwise
-template <typename ToType>
-bool try_convert(const std::string& input, ToType& output) {
-  try {
-    output = static_cast<ToType>(std::stoull(input));
-    return true;
-  } catch (const std::exception& e) {
-  }
-  return false;
-}
-
-/// @brief Checks if needle is present within haystack
-/// @tparam T Output type
-/// @param haystack Vector of values of type T
-/// @param needle Value to look for
-/// @return True if value found, false otherwise
-template <typename T>
-bool is_in_vector(const std::vector<T>& haystack, const T& needle) {
-  return std::find(haystack.cbegin(), haystack.cend(), needle) !=
-         haystack.cend();
-}
-
-/// @brief Converts a date string into the corresponding timestamp
-/// @param date A string containing a date
-/// @param format Date format expected in the input string
-/// @param output Where to store the timestamp
-/// @return True if conversion succeeds, false otherwise
-bool to_timestamp(const std::string& date, const char* format,
-                  std::time_t& output);
-
-/// @brief Checks if the date string can be converted to a timestamp
-/// following a given format
-/// @param date String containing a date
-/// @param format Date format
-/// @return True if string is a valid date, false otherwise
-bool is_valid_date(const std::string& date, const char* format);
-
-/// @brief Replace all occurrences of pattern (individual chars) with 'replace'
-/// in str
-/// @param str Input string
-/// @param pattern A string containing one or more chars to use as pattern
-/// @param replace Single-char to replace all chars from pattern with
-void remove_chars_from_str(std::string& str, const std::string& pattern,
-                           const char replace);
-
-}  // namespace utilities
-
-#endif  // __UTILITIES_H__
+#ifndef __UTILITIES_H__
+#define __UTILITIES_H__
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <ctime>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace utilities {
+
+/// @brief Safely convert a string to an integer
+/// @tparam ToType Output type
+/// @param input String to attempt to convert
+/// @param output Where to store the converted result
+/// @return True if conversion succeeds, false otherwise
+template <typename ToType>
+bool try_convert(const std::string& input, ToType& output) {
+  try {
+    output = static_cast<ToType>(std::stoull(input));
+    return true;
+  } catch (const std::exception& e) {
+  }
+  return false;
+}
+
+/// @brief Checks if needle is present within haystack
+/// @tparam T Output type
+/// @param haystack Vector of values of type T
+/// @param needle Value to look for
+/// @return True if value found, false otherwise
+template <typename T>
+bool is_in_vector(const std::vector<T>& haystack, const T& needle) {
+  return std::find(haystack.cbegin(), haystack.cend(), needle) !=
+         haystack.cend();
+}
+
+/// @brief Converts a date string into the corresponding timestamp
+/// @param date A string containing a date
+/// @param format Date format expected in the input string
+/// @param output Where to store the timestamp
+/// @return True if conversion succeeds, false otherwise
+bool to_timestamp(const std::string_view date, const char* format,
+                  std::time_t& output);
+
+/// @brief Converts a timestamp into a date string
+/// @param timestamp UNIX Timestamp
+/// @param format Date format of the output
+/// @return Date string, in local time
+std::string to_date(const std::time_t timestamp, const char* format);
+
+/// @brief Checks if the date string can be converted to a timestamp
+/// following a given format
+/// @param date String containing a date
+/// @param format Date format
+/// @return True if string is a valid date, false otherwise
+bool is_valid_date(const std::string_view date, const char* format);
+
+/// @brief Replace all occurrences of pattern (individual chars) with 'replace'
+/// in str
+/// @param str Input string
+/// @param pattern A string containing one or more chars to use as pattern
+/// @param replace Single-char to replace all chars from pattern with
+void remove_chars_from_str(std::string& str, const std::string& pattern,
+                           const char replace);
+
+/// @brief Forces the content of a file to be written to the physical disk
+/// @param path Path of the file to flush
+/// @return True on success, false otherwise
+bool sync_file(const std::string& path);
+
+/// @brief Atomically replaces a file with another one, so readers either see
+/// the old or the new content but never a mix of both
+/// @param source_path File to move
+/// @param destination_path File to replace
+/// @return True on success, false otherwise
+bool replace_file(const std::string& source_path,
+                  const std::string& destination_path);
+
+/// @brief Cuts a file back to a given size, dropping whatever follows
+/// @param path Path of the file
+/// @param size Size to keep, in bytes
+/// @return True on success, false otherwise
+bool truncate_file(const std::string& path, const std::uint64_t size);
+
+/// @brief Identifies the current version of a file, which changes whenever
+/// the file is modified or replaced
+/// @param path Path of the file
+/// @return Combination of the inode, size and modification time, 0 if the
+/// file does not exist
+std::uint64_t get_file_version(const std::string& path);
+
+/// @brief Writes a file atomically: to a temporary file first, flushed to
+/// disk and then moved over the previous one
+/// @param path Path of the file
+/// @param content Content of the file
+/// @return True if the file reached the disk, false otherwise
+bool write_file(const std::string& path, const std::string& content);
+
+/// @brief Copies a file, if it exists
+/// @param source_path File to copy
+/// @param destination_path Where to copy it
+/// @return False if the source cannot be read or the copy cannot be written
+bool copy_file(const std::string& source_path,
+               const std::string& destination_path);
+
+/// @brief Creates a directory, unless it exists already
+/// @param path Path of the directory
+/// @return True if the directory exists afterwards, false otherwise
+bool create_directory(const std::string& path);
+
+/// @brief Lists the names of the regular files in a directory
+/// @param path Path of the directory
+/// @param file_names Where to store the file names, without the directory
+/// @return False if the directory cannot be read
+bool list_directory(const std::string& path,
+                    std::vector<std::string>& file_names);
+
+/// @brief Computes the 64-bit FNV-1a hash of a buffer, used to detect
+/// corrupted files
+/// @param data Start of the buffer
+/// @param size Size of the buffer in bytes
+/// @return Checksum
+std::uint64_t checksum(const char* data, const std::size_t size);
+
+/// @brief Computes the CRC32C (Castagnoli) of a buffer, with the CRC
+/// instructions of the CPU when available
+/// @param data Start of the buffer
+/// @param size Size of the buffer in bytes
+/// @return CRC32C
+std::uint32_t crc32c(const char* data, const std::size_t size);
+
+/// @brief Appends the CRC32C of a line to it, as a last field of 8
+/// hexadecimal digits
+/// @param line Line, without the newline
+void append_crc32c(std::string& line);
+
+/// @brief Checks the CRC32C field appended by append_crc32c() and removes it
+/// @param line Line, without the newline
+/// @return False if the field is missing or does not match, the line is left
+/// untouched in that case
+bool strip_crc32c(std::string& line);
+
+/// @brief Quotes a string as a JSON string literal, escaping it as needed
+/// @param str String to quote
+/// @return JSON string literal, quotes included
+std::string to_json_string(const std::string& str);
+
+}  // namespace utilities
+
+#endif  // __UTILITIES_H__
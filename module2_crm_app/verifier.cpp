@@ -0,0 +1,32 @@
+#include "verifier.h"
+
+#include <cstdlib>
+#include <iostream>
+
+#include "storage_engine.h"
+
+Verifier::Verifier(const Config& config) : config_{config} {}
+
+std::int32_t Verifier::Run() {
+  const auto engine = StorageEngine::Create(config_.storage_engine_,
+                                            config_.database_path_, true);
+
+  StorageEngine::Verification verification{};
+  if (engine == nullptr || !engine->Verify(verification)) {
+    std::cout << "Impossibile leggere il database." << std::endl;
+    return EXIT_FAILURE;
+  }
+
+  std::cout << "Record verificati: " << verification.verified_ << std::endl;
+  if (verification.unchecked_ > 0U) {
+    std::cout << "Record senza checksum: " << verification.unchecked_
+              << " (verranno protetti al prossimo salvataggio)" << std::endl;
+  }
+  std::cout << "Record danneggiati: " << verification.corrupted_.size()
+            << std::endl;
+  for (const auto& location : verification.corrupted_) {
+    std::cout << "  " << location << std::endl;
+  }
+
+  return verification.corrupted_.empty() ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -0,0 +1,31 @@
+#ifndef __VERIFIER_H__
+#define __VERIFIER_H__
+
+#include <cstdint>
+
+#include "config.h"
+
+/// @brief Checks the checksum of every record persisted by the storage
+/// engine, without loading the database, and reports the corrupted ones
+class Verifier {
+ public:
+  // No default, move and copy constructors/operators
+  Verifier() = delete;
+  Verifier(const Verifier&) = delete;
+  Verifier& operator=(const Verifier&) = delete;
+  Verifier(Verifier&&) = delete;
+  Verifier& operator=(Verifier&&) = delete;
+
+  /// @brief Prepares the scan
+  /// @param config Options of the scan: database and storage engine
+  explicit Verifier(const Config& config);
+
+  /// @brief Scans the database and prints the report
+  /// @return Exit status code, failure if any record is corrupted
+  std::int32_t Run();
+
+ private:
+  Config config_;
+};
+
+#endif  // __VERIFIER_H__